@@ -1,5 +1,7 @@
 #include "IPCClient.hpp"
 #include "../../../common/Logger.hpp"
+#include "../../../common/TriggerTrace.hpp"
+#include "../../../common/AllocationCounter.hpp"
 #include <iostream>
 #ifdef _WIN32
 #include <Windows.h>
@@ -374,6 +376,7 @@ namespace StayPutVR {
     }
 
     void IPCClient::ProcessDeviceUpdateMessage(const std::vector<uint8_t>& buffer) {
+        AllocationScope alloc_scope(AllocTag::IPC);
         if (!device_update_callback_ || buffer.size() < 5) { // 1 byte type + 4 bytes count
             return;
         }
@@ -457,6 +460,22 @@ namespace StayPutVR {
                 
                 devices.push_back(device);
             }
+
+            // Optional trailer (newer drivers): pose sample time for latency
+            // tracing. Only read it when every device record was parsed;
+            // after an early break offset sits inside a record. Stamp our
+            // receive time alongside it.
+            const bool allDevicesParsed = devices.size() == numDevices;
+            int64_t sampleTimeUs = 0;
+            if (allDevicesParsed && offset + sizeof(sampleTimeUs) <= buffer.size()) {
+                memcpy(&sampleTimeUs, buffer.data() + offset, sizeof(sampleTimeUs));
+                offset += sizeof(sampleTimeUs);
+            }
+            const int64_t receiveTimeUs = TraceNowUs();
+            for (auto& device : devices) {
+                device.sample_time_us = sampleTimeUs;
+                device.receive_time_us = receiveTimeUs;
+            }
             
             // Call the callback with the device data
             device_update_callback_(devices);
@@ -12,6 +12,7 @@
 #include "../../common/OSCManager.hpp"
 #include "ui/UIManager.hpp"
 #include "../../common/Logger.hpp"
+#include "../../common/LogRing.hpp"
 #include "../../common/PathUtils.hpp"
 #include "../../common/Audio.hpp"
 #include "../../common/Config.hpp"
@@ -80,6 +81,10 @@ static int RunStayPutVR() {
             }
         }
         
+        // Keep the most recent log lines in memory for the Logs tab. Enabled
+        // before Init so the startup lines are captured too.
+        StayPutVR::LogRing::SetCapacity(20000);
+
         // Initialize the logger
         StayPutVR::Logger::Init(logPath, StayPutVR::Logger::LogType::APPLICATION);
         StayPutVR::Logger::Info("StayPutVR application starting up");
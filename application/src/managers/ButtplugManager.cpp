@@ -1,7 +1,9 @@
 #include "ButtplugManager.hpp"
+#include "../../../common/AllocationCounter.hpp"
 #include <thread>
 #include <sstream>
 #include <algorithm>
+#include <nlohmann/json.hpp>
 
 namespace StayPutVR {
 
@@ -39,7 +41,7 @@ namespace StayPutVR {
         // Set up callbacks
         ws_client_->SetOnConnectedCallback([this]() { OnWebSocketConnected(); });
         ws_client_->SetOnDisconnectedCallback([this](const std::string& reason) { OnWebSocketDisconnected(reason); });
-        ws_client_->SetOnMessageCallback([this](const std::string& message) { OnWebSocketMessage(message); });
+        ws_client_->SetOnMessageCallback([this](std::string_view message) { OnWebSocketMessage(message); });
         ws_client_->SetOnErrorCallback([this](const std::string& error) { OnWebSocketError(error); });
 
         Logger::Info("ButtplugManager initialized");
@@ -283,6 +285,7 @@ namespace StayPutVR {
                          config_->buttplug_master_disobedience_intensity;
         
         auto device_indices = GetEnabledDeviceIndices();
+        WebSocketClient::SendBatch batch(*ws_client_);
         for (int device_index : device_indices) {
             SendVibrateContinuous(device_index, intensity, "Test");
         }
@@ -317,6 +320,7 @@ namespace StayPutVR {
             return;
         }
 
+        WebSocketClient::SendBatch batch(*ws_client_);
         for (int device_index : device_indices) {
             SendVibrate(device_index, intensity, duration, reason);
         }
@@ -341,7 +345,7 @@ namespace StayPutVR {
         }
 
         Logger::Info("Stopping vibration on device " + std::to_string(device_index));
-        SendScalarCmd(device_index, 0.0f, "Vibrate");
+        SendScalarCmd(device_index, 0.0f, "Vibrate", SendPriority::Urgent);
     }
 
     void ButtplugManager::StopVibrationMulti(const std::vector<int>& device_indices) {
@@ -433,42 +437,54 @@ namespace StayPutVR {
         Logger::Info("WebSocket disconnected from Buttplug/Intiface: " + reason);
         connected_ = false;
         server_ready_ = false;
+
+        {
+            std::lock_guard<std::mutex> lock(trace_mutex_);
+            pending_traces_.clear();
+        }
         
         std::lock_guard<std::mutex> lock(devices_mutex_);
         available_devices_.clear();
     }
 
-    void ButtplugManager::OnWebSocketMessage(const std::string& message) {
-        Logger::Debug("Received Buttplug message: " + message);
-        
-        try {
-            nlohmann::json j = nlohmann::json::parse(message);
-            
-            if (!j.is_array() || j.empty()) {
-                Logger::Warning("Invalid Buttplug message format (not an array or empty)");
-                return;
-            }
-            
-            for (const auto& msg : j) {
-                if (msg.contains("ServerInfo")) {
-                    HandleServerInfo(msg);
-                } else if (msg.contains("DeviceAdded")) {
-                    HandleDeviceAdded(msg);
-                } else if (msg.contains("DeviceRemoved")) {
-                    HandleDeviceRemoved(msg);
-                } else if (msg.contains("DeviceList")) {
-                    HandleDeviceList(msg);
-                } else if (msg.contains("Ok")) {
-                    HandleOk(msg);
-                } else if (msg.contains("Error")) {
-                    HandleError(msg);
+    void ButtplugManager::OnWebSocketMessage(std::string_view message) {
+        AllocationScope alloc_scope(AllocTag::WebSocket);
+        if (Logger::IsEnabled(Logger::LogLevel::DEBUG)) {
+            Logger::Debug("Received Buttplug message: " + std::string(message));
+        }
+
+        std::string parse_error;
+        const JsonView messages = JsonView::Parse(message, &parse_error);
+        if (!messages) {
+            Logger::Error("Failed to parse Buttplug message: " + parse_error);
+            return;
+        }
+
+        if (!messages.IsArray() || messages.Empty()) {
+            Logger::Warning("Invalid Buttplug message format (not an array or empty)");
+            return;
+        }
+
+        // Each element is an object with one member: {"<MessageType>": {...}}.
+        messages.ForEach([this](const JsonView& msg) {
+            msg.ForEachMember([this](std::string_view type, const JsonView& body) {
+                if (type == "Ok") {
+                    HandleOk(body);
+                } else if (type == "ServerInfo") {
+                    HandleServerInfo(body);
+                } else if (type == "DeviceAdded") {
+                    HandleDeviceAdded(body);
+                } else if (type == "DeviceRemoved") {
+                    HandleDeviceRemoved(body);
+                } else if (type == "DeviceList") {
+                    HandleDeviceList(body);
+                } else if (type == "Error") {
+                    HandleError(body);
                 } else {
                     Logger::Debug("Unknown Buttplug message type");
                 }
-            }
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse Buttplug message: " + std::string(e.what()));
-        }
+            });
+        });
     }
 
     void ButtplugManager::OnWebSocketError(const std::string& error) {
@@ -538,9 +554,16 @@ namespace StayPutVR {
         // Get device indices before starting new vibration
         auto device_indices = GetEnabledDeviceIndices(device_serial);
         if (!device_indices.empty()) {
+            // Re-scope the caller's latency trace (if any) with the enqueue
+            // stamp so SendScalarCmd can register it against the message Id.
+            TriggerTrace trace = TriggerLatency::Current();
+            trace.Mark(TraceStage::Enqueue);
+            TriggerLatency::Scope trace_scope(trace);
+
             // Send new intensity directly - Buttplug protocol allows updating intensity without stopping
             Logger::Info("Zone changed to " + zone_name + " for device " + device_serial + 
                         " - setting continuous vibration at intensity " + std::to_string(intensity));
+            WebSocketClient::SendBatch batch(*ws_client_);
             for (int device_index : device_indices) {
                 SendVibrateContinuous(device_index, intensity, zone_name);
             }
@@ -603,11 +626,12 @@ namespace StayPutVR {
         return ws_client_->SendText(message_str);
     }
 
-    bool ButtplugManager::SendScalarCmd(int device_index, float scalar, const std::string& actuator_type) {
+    bool ButtplugManager::SendScalarCmd(int device_index, float scalar, const std::string& actuator_type, SendPriority priority) {
+        const uint32_t msg_id = GetNextMessageId();
         nlohmann::json message = nlohmann::json::array({
             {
                 {"ScalarCmd", {
-                    {"Id", GetNextMessageId()},
+                    {"Id", msg_id},
                     {"DeviceIndex", device_index},
                     {"Scalars", nlohmann::json::array({
                         {
@@ -622,8 +646,28 @@ namespace StayPutVR {
 
         std::string message_str = message.dump();
         Logger::Debug("Sending ScalarCmd: " + message_str);
-        
-        return ws_client_->SendText(message_str);
+
+        // Send is stamped at enqueue; the writer thread puts it on the wire.
+        // Registered first so an Ok can never beat its trace.
+        TriggerTrace trace = TriggerLatency::Current();
+        trace.Mark(TraceStage::Send);
+        if (trace.IsActive()) {
+            std::lock_guard<std::mutex> lock(trace_mutex_);
+            if (pending_traces_.size() >= MAX_PENDING_TRACES) {
+                pending_traces_.erase(pending_traces_.begin()); // oldest Id, never acked
+            }
+            pending_traces_[msg_id] = trace;
+        }
+        if (!ws_client_->SendText(message_str, priority, DeviceSendKey(device_index))) {
+            std::lock_guard<std::mutex> lock(trace_mutex_);
+            pending_traces_.erase(msg_id);
+            return false;
+        }
+        return true;
+    }
+
+    std::string ButtplugManager::DeviceSendKey(int device_index) {
+        return "device:" + std::to_string(device_index);
     }
 
     bool ButtplugManager::SendStopDeviceCmd(int device_index) {
@@ -639,7 +683,7 @@ namespace StayPutVR {
         std::string message_str = message.dump();
         Logger::Debug("Sending StopDeviceCmd: " + message_str);
         
-        return ws_client_->SendText(message_str);
+        return ws_client_->SendText(message_str, SendPriority::Urgent, DeviceSendKey(device_index));
     }
 
     bool ButtplugManager::SendStopAllDevices() {
@@ -654,7 +698,8 @@ namespace StayPutVR {
         std::string message_str = message.dump();
         Logger::Debug("Sending StopAllDevices: " + message_str);
         
-        return ws_client_->SendText(message_str);
+        // No key: cancels every device's queued intensity updates.
+        return ws_client_->SendText(message_str, SendPriority::Urgent);
     }
 
     bool ButtplugManager::SendPing() {
@@ -672,144 +717,114 @@ namespace StayPutVR {
         return ws_client_->SendText(message_str);
     }
 
-    void ButtplugManager::HandleServerInfo(const nlohmann::json& message) {
-        try {
-            const auto& server_info = message["ServerInfo"];
-            std::string server_name = server_info.value("ServerName", "Unknown");
-            int message_version = server_info.value("MessageVersion", 0);
-            
-            Logger::Info("Connected to Buttplug server: " + server_name + 
-                        " (Protocol v" + std::to_string(message_version) + ")");
-            
-            server_ready_ = true;
-            
-            RequestDeviceList();
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse ServerInfo: " + std::string(e.what()));
-        }
+    void ButtplugManager::HandleServerInfo(const JsonView& server_info) {
+        std::string server_name = server_info["ServerName"].AsString("Unknown");
+        int64_t message_version = server_info["MessageVersion"].AsInt(0);
+
+        Logger::Info("Connected to Buttplug server: " + server_name + 
+                    " (Protocol v" + std::to_string(message_version) + ")");
+
+        server_ready_ = true;
+
+        RequestDeviceList();
     }
 
-    void ButtplugManager::HandleDeviceAdded(const nlohmann::json& message) {
-        try {
-            const auto& device = message["DeviceAdded"];
-            AddDevice(device);
-            
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse DeviceAdded: " + std::string(e.what()));
-        }
+    void ButtplugManager::HandleDeviceAdded(const JsonView& device) {
+        AddDevice(device);
     }
 
-    void ButtplugManager::HandleDeviceRemoved(const nlohmann::json& message) {
-        try {
-            const auto& device_removed = message["DeviceRemoved"];
-            int device_index = device_removed.value("DeviceIndex", -1);
-            
-            if (device_index >= 0) {
-                RemoveDevice(device_index);
-            }
-            
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse DeviceRemoved: " + std::string(e.what()));
+    void ButtplugManager::HandleDeviceRemoved(const JsonView& device_removed) {
+        int device_index = static_cast<int>(device_removed["DeviceIndex"].AsInt(-1));
+
+        if (device_index >= 0) {
+            RemoveDevice(device_index);
         }
     }
 
-    void ButtplugManager::HandleDeviceList(const nlohmann::json& message) {
-        try {
-            const auto& device_list = message["DeviceList"];
-            const auto& devices = device_list["Devices"];
-            
-            Logger::Info("Received device list with " + std::to_string(devices.size()) + " devices");
-            
+    void ButtplugManager::HandleDeviceList(const JsonView& device_list) {
+        const JsonView devices = device_list["Devices"];
+
+        Logger::Info("Received device list with " + std::to_string(devices.Size()) + " devices");
+
+        {
             std::lock_guard<std::mutex> lock(devices_mutex_);
             available_devices_.clear();
-            
-            for (const auto& device : devices) {
-                AddDevice(device);
-            }
-            
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse DeviceList: " + std::string(e.what()));
         }
+
+        // AddDevice takes devices_mutex_ itself.
+        devices.ForEach([this](const JsonView& device) {
+            AddDevice(device);
+        });
     }
 
-    void ButtplugManager::HandleOk(const nlohmann::json& message) {
-        try {
-            const auto& ok = message["Ok"];
-            int msg_id = ok.value("Id", 0);
+    void ButtplugManager::HandleOk(const JsonView& ok) {
+        const int64_t msg_id = ok["Id"].AsInt(0);
+        if (Logger::IsEnabled(Logger::LogLevel::DEBUG)) {
             Logger::Debug("Received Ok for message ID " + std::to_string(msg_id));
-            
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse Ok: " + std::string(e.what()));
         }
-    }
 
-    void ButtplugManager::HandleError(const nlohmann::json& message) {
-        try {
-            const auto& error = message["Error"];
-            int msg_id = error.value("Id", 0);
-            std::string error_message = error.value("ErrorMessage", "Unknown error");
-            int error_code = error.value("ErrorCode", 0);
-            
-            Logger::Error("Received Error for message ID " + std::to_string(msg_id) + 
-                         ": " + error_message + " (Code: " + std::to_string(error_code) + ")");
-            
-            SetError(error_message);
-            
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to parse Error: " + std::string(e.what()));
+        TriggerTrace trace;
+        {
+            std::lock_guard<std::mutex> lock(trace_mutex_);
+            auto it = pending_traces_.find(static_cast<uint32_t>(msg_id));
+            if (it != pending_traces_.end()) {
+                trace = it->second;
+                pending_traces_.erase(it);
+            }
         }
+        trace.Mark(TraceStage::Response);
+        TriggerLatency::Complete(TraceIntegration::Buttplug, trace);
+    }
+
+    void ButtplugManager::HandleError(const JsonView& error) {
+        int64_t msg_id = error["Id"].AsInt(0);
+        std::string error_message = error["ErrorMessage"].AsString("Unknown error");
+        int64_t error_code = error["ErrorCode"].AsInt(0);
+
+        Logger::Error("Received Error for message ID " + std::to_string(msg_id) + 
+                     ": " + error_message + " (Code: " + std::to_string(error_code) + ")");
+
+        SetError(error_message);
+
+        std::lock_guard<std::mutex> lock(trace_mutex_);
+        pending_traces_.erase(static_cast<uint32_t>(msg_id));
     }
 
     uint32_t ButtplugManager::GetNextMessageId() {
         return next_message_id_++;
     }
 
-    void ButtplugManager::AddDevice(const nlohmann::json& device_json) {
-        try {
-            int device_index = device_json.value("DeviceIndex", -1);
-            std::string device_name = device_json.value("DeviceName", "Unknown");
-            
-            if (device_index < 0) {
-                Logger::Warning("Invalid device index in AddDevice");
-                return;
-            }
-            
-            ButtplugDeviceInfo info;
-            info.device_index = device_index;
-            info.device_name = device_name;
-            info.supports_vibration = false;
-            info.vibration_feature_count = 0;
-            
-            // Check if device supports ScalarCmd with Vibrate actuator
-            if (device_json.contains("DeviceMessages")) {
-                const auto& messages = device_json["DeviceMessages"];
-                
-                if (messages.contains("ScalarCmd")) {
-                    const auto& scalar_cmd = messages["ScalarCmd"];
-                    if (scalar_cmd.is_array()) {
-                        for (const auto& actuator : scalar_cmd) {
-                            std::string actuator_type = actuator.value("ActuatorType", "");
-                            if (actuator_type == "Vibrate") {
-                                info.supports_vibration = true;
-                                info.vibration_feature_count++;
-                            }
-                        }
-                    }
-                }
-            }
-            
-            {
-                std::lock_guard<std::mutex> lock(devices_mutex_);
-                available_devices_[device_index] = info;
+    void ButtplugManager::AddDevice(const JsonView& device_json) {
+        int device_index = static_cast<int>(device_json["DeviceIndex"].AsInt(-1));
+        std::string device_name = device_json["DeviceName"].AsString("Unknown");
+
+        if (device_index < 0) {
+            Logger::Warning("Invalid device index in AddDevice");
+            return;
+        }
+
+        ButtplugDeviceInfo info;
+        info.device_index = device_index;
+        info.device_name = device_name;
+        info.supports_vibration = false;
+        info.vibration_feature_count = 0;
+
+        // Check if device supports ScalarCmd with Vibrate actuator
+        device_json["DeviceMessages"]["ScalarCmd"].ForEach([&info](const JsonView& actuator) {
+            if (actuator["ActuatorType"].Equals("Vibrate")) {
+                info.supports_vibration = true;
+                info.vibration_feature_count++;
             }
-            
-            Logger::Info("Device added: [" + std::to_string(device_index) + "] " + 
-                        device_name + " (Vibration: " + 
-                        (info.supports_vibration ? "Yes" : "No") + ")");
-            
-        } catch (const nlohmann::json::exception& e) {
-            Logger::Error("Failed to add device: " + std::string(e.what()));
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex_);
+            available_devices_[device_index] = info;
         }
+
+        Logger::Info("Device added: [" + std::to_string(device_index) + "] " + 
+                    device_name + " (Vibration: " + 
+                    (info.supports_vibration ? "Yes" : "No") + ")");
     }
 
     void ButtplugManager::RemoveDevice(int device_index) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <atomic>
 #include <chrono>
@@ -11,7 +12,8 @@
 #include "../../../common/Config.hpp"
 #include "../../../common/Logger.hpp"
 #include "../../../common/WebSocketClient.hpp"
-#include <nlohmann/json.hpp>
+#include "../../../common/TriggerTrace.hpp"
+#include "../../../common/JsonView.hpp"
 
 namespace StayPutVR {
 
@@ -74,6 +76,7 @@ namespace StayPutVR {
         std::string GetConnectionStatus() const;
         std::string GetLastError() const { return last_error_; }
         bool CanTriggerAction() const; // Rate limiting check
+        WebSocketClient::SendStats GetSendStats() const { return ws_client_ ? ws_client_->GetSendStats() : WebSocketClient::SendStats{}; }
         
         // Event callbacks
         void SetActionCallback(ButtplugActionCallback callback) { action_callback_ = callback; }
@@ -105,6 +108,11 @@ namespace StayPutVR {
         // Zone state tracking for continuous vibration
         mutable std::mutex zone_state_mutex_;
         std::map<std::string, ButtplugZoneType> current_zone_state_; // device_serial -> current zone
+
+        // Latency traces of ScalarCmds awaiting the server's Ok, by message Id.
+        std::mutex trace_mutex_;
+        std::map<uint32_t, TriggerTrace> pending_traces_;
+        static constexpr size_t MAX_PENDING_TRACES = 32;
         
         // Rate limiting
         mutable std::chrono::steady_clock::time_point last_action_time_;
@@ -126,7 +134,7 @@ namespace StayPutVR {
         // WebSocket callbacks
         void OnWebSocketConnected();
         void OnWebSocketDisconnected(const std::string& reason);
-        void OnWebSocketMessage(const std::string& message);
+        void OnWebSocketMessage(std::string_view message);
         void OnWebSocketError(const std::string& error);
         
         // Internal methods
@@ -144,22 +152,27 @@ namespace StayPutVR {
         bool SendRequestServerInfo();
         bool SendStartScanning();
         bool SendStopScanning();
-        bool SendScalarCmd(int device_index, float scalar, const std::string& actuator_type = "Vibrate");
+        // Intensity updates are keyed per device (DeviceSendKey) so a backed-up
+        // queue keeps only the newest, and a stop cancels the ones still queued.
+        bool SendScalarCmd(int device_index, float scalar, const std::string& actuator_type = "Vibrate",
+                           SendPriority priority = SendPriority::Normal);
         bool SendStopDeviceCmd(int device_index);
         bool SendStopAllDevices();
+        static std::string DeviceSendKey(int device_index);
         bool SendPing();
         
         // Message handling
-        void HandleServerInfo(const nlohmann::json& message);
-        void HandleDeviceAdded(const nlohmann::json& message);
-        void HandleDeviceRemoved(const nlohmann::json& message);
-        void HandleDeviceList(const nlohmann::json& message);
-        void HandleOk(const nlohmann::json& message);
-        void HandleError(const nlohmann::json& message);
+        // Each takes the body of one message: the value under its type name.
+        void HandleServerInfo(const JsonView& server_info);
+        void HandleDeviceAdded(const JsonView& device);
+        void HandleDeviceRemoved(const JsonView& device_removed);
+        void HandleDeviceList(const JsonView& device_list);
+        void HandleOk(const JsonView& ok);
+        void HandleError(const JsonView& error);
         
         // Helper methods
         uint32_t GetNextMessageId();
-        void AddDevice(const nlohmann::json& device_json);
+        void AddDevice(const JsonView& device_json);
         void RemoveDevice(int device_index);
         
         // Multi-device methods
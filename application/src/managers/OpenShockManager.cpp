@@ -2,6 +2,7 @@
 #include <sstream>
 #include <algorithm>
 #include <array>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -17,7 +18,18 @@ namespace StayPutVR {
         return true;
     }
 
+    OpenShockManager::~OpenShockManager() {
+        // Shutdown() normally did this; the window timer must not outlive us.
+        CancelFlushTimer();
+    }
+
     void OpenShockManager::OnShutdown() {
+        // Send an open window now rather than dropping it; the work queue
+        // drains before it stops.
+        CancelFlushTimer();
+        if (CoalescePending() && !EnqueueWork([this]() { FlushPendingControls(); })) {
+            DropPendingControls("Work queue unavailable");
+        }
         Logger::Info("OpenShockManager shutdown");
     }
 
@@ -45,7 +57,7 @@ namespace StayPutVR {
             return;
         }
 
-        if (!CanTriggerAction()) {
+        if (!CoalescePending() && !CanTriggerAction()) {
             Logger::Info("Rate limit active, skipping disobedience actions");
             return;
         }
@@ -85,7 +97,7 @@ namespace StayPutVR {
             return;
         }
 
-        if (!CanTriggerAction()) {
+        if (!CoalescePending() && !CanTriggerAction()) {
             Logger::Info("Rate limit active, skipping warning actions");
             return;
         }
@@ -149,13 +161,24 @@ namespace StayPutVR {
         TriggerDisobedienceActions("");
     }
 
+    void OpenShockManager::OnLockEngaged() {
+        if (!IsFullyConfigured()) return;
+        std::string server_url;
+        {
+            auto cfg_lock = config_->ReadLock();
+            server_url = config_->openshock_server_url;
+        }
+        // The first violation after this then skips DNS/TCP/TLS setup.
+        HttpClient::PrewarmConnection(server_url);
+    }
+
     void OpenShockManager::SendShockWithIndividualIntensities(int duration, const std::string& reason, const std::string& device_serial, bool is_disobedience) {
         if (!ValidateCredentials()) {
             SetError("Invalid OpenShock credentials");
             return;
         }
 
-        if (!CheckRateLimit()) {
+        if (!CoalescePending() && !CheckRateLimit()) {
             SetError("Rate limit exceeded");
             return;
         }
@@ -177,7 +200,6 @@ namespace StayPutVR {
         }
 
         try {
-            std::string server_url, api_token;
             std::array<std::string, 5> device_ids;
             std::unordered_map<std::string, std::array<bool, 5>> device_shock_map;
             bool use_individual_disob, use_individual_warn;
@@ -185,8 +207,6 @@ namespace StayPutVR {
             float master_disob_intensity, master_warn_intensity;
             {
                 auto cfg_lock = config_->ReadLock();
-                server_url = config_->openshock_server_url;
-                api_token = config_->openshock_api_token;
                 device_ids = config_->openshock_device_ids;
                 device_shock_map = config_->device_openshock_ids;
                 use_individual_disob = config_->openshock_use_individual_disobedience_intensities;
@@ -227,6 +247,18 @@ namespace StayPutVR {
                 return;
             }
 
+            // The command set is queued for the coalescing window here, so the
+            // "enqueue" stage is the point it was resolved.
+            OpenShockActionData action;
+            action.type = OpenShockActionType::SHOCK;
+            action.intensity = 0;
+            action.duration = duration;
+            action.reason = reason;
+            action.trace = TriggerLatency::Current();
+            action.trace.Mark(TraceStage::Enqueue);
+
+            std::vector<PendingControl> controls;
+            controls.reserve(device_ids_to_use.size());
             for (size_t i = 0; i < device_ids_to_use.size(); ++i) {
                 int device_index = device_indices[i];
                 float intensity_normalized;
@@ -253,20 +285,13 @@ namespace StayPutVR {
                            ", Duration: " + std::to_string(duration) + "ms" +
                            ", Reason: " + reason + ")");
 
-                std::string response;
-                bool success = SendOpenShockCommand(
-                    server_url, api_token,
-                    device_ids_to_use[i],
-                    0, // 0 = Shock
-                    intensity, duration, response
-                );
-                RecordCommandResult(success);
-
-                if (!success) {
-                    Logger::Error("Failed to send shock to device " + std::to_string(device_index) + ": " + response);
-                }
+                controls.push_back({device_ids_to_use[i], OpenShockActionType::SHOCK, intensity, duration});
+                action.intensity = (std::max)(action.intensity, intensity);
             }
 
+            // On their own these went out as one request per device.
+            QueueControls(controls, action, /*report=*/false, static_cast<int>(controls.size()));
+
         } catch (const std::exception& e) {
             std::string error = "OpenShock individual shock action failed: " + std::string(e.what());
             SetError(error);
@@ -280,13 +305,12 @@ namespace StayPutVR {
             return;
         }
 
-        if (!CheckRateLimit()) {
+        if (!CoalescePending() && !CheckRateLimit()) {
             SetError("Rate limit exceeded");
             return;
         }
 
         try {
-            std::string server_url, api_token;
             std::array<std::string, 5> device_ids;
             std::unordered_map<std::string, std::array<bool, 5>> device_shock_map;
             bool use_individual_disob, use_individual_warn;
@@ -294,8 +318,6 @@ namespace StayPutVR {
             float master_disob_intensity, master_warn_intensity;
             {
                 auto cfg_lock = config_->ReadLock();
-                server_url = config_->openshock_server_url;
-                api_token = config_->openshock_api_token;
                 device_ids = config_->openshock_device_ids;
                 device_shock_map = config_->device_openshock_ids;
                 use_individual_disob = config_->openshock_use_individual_disobedience_intensities;
@@ -336,6 +358,18 @@ namespace StayPutVR {
                 return;
             }
 
+            // The command set is queued for the coalescing window here, so the
+            // "enqueue" stage is the point it was resolved.
+            OpenShockActionData action;
+            action.type = OpenShockActionType::VIBRATE;
+            action.intensity = 0;
+            action.duration = duration;
+            action.reason = reason;
+            action.trace = TriggerLatency::Current();
+            action.trace.Mark(TraceStage::Enqueue);
+
+            std::vector<PendingControl> controls;
+            controls.reserve(device_ids_to_use.size());
             for (size_t i = 0; i < device_ids_to_use.size(); ++i) {
                 int device_index = device_indices[i];
                 float intensity_normalized;
@@ -362,20 +396,13 @@ namespace StayPutVR {
                            ", Duration: " + std::to_string(duration) + "ms" +
                            ", Reason: " + reason + ")");
 
-                std::string response;
-                bool success = SendOpenShockCommand(
-                    server_url, api_token,
-                    device_ids_to_use[i],
-                    1, // 1 = Vibrate
-                    intensity, duration, response
-                );
-                RecordCommandResult(success);
-
-                if (!success) {
-                    Logger::Error("Failed to send vibrate to device " + std::to_string(device_index) + ": " + response);
-                }
+                controls.push_back({device_ids_to_use[i], OpenShockActionType::VIBRATE, intensity, duration});
+                action.intensity = (std::max)(action.intensity, intensity);
             }
 
+            // On their own these went out as one request per device.
+            QueueControls(controls, action, /*report=*/false, static_cast<int>(controls.size()));
+
         } catch (const std::exception& e) {
             std::string error = "OpenShock individual vibrate action failed: " + std::string(e.what());
             SetError(error);
@@ -495,11 +522,15 @@ namespace StayPutVR {
             std::string response;
             bool success = false;
             if (!device_ids.empty()) {
+                TriggerTrace trace = action.trace;
+                trace.Mark(TraceStage::Send);
                 success = SendOpenShockCommandMulti(
                     server_url, api_token, device_ids,
                     static_cast<int>(action.type),
                     action.intensity, action.duration, response
                 );
+                trace.Mark(TraceStage::Response);
+                if (success) TriggerLatency::Complete(TraceIntegration::OpenShock, trace);
                 RecordCommandResult(success);
             } else {
                 SetError("No shock devices configured");
@@ -525,15 +556,21 @@ namespace StayPutVR {
     }
 
     void OpenShockManager::ExecuteActionAsync(const OpenShockActionData& action) {
-        EnqueueWork([this, action]() {
-            ExecuteAction(action);
+        OpenShockActionData traced = action;
+        traced.trace = TriggerLatency::Current();
+        traced.trace.Mark(TraceStage::Enqueue);
+        EnqueueWork([this, traced]() {
+            ExecuteAction(traced);
         });
     }
 
     void OpenShockManager::ExecuteActionAsyncMulti(const OpenShockActionData& action, const std::string& device_serial) {
-        EnqueueWork([this, action, device_serial]() {
-            ExecuteActionMulti(action, device_serial);
-        });
+        // ExecuteActionMulti only resolves the devices and queues the commands
+        // for the coalescing window, so it runs here; the send is on the worker.
+        OpenShockActionData traced = action;
+        traced.trace = TriggerLatency::Current();
+        traced.trace.Mark(TraceStage::Enqueue);
+        ExecuteActionMulti(traced, device_serial);
     }
 
     void OpenShockManager::ExecuteActionMulti(const OpenShockActionData& action, const std::string& device_serial) {
@@ -545,7 +582,7 @@ namespace StayPutVR {
             return;
         }
 
-        if (!CheckRateLimit()) {
+        if (!CoalescePending() && !CheckRateLimit()) {
             SetError("Rate limit exceeded");
             if (action_callback_) {
                 action_callback_(ActionTypeToString(action.type), false, "Rate limit exceeded");
@@ -554,13 +591,10 @@ namespace StayPutVR {
         }
 
         try {
-            std::string server_url, api_token;
             std::array<std::string, 5> device_ids;
             std::unordered_map<std::string, std::array<bool, 5>> device_shock_map;
             {
                 auto cfg_lock = config_->ReadLock();
-                server_url = config_->openshock_server_url;
-                api_token = config_->openshock_api_token;
                 device_ids = config_->openshock_device_ids;
                 device_shock_map = config_->device_openshock_ids;
             }
@@ -598,25 +632,17 @@ namespace StayPutVR {
                        ", Duration: " + std::to_string(action.duration) + "ms" +
                        ", Reason: " + action.reason + ")");
 
-            std::string response;
-            bool success = SendOpenShockCommandMulti(
-                server_url, api_token, device_ids_to_use,
-                static_cast<int>(action.type),
-                action.intensity, action.duration, response
-            );
-            RecordCommandResult(success);
-
-            LogAction(action, success, response);
-
-            if (action_callback_) {
-                action_callback_(ActionTypeToString(action.type), success,
-                               success ? "Action completed successfully" : response);
+            std::vector<PendingControl> controls;
+            controls.reserve(device_ids_to_use.size());
+            for (const auto& device_id : device_ids_to_use) {
+                controls.push_back({device_id, action.type, action.intensity, action.duration});
             }
+            // Logged and reported to action_callback_ once the request completes.
+            QueueControls(controls, action, /*report=*/true, 1);
 
         } catch (const std::exception& e) {
             std::string error = "OpenShock action failed: " + std::string(e.what());
             SetError(error);
-            RecordCommandResult(false);
             LogAction(action, false, error);
             if (action_callback_) {
                 action_callback_(ActionTypeToString(action.type), false, error);
@@ -624,6 +650,171 @@ namespace StayPutVR {
         }
     }
 
+    void OpenShockManager::QueueControls(const std::vector<PendingControl>& controls, const OpenShockActionData& action,
+                                         bool report, int unmerged_requests) {
+        int window_ms;
+        {
+            auto cfg_lock = config_->ReadLock();
+            window_ms = config_->openshock_coalesce_window_ms;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            for (const PendingControl& control : controls) {
+                auto it = std::find_if(pending_controls_.begin(), pending_controls_.end(),
+                                       [&control](const PendingControl& pending) { return pending.device_id == control.device_id; });
+                if (it == pending_controls_.end()) {
+                    pending_controls_.push_back(control);
+                    continue;
+                }
+                // One command per shocker. Lower types are stronger (shock,
+                // vibrate, sound); a weaker command is absorbed, and intensity
+                // and duration only ever come from commands of the winning type.
+                ++coalesce_stats_.commands_merged;
+                if (control.type < it->type) {
+                    *it = control;
+                } else if (control.type == it->type) {
+                    it->intensity = (std::max)(it->intensity, control.intensity);
+                    it->duration = (std::max)(it->duration, control.duration);
+                }
+            }
+            pending_triggers_.push_back({action, report});
+            pending_unmerged_requests_ += unmerged_requests;
+
+            if (flush_scheduled_) return;
+            flush_scheduled_ = true;
+        }
+        ArmFlushTimer(window_ms);
+    }
+
+    void OpenShockManager::ArmFlushTimer(int window_ms) {
+        EventLoop& loop = EventLoop::Shared();
+        if (!loop.IsRunning()) {
+            // Only at exit: no timer would fire, so send what we have now.
+            if (!EnqueueWork([this]() { FlushPendingControls(); })) {
+                DropPendingControls("Work queue unavailable");
+            }
+            return;
+        }
+        // Let the rest of the burst arrive before the flush is queued; the
+        // worker stays free for other jobs in the meantime.
+        std::lock_guard<std::mutex> lock(flush_timer_mutex_);
+        flush_timer_ = loop.AddTimer(std::chrono::milliseconds((std::max)(0, window_ms)), [this]() {
+            if (!EnqueueWork([this]() { FlushPendingControls(); })) {
+                DropPendingControls("Work queue unavailable");
+            }
+        });
+    }
+
+    void OpenShockManager::CancelFlushTimer() {
+        std::lock_guard<std::mutex> lock(flush_timer_mutex_);
+        if (flush_timer_ == 0) return;
+        // Waits out a callback that is already running. A timer that has
+        // fired already is a no-op to cancel.
+        EventLoop::Shared().CancelTimer(flush_timer_);
+        flush_timer_ = 0;
+    }
+
+    void OpenShockManager::DropPendingControls(const std::string& reason) {
+        std::vector<PendingTrigger> dropped;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            dropped.swap(pending_triggers_);
+            pending_controls_.clear();
+            pending_unmerged_requests_ = 0;
+            flush_scheduled_ = false;
+        }
+        if (dropped.empty()) return;
+
+        // Shutting down (or the queue is full): nothing will send these.
+        SetError("OpenShock command dropped: " + reason);
+        for (const PendingTrigger& trigger : dropped) {
+            if (!trigger.report) continue;
+            LogAction(trigger.action, false, reason);
+            if (action_callback_) {
+                action_callback_(ActionTypeToString(trigger.action.type), false, reason);
+            }
+        }
+    }
+
+    void OpenShockManager::FlushPendingControls() {
+        std::vector<PendingControl> controls;
+        std::vector<PendingTrigger> triggers;
+        int unmerged_requests;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            controls.swap(pending_controls_);
+            triggers.swap(pending_triggers_);
+            unmerged_requests = pending_unmerged_requests_;
+            pending_unmerged_requests_ = 0;
+            flush_scheduled_ = false;
+        }
+        if (controls.empty()) return;
+
+        std::string server_url, api_token;
+        {
+            auto cfg_lock = config_->ReadLock();
+            server_url = config_->openshock_server_url;
+            api_token = config_->openshock_api_token;
+        }
+
+        std::vector<OpenShockControl> request;
+        request.reserve(controls.size());
+        for (const PendingControl& control : controls) {
+            request.push_back({control.device_id, static_cast<int>(control.type), control.intensity, control.duration});
+        }
+
+        if (unmerged_requests > 1) {
+            Logger::Info("OpenShock: " + std::to_string(triggers.size()) + " trigger(s) coalesced into one request for " +
+                         std::to_string(controls.size()) + " shocker(s), " +
+                         std::to_string(unmerged_requests - 1) + " request(s) saved");
+        }
+
+        for (PendingTrigger& trigger : triggers) {
+            trigger.action.trace.Mark(TraceStage::Send);
+        }
+        std::string response;
+        bool success;
+        try {
+            success = SendOpenShockControls(server_url, api_token, request, response);
+        } catch (const std::exception& e) {
+            success = false;
+            response = "OpenShock action failed: " + std::string(e.what());
+        }
+        RecordCommandResult(success);
+        if (!success) {
+            SetError(response.empty() ? "OpenShock control request failed" : response);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            coalesce_stats_.triggers += triggers.size();
+            coalesce_stats_.requests += 1;
+            coalesce_stats_.requests_saved += static_cast<uint64_t>((std::max)(0, unmerged_requests - 1));
+        }
+
+        for (PendingTrigger& trigger : triggers) {
+            trigger.action.trace.Mark(TraceStage::Response);
+            if (success) TriggerLatency::Complete(TraceIntegration::OpenShock, trigger.action.trace);
+            if (!trigger.report) continue;
+            LogAction(trigger.action, success, response);
+            if (action_callback_) {
+                action_callback_(ActionTypeToString(trigger.action.type), success,
+                                 success ? "Action completed successfully" : response);
+            }
+        }
+    }
+
+    bool OpenShockManager::CoalescePending() const {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        return flush_scheduled_;
+    }
+
+    OpenShockManager::CoalesceStats OpenShockManager::GetCoalesceStats() const {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        return coalesce_stats_;
+    }
+
     bool OpenShockManager::ValidateCredentials() const {
         if (!config_) return false;
 
@@ -2,9 +2,15 @@
 
 #include <string>
 #include <functional>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 #include "../../../common/ShockDeviceBase.hpp"
+#include "../../../common/EventLoop.hpp"
 #include "../../../common/HttpClient.hpp"
+#include "../../../common/TriggerTrace.hpp"
 
 namespace StayPutVR {
 
@@ -19,12 +25,13 @@ namespace StayPutVR {
         int intensity;  // 1-100
         int duration;   // Duration in milliseconds (OpenShock uses ms, not seconds)
         std::string reason;
+        TriggerTrace trace; // latency trace, stamped at enqueue (inactive if untraced)
     };
 
     class OpenShockManager : public ShockDeviceBase {
     public:
         OpenShockManager();
-        ~OpenShockManager() override = default;
+        ~OpenShockManager() override;
 
         // IShockDeviceManager overrides
         bool ValidateConfiguration() const override;
@@ -38,6 +45,7 @@ namespace StayPutVR {
         // instead of a single supplied intensity (for OSC bite/shock).
         void TriggerShockIndividual(float duration_seconds, const std::string& reason = "");
         void TestActions() override;
+        void OnLockEngaged() override;
         std::string GetConnectionStatus() const override;
 
         // OpenShock-specific action methods
@@ -51,6 +59,18 @@ namespace StayPutVR {
 
         bool IsFullyConfigured() const;
 
+        // Cross-trigger coalescing counters since start. Requests saved is the
+        // number of control requests the merged triggers would have sent on
+        // their own (one per trigger, or one per shocker for the individual-
+        // intensity paths) minus the requests actually sent.
+        struct CoalesceStats {
+            uint64_t triggers = 0;         // triggers sent through the window
+            uint64_t requests = 0;         // control requests that carried them
+            uint64_t requests_saved = 0;
+            uint64_t commands_merged = 0;  // shocker commands folded into another for the same shocker
+        };
+        CoalesceStats GetCoalesceStats() const;
+
         // Configuration helpers
         static int ConvertIntensityToAPI(float normalized_intensity); // 0.0-1.0 -> 1-100
         static int ConvertDurationToAPI(float normalized_duration);   // 0.0-1.0 -> 1000-15000 (ms)
@@ -67,6 +87,43 @@ namespace StayPutVR {
         void ExecuteActionAsyncMulti(const OpenShockActionData& action, const std::string& device_serial);
         void ExecuteActionMulti(const OpenShockActionData& action, const std::string& device_serial);
 
+        // Cross-trigger coalescing. Triggers queue their per-shocker commands
+        // here instead of sending; the first one in a window arms a one-shot
+        // timer on the shared EventLoop for openshock_coalesce_window_ms. When
+        // it fires the flush is queued on the worker, which merges the commands
+        // per shocker (strongest type, then max intensity and duration) and
+        // sends them all in one control request.
+        struct PendingControl {
+            std::string device_id;
+            OpenShockActionType type;
+            int intensity;
+            int duration;
+        };
+        struct PendingTrigger {
+            OpenShockActionData action; // trace, plus what LogAction reports
+            bool report;                // LogAction and action_callback_ after the send
+        };
+        void QueueControls(const std::vector<PendingControl>& controls, const OpenShockActionData& action,
+                           bool report, int unmerged_requests);
+        void ArmFlushTimer(int window_ms);
+        void CancelFlushTimer();
+        void DropPendingControls(const std::string& reason);
+        void FlushPendingControls();
+        // A flush is scheduled, so a trigger now joins its request instead of
+        // making one of its own; such triggers are not held to the rate limit.
+        bool CoalescePending() const;
+
+        mutable std::mutex pending_mutex_;
+        std::vector<PendingControl> pending_controls_;
+        std::vector<PendingTrigger> pending_triggers_;
+        int pending_unmerged_requests_ = 0;
+        bool flush_scheduled_ = false;
+        // The window's timer. Its callback never takes flush_timer_mutex_, so
+        // CancelFlushTimer can wait on it while holding the mutex.
+        std::mutex flush_timer_mutex_;
+        EventLoop::Id flush_timer_ = 0;
+        CoalesceStats coalesce_stats_; // under pending_mutex_
+
         // Validation helpers
         bool ValidateCredentials() const;
         bool ValidateActionParameters(int intensity, int duration) const;
@@ -178,6 +178,12 @@ namespace StayPutVR {
         TriggerDisobedienceActions("TEST");
     }
 
+    void PiShockManager::OnLockEngaged() {
+        if (!IsFullyConfigured()) return;
+        // The first violation after this then skips DNS/TCP/TLS setup.
+        PrewarmPiShockConnection();
+    }
+
     void PiShockManager::SendBeep(int intensity, int duration, const std::string& reason) {
         PiShockActionData action;
         action.type = PiShockActionType::BEEP;
@@ -275,6 +281,8 @@ namespace StayPutVR {
                        ", Duration: " + std::to_string(action.duration) +
                        ", Reason: " + action.reason + ")");
 
+            TriggerTrace trace = action.trace;
+            trace.Mark(TraceStage::Send);
             std::string response;
             bool success = SendPiShockCommand(
                 username, api_key, share_code,
@@ -282,6 +290,8 @@ namespace StayPutVR {
                 action.intensity, action.duration,
                 response
             );
+            trace.Mark(TraceStage::Response);
+            if (success) TriggerLatency::Complete(TraceIntegration::PiShock, trace);
 
             LogAction(action, success, response);
             RecordCommandResult(success);
@@ -303,8 +313,11 @@ namespace StayPutVR {
     }
 
     void PiShockManager::ExecuteActionAsync(const PiShockActionData& action) {
-        EnqueueWork([this, action]() {
-            ExecuteAction(action);
+        PiShockActionData traced = action;
+        traced.trace = TriggerLatency::Current();
+        traced.trace.Mark(TraceStage::Enqueue);
+        EnqueueWork([this, traced]() {
+            ExecuteAction(traced);
         });
     }
 
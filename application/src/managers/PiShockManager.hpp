@@ -5,6 +5,7 @@
 
 #include "../../../common/ShockDeviceBase.hpp"
 #include "../../../common/HttpClient.hpp"
+#include "../../../common/TriggerTrace.hpp"
 
 namespace StayPutVR {
 
@@ -19,6 +20,7 @@ namespace StayPutVR {
         int intensity;  // 1-100
         int duration;   // 1-15 seconds
         std::string reason;
+        TriggerTrace trace; // latency trace, stamped at enqueue (inactive if untraced)
     };
 
     class PiShockManager : public ShockDeviceBase {
@@ -38,6 +40,7 @@ namespace StayPutVR {
         // intensity (for OSC bite/shock per-device-intensity option).
         void TriggerShockIndividual(float duration_seconds, const std::string& reason = "");
         void TestActions() override;
+        void OnLockEngaged() override;
         std::string GetConnectionStatus() const override;
 
         // PiShock-specific action methods
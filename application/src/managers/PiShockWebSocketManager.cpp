@@ -1,10 +1,31 @@
 #include "PiShockWebSocketManager.hpp"
+#include "../../../common/AllocationCounter.hpp"
+#include "../../../common/JsonView.hpp"
+#include <charconv>
 #include <thread>
 #include <sstream>
 #include <algorithm>
 
 namespace StayPutVR {
 
+    namespace {
+        // Whether an error response answers one of our PUBLISH messages. The
+        // broker echoes the request in OriginalCommand (as a JSON string or an
+        // object); errors without it, or for a PING, aren't tied to a publish.
+        bool AnswersPublish(const JsonView& response) {
+            const JsonView original = response["OriginalCommand"];
+            if (original.IsObject()) {
+                return original["Operation"].Equals("PUBLISH");
+            }
+            std::string original_text;
+            if (!original.GetString(original_text)) {
+                return false;
+            }
+            const JsonView command = JsonView::Parse(original_text);
+            return command["Operation"].Equals("PUBLISH");
+        }
+    }
+
     PiShockWebSocketManager::PiShockWebSocketManager()
         : config_(nullptr)
         , enabled_(false)
@@ -39,9 +60,14 @@ namespace StayPutVR {
         // Set up callbacks
         ws_client_->SetOnConnectedCallback([this]() { OnWebSocketConnected(); });
         ws_client_->SetOnDisconnectedCallback([this](const std::string& reason) { OnWebSocketDisconnected(reason); });
-        ws_client_->SetOnMessageCallback([this](const std::string& message) { OnWebSocketMessage(message); });
+        ws_client_->SetOnMessageCallback([this](std::string_view message) { OnWebSocketMessage(message); });
         ws_client_->SetOnErrorCallback([this](const std::string& error) { OnWebSocketError(error); });
 
+        {
+            std::lock_guard<std::mutex> lock(publish_mutex_);
+            RefreshPublishTemplates();
+        }
+
         work_queue_.Start();
         Logger::Info("PiShockWebSocketManager initialized");
         return true;
@@ -484,12 +510,9 @@ namespace StayPutVR {
                        ", Duration: " + std::to_string(action.duration) + "ms" +
                        ", Reason: " + action.reason + ")");
 
-            bool success = SendPublishCommand(
-                ActionTypeToMode(action.type),
-                action.intensity,
-                action.duration,
-                "StayPutVR"
-            );
+            // Single-device call: the first shocker slot.
+            const PublishTarget target{0, action.intensity};
+            bool success = SendPublishCommands(&target, 1, ActionTypeToMode(action.type), action.duration, action.trace);
             
             LogAction(action, success, success ? "Command sent" : "Failed to send command");
             
@@ -510,8 +533,11 @@ namespace StayPutVR {
     }
 
     void PiShockWebSocketManager::ExecuteActionAsync(const PiShockWSActionData& action) {
-        work_queue_.Enqueue([this, action]() {
-            ExecuteAction(action);
+        PiShockWSActionData traced = action;
+        traced.trace = TriggerLatency::Current();
+        traced.trace.Mark(TraceStage::Enqueue);
+        work_queue_.Enqueue([this, traced]() {
+            ExecuteAction(traced);
         });
     }
 
@@ -562,12 +588,17 @@ namespace StayPutVR {
             Logger::Debug("User ID API response: " + response);
 
             // Parse JSON response
-            nlohmann::json json_response = nlohmann::json::parse(response);
+            std::string parse_error;
+            const JsonView json_response = JsonView::Parse(response, &parse_error);
+            if (!json_response) {
+                Logger::Error("Failed to fetch User ID: " + parse_error);
+                return false;
+            }
 
             // Check if response contains user ID
-            if (json_response.contains("UserId")) {
-                if (json_response["UserId"].is_number()) {
-                    config_->pishock_user_id = json_response["UserId"].get<int>();
+            if (const JsonView user_id = json_response["UserId"]) {
+                if (user_id.IsNumber()) {
+                    config_->pishock_user_id = static_cast<int>(user_id.AsInt());
                 } else {
                     Logger::Error("User ID field has unexpected type (expected integer)");
                     return false;
@@ -613,13 +644,13 @@ namespace StayPutVR {
         }
     }
 
-    std::string PiShockWebSocketManager::ActionTypeToMode(PiShockWSActionType type) const {
+    char PiShockWebSocketManager::ActionTypeToMode(PiShockWSActionType type) const {
         switch (type) {
-            case PiShockWSActionType::BEEP: return "b";
-            case PiShockWSActionType::VIBRATE: return "v";
-            case PiShockWSActionType::SHOCK: return "s";
-            case PiShockWSActionType::STOP: return "e";
-            default: return "e";
+            case PiShockWSActionType::BEEP: return 'b';
+            case PiShockWSActionType::VIBRATE: return 'v';
+            case PiShockWSActionType::SHOCK: return 's';
+            case PiShockWSActionType::STOP: return 'e';
+            default: return 'e';
         }
     }
 
@@ -627,6 +658,12 @@ namespace StayPutVR {
     void PiShockWebSocketManager::OnWebSocketConnected() {
         connected_ = true;
         Logger::Info("PiShock WebSocket connected successfully");
+
+        // Connect() may have just fetched the user id the templates embed.
+        {
+            std::lock_guard<std::mutex> lock(publish_mutex_);
+            RefreshPublishTemplates();
+        }
         
         // Send initial ping
         SendPing();
@@ -635,39 +672,62 @@ namespace StayPutVR {
 
     void PiShockWebSocketManager::OnWebSocketDisconnected(const std::string& reason) {
         connected_ = false;
+        {
+            std::lock_guard<std::mutex> lock(trace_mutex_);
+            pending_publish_traces_.clear();
+        }
         Logger::Warning("PiShock WebSocket disconnected: " + reason);
         SetError("Disconnected: " + reason);
     }
 
-    void PiShockWebSocketManager::OnWebSocketMessage(const std::string& message) {
-        try {
-            nlohmann::json response = nlohmann::json::parse(message);
-            
-            // Log the response
-            Logger::Debug("PiShock WebSocket response: " + message);
-            
-            // Check for errors
-            if (response.contains("IsError") && response["IsError"].get<bool>()) {
-                std::string error_msg = response.value("Message", "Unknown error");
-                Logger::Error("PiShock WebSocket error response: " + error_msg);
-                SetError(error_msg);
+    void PiShockWebSocketManager::OnWebSocketMessage(std::string_view message) {
+        AllocationScope alloc_scope(AllocTag::WebSocket);
+        std::string parse_error;
+        const JsonView response = JsonView::Parse(message, &parse_error);
+        if (!response) {
+            Logger::Error("Failed to parse PiShock WebSocket message: " + parse_error);
+            return;
+        }
+
+        // Pongs and publish acks arrive constantly; don't build log lines
+        // nobody will see.
+        const bool debug = Logger::IsEnabled(Logger::LogLevel::DEBUG);
+        if (debug) {
+            Logger::Debug("PiShock WebSocket response: " + std::string(message));
+        }
+
+        // Check for errors
+        if (response["IsError"].AsBool()) {
+            std::string error_msg = response["Message"].AsString("Unknown error");
+            Logger::Error("PiShock WebSocket error response: " + error_msg);
+            SetError(error_msg);
+            // A rejected publish still consumes its slot in the ack FIFO; any
+            // other error leaves the FIFO aligned with the outstanding publishes.
+            if (AnswersPublish(response)) {
+                std::lock_guard<std::mutex> lock(trace_mutex_);
+                if (!pending_publish_traces_.empty()) pending_publish_traces_.pop_front();
             }
-            else if (response.contains("Message")) {
-                std::string msg = response["Message"].get<std::string>();
-                
-                if (msg == "PONG") {
-                    Logger::Debug("PiShock WebSocket PONG received");
-                }
-                else if (msg == "Publish successful.") {
-                    Logger::Debug("PiShock WebSocket publish successful");
-                }
-                else {
-                    Logger::Info("PiShock WebSocket message: " + msg);
+        }
+        else if (const JsonView msg = response["Message"]; msg.IsString()) {
+            if (msg.Equals("PONG")) {
+                if (debug) Logger::Debug("PiShock WebSocket PONG received");
+            }
+            else if (msg.Equals("Publish successful.")) {
+                if (debug) Logger::Debug("PiShock WebSocket publish successful");
+                TriggerTrace trace;
+                {
+                    std::lock_guard<std::mutex> lock(trace_mutex_);
+                    if (!pending_publish_traces_.empty()) {
+                        trace = pending_publish_traces_.front();
+                        pending_publish_traces_.pop_front();
+                    }
                 }
+                trace.Mark(TraceStage::Response);
+                TriggerLatency::Complete(TraceIntegration::PiShockWS, trace);
+            }
+            else {
+                Logger::Info("PiShock WebSocket message: " + msg.AsString());
             }
-            
-        } catch (const std::exception& e) {
-            Logger::Error("Failed to parse PiShock WebSocket message: " + std::string(e.what()));
         }
     }
 
@@ -682,72 +742,110 @@ namespace StayPutVR {
             return false;
         }
 
-        nlohmann::json ping_msg;
-        ping_msg["Operation"] = "PING";
-        ping_msg["Targets"] = nullptr;
-        ping_msg["PublishCommands"] = nullptr;
-        
-        std::string msg = ping_msg.dump();
-        Logger::Debug("Sending PiShock WebSocket PING: " + msg);
-        
-        return ws_client_->SendText(msg);
+        // The server expects Targets and PublishCommands in every message.
+        static constexpr std::string_view kPing = R"({"Operation":"PING","PublishCommands":null,"Targets":null})";
+        if (Logger::IsEnabled(Logger::LogLevel::DEBUG)) {
+            Logger::Debug("Sending PiShock WebSocket PING: " + std::string(kPing));
+        }
+
+        return ws_client_->SendText(kPing);
     }
 
-    bool PiShockWebSocketManager::SendPublishCommand(
-        const std::string& mode, 
-        int intensity, 
-        int duration, 
-        const std::string& origin) {
-        
+    void PiShockWebSocketManager::RefreshPublishTemplates() {
+        if (!config_) return;
+
+        std::array<int, 5> shocker_ids;
+        int user_id;
+        std::string target;
+        {
+            auto cfg_lock = config_->ReadLock();
+            shocker_ids = config_->pishock_shocker_ids;
+            user_id = config_->pishock_user_id;
+            if (publish_templates_.built && shocker_ids == publish_templates_.shocker_ids &&
+                user_id == publish_templates_.user_id && config_->pishock_client_id == publish_templates_.client_id) {
+                return;
+            }
+            publish_templates_.client_id = config_->pishock_client_id;
+            target = GetChannelTarget();
+        }
+        publish_templates_.shocker_ids = shocker_ids;
+        publish_templates_.user_id = user_id;
+
+        // Same bytes json::dump() produced for the old per-send DOM (keys in
+        // sorted order); the Body is an object, not a string, in the v2 API.
+        // "ty" is "api" for direct API access ("sc" would be a share code).
+        const std::string log_data = R"("l":{"h":false,"o":"StayPutVR","ty":"api","u":)" +
+                                     std::to_string(user_id) + R"(,"w":false})";
+        for (size_t slot = 0; slot < shocker_ids.size(); ++slot) {
+            publish_templates_.shocker_segments[slot] =
+                R"(,"id":)" + std::to_string(shocker_ids[slot]) + "," + log_data + R"(,"m":")";
+        }
+        publish_templates_.command_tail =
+            R"(","r":true},"Target":)" + nlohmann::json(target).dump() + "}";
+        publish_templates_.built = true;
+    }
+
+    bool PiShockWebSocketManager::SendPublishCommands(
+        const PublishTarget* targets,
+        size_t count,
+        char mode,
+        int duration,
+        const TriggerTrace& trace) {
+
         if (!ws_client_ || !connected_) {
             SetError("WebSocket not connected");
             return false;
         }
 
-        try {
-            // Get the channel target
-            std::string target = GetChannelTarget();
-            
-            // Build the command body
-            nlohmann::json body;
-            body["id"] = config_->pishock_shocker_ids[0];  // Use first shocker for legacy single-device call 
-            body["m"] = mode;
-            body["i"] = intensity;
-            body["d"] = duration;
-            body["r"] = true;
-            
-            // Log metadata
-            nlohmann::json log_data;
-            log_data["u"] = config_->pishock_user_id;
-            log_data["ty"] = "api";  // "sc" for ShareCode, "api" for direct API access
-            log_data["w"] = false;
-            log_data["h"] = false;
-            log_data["o"] = origin;
-            
-            body["l"] = log_data;
-            
-            // Build the publish command
-            // V2 API requires Body as a JSON object (NOT stringified)
-            nlohmann::json command_obj;
-            command_obj["Target"] = target;
-            command_obj["Body"] = body;  // Body as object, not string
-            
-            // Build the full message
-            // The server expects BOTH Targets and PublishCommands in every message
-            // For PUBLISH: Targets contains the channel, PublishCommands has the command data
-            nlohmann::json message;
-            message["Operation"] = "PUBLISH";
-            message["PublishCommands"] = nlohmann::json::array({command_obj});
-            
-            std::string msg = message.dump();
+        std::lock_guard<std::mutex> lock(publish_mutex_);
+        RefreshPublishTemplates();
+
+        char duration_text[16];
+        char* duration_end = std::to_chars(duration_text, duration_text + sizeof(duration_text), duration).ptr;
+
+        std::string& msg = publish_buffer_;
+        msg.assign(R"({"Operation":"PUBLISH","PublishCommands":[)");
+        for (size_t i = 0; i < count; ++i) {
+            char intensity_text[16];
+            char* intensity_end =
+                std::to_chars(intensity_text, intensity_text + sizeof(intensity_text), targets[i].intensity).ptr;
+
+            if (i > 0) msg += ',';
+            msg += R"({"Body":{"d":)";
+            msg.append(duration_text, duration_end);
+            msg += R"(,"i":)";
+            msg.append(intensity_text, intensity_end);
+            msg += publish_templates_.shocker_segments[targets[i].slot];
+            msg += mode;
+            msg += publish_templates_.command_tail;
+        }
+        msg += "]}";
+
+        if (Logger::IsEnabled(Logger::LogLevel::DEBUG)) {
             Logger::Debug("Sending PiShock WebSocket PUBLISH: " + msg);
-            
-            return ws_client_->SendText(msg);
-            
-        } catch (const std::exception& e) {
-            SetError("Failed to build publish command: " + std::string(e.what()));
+        }
+
+        return SendPublishMessage(msg, trace, PublishPriority(mode));
+    }
+
+    SendPriority PiShockWebSocketManager::PublishPriority(char mode) {
+        // A stop jumps the outbound queue. Nothing is keyed for superseding:
+        // every shock, vibrate and beep is a discrete action that must arrive.
+        return mode == 'e' ? SendPriority::Urgent : SendPriority::Normal;
+    }
+
+    bool PiShockWebSocketManager::SendPublishMessage(std::string_view msg, TriggerTrace trace, SendPriority priority) {
+        // Send is stamped at enqueue; the writer thread puts it on the wire.
+        trace.Mark(TraceStage::Send);
+        if (!ws_client_->SendText(msg, priority)) {
             return false;
         }
+        std::lock_guard<std::mutex> lock(trace_mutex_);
+        if (pending_publish_traces_.size() >= MAX_PENDING_TRACES) {
+            pending_publish_traces_.pop_front(); // server never acked; drop the oldest
+        }
+        pending_publish_traces_.push_back(trace);
+        return true;
     }
 
     std::string PiShockWebSocketManager::GetChannelTarget() const {
@@ -770,6 +868,10 @@ namespace StayPutVR {
 
         // Rate limiting is applied once per event by the Trigger* methods.
 
+        // These send synchronously on the caller's thread; "enqueue" is entry.
+        TriggerTrace trace = TriggerLatency::Current();
+        trace.Mark(TraceStage::Enqueue);
+
         try {
             // Determine which shocker devices to use
             std::vector<int> shocker_ids_to_use;
@@ -812,7 +914,11 @@ namespace StayPutVR {
 
             // Send command to all selected devices using multiple entries in a single message
             int duration_ms = (std::max)(1, (std::min)(15, duration)) * 1000;
-            bool success = SendPublishCommandMulti(shocker_ids_to_use, "b", 0, duration_ms, "StayPutVR");
+            std::array<PublishTarget, 5> targets;
+            for (size_t i = 0; i < device_indices.size(); ++i) {
+                targets[i] = {device_indices[i], 0};
+            }
+            bool success = SendPublishCommands(targets.data(), device_indices.size(), 'b', duration_ms, trace);
             
             if (action_callback_) {
                 action_callback_("Beep", success, success ? "Action sent successfully" : "Failed to send");
@@ -837,6 +943,10 @@ namespace StayPutVR {
 
         // Rate limiting is applied once per event by the Trigger* methods.
 
+        // These send synchronously on the caller's thread; "enqueue" is entry.
+        TriggerTrace trace = TriggerLatency::Current();
+        trace.Mark(TraceStage::Enqueue);
+
         try {
             // Determine which shocker devices to use
             std::vector<int> shocker_ids_to_use;
@@ -874,8 +984,8 @@ namespace StayPutVR {
                 return;
             }
 
-            // Send individual commands to each device with their specific intensity
-            std::vector<nlohmann::json> commands;
+            // One command per device, each at its own intensity, in a single message
+            std::array<PublishTarget, 5> targets;
             for (size_t i = 0; i < shocker_ids_to_use.size(); ++i) {
                 int device_index = device_indices[i];
                 int intensity;
@@ -898,39 +1008,10 @@ namespace StayPutVR {
                            " (Intensity: " + std::to_string(intensity) + 
                            ", Duration: " + std::to_string(duration) + "ms)");
 
-                // Build command for this device
-                nlohmann::json body;
-                body["id"] = shocker_ids_to_use[i];
-                body["m"] = "v";  // vibrate
-                body["i"] = intensity;
-                body["d"] = duration;
-                body["r"] = true;
-                
-                nlohmann::json log_data;
-                log_data["u"] = config_->pishock_user_id;
-                log_data["ty"] = "api";
-                log_data["w"] = false;
-                log_data["h"] = false;
-                log_data["o"] = "StayPutVR";
-                
-                body["l"] = log_data;
-                
-                nlohmann::json command_obj;
-                command_obj["Target"] = GetChannelTarget();
-                command_obj["Body"] = body;
-                
-                commands.push_back(command_obj);
+                targets[i] = {device_index, intensity};
             }
 
-            // Send all commands in a single message
-            nlohmann::json message;
-            message["Operation"] = "PUBLISH";
-            message["PublishCommands"] = commands;
-            
-            std::string msg = message.dump();
-            Logger::Debug("Sending PiShock multi-device PUBLISH: " + msg);
-            
-            bool success = ws_client_->SendText(msg);
+            bool success = SendPublishCommands(targets.data(), shocker_ids_to_use.size(), 'v', duration, trace);
             
             if (action_callback_) {
                 action_callback_("Vibrate", success, success ? "Action sent successfully" : "Failed to send");
@@ -966,6 +1047,10 @@ namespace StayPutVR {
 
         // Rate limiting is applied once per event by the Trigger* methods.
 
+        // These send synchronously on the caller's thread; "enqueue" is entry.
+        TriggerTrace trace = TriggerLatency::Current();
+        trace.Mark(TraceStage::Enqueue);
+
         try {
             // Determine which shocker devices to use
             std::vector<int> shocker_ids_to_use;
@@ -1003,8 +1088,8 @@ namespace StayPutVR {
                 return;
             }
 
-            // Send individual commands to each device with their specific intensity
-            std::vector<nlohmann::json> commands;
+            // One command per device, each at its own intensity, in a single message
+            std::array<PublishTarget, 5> targets;
             for (size_t i = 0; i < shocker_ids_to_use.size(); ++i) {
                 int device_index = device_indices[i];
                 int intensity;
@@ -1027,39 +1112,10 @@ namespace StayPutVR {
                            " (Intensity: " + std::to_string(intensity) + 
                            ", Duration: " + std::to_string(duration) + "ms)");
 
-                // Build command for this device
-                nlohmann::json body;
-                body["id"] = shocker_ids_to_use[i];
-                body["m"] = "s";  // shock
-                body["i"] = intensity;
-                body["d"] = duration;
-                body["r"] = true;
-                
-                nlohmann::json log_data;
-                log_data["u"] = config_->pishock_user_id;
-                log_data["ty"] = "api";
-                log_data["w"] = false;
-                log_data["h"] = false;
-                log_data["o"] = "StayPutVR";
-                
-                body["l"] = log_data;
-                
-                nlohmann::json command_obj;
-                command_obj["Target"] = GetChannelTarget();
-                command_obj["Body"] = body;
-                
-                commands.push_back(command_obj);
+                targets[i] = {device_index, intensity};
             }
 
-            // Send all commands in a single message
-            nlohmann::json message;
-            message["Operation"] = "PUBLISH";
-            message["PublishCommands"] = commands;
-            
-            std::string msg = message.dump();
-            Logger::Debug("Sending PiShock multi-device PUBLISH: " + msg);
-            
-            bool success = ws_client_->SendText(msg);
+            bool success = SendPublishCommands(targets.data(), shocker_ids_to_use.size(), 's', duration, trace);
             
             if (action_callback_) {
                 action_callback_("Shock", success, success ? "Action sent successfully" : "Failed to send");
@@ -1071,63 +1127,5 @@ namespace StayPutVR {
         }
     }
 
-    bool PiShockWebSocketManager::SendPublishCommandMulti(
-        const std::vector<int>& shocker_ids,
-        const std::string& mode, 
-        int intensity, 
-        int duration, 
-        const std::string& origin) {
-        
-        if (!ws_client_ || !connected_) {
-            SetError("WebSocket not connected");
-            return false;
-        }
-
-        try {
-            std::vector<nlohmann::json> commands;
-            
-            for (int shocker_id : shocker_ids) {
-                // Build the command body
-                nlohmann::json body;
-                body["id"] = shocker_id;
-                body["m"] = mode;
-                body["i"] = intensity;
-                body["d"] = duration;
-                body["r"] = true;
-                
-                // Log metadata
-                nlohmann::json log_data;
-                log_data["u"] = config_->pishock_user_id;
-                log_data["ty"] = "api";
-                log_data["w"] = false;
-                log_data["h"] = false;
-                log_data["o"] = origin;
-                
-                body["l"] = log_data;
-                
-                // Build the publish command
-                nlohmann::json command_obj;
-                command_obj["Target"] = GetChannelTarget();
-                command_obj["Body"] = body;
-                
-                commands.push_back(command_obj);
-            }
-            
-            // Build the full message
-            nlohmann::json message;
-            message["Operation"] = "PUBLISH";
-            message["PublishCommands"] = commands;
-            
-            std::string msg = message.dump();
-            Logger::Debug("Sending PiShock WebSocket multi PUBLISH: " + msg);
-            
-            return ws_client_->SendText(msg);
-            
-        } catch (const std::exception& e) {
-            SetError("Failed to build publish command: " + std::string(e.what()));
-            return false;
-        }
-    }
-
 } // namespace StayPutVR
 
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <array>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <atomic>
 #include <chrono>
 #include <functional>
 #include <mutex>
+#include <deque>
 
 #include "../../../common/Config.hpp"
 #include "../../../common/Logger.hpp"
@@ -13,6 +16,7 @@
 #include "../../../common/HttpClient.hpp"
 #include "../../../common/AsyncWorkQueue.hpp"
 #include "../../../common/LinkStatus.hpp"
+#include "../../../common/TriggerTrace.hpp"
 #include <nlohmann/json.hpp>
 
 namespace StayPutVR {
@@ -32,6 +36,7 @@ namespace StayPutVR {
         int intensity;  // 1-100
         int duration;   // milliseconds (converted from seconds)
         std::string reason;
+        TriggerTrace trace; // latency trace, stamped at enqueue (inactive if untraced)
     };
 
     class PiShockWebSocketManager {
@@ -80,6 +85,7 @@ namespace StayPutVR {
         std::string GetConnectionStatus() const;
         std::string GetLastError() const { return last_error_; }
         bool CanTriggerAction() const; // Rate limiting check
+        WebSocketClient::SendStats GetSendStats() const { return ws_client_ ? ws_client_->GetSendStats() : WebSocketClient::SendStats{}; }
         
         // Event callbacks
         void SetActionCallback(PiShockWSActionCallback callback) { action_callback_ = callback; }
@@ -132,10 +138,17 @@ namespace StayPutVR {
         // Bounded async work queue (replaces detached threads)
         AsyncWorkQueue work_queue_;
 
+        // Latency traces of PUBLISH messages awaiting "Publish successful."
+        // The server acks publishes in order, so this is a FIFO; untraced
+        // publishes are queued too (inactive traces) to keep acks aligned.
+        std::mutex trace_mutex_;
+        std::deque<TriggerTrace> pending_publish_traces_;
+        static constexpr size_t MAX_PENDING_TRACES = 32;
+
         // WebSocket callbacks
         void OnWebSocketConnected();
         void OnWebSocketDisconnected(const std::string& reason);
-        void OnWebSocketMessage(const std::string& message);
+        void OnWebSocketMessage(std::string_view message);
         void OnWebSocketError(const std::string& error);
         
         // Internal methods
@@ -155,10 +168,38 @@ namespace StayPutVR {
         bool ValidateActionParameters(int intensity, int duration) const;
         bool FetchUserId();  // Fetch User ID from PiShock API
         
+        // Pre-serialized PUBLISH commands. Everything in a command except the
+        // intensity, duration and mode is fixed by the configuration, so each
+        // shocker slot's command is kept as text around those three values and
+        // a publish is assembled by splicing them in. Built at Initialize() and
+        // on connect, and rebuilt at send time if the shocker ids, user id or
+        // client id have changed since.
+        struct PublishTarget {
+            int slot;      // index into pishock_shocker_ids
+            int intensity; // API intensity (0..100)
+        };
+        struct PublishTemplates {
+            bool built = false;
+            std::array<int, 5> shocker_ids{};
+            int user_id = 0;
+            std::string client_id;
+            // ,"id":<id>,"l":{...},"m":"  -- between the intensity and the mode
+            std::array<std::string, 5> shocker_segments;
+            // ","r":true},"Target":"c<client>-ops"}  -- after the mode
+            std::string command_tail;
+        };
+        std::mutex publish_mutex_;
+        PublishTemplates publish_templates_; // under publish_mutex_
+        std::string publish_buffer_;         // under publish_mutex_
+        void RefreshPublishTemplates();      // under publish_mutex_
+
         // WebSocket protocol methods
         bool SendPing();
-        bool SendPublishCommand(const std::string& mode, int intensity, int duration, const std::string& origin);
-        bool SendPublishCommandMulti(const std::vector<int>& shocker_ids, const std::string& mode, int intensity, int duration, const std::string& origin);
+        // One PUBLISH carrying a command for every target, sent as one message.
+        bool SendPublishCommands(const PublishTarget* targets, size_t count, char mode, int duration, const TriggerTrace& trace);
+        // Queue a serialized PUBLISH and its trace for the server's ack.
+        bool SendPublishMessage(std::string_view msg, TriggerTrace trace, SendPriority priority = SendPriority::Normal);
+        static SendPriority PublishPriority(char mode);
         std::string GetChannelTarget() const;
         
         // Multi-device methods
@@ -171,7 +212,7 @@ namespace StayPutVR {
         // Logging helpers
         void LogAction(const PiShockWSActionData& action, bool success, const std::string& response) const;
         std::string ActionTypeToString(PiShockWSActionType type) const;
-        std::string ActionTypeToMode(PiShockWSActionType type) const;
+        char ActionTypeToMode(PiShockWSActionType type) const;
     };
 
 } // namespace StayPutVR
@@ -1,4 +1,5 @@
 #include "TwitchManager.hpp"
+#include "../../../common/AllocationCounter.hpp"
 #include <sstream>
 #include <iomanip>
 #include <random>
@@ -299,32 +300,32 @@ namespace StayPutVR {
             return false;
         }
 
-        try {
-            nlohmann::json response_json = nlohmann::json::parse(response);
-            
-            if (response_json.contains("access_token")) {
-                std::string new_access = response_json["access_token"];
-                std::string new_refresh = response_json.value("refresh_token", "");
-                int expires_in = response_json.value("expires_in", 3600);
-                auto expiry = std::chrono::steady_clock::now() + std::chrono::seconds(expires_in);
+        std::string parse_error;
+        const JsonView response_json = JsonView::Parse(response, &parse_error);
+        if (!response_json) {
+            SetError("Failed to parse OAuth response: " + parse_error);
+            return false;
+        }
 
-                SetTokens(new_access, new_refresh, expiry);
+        if (const JsonView access_token = response_json["access_token"]; access_token.IsString()) {
+            std::string new_access = access_token.AsString();
+            std::string new_refresh = response_json["refresh_token"].AsString();
+            int64_t expires_in = response_json["expires_in"].AsInt(3600);
+            auto expiry = std::chrono::steady_clock::now() + std::chrono::seconds(expires_in);
 
-                // Store tokens in config for persistence
-                config_->twitch_access_token = new_access;
-                config_->twitch_refresh_token = new_refresh;
-                
-                if (Logger::IsInitialized()) {
-                    Logger::Info("Successfully obtained Twitch access token");
-                }
-                
-                return true;
-            } else {
-                SetError("No access token in OAuth response");
-                return false;
+            SetTokens(new_access, new_refresh, expiry);
+
+            // Store tokens in config for persistence
+            config_->twitch_access_token = new_access;
+            config_->twitch_refresh_token = new_refresh;
+            
+            if (Logger::IsInitialized()) {
+                Logger::Info("Successfully obtained Twitch access token");
             }
-        } catch (const std::exception& e) {
-            SetError("Failed to parse OAuth response: " + std::string(e.what()));
+            
+            return true;
+        } else {
+            SetError("No access token in OAuth response");
             return false;
         }
     }
@@ -386,33 +387,33 @@ namespace StayPutVR {
             return false;
         }
 
-        try {
-            nlohmann::json response_json = nlohmann::json::parse(response);
+        std::string parse_error;
+        const JsonView response_json = JsonView::Parse(response, &parse_error);
+        if (!response_json) {
+            SetError("Failed to parse refresh response: " + parse_error);
+            return false;
+        }
+
+        if (const JsonView access_token = response_json["access_token"]; access_token.IsString()) {
+            std::string new_access = access_token.AsString();
+            std::string new_refresh = response_json["refresh_token"].AsString(
+                GetRefreshTokenCopy()); // Keep old if not provided
+            int64_t expires_in = response_json["expires_in"].AsInt(3600);
+            auto expiry = std::chrono::steady_clock::now() + std::chrono::seconds(expires_in);
+
+            SetTokens(new_access, new_refresh, expiry);
+
+            // Update config
+            config_->twitch_access_token = new_access;
+            config_->twitch_refresh_token = new_refresh;
             
-            if (response_json.contains("access_token")) {
-                std::string new_access = response_json["access_token"];
-                std::string new_refresh = response_json.value("refresh_token",
-                                                              GetRefreshTokenCopy()); // Keep old if not provided
-                int expires_in = response_json.value("expires_in", 3600);
-                auto expiry = std::chrono::steady_clock::now() + std::chrono::seconds(expires_in);
-
-                SetTokens(new_access, new_refresh, expiry);
-
-                // Update config
-                config_->twitch_access_token = new_access;
-                config_->twitch_refresh_token = new_refresh;
-                
-                if (Logger::IsInitialized()) {
-                    Logger::Info("Successfully refreshed Twitch access token");
-                }
-                
-                return true;
-            } else {
-                SetError("No access token in refresh response");
-                return false;
+            if (Logger::IsInitialized()) {
+                Logger::Info("Successfully refreshed Twitch access token");
             }
-        } catch (const std::exception& e) {
-            SetError("Failed to parse refresh response: " + std::string(e.what()));
+            
+            return true;
+        } else {
+            SetError("No access token in refresh response");
             return false;
         }
     }
@@ -590,35 +591,41 @@ namespace StayPutVR {
     }
 
     void TwitchManager::ProcessEventSubMessage(const std::string& message) {
-        try {
-            nlohmann::json json_message = nlohmann::json::parse(message);
-            
-            if (!json_message.contains("metadata") || !json_message.contains("payload")) {
-                return;
-            }
-
-            std::string message_type = json_message["metadata"].value("message_type", "");
-            
-            if (message_type == "notification") {
-                std::string subscription_type = json_message["metadata"].value("subscription_type", "");
-                
-                TwitchEventData event;
-                event.event_type = subscription_type;
-                
-                if (subscription_type == "channel.cheer" && ParseBitsEvent(message, event)) {
-                    ProcessEventSubEvent(event);
-                } else if (subscription_type == "channel.subscribe" && ParseSubscriptionEvent(message, event)) {
-                    ProcessEventSubEvent(event);
-                } else if (subscription_type == "channel.subscription.gift" && ParseSubscriptionEvent(message, event)) {
-                    ProcessEventSubEvent(event);
-                } else if (subscription_type == "channel.channel_points_custom_reward_redemption.add" && ParseDonationEvent(message, event)) {
-                    ProcessEventSubEvent(event);
-                }
-            }
-        } catch (const std::exception& e) {
+        AllocationScope alloc_scope(AllocTag::WebSocket);
+        std::string parse_error;
+        const JsonView json_message = JsonView::Parse(message, &parse_error);
+        if (!json_message) {
             if (Logger::IsInitialized()) {
-                Logger::Error("Failed to process EventSub message: " + std::string(e.what()));
+                Logger::Error("Failed to process EventSub message: " + parse_error);
             }
+            return;
+        }
+
+        const JsonView metadata = json_message["metadata"];
+        const JsonView payload = json_message["payload"];
+        if (!metadata || !payload) {
+            return;
+        }
+
+        // Keepalives and the rest carry nothing to act on.
+        if (!metadata["message_type"].Equals("notification")) {
+            return;
+        }
+
+        const JsonView subscription_type = metadata["subscription_type"];
+        const JsonView event_data = payload["event"];
+
+        TwitchEventData event;
+        event.event_type = subscription_type.AsString();
+
+        if (subscription_type.Equals("channel.cheer") && ParseBitsEvent(event_data, event)) {
+            ProcessEventSubEvent(event);
+        } else if (subscription_type.Equals("channel.subscribe") && ParseSubscriptionEvent(event_data, event)) {
+            ProcessEventSubEvent(event);
+        } else if (subscription_type.Equals("channel.subscription.gift") && ParseSubscriptionEvent(event_data, event)) {
+            ProcessEventSubEvent(event);
+        } else if (subscription_type.Equals("channel.channel_points_custom_reward_redemption.add") && ParseDonationEvent(event_data, event)) {
+            ProcessEventSubEvent(event);
         }
     }
 
@@ -775,29 +782,29 @@ namespace StayPutVR {
             return false;
         }
 
-        try {
-            // Parse the response to make sure it's valid
-            nlohmann::json response_json = nlohmann::json::parse(response);
-            
-            // If we get a "data" array, the token is valid
-            if (response_json.contains("data") && response_json["data"].is_array()) {
-                if (Logger::IsInitialized()) {
-                    Logger::Debug("Access token validation successful");
-                }
-                
-                // Also validate token scopes for IRC chat
-                ValidateTokenScopes();
-                
-                return true;
-            } else {
-                if (Logger::IsInitialized()) {
-                    Logger::Debug("Access token validation failed: invalid response format");
-                }
-                return false;
+        // Parse the response to make sure it's valid
+        std::string parse_error;
+        const JsonView response_json = JsonView::Parse(response, &parse_error);
+        if (!response_json) {
+            if (Logger::IsInitialized()) {
+                Logger::Error("Failed to parse token validation response: " + parse_error);
             }
-        } catch (const std::exception& e) {
+            return false;
+        }
+
+        // If we get a "data" array, the token is valid
+        if (response_json["data"].IsArray()) {
             if (Logger::IsInitialized()) {
-                Logger::Error("Failed to parse token validation response: " + std::string(e.what()));
+                Logger::Debug("Access token validation successful");
+            }
+            
+            // Also validate token scopes for IRC chat
+            ValidateTokenScopes();
+            
+            return true;
+        } else {
+            if (Logger::IsInitialized()) {
+                Logger::Debug("Access token validation failed: invalid response format");
             }
             return false;
         }
@@ -823,48 +830,47 @@ namespace StayPutVR {
             return false;
         }
 
-        try {
-            nlohmann::json response_json = nlohmann::json::parse(response);
-            
-            if (response_json.contains("scopes") && response_json["scopes"].is_array()) {
-                std::vector<std::string> scopes;
-                for (const auto& scope : response_json["scopes"]) {
-                    scopes.push_back(scope.get<std::string>());
-                }
-                
-                if (Logger::IsInitialized()) {
-                    std::string scope_list;
-                    for (const auto& scope : scopes) {
-                        if (!scope_list.empty()) scope_list += ", ";
-                        scope_list += scope;
-                    }
-                    Logger::Info("Token scopes: " + scope_list);
-                }
-                
-                // Check for required IRC chat scopes
-                bool has_chat_read = std::find(scopes.begin(), scopes.end(), "chat:read") != scopes.end();
-                bool has_chat_edit = std::find(scopes.begin(), scopes.end(), "chat:edit") != scopes.end();
-                
-                if (!has_chat_read || !has_chat_edit) {
-                    if (Logger::IsInitialized()) {
-                        Logger::Warning("Token missing required IRC chat scopes (chat:read, chat:edit)");
-                        Logger::Warning("Current token was authorized with old scopes - re-authorization needed");
-                    }
-                    return false;
-                } else {
-                    if (Logger::IsInitialized()) {
-                        Logger::Info("Token has required IRC chat scopes");
-                    }
-                    return true;
-                }
-            }
-        } catch (const std::exception& e) {
+        std::string parse_error;
+        const JsonView response_json = JsonView::Parse(response, &parse_error);
+        if (!response_json) {
             if (Logger::IsInitialized()) {
-                Logger::Error("Failed to parse scope validation response: " + std::string(e.what()));
+                Logger::Error("Failed to parse scope validation response: " + parse_error);
             }
+            return false;
         }
 
-        return false;
+        const JsonView scopes = response_json["scopes"];
+        if (!scopes.IsArray()) {
+            return false;
+        }
+
+        // Check for required IRC chat scopes
+        bool has_chat_read = false;
+        bool has_chat_edit = false;
+        std::string scope_list;
+        scopes.ForEach([&](const JsonView& scope) {
+            has_chat_read = has_chat_read || scope.Equals("chat:read");
+            has_chat_edit = has_chat_edit || scope.Equals("chat:edit");
+            if (!scope_list.empty()) scope_list += ", ";
+            scope_list += scope.AsString();
+        });
+
+        if (Logger::IsInitialized()) {
+            Logger::Info("Token scopes: " + scope_list);
+        }
+
+        if (!has_chat_read || !has_chat_edit) {
+            if (Logger::IsInitialized()) {
+                Logger::Warning("Token missing required IRC chat scopes (chat:read, chat:edit)");
+                Logger::Warning("Current token was authorized with old scopes - re-authorization needed");
+            }
+            return false;
+        } else {
+            if (Logger::IsInitialized()) {
+                Logger::Info("Token has required IRC chat scopes");
+            }
+            return true;
+        }
     }
 
     void TwitchManager::EventSubWorker() {
@@ -1488,76 +1494,33 @@ namespace StayPutVR {
         return true; // Placeholder
     }
 
-    bool TwitchManager::ParseDonationEvent(const std::string& json, TwitchEventData& event) {
-        try {
-            nlohmann::json j = nlohmann::json::parse(json);
-            
-            if (j.contains("payload") && j["payload"].contains("event")) {
-                auto event_data = j["payload"]["event"];
-                
-                event.username = event_data.value("user_name", "");
-                event.message = event_data.value("user_input", "");
-                
-                // For channel points, we might need to map reward cost to dollar amount
-                // This is a simplified approach
-                if (event_data.contains("reward") && event_data["reward"].contains("cost")) {
-                    int cost = event_data["reward"]["cost"];
-                    event.amount = cost / 100.0f; // Convert points to approximate dollar value
-                }
-                
-                return !event.username.empty();
-            }
-        } catch (const std::exception& e) {
-            if (Logger::IsInitialized()) {
-                Logger::Error("Failed to parse donation event: " + std::string(e.what()));
-            }
+    bool TwitchManager::ParseDonationEvent(const JsonView& event_data, TwitchEventData& event) {
+        event.username = event_data["user_name"].AsString();
+        event.message = event_data["user_input"].AsString();
+
+        // For channel points, we might need to map reward cost to dollar amount
+        // This is a simplified approach
+        if (const JsonView cost = event_data["reward"]["cost"]; cost.IsNumber()) {
+            event.amount = static_cast<int>(cost.AsInt()) / 100.0f; // Convert points to approximate dollar value
         }
-        
-        return false;
+
+        return !event.username.empty();
     }
 
-    bool TwitchManager::ParseBitsEvent(const std::string& json, TwitchEventData& event) {
-        try {
-            nlohmann::json j = nlohmann::json::parse(json);
-            
-            if (j.contains("payload") && j["payload"].contains("event")) {
-                auto event_data = j["payload"]["event"];
-                
-                event.username = event_data.value("user_name", "");
-                event.bits = event_data.value("bits", 0);
-                event.message = event_data.value("message", "");
-                
-                return !event.username.empty() && event.bits > 0;
-            }
-        } catch (const std::exception& e) {
-            if (Logger::IsInitialized()) {
-                Logger::Error("Failed to parse bits event: " + std::string(e.what()));
-            }
-        }
-        
-        return false;
+    bool TwitchManager::ParseBitsEvent(const JsonView& event_data, TwitchEventData& event) {
+        event.username = event_data["user_name"].AsString();
+        event.bits = static_cast<int>(event_data["bits"].AsInt(0));
+        event.message = event_data["message"].AsString();
+
+        return !event.username.empty() && event.bits > 0;
     }
 
-    bool TwitchManager::ParseSubscriptionEvent(const std::string& json, TwitchEventData& event) {
-        try {
-            nlohmann::json j = nlohmann::json::parse(json);
-            
-            if (j.contains("payload") && j["payload"].contains("event")) {
-                auto event_data = j["payload"]["event"];
-                
-                event.username = event_data.value("user_name", "");
-                event.months = event_data.value("cumulative_months", 1);
-                event.is_gift = event_data.value("is_gift", false);
-                
-                return !event.username.empty();
-            }
-        } catch (const std::exception& e) {
-            if (Logger::IsInitialized()) {
-                Logger::Error("Failed to parse subscription event: " + std::string(e.what()));
-            }
-        }
-        
-        return false;
+    bool TwitchManager::ParseSubscriptionEvent(const JsonView& event_data, TwitchEventData& event) {
+        event.username = event_data["user_name"].AsString();
+        event.months = static_cast<int>(event_data["cumulative_months"].AsInt(1));
+        event.is_gift = event_data["is_gift"].AsBool(false);
+
+        return !event.username.empty();
     }
 
     // Placeholder WebSocket methods - these would need actual WebSocket implementation
@@ -1654,21 +1617,17 @@ namespace StayPutVR {
             return false;
         }
 
-        try {
-            nlohmann::json response_json = nlohmann::json::parse(response);
-            
-            if (response_json.contains("data") && response_json["data"].is_array() && 
-                !response_json["data"].empty()) {
-                user_id = response_json["data"][0].value("id", "");
-                return !user_id.empty();
-            }
-        } catch (const std::exception& e) {
+        std::string parse_error;
+        const JsonView response_json = JsonView::Parse(response, &parse_error);
+        if (!response_json) {
             if (Logger::IsInitialized()) {
-                Logger::Error("Failed to parse user ID response: " + std::string(e.what()));
+                Logger::Error("Failed to parse user ID response: " + parse_error);
             }
+            return false;
         }
 
-        return false;
+        user_id = response_json["data"].At(0)["id"].AsString();
+        return !user_id.empty();
     }
 
     void TwitchManager::ProcessEventSubEvent(const TwitchEventData& event) {
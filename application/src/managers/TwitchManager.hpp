@@ -12,6 +12,7 @@
 #include "../../../common/Logger.hpp"
 #include "../../../common/HttpClient.hpp"
 #include "../../../common/LinkStatus.hpp"
+#include "../../../common/JsonView.hpp"
 #include "twitch/TwitchOAuthCallbackServer.hpp"
 
 namespace StayPutVR {
@@ -180,10 +181,10 @@ namespace StayPutVR {
         bool SubscribeToEvent(const std::string& event_type, const std::string& condition);
         bool UnsubscribeFromEvent(const std::string& subscription_id);
         
-        // JSON parsing helpers
-        bool ParseDonationEvent(const std::string& json, TwitchEventData& event);
-        bool ParseBitsEvent(const std::string& json, TwitchEventData& event);
-        bool ParseSubscriptionEvent(const std::string& json, TwitchEventData& event);
+        // EventSub notification parsing; each takes the notification's payload.event.
+        bool ParseDonationEvent(const JsonView& event_data, TwitchEventData& event);
+        bool ParseBitsEvent(const JsonView& event_data, TwitchEventData& event);
+        bool ParseSubscriptionEvent(const JsonView& event_data, TwitchEventData& event);
     };
 
 } // namespace StayPutVR 
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "FrameProfiler.hpp"
+#include "../../../common/AllocationCounter.hpp"
+#include <imgui.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace StayPutVR {
+
+    void FrameProfiler::BeginFrame() {
+        if (requested_enabled_ != enabled_) {
+            enabled_ = requested_enabled_;
+            // Start from a clean window so stale numbers from a previous
+            // session don't get averaged in.
+            sections_.clear();
+            frame_us_.fill(0.0f);
+            frame_allocs_.fill(0);
+            frame_ = 0;
+            depth_ = 0;
+        }
+        if (!enabled_) return;
+        frame_start_ = std::chrono::steady_clock::now();
+        frame_start_allocs_ = AllocationCounter::ThreadAllocations();
+        for (auto& s : sections_) {
+            s.frame_us = 0.0f;
+            s.frame_allocs = 0;
+            s.frame_calls = 0;
+        }
+    }
+
+    void FrameProfiler::EndFrame() {
+        if (!enabled_) return;
+        const int slot = frame_ % kHistory;
+        frame_us_[slot] = std::chrono::duration<float, std::micro>(
+            std::chrono::steady_clock::now() - frame_start_).count();
+        frame_allocs_[slot] = static_cast<uint32_t>(AllocationCounter::ThreadAllocations() - frame_start_allocs_);
+        for (auto& s : sections_) {
+            // -1 marks "not run this frame" (e.g. an inactive tab) so averages
+            // only cover frames where the section actually ran.
+            s.us[slot] = s.frame_calls ? s.frame_us : -1.0f;
+            s.allocs[slot] = s.frame_allocs;
+            if (s.frame_calls) s.last_seen_frame = frame_;
+        }
+        ++frame_;
+    }
+
+    FrameProfiler::Section& FrameProfiler::FindOrAdd(const char* name) {
+        for (auto& s : sections_) {
+            if (s.name == name || std::strcmp(s.name, name) == 0) return s;
+        }
+        Section s;
+        s.name = name;
+        s.depth = depth_;
+        s.us.fill(-1.0f);
+        sections_.push_back(s);
+        return sections_.back();
+    }
+
+    void FrameProfiler::Record(const char* name, float us, uint32_t allocs) {
+        Section& s = FindOrAdd(name);
+        s.frame_us += us;
+        s.frame_allocs += allocs;
+        ++s.frame_calls;
+    }
+
+    FrameProfiler::Scope::Scope(FrameProfiler& profiler, const char* name)
+        : profiler_(profiler.enabled_ ? &profiler : nullptr), name_(name) {
+        if (!profiler_) return;
+        ++profiler_->depth_;
+        start_allocs_ = AllocationCounter::ThreadAllocations();
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    FrameProfiler::Scope::~Scope() {
+        if (!profiler_) return;
+        float us = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start_).count();
+        uint32_t allocs = static_cast<uint32_t>(AllocationCounter::ThreadAllocations() - start_allocs_);
+        --profiler_->depth_;
+        profiler_->Record(name_, us, allocs);
+    }
+
+    void FrameProfiler::RenderOverlay() {
+        if (!enabled_) return;
+
+        const ImGuiViewport* viewport = ImGui::GetMainViewport();
+        ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - 10.0f, viewport->WorkPos.y + 40.0f),
+                                ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+        ImGui::SetNextWindowBgAlpha(0.85f);
+        bool open = true;
+        if (!ImGui::Begin("Frame Profiler (F3)", &open,
+                          ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+                          ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoNav)) {
+            ImGui::End();
+            if (!open) SetEnabled(false);
+            return;
+        }
+
+        const int frames = (std::min)(frame_, kHistory);
+        if (frames == 0) {
+            ImGui::TextDisabled("Collecting...");
+            ImGui::End();
+            if (!open) SetEnabled(false);
+            return;
+        }
+
+        float frame_sum = 0.0f, frame_max = 0.0f;
+        uint64_t frame_alloc_sum = 0;
+        for (int i = 0; i < frames; ++i) {
+            frame_sum += frame_us_[i];
+            frame_max = (std::max)(frame_max, frame_us_[i]);
+            frame_alloc_sum += frame_allocs_[i];
+        }
+        // Allocation counts are only real when the hooks are linked in
+        // (STAYPUTVR_COUNT_ALLOCATIONS); otherwise they would read 0.
+        constexpr bool show_allocs = AllocationCounter::CountingEnabled();
+        if (show_allocs) {
+            ImGui::Text("Frame CPU: avg %.2f ms, max %.2f ms, %.1f allocs/frame",
+                        frame_sum / frames / 1000.0f, frame_max / 1000.0f,
+                        static_cast<double>(frame_alloc_sum) / frames);
+        } else {
+            ImGui::Text("Frame CPU: avg %.2f ms, max %.2f ms",
+                        frame_sum / frames / 1000.0f, frame_max / 1000.0f);
+        }
+        // Oldest-to-newest view of the ring for the plot.
+        ImGui::PlotLines("##frame_us", frame_us_.data(), frames, frame_ < kHistory ? 0 : frame_ % kHistory,
+                         "frame us", 0.0f, FLT_MAX, ImVec2(320.0f, 40.0f));
+
+        if (ImGui::BeginTable("sections", show_allocs ? 4 : 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+            ImGui::TableSetupColumn("Section");
+            ImGui::TableSetupColumn("avg ms");
+            ImGui::TableSetupColumn("max ms");
+            if (show_allocs) ImGui::TableSetupColumn("allocs");
+            ImGui::TableHeadersRow();
+            for (const auto& s : sections_) {
+                if (frame_ - s.last_seen_frame > kHistory) continue; // not run recently
+                float sum = 0.0f, max = 0.0f;
+                uint64_t alloc_sum = 0;
+                int n = 0;
+                for (int i = 0; i < frames; ++i) {
+                    if (s.us[i] < 0.0f) continue;
+                    sum += s.us[i];
+                    max = (std::max)(max, s.us[i]);
+                    alloc_sum += s.allocs[i];
+                    ++n;
+                }
+                if (n == 0) continue;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Indent(12.0f * s.depth + 1.0f);
+                ImGui::TextUnformatted(s.name);
+                ImGui::Unindent(12.0f * s.depth + 1.0f);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", sum / n / 1000.0f);
+                ImGui::TableNextColumn(); ImGui::Text("%.3f", max / 1000.0f);
+                if (show_allocs) {
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f", static_cast<double>(alloc_sum) / n);
+                }
+            }
+            ImGui::EndTable();
+        }
+        if (show_allocs) ImGui::TextDisabled("allocs = heap allocations per frame on the UI thread");
+
+        ImGui::End();
+        if (!open) SetEnabled(false);
+    }
+
+} // namespace StayPutVR
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace StayPutVR {
+
+    // Lightweight per-section CPU profiler for the UI thread.
+    //
+    // Sections are identified by name (a string literal that outlives the
+    // profiler) and timed with the RAII Scope. Each frame's total time and
+    // allocation count (from AllocationCounter, this thread only) per section
+    // is pushed into a rolling window, and RenderOverlay() draws a small
+    // always-on-top window with the averages so we can see which tab is
+    // costing frames while someone is in VR. Allocation counts are only shown
+    // when built with STAYPUTVR_COUNT_ALLOCATIONS.
+    //
+    // When disabled, Scope is a single branch; nothing is timed or recorded.
+    class FrameProfiler {
+    public:
+        static constexpr int kHistory = 120; // frames (~2 s at 60 Hz)
+
+        // Enable/disable takes effect at the next BeginFrame() so a toggle from
+        // inside a frame never leaves half-open scopes behind.
+        bool IsEnabled() const { return requested_enabled_; }
+        void SetEnabled(bool enabled) { requested_enabled_ = enabled; }
+        void Toggle() { requested_enabled_ = !requested_enabled_; }
+
+        // Bracket one UI frame. EndFrame() commits this frame's section totals
+        // to the rolling history.
+        void BeginFrame();
+        void EndFrame();
+
+        class Scope {
+        public:
+            Scope(FrameProfiler& profiler, const char* name);
+            ~Scope();
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        private:
+            FrameProfiler* profiler_;
+            const char* name_;
+            std::chrono::steady_clock::time_point start_;
+            uint64_t start_allocs_ = 0;
+        };
+
+        // Draw the overlay window (no-op when disabled). Call between
+        // ImGui::NewFrame() and ImGui::Render().
+        void RenderOverlay();
+
+    private:
+        struct Section {
+            const char* name = nullptr;
+            int depth = 0;                 // nesting depth at first sighting (indentation)
+            float frame_us = 0.0f;         // accumulated this frame
+            uint32_t frame_allocs = 0;
+            uint32_t frame_calls = 0;
+            std::array<float, kHistory> us{};
+            std::array<uint32_t, kHistory> allocs{};
+            int last_seen_frame = -1;
+        };
+
+        Section& FindOrAdd(const char* name);
+        void Record(const char* name, float us, uint32_t allocs);
+
+        bool enabled_ = false;
+        bool requested_enabled_ = false;
+        int frame_ = 0;                    // monotonic frame counter
+        int depth_ = 0;                    // current Scope nesting
+        std::vector<Section> sections_;    // in first-seen order (roughly call order)
+        std::array<float, kHistory> frame_us_{};
+        std::chrono::steady_clock::time_point frame_start_{};
+        uint64_t frame_start_allocs_ = 0;
+        std::array<uint32_t, kHistory> frame_allocs_{};
+    };
+
+} // namespace StayPutVR
@@ -0,0 +1,121 @@
+#include "LogViewer.hpp"
+#include "../../../common/LogRing.hpp"
+#include <algorithm>
+#include <string>
+
+namespace StayPutVR {
+
+    namespace {
+        // Records examined per frame. New lines arrive far slower than this;
+        // it only bounds the catch-up after a filter change over a full ring.
+        constexpr uint64_t kScanBudget = 20000;
+
+        const char* kLevelNames[] = { "Debug", "Info", "Warning", "Error", "Critical" };
+
+        ImVec4 LevelColor(Logger::LogLevel level) {
+            switch (level) {
+                case Logger::LogLevel::DEBUG:    return ImVec4(0.60f, 0.60f, 0.60f, 1.0f);
+                case Logger::LogLevel::WARNING:  return ImVec4(1.00f, 0.80f, 0.30f, 1.0f);
+                case Logger::LogLevel::E_ERROR:
+                case Logger::LogLevel::CRITICAL: return ImVec4(1.00f, 0.40f, 0.40f, 1.0f);
+                default:                         return ImGui::GetStyleColorVec4(ImGuiCol_Text);
+            }
+        }
+    }
+
+    void LogViewer::Scan() {
+        LogRing::Reader reader;
+        const uint64_t first = reader.FirstSeq();
+        const uint64_t end = reader.EndSeq();
+
+        if (restart_scan_) {
+            matches_.clear();
+            scanned_end_ = first;
+            restart_scan_ = false;
+        }
+
+        // Forget records the ring has evicted since last frame.
+        while (!matches_.empty() && matches_.front() < first) {
+            matches_.pop_front();
+        }
+        scanned_end_ = (std::max)(scanned_end_, first);
+
+        const uint64_t stop = (std::min)(end, scanned_end_ + kScanBudget);
+        for (; scanned_end_ < stop; ++scanned_end_) {
+            const LogRing::Record* rec = reader.Get(scanned_end_);
+            if (!rec || static_cast<int>(rec->level) < min_level_) continue;
+            if (!filter_.PassFilter(rec->text.data(), rec->text.data() + rec->text.size())) continue;
+            matches_.push_back(scanned_end_);
+        }
+    }
+
+    void LogViewer::CopyToClipboard() {
+        std::string text;
+        {
+            LogRing::Reader reader;
+            for (uint64_t seq : matches_) {
+                if (const LogRing::Record* rec = reader.Get(seq)) {
+                    text += rec->text;
+                    text += '\n';
+                }
+            }
+        }
+        ImGui::SetClipboardText(text.c_str());
+    }
+
+    void LogViewer::Render() {
+        ImGui::SetNextItemWidth(110.0f);
+        if (ImGui::Combo("Level", &min_level_, kLevelNames, IM_ARRAYSIZE(kLevelNames))) {
+            restart_scan_ = true;
+        }
+        ImGui::SameLine();
+        if (filter_.Draw("Filter", 220.0f)) {
+            restart_scan_ = true;
+        }
+        if (ImGui::IsItemHovered()) {
+            ImGui::SetTooltip("Substring filter. Separate terms with commas; prefix with - to exclude (e.g. \"osc,-debug\").");
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Auto-scroll", &auto_scroll_);
+        ImGui::SameLine();
+        if (ImGui::Button("Copy")) {
+            CopyToClipboard();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) {
+            LogRing::Clear();
+        }
+
+        Scan();
+
+        ImGui::TextDisabled("%zu matching lines (only the most recent %zu are kept in memory; the log file has everything)",
+                            matches_.size(), LogRing::Capacity());
+        ImGui::Separator();
+
+        ImGui::BeginChild("##log_lines", ImVec2(0.0f, 0.0f), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar);
+        {
+            LogRing::Reader reader;
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(matches_.size()));
+            while (clipper.Step()) {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+                    const LogRing::Record* rec = reader.Get(matches_[i]);
+                    if (!rec) {
+                        // Evicted between Scan() and now; keep the row height.
+                        ImGui::TextUnformatted("");
+                        continue;
+                    }
+                    ImGui::PushStyleColor(ImGuiCol_Text, LevelColor(rec->level));
+                    ImGui::TextUnformatted(rec->text.data(), rec->text.data() + rec->text.size());
+                    ImGui::PopStyleColor();
+                }
+            }
+            clipper.End();
+        }
+        if (auto_scroll_ && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) {
+            ImGui::SetScrollHereY(1.0f);
+        }
+        ImGui::EndChild();
+    }
+
+} // namespace StayPutVR
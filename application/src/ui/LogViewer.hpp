@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <imgui.h>
+
+namespace StayPutVR {
+
+    // Logs tab: a virtualized view over LogRing.
+    //
+    // The viewer keeps the sequence numbers of the records that pass the
+    // current level + text filter. Each frame it only examines records that
+    // arrived since the previous frame (and drops evicted ones from the front),
+    // so the cost is proportional to new log lines, not to what is retained.
+    // Changing the filter restarts the scan, spread over several frames.
+    // Nothing runs when the tab isn't shown.
+    class LogViewer {
+    public:
+        void Render();
+
+    private:
+        void Scan();
+        void CopyToClipboard();
+
+        ImGuiTextFilter filter_;
+        int min_level_ = 0;              // index into Logger::LogLevel
+        bool auto_scroll_ = true;
+        bool restart_scan_ = true;
+        uint64_t scanned_end_ = 0;       // next sequence number to examine
+        std::deque<uint64_t> matches_;   // sequence numbers passing the filter
+    };
+
+} // namespace StayPutVR
@@ -12,6 +12,7 @@
 #include "../../common/Logger.hpp"
 #include "../../common/PathUtils.hpp"
 #include "../../common/Audio.hpp"
+#include "../../common/AllocationCounter.hpp"
 #ifdef _WIN32
 #include <shellapi.h> // For ShellExecuteA
 #else
@@ -277,6 +278,9 @@ namespace StayPutVR {
     }
 
     void UIManager::Update() {
+        frame_profiler_.BeginFrame();
+        FrameProfiler::Scope prof(frame_profiler_, "Update");
+
         // Poll and handle events
         glfwPollEvents();
         
@@ -321,12 +325,14 @@ namespace StayPutVR {
         ProcessGlobalOutOfBoundsTimer();
         ProcessBiteTimer();
         ProcessAvatarResyncTimer();
+        PollOSCValues();
         
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
         
         if (device_manager_) {
+            FrameProfiler::Scope prof_devices(frame_profiler_, "UpdateDevicePositions");
             device_manager_->Update();
             
             const auto& devices = device_manager_->GetDevices();
@@ -336,15 +342,34 @@ namespace StayPutVR {
     }
 
     void UIManager::Render() {
-        RenderMainWindow();
-        
-        ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(window_, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        AllocationScope alloc_scope(AllocTag::UI);
+        {
+            FrameProfiler::Scope prof(frame_profiler_, "RenderMainWindow");
+            RenderMainWindow();
+        }
+        frame_profiler_.RenderOverlay();
+
+        // Everything this frame queued for VRChat goes out as one bundle.
+        {
+            FrameProfiler::Scope prof(frame_profiler_, "OSC flush");
+            OSCManager::GetInstance().FlushSends();
+        }
+
+        {
+            FrameProfiler::Scope prof(frame_profiler_, "ImGui::Render");
+            ImGui::Render();
+        }
+        {
+            FrameProfiler::Scope prof(frame_profiler_, "RenderDrawData");
+            int display_w, display_h;
+            glfwGetFramebufferSize(window_, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        // Swap (which may block on vsync) is deliberately outside the frame.
+        frame_profiler_.EndFrame();
         
         glfwSwapBuffers(window_);
     }
@@ -453,47 +478,80 @@ namespace StayPutVR {
 
         RenderTabBar();
 
+        if (ImGui::IsKeyPressed(ImGuiKey_F3, false)) {
+            frame_profiler_.Toggle();
+        }
+
         // Persistent config-health warning sits directly under the tabs so it is
         // visible from any tab whenever settings can't be read or saved.
         RenderConfigHealthWarning();
 
         switch (current_tab_) {
-            case TabType::MAIN:
+            case TabType::MAIN: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderMainTab");
                 RenderMainTab();
                 break;
-            case TabType::DEVICES:
+            }
+            case TabType::DEVICES: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderDevicesTab");
                 RenderDevicesTab();
                 break;
-            case TabType::BOUNDARIES:
+            }
+            case TabType::BOUNDARIES: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderBoundariesTab");
                 RenderBoundariesTab();
                 break;
-            case TabType::NOTIFICATIONS:
+            }
+            case TabType::NOTIFICATIONS: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderNotificationsTab");
                 RenderNotificationsTab();
                 break;
-            case TabType::TIMERS:
+            }
+            case TabType::TIMERS: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderTimersTab");
                 RenderTimersTab();
                 break;
-            case TabType::OSC:
+            }
+            case TabType::OSC: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderOSCTab");
                 RenderOSCTab();
                 break;
-            case TabType::PISHOCK:
+            }
+            case TabType::PISHOCK: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderPiShockTab");
                 RenderPiShockTab();
                 break;
-            case TabType::OPENSHOCK:
+            }
+            case TabType::OPENSHOCK: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderOpenShockTab");
                 RenderOpenShockTab();
                 break;
-            case TabType::BUTTPLUG:
+            }
+            case TabType::BUTTPLUG: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderButtplugTab");
                 RenderButtplugTab();
                 break;
-            case TabType::TWITCH:
+            }
+            case TabType::TWITCH: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderTwitchTab");
                 RenderTwitchTab();
                 break;
-            case TabType::INTEGRATIONS:
+            }
+            case TabType::INTEGRATIONS: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderIntegrationsTab");
                 RenderIntegrationsTab();
                 break;
-            case TabType::SETTINGS:
+            }
+            case TabType::SETTINGS: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderSettingsTab");
                 RenderSettingsTab();
                 break;
+            }
+            case TabType::LOGS: {
+                FrameProfiler::Scope prof(frame_profiler_, "RenderLogsTab");
+                RenderLogsTab();
+                break;
+            }
         }
 
         ImGui::End();
@@ -619,6 +677,11 @@ namespace StayPutVR {
                 ImGui::EndTabItem();
             }
 
+            if (ImGui::BeginTabItem("Logs")) {
+                current_tab_ = TabType::LOGS;
+                ImGui::EndTabItem();
+            }
+
             ImGui::EndTabBar();
         }
     }
@@ -43,6 +43,8 @@
 #include "panels/OpenShockPanel.hpp"
 #include "panels/ButtplugPanel.hpp"
 #include "SplashScreen.hpp"
+#include "FrameProfiler.hpp"
+#include "LogViewer.hpp"
 
 namespace StayPutVR {
 
@@ -59,7 +61,8 @@ namespace StayPutVR {
         OPENSHOCK,
         BUTTPLUG,
         TWITCH,
-        INTEGRATIONS
+        INTEGRATIONS,
+        LOGS
     };
 
     struct DevicePosition {
@@ -81,6 +84,11 @@ namespace StayPutVR {
         
         // Time of last position update
         std::chrono::steady_clock::time_point last_update_time = std::chrono::steady_clock::now();
+
+        // Driver sample / IPC receive time of the latest update (steady_clock us,
+        // 0 = unknown), carried into the trigger latency trace.
+        int64_t sample_time_us = 0;
+        int64_t receive_time_us = 0;
         
         // Previous position for detecting changes
         float previous_position[3] = {0.0f, 0.0f, 0.0f};
@@ -161,6 +169,10 @@ namespace StayPutVR {
     enum class InGameSound { None = 0, Lock = 1, Unlock = 2, Warning = 3, Disobedience = 4, CollarMode = 5 };
 
     class UIManager {
+        // Headless tools (tools/ui_bench, tools/alloc_audit) drive the private
+        // Render*Tab functions directly against a synthetic device set.
+        friend class UIBenchmark;
+        friend class AllocationAudit;
     public:
         UIManager();
         ~UIManager();
@@ -202,6 +214,7 @@ namespace StayPutVR {
         // Device data
         std::vector<DevicePosition> device_positions_;
         std::unordered_map<std::string, size_t> device_map_; // Maps serial to index in device_positions_
+        std::vector<uint8_t> device_seen_; // UpdateDevicePositions scratch: index was in this update
         
         // Saved configurations directory
         std::string config_dir_ = "config";
@@ -237,6 +250,12 @@ namespace StayPutVR {
         // receive port to VRChat and discovers VRChat's OSC port for sends.
         std::unique_ptr<OSCQueryServer> osc_query_server_;
 
+        // Per-section UI CPU timing overlay (Settings > "Frame profiler", or F3).
+        FrameProfiler frame_profiler_;
+
+        // Logs tab (in-memory ring fed by Logger)
+        LogViewer log_viewer_;
+
         // Startup splash / Welcome+About overlay and the What's New window.
         std::unique_ptr<SplashScreen> splash_;
         std::string assets_path_;            // resources dir (logo, whats_new.md, supporters)
@@ -277,12 +296,14 @@ namespace StayPutVR {
         // communication integration (OSC, PiShock, OpenShock, Twitch) showing
         // live link state, detail, last error, and a manual reconnect button.
         void RenderConnectionStatusPanel();
+        void RenderTriggerLatencyPanel(); // Status tab: pose-sample -> shocker-ack latency histograms
         void RenderDevicesTab();
         void RenderBoundariesTab();
         void RenderNotificationsTab();
         void RenderTimersTab();
         void RenderOSCTab();
         void RenderSettingsTab();
+        void RenderLogsTab();
         void RenderPiShockTab();
         void RenderOpenShockTab();
         void RenderButtplugTab();
@@ -344,6 +365,8 @@ namespace StayPutVR {
         // (non-user-initiated) transitions, e.g. unlocking on avatar change.
         void ActivateGlobalLock(bool activate, bool play_sound = true);
         void ActivateGlobalLockInternal(bool activate, bool play_sound = true);
+        // Lets the shock managers warm their connections as a lock engages.
+        void NotifyLockEngaged();
         void CheckDevicePositionDeviations();
 
         // VRCFT JawOpen constraint. Reserved serial used to key its shocker /
@@ -382,6 +405,8 @@ namespace StayPutVR {
 
         // VRCFT JawOpen constraint runtime state (see CheckJawOpenConstraint).
         JawOpenConstraint jaw_;
+        // Mailbox sequence of the last JawOpen value pulled by PollOSCValues().
+        uint32_t jaw_open_seq_ = 0;
         // True when the JawOpen head hotspot is selected in the Visual view, so
         // its config panel shows instead of a device slot's (selected_slot_role_).
         bool jaw_selected_ = false;
@@ -524,6 +549,9 @@ namespace StayPutVR {
         // and is often dropped. Schedule a one-shot delayed re-push that lands after
         // the avatar is ready, so the display restores even if the user never interacts.
         void ProcessAvatarResyncTimer();
+        // Pull continuous OSC params (JawOpen) from OSCManager's latest-value
+        // mailboxes; once per frame, before the constraint engines run.
+        void PollOSCValues();
         bool avatar_resync_pending_ = false;
         std::chrono::steady_clock::time_point avatar_resync_start_;
         static constexpr float AVATAR_RESYNC_DELAY = 1.0f; // Seconds after /avatar/change
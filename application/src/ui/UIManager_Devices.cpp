@@ -20,6 +20,7 @@
 #endif
 #include <thread> // For std::this_thread::sleep_for
 #include "../../../common/OSCManager.hpp"
+#include "../../../common/TriggerTrace.hpp"
 #include "../../common/HttpClient.hpp"
 
 // Windows-specific includes for icon handling
@@ -40,16 +41,19 @@ extern std::atomic<bool> g_running;
 namespace StayPutVR {
 
     void UIManager::UpdateDevicePositions(const std::vector<DevicePositionData>& devices) {
+        AllocationScope alloc_scope(AllocTag::Devices);
+
         // Mark current time for tracking device activity
         auto now = std::chrono::steady_clock::now();
         
-        // Create a set of all current device serials
-        std::unordered_set<std::string> current_device_serials;
+        // Which entries of device_positions_ are in this update, by index.
+        // A reused member (not a per-call set of serial copies) so a steady
+        // stream of updates doesn't allocate.
+        device_seen_.assign(device_positions_.size(), 0);
         
         // Update device map
         for (const auto& device : devices) {
-            std::string serial = device.serial;
-            current_device_serials.insert(serial);
+            const std::string& serial = device.serial;
             
             // Check if this device exists in our map
             auto it = device_map_.find(serial);
@@ -80,6 +84,8 @@ namespace StayPutVR {
                 
                 // Initialize last update time
                 pos.last_update_time = now;
+                pos.sample_time_us = device.sample_time_us;
+                pos.receive_time_us = device.receive_time_us;
                 
                 // Look up device name from config if available
                 auto nameIt = config_.device_names.find(serial);
@@ -140,9 +146,11 @@ namespace StayPutVR {
                 // Add to our list and map
                 device_positions_.push_back(pos);
                 device_map_[serial] = device_positions_.size() - 1;
+                device_seen_.push_back(1);
             } else {
                 // Existing device, update it
                 size_t index = it->second;
+                device_seen_[index] = 1;
                 
                 // Save previous position
                 for (int i = 0; i < 3; i++) {
@@ -169,6 +177,8 @@ namespace StayPutVR {
                 for (int i = 0; i < 4; i++) {
                     device_positions_[index].rotation[i] = current_rot[i];
                 }
+                device_positions_[index].sample_time_us = device.sample_time_us;
+                device_positions_[index].receive_time_us = device.receive_time_us;
 
                 // Update movement heat (for device identification): fast attack
                 // when moving, slow decay when still, so wiggling a tracker in
@@ -215,7 +225,7 @@ namespace StayPutVR {
             const auto& device = device_positions_[i];
             
             // Skip devices that are in the current update
-            if (current_device_serials.find(device.serial) != current_device_serials.end()) {
+            if (device_seen_[i]) {
                 continue;
             }
             
@@ -307,6 +317,7 @@ namespace StayPutVR {
         if (it != device_map_.end()) {
             size_t index = it->second;
             device_positions_[index].locked = lock;
+            if (lock) NotifyLockEngaged();
             
             // If locking, store the current position as original
             if (lock) {
@@ -354,6 +365,9 @@ namespace StayPutVR {
     }
 
     void UIManager::ActivateGlobalLock(bool activate, bool play_sound) {
+        // Before any countdown, so connections are warm by the time it ends.
+        if (activate && !emergency_stop_active_) NotifyLockEngaged();
+
         if (activate && config_.countdown_enabled) {
             // Start countdown by playing countdown.wav once
             // The countdown.wav is a 3-second sound
@@ -389,6 +403,13 @@ namespace StayPutVR {
         ActivateGlobalLockInternal(activate, play_sound);
     }
 
+    void UIManager::NotifyLockEngaged() {
+        // The WebSocket-based managers hold a live link already; only the
+        // HTTP ones have a connection to open.
+        if (pishock_manager_) pishock_manager_->OnLockEngaged();
+        if (openshock_manager_) openshock_manager_->OnLockEngaged();
+    }
+
     // Internal method to actually handle the lock activation
     void UIManager::ActivateGlobalLockInternal(bool activate, bool play_sound) {
         // Prevent locking during emergency stop mode (but allow unlocking)
@@ -564,6 +585,8 @@ namespace StayPutVR {
                     
                     // Trigger Buttplug safe zone actions when returning to safe zone
                     if (buttplug_manager_ && buttplug_manager_->IsEnabled()) {
+                        TriggerLatency::Scope trace_scope(
+                            TriggerLatency::Begin(device.sample_time_us, device.receive_time_us));
                         if (StayPutVR::Logger::IsInitialized()) {
                             Logger::Info("Triggering Buttplug safe zone actions for device " + device.serial + " returning to safe zone");
                         }
@@ -594,6 +617,8 @@ namespace StayPutVR {
                     
                     // Trigger Buttplug warning zone actions when entering warning zone
                     if (buttplug_manager_ && buttplug_manager_->IsEnabled()) {
+                        TriggerLatency::Scope trace_scope(
+                            TriggerLatency::Begin(device.sample_time_us, device.receive_time_us));
                         if (StayPutVR::Logger::IsInitialized()) {
                             Logger::Info("Triggering Buttplug warning zone actions for device " + device.serial + " entering warning zone");
                         }
@@ -623,6 +648,8 @@ namespace StayPutVR {
                     
                     // Trigger Buttplug warning zone actions when returning to warning zone from out of bounds
                     if (buttplug_manager_ && buttplug_manager_->IsEnabled()) {
+                        TriggerLatency::Scope trace_scope(
+                            TriggerLatency::Begin(device.sample_time_us, device.receive_time_us));
                         if (StayPutVR::Logger::IsInitialized()) {
                             Logger::Info("Triggering Buttplug warning zone actions for device " + device.serial + " returning to warning from out of bounds");
                         }
@@ -650,6 +677,11 @@ namespace StayPutVR {
                         }
                     }
                     
+                    // Latency trace for this trigger; the integrations pick it
+                    // up from the scope when they enqueue their commands.
+                    TriggerLatency::Scope trace_scope(
+                        TriggerLatency::Begin(device.sample_time_us, device.receive_time_us));
+
                     if (StayPutVR::Logger::IsInitialized()) {
                         Logger::Info("Triggering initial PiShock disobedience actions for device " + device.serial);
                     }
@@ -664,6 +696,8 @@ namespace StayPutVR {
                 } 
                 // Continue triggering PiShock for devices that remain in out-of-bounds zone
                 else if (device.exceeds_threshold && CanTriggerPiShock()) {
+                    TriggerLatency::Scope trace_scope(
+                        TriggerLatency::Begin(device.sample_time_us, device.receive_time_us));
                     if (StayPutVR::Logger::IsInitialized()) {
                         Logger::Info("Triggering continuous PiShock disobedience actions for device " + device.serial);
                     }
@@ -674,6 +708,8 @@ namespace StayPutVR {
                 else if (device.exceeds_threshold && openshock_manager_ && openshock_manager_->IsEnabled()) {
                     // OpenShockManager handles its own rate limiting
                     if (openshock_manager_->CanTriggerAction()) {
+                        TriggerLatency::Scope trace_scope(
+                            TriggerLatency::Begin(device.sample_time_us, device.receive_time_us));
                         if (StayPutVR::Logger::IsInitialized()) {
                             Logger::Info("Triggering continuous OpenShock disobedience actions for device " + device.serial);
                         }
@@ -1266,6 +1302,7 @@ namespace StayPutVR {
     }
 
     void UIManager::RenderZoneMap() {
+        FrameProfiler::Scope prof(frame_profiler_, "RenderZoneMap");
         // Auto-fit the map to the available region so the rings never clip. The
         // largest threshold maps to the rim; device dots stay literal-distance
         // (clamped to the rim so a far-out device renders at the edge, not off
@@ -1409,6 +1446,7 @@ namespace StayPutVR {
     // Decode a PNG to an RGBA GL texture. Returns the texture id (0 on
     // missing/undecodable file); sets w/h to the image dimensions.
     unsigned int UIManager::LoadPngTexture(const std::string& path, int& w, int& h) {
+        FrameProfiler::Scope prof(frame_profiler_, "LoadPngTexture");
         w = 0; h = 0;
         if (!std::filesystem::exists(path)) return 0;
 
@@ -1638,6 +1676,7 @@ namespace StayPutVR {
     }
 
     void UIManager::RenderVisualAssignment() {
+        FrameProfiler::Scope prof(frame_profiler_, "RenderVisualAssignment");
         LoadEffigyTexture();
 
         struct Slot { DeviceRole role; const char* label; float ux, uy; };
@@ -2284,6 +2323,7 @@ namespace StayPutVR {
     }
 
     void UIManager::RenderDeviceList() {
+        FrameProfiler::Scope prof(frame_profiler_, "RenderDeviceList");
         ImGui::Text("Connected Devices: %zu", device_positions_.size());
         ImGui::Separator();
         
@@ -196,6 +196,78 @@ namespace StayPutVR {
                 "sending. When disabled, the manual Send/Receive ports above are used. "
                 "Changes take effect the next time OSC is enabled.");
 
+            if (ImGui::SliderFloat("Status Keepalive (s)", &config_.osc_send_keepalive_seconds, 0.0f, 60.0f,
+                                   config_.osc_send_keepalive_seconds > 0.0f ? "%.0f" : "Off")) {
+                changed = true;
+            }
+            ImGui::SameLine();
+            ImGuiHelpers::HelpTooltip("Status, collar mode and sound-effect params are only sent to VRChat when "
+                "they change (and again after an avatar change). If your avatar sometimes shows a stale status, "
+                "set this to re-send unchanged values every few seconds. Off sends changes only.");
+
+            if (ImGui::InputInt("Receive Buffer (KB)", &config_.osc_receive_buffer_kb, 256, 1024)) {
+                config_.osc_receive_buffer_kb = (std::clamp)(config_.osc_receive_buffer_kb, 0, 64 * 1024);
+                changed = true;
+            }
+            ImGui::SameLine();
+            ImGuiHelpers::HelpTooltip("Kernel buffer for incoming OSC. VRChat sends every avatar parameter at once "
+                "after an avatar change, plus face tracking if you use it; a small buffer overflows and the OS "
+                "silently drops packets (see Status > Connection Status). 0 uses the OS default. The OS may cap "
+                "the size (on Linux, net.core.rmem_max).");
+
+            // Extra destinations: same outbound params, no separate router.
+            ImGui::Spacing();
+            ImGui::Text("Additional Destinations");
+            ImGui::SameLine();
+            ImGuiHelpers::HelpTooltip("Also send StayPutVR's outbound params to other OSC apps (routers, overlays, "
+                "the VRCOSC PiShock module). Filter is a comma-separated list of address prefixes, e.g. "
+                "/VRCOSC/PiShock/ -- leave it empty to forward everything. Addresses must be IPv4.");
+            int remove_destination = -1;
+            for (size_t i = 0; i < config_.osc_destinations.size(); ++i) {
+                Config::OSCDestination& dest = config_.osc_destinations[i];
+                ImGui::PushID(static_cast<int>(i));
+                if (ImGui::Checkbox("##enabled", &dest.enabled)) {
+                    changed = true;
+                }
+                ImGui::SameLine();
+                char dest_ip[64];
+                strcpy_s(dest_ip, sizeof(dest_ip), dest.address.c_str());
+                ImGui::SetNextItemWidth(120.0f);
+                if (ImGui::InputText("##address", dest_ip, IM_ARRAYSIZE(dest_ip))) {
+                    dest.address = dest_ip;
+                }
+                // Applied when the edit finishes, not on every half-typed address.
+                if (ImGui::IsItemDeactivatedAfterEdit()) changed = true;
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(90.0f);
+                if (ImGui::InputInt("##port", &dest.port, 0)) {
+                    dest.port = (std::clamp)(dest.port, 1, 65535);
+                }
+                if (ImGui::IsItemDeactivatedAfterEdit()) changed = true;
+                ImGui::SameLine();
+                char dest_filter[256];
+                strcpy_s(dest_filter, sizeof(dest_filter), dest.filter.c_str());
+                ImGui::SetNextItemWidth(220.0f);
+                if (ImGui::InputTextWithHint("##filter", "all addresses", dest_filter, IM_ARRAYSIZE(dest_filter))) {
+                    dest.filter = dest_filter;
+                }
+                if (ImGui::IsItemDeactivatedAfterEdit()) changed = true;
+                ImGui::SameLine();
+                if (ImGui::SmallButton("Remove")) {
+                    remove_destination = static_cast<int>(i);
+                }
+                ImGui::PopID();
+            }
+            if (remove_destination >= 0) {
+                config_.osc_destinations.erase(config_.osc_destinations.begin() + remove_destination);
+                changed = true;
+            }
+            if (config_.osc_destinations.size() < OSCManager::kMaxDestinations &&
+                ImGui::SmallButton("Add Destination")) {
+                config_.osc_destinations.push_back(Config::OSCDestination{});
+                changed = true;
+            }
+
             ImGui::Spacing();
             if (ImGui::SmallButton("Reset to Defaults##conn")) {
                 config_.osc_address = "127.0.0.1";
@@ -203,6 +275,8 @@ namespace StayPutVR {
                 config_.osc_send_port = 9000; osc_send_port = 9000;
                 config_.osc_receive_port = 9001; osc_receive_port = 9001;
                 config_.osc_query_enabled = true;
+                config_.osc_send_keepalive_seconds = 0.0f;
+                config_.osc_receive_buffer_kb = 1024;
                 changed = true;
             }
         }
@@ -722,8 +796,9 @@ namespace StayPutVR {
         // SPVR_Collar_Mode between collar-toggle presses - so without this the collar
         // display blanks after a reload and stays stale until the next toggle. Every
         // lock/unlock/warning/disobedience/safe edge funnels through here (all callers
-        // are edge-triggered), so this self-heals the display on any interaction. The
-        // send is idempotent and cheap (one UDP int).
+        // are edge-triggered), so this self-heals the display on any interaction.
+        // OSCManager drops it when the mode is unchanged since the last send, which
+        // costs nothing; after /avatar/change that cache is cleared, so it goes out.
         OSCManager::GetInstance().SendCollarMode(collar_mode_.load());
 
         // Central hook for the warning/disobedience in-game sound effects: the
@@ -973,14 +1048,6 @@ namespace StayPutVR {
             }
         );
 
-        // VRCFT JawOpen: store every inbound value so the Visual heat bar and the
-        // constraint engine (CheckJawOpenConstraint) always see the live jaw value.
-        OSCManager::GetInstance().SetJawOpenCallback(
-            [this](float jaw_value) {
-                jaw_.current = jaw_value;
-            }
-        );
-
         // Unified collar-mode toggle button (momentary contact). Runs on the OSC
         // receive thread: rising-edge detect, advance to the next enabled+agreed mode,
         // and echo SPVR_Collar_Mode. Reads only collar_valid_mask_ (atomic), never config_.
@@ -1462,6 +1529,16 @@ namespace StayPutVR {
         }
     }
 
+    // VRCFT JawOpen arrives far faster than the UI runs; the receive thread only
+    // overwrites a mailbox and the Visual heat bar and the constraint engine
+    // (CheckJawOpenConstraint) see the newest value as of this frame.
+    void UIManager::PollOSCValues() {
+        float jaw_value;
+        if (OSCManager::GetInstance().ReadLatest(OSCContinuousParam::JawOpen, jaw_value, jaw_open_seq_)) {
+            jaw_.current = jaw_value;
+        }
+    }
+
     // One-shot re-push scheduled by HandleAvatarChange. The immediate push there races
     // VRChat's avatar load (params reset to default, avatar not yet ready to take the
     // echo), so we re-assert the current state once after a short delay - by which time
@@ -1485,6 +1562,10 @@ namespace StayPutVR {
             Logger::Info("Avatar re-sync delay elapsed - re-pushing device statuses and collar mode");
         }
 
+        // The pushes at /avatar/change may have been lost to the avatar load, so
+        // these must go out even though they repeat what was sent then.
+        OSCManager::GetInstance().InvalidateSendCache();
+
         // Re-assert each tracked device's current status (same logic as ProcessBiteTimer).
         for (auto& device : device_positions_) {
             if (device.role != DeviceRole::None) {
@@ -21,6 +21,7 @@
 #include "../../../common/OSCManager.hpp"
 #include "../../../common/OSCQueryServer.hpp"
 #include "../../../common/LinkStatus.hpp"
+#include "../../../common/TriggerTrace.hpp"
 #include "../../common/HttpClient.hpp"
 #include "../../../common/Version.hpp"
 // TwitchManager / PiShock* / OpenShock manager headers come transitively via
@@ -135,6 +136,29 @@ namespace StayPutVR {
                 }
             }
             RenderLinkRow("OSC", s);
+
+            // Receive-side health: drops mean the receive buffer overflowed
+            // (typically the param burst after an avatar change).
+            if (osc_enabled_) {
+                const OSCManager::ReceiveStats rx = OSCManager::GetInstance().GetReceiveStats();
+                ImGui::Indent();
+                if (!rx.drops_supported) {
+                    ImGui::TextDisabled("%llu datagrams received, buffer %d KB",
+                                        static_cast<unsigned long long>(rx.datagrams), rx.buffer_bytes / 1024);
+                } else if (rx.kernel_drops == 0) {
+                    ImGui::TextDisabled("%llu datagrams received, none dropped, buffer %d KB",
+                                        static_cast<unsigned long long>(rx.datagrams), rx.buffer_bytes / 1024);
+                } else {
+                    ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.2f, 1.0f),
+                                       "%llu datagrams received, %llu dropped by the OS (buffer %d KB full)",
+                                       static_cast<unsigned long long>(rx.datagrams),
+                                       static_cast<unsigned long long>(rx.kernel_drops), rx.buffer_bytes / 1024);
+                    ImGui::SameLine();
+                    ImGuiHelpers::HelpTooltip("Incoming OSC arrived faster than StayPutVR read it and the OS "
+                        "discarded the overflow. Raise Receive Buffer in the OSC tab's Connection section.");
+                }
+                ImGui::Unindent();
+            }
         }
 
         // --- PiShock (WebSocket v2 or Legacy HTTP, per config) ---
@@ -192,6 +216,104 @@ namespace StayPutVR {
         ImGui::EndChild();
     }
 
+    void UIManager::RenderTriggerLatencyPanel() {
+        if (!ImGui::CollapsingHeader("Trigger Latency")) {
+            return;
+        }
+        ImGui::TextDisabled("Time from the tracker pose sample to the shocker server acknowledging the command.");
+
+        auto ms = [](uint64_t us) { return static_cast<double>(us) / 1000.0; };
+        bool any = false;
+        for (int i = 0; i < static_cast<int>(TraceIntegration::Count); ++i) {
+            const auto integration = static_cast<TraceIntegration>(i);
+            const LatencyHistogram& total = TriggerLatency::TotalHistogram(integration);
+            if (total.Count() == 0) continue;
+            any = true;
+
+            ImGui::SeparatorText(ToString(integration));
+            ImGui::PushID(i);
+            if (ImGui::BeginTable("latency", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                ImGui::TableSetupColumn("Stage");
+                ImGui::TableSetupColumn("Count");
+                ImGui::TableSetupColumn("p50 (ms)");
+                ImGui::TableSetupColumn("p95 (ms)");
+                ImGui::TableSetupColumn("Max (ms)");
+                ImGui::TableHeadersRow();
+
+                auto row = [&](const char* label, const LatencyHistogram& h) {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::TextUnformatted(label);
+                    ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(h.Count()));
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f", ms(h.PercentileUs(0.50)));
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f", ms(h.PercentileUs(0.95)));
+                    ImGui::TableNextColumn(); ImGui::Text("%.1f", ms(h.MaxUs()));
+                };
+                // Each stage row is the delay INTO that stage from the previous one.
+                for (int s = static_cast<int>(TraceStage::IpcReceive); s < static_cast<int>(TraceStage::Count); ++s) {
+                    const auto stage = static_cast<TraceStage>(s);
+                    const LatencyHistogram& h = TriggerLatency::StageHistogram(integration, stage);
+                    if (h.Count() > 0) row(ToString(stage), h);
+                }
+                row("End to end", total);
+                ImGui::EndTable();
+            }
+            ImGui::PopID();
+        }
+
+        if (!any) {
+            ImGui::TextDisabled("No triggers traced yet.");
+        } else if (ImGui::SmallButton("Reset latency stats")) {
+            TriggerLatency::Reset();
+        }
+
+        // HttpClient's async queue: a growing peak or any expiries mean
+        // commands are waiting on a slow server.
+        const HttpClient::AsyncStats http = HttpClient::GetAsyncStats();
+        if (http.completed + http.expired + http.rejected > 0) {
+            ImGui::SeparatorText("HTTP queue");
+            ImGui::TextDisabled("%zu queued (peak %zu), %zu in flight, longest wait %.0f ms",
+                                http.queued, http.peak_queued, http.in_flight, http.max_wait_ms);
+            ImGui::TextDisabled("%llu sent, %llu expired, %llu rejected (queue full)",
+                                static_cast<unsigned long long>(http.completed),
+                                static_cast<unsigned long long>(http.expired),
+                                static_cast<unsigned long long>(http.rejected));
+        }
+
+        // WebSocketClient outbound queues: queue time is the wait for the
+        // writer thread, write time the socket write that carried it.
+        const auto render_ws_queue = [](const char* name, const WebSocketClient::SendStats& ws) {
+            if (ws.sent + ws.rejected == 0) return;
+            ImGui::Text("%s", name);
+            ImGui::TextDisabled("%zu queued (peak %zu), queue %.2f ms avg / %.1f ms max, write %.2f ms avg / %.1f ms max",
+                                ws.queued, ws.peak_queued, ws.avg_queue_ms, ws.max_queue_ms, ws.avg_write_ms, ws.max_write_ms);
+            ImGui::TextDisabled("%llu sent in %llu writes, %llu superseded, %llu rejected (queue full)",
+                                static_cast<unsigned long long>(ws.sent),
+                                static_cast<unsigned long long>(ws.writes),
+                                static_cast<unsigned long long>(ws.superseded),
+                                static_cast<unsigned long long>(ws.rejected));
+        };
+        const WebSocketClient::SendStats pishock_ws = pishock_ws_manager_ ? pishock_ws_manager_->GetSendStats() : WebSocketClient::SendStats{};
+        const WebSocketClient::SendStats buttplug_ws = buttplug_manager_ ? buttplug_manager_->GetSendStats() : WebSocketClient::SendStats{};
+        if (pishock_ws.sent + pishock_ws.rejected + buttplug_ws.sent + buttplug_ws.rejected > 0) {
+            ImGui::SeparatorText("WebSocket send queues");
+            render_ws_queue("PiShock", pishock_ws);
+            render_ws_queue("Buttplug", buttplug_ws);
+        }
+
+        // OpenShock coalescing window: triggers merged into shared requests.
+        if (openshock_manager_) {
+            const OpenShockManager::CoalesceStats openshock = openshock_manager_->GetCoalesceStats();
+            if (openshock.triggers > 0) {
+                ImGui::SeparatorText("OpenShock coalescing");
+                ImGui::TextDisabled("%llu triggers in %llu requests, %llu requests saved, %llu shocker commands merged",
+                                    static_cast<unsigned long long>(openshock.triggers),
+                                    static_cast<unsigned long long>(openshock.requests),
+                                    static_cast<unsigned long long>(openshock.requests_saved),
+                                    static_cast<unsigned long long>(openshock.commands_merged));
+            }
+        }
+    }
+
     void UIManager::RenderMainTab() {
         ImGui::Text("StayPutVR Status");
         ImGui::Separator();
@@ -306,6 +428,7 @@ namespace StayPutVR {
 
         // Communication health for every enabled integration.
         RenderConnectionStatusPanel();
+        RenderTriggerLatencyPanel();
 
         // Emergency Stop Status Panel
         if (emergency_stop_active_) {
@@ -779,6 +902,10 @@ namespace StayPutVR {
         }
     }
 
+    void UIManager::RenderLogsTab() {
+        log_viewer_.Render();
+    }
+
     void UIManager::RenderTimersTab() {
         ImGui::Text("Timer Settings");
         ImGui::Separator();
@@ -940,6 +1067,14 @@ namespace StayPutVR {
             ImGui::SameLine();
             ImGuiHelpers::HelpTooltip("DEBUG: most verbose. INFO: informational and above. "
                 "WARNING: warnings + errors (default). ERROR: errors only. CRITICAL: most severe only.");
+            ImGui::SameLine();
+            bool profiler_on = frame_profiler_.IsEnabled();
+            if (ImGui::Checkbox("Frame profiler", &profiler_on)) {
+                frame_profiler_.SetEnabled(profiler_on);
+            }
+            ImGui::SameLine();
+            ImGuiHelpers::HelpTooltip("Overlay with per-section UI CPU time and heap allocations per frame. "
+                "Toggle anywhere with F3. Not saved.");
         }
 
         // ---- First-class: About ----
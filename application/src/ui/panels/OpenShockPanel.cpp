@@ -2,6 +2,7 @@
 #include "../ImGuiHelpers.hpp"
 #include <imgui.h>
 #include <string>
+#include <algorithm>
 
 #include "../../managers/OpenShockManager.hpp"
 
@@ -94,6 +95,16 @@ void OpenShockPanel::Render() {
     ImGui::SameLine();
     ImGuiHelpers::HelpTooltip("OpenShock server URL (default: https://api.openshock.app)");
 
+    if (ImGui::InputInt("Coalesce Window (ms)", &config_.openshock_coalesce_window_ms, 5, 20)) {
+        config_.openshock_coalesce_window_ms = (std::clamp)(config_.openshock_coalesce_window_ms, 0, 500);
+        save_config_();
+    }
+    ImGui::SameLine();
+    ImGuiHelpers::HelpTooltip("Actions that fire within this window of each other (several devices leaving "
+        "the zone at once, a bite during a disobedience) go out as one request. Each shocker gets the "
+        "strongest action type with the highest intensity and longest duration among them. 0 still merges "
+        "actions that are already waiting.");
+
     ImGui::Separator();
 
     if (!config_.openshock_enabled) {
@@ -2,7 +2,9 @@
 # --- StayPutVR Linux development build script ---
 #
 # Builds the overlay GUI application (no SteamVR driver) for local development
-# and OSC simulation. The GUI runs; PiShock/Twitch/audio are stubbed on Linux.
+# and OSC simulation. The GUI runs; HTTP commands and the PiShock WS and
+# Buttplug WebSocket integrations work (https/wss when OpenSSL is installed).
+# Twitch EventSub and audio are stubbed on Linux.
 #
 # Usage:
 #   ./build_linux.sh [Debug|Release] [run]
@@ -0,0 +1,69 @@
+#include "AllocationCounter.hpp"
+
+#include <atomic>
+
+namespace {
+    // Trivially-initialized, so safe to touch from operator new at any point
+    // in a thread's life (no dynamic TLS initialization).
+    thread_local uint64_t t_allocations = 0;
+    std::atomic<uint64_t> g_allocations{0};
+
+#ifdef STAYPUTVR_ALLOC_AUDIT
+    constexpr int kTagCount = static_cast<int>(StayPutVR::AllocTag::Count);
+    thread_local StayPutVR::AllocTag t_tag = StayPutVR::AllocTag::Untagged;
+    std::atomic<uint64_t> g_tag_allocations[kTagCount] = {};
+#endif
+}
+
+namespace StayPutVR {
+
+void AllocationCounter::CountAllocation() noexcept {
+    ++t_allocations;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+#ifdef STAYPUTVR_ALLOC_AUDIT
+    g_tag_allocations[static_cast<int>(t_tag)].fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+uint64_t AllocationCounter::ThreadAllocations() {
+    return t_allocations;
+}
+
+uint64_t AllocationCounter::TotalAllocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::TagAllocations(AllocTag tag) {
+#ifdef STAYPUTVR_ALLOC_AUDIT
+    return g_tag_allocations[static_cast<int>(tag)].load(std::memory_order_relaxed);
+#else
+    (void)tag;
+    return 0;
+#endif
+}
+
+const char* ToString(AllocTag tag) {
+    switch (tag) {
+        case AllocTag::Untagged:  return "Untagged";
+        case AllocTag::UI:        return "UI";
+        case AllocTag::Devices:   return "Devices";
+        case AllocTag::IPC:       return "IPC";
+        case AllocTag::OSC:       return "OSC";
+        case AllocTag::WebSocket: return "WebSocket";
+        case AllocTag::WorkQueue: return "WorkQueue";
+        case AllocTag::Count:     break;
+    }
+    return "Unknown";
+}
+
+#ifdef STAYPUTVR_ALLOC_AUDIT
+AllocationScope::AllocationScope(AllocTag tag) : previous_(t_tag) {
+    t_tag = tag;
+}
+
+AllocationScope::~AllocationScope() {
+    t_tag = previous_;
+}
+#endif
+
+} // namespace StayPutVR
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+namespace StayPutVR {
+
+// Counts calls to the global operator new. The counting itself lives in
+// AllocationHooks.cpp (the stayputvr_alloc_hooks object library), which
+// replaces the global allocation functions with malloc/free wrappers that call
+// CountAllocation(). Only binaries that link it count anything: the app when
+// built with STAYPUTVR_COUNT_ALLOCATIONS (implied by STAYPUTVR_ALLOC_AUDIT)
+// and the benchmark tools. Everywhere else, including the driver, the
+// runtime's operator new is untouched and every count reads 0.
+//
+// Counts are monotonic; callers take a reading before and after a region and
+// diff them. The per-thread count is what the UI profiler uses, since other
+// threads (IPC reader, OSC receive, workers) allocate concurrently.
+
+// Subsystems that hot paths attribute their allocations to (see
+// AllocationScope). Only tracked in allocation-audit builds.
+enum class AllocTag : uint8_t {
+    Untagged = 0,
+    UI,          // UIManager::Render
+    Devices,     // UIManager::UpdateDevicePositions (+ deviation checks)
+    IPC,         // IPCClient device-update parsing
+    OSC,         // OSCManager inbound message dispatch
+    WebSocket,   // WebSocket message handlers (PiShock WS, Buttplug, Twitch)
+    WorkQueue,   // AsyncWorkQueue enqueue (std::function + queue node)
+    Count
+};
+
+const char* ToString(AllocTag tag);
+
+class AllocationCounter {
+public:
+    static uint64_t ThreadAllocations();
+    static uint64_t TotalAllocations();
+
+    // Whether this binary links the allocation hooks; when false the counts
+    // above are always 0 and callers should not display them.
+    static constexpr bool CountingEnabled() {
+#ifdef STAYPUTVR_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Called by the replacement operator new for every allocation.
+    static void CountAllocation() noexcept;
+
+    // Process-wide count of allocations made while `tag` was the innermost
+    // AllocationScope on the allocating thread. Always 0 unless built with
+    // STAYPUTVR_ALLOC_AUDIT.
+    static uint64_t TagAllocations(AllocTag tag);
+    static constexpr bool TaggingEnabled() {
+#ifdef STAYPUTVR_ALLOC_AUDIT
+        return true;
+#else
+        return false;
+#endif
+    }
+};
+
+// RAII: attribute this thread's allocations to `tag` until the scope ends
+// (scopes nest; the innermost wins). Compiles to nothing unless the build
+// enables STAYPUTVR_ALLOC_AUDIT, so it can stay in hot paths.
+#ifdef STAYPUTVR_ALLOC_AUDIT
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocTag tag);
+    ~AllocationScope();
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+private:
+    AllocTag previous_;
+};
+#else
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocTag) {}
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+};
+#endif
+
+} // namespace StayPutVR
@@ -7,6 +7,7 @@
 #include <thread>
 #include <atomic>
 #include "Logger.hpp"
+#include "AllocationCounter.hpp"
 
 namespace StayPutVR {
 
@@ -35,8 +36,12 @@ public:
         }
     }
 
+    // Note the std::function itself is built at the call site, so its
+    // allocation is attributed to the caller's AllocationScope; the queue
+    // node allocation is attributed here.
     bool Enqueue(std::function<void()> work) {
         if (!running_) return false;
+        AllocationScope alloc_scope(AllocTag::WorkQueue);
         {
             std::lock_guard<std::mutex> lock(mutex_);
             if (queue_.size() >= max_size_) {
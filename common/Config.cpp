@@ -403,6 +403,20 @@ ConfigResult Config::LoadFromFileEx(const std::string& filename) {
         }
         
         osc_query_enabled = jval(j, "osc_query_enabled", true);
+        osc_send_keepalive_seconds = jval(j, "osc_send_keepalive_seconds", 0.0f);
+        osc_receive_buffer_kb = jval(j, "osc_receive_buffer_kb", 1024);
+        osc_destinations.clear();
+        if (j.contains("osc_destinations") && j["osc_destinations"].is_array()) {
+            for (const auto& d : j["osc_destinations"]) {
+                if (!d.is_object()) continue;
+                OSCDestination dest;
+                dest.enabled = jval(d, "enabled", true);
+                dest.address = jval(d, "address", "127.0.0.1");
+                dest.port = jval(d, "port", 9002);
+                dest.filter = jval(d, "filter", "");
+                osc_destinations.push_back(dest);
+            }
+        }
         chaining_mode = jval(j, "chaining_mode", false);
 
         // Load OSC lock paths
@@ -545,6 +559,7 @@ ConfigResult Config::LoadFromFileEx(const std::string& filename) {
         }
         
         openshock_server_url = jval(j, "openshock_server_url", "https://api.openshock.app");
+        openshock_coalesce_window_ms = (std::max)(0, (std::min)(500, jval(j, "openshock_coalesce_window_ms", 20)));
         
         // Warning Zone OpenShock Settings
         openshock_warning_action = jval(j, "openshock_warning_action", 0);
@@ -920,6 +935,18 @@ ConfigResult Config::SaveToFileEx(const std::string& filename) const {
         j["osc_send_port"] = osc_send_port;
         j["osc_receive_port"] = osc_receive_port;
         j["osc_query_enabled"] = osc_query_enabled;
+        j["osc_send_keepalive_seconds"] = osc_send_keepalive_seconds;
+        j["osc_receive_buffer_kb"] = osc_receive_buffer_kb;
+        nlohmann::json osc_destinations_json = nlohmann::json::array();
+        for (const auto& dest : osc_destinations) {
+            osc_destinations_json.push_back({
+                {"enabled", dest.enabled},
+                {"address", dest.address},
+                {"port", dest.port},
+                {"filter", dest.filter}
+            });
+        }
+        j["osc_destinations"] = osc_destinations_json;
         j["chaining_mode"] = chaining_mode;
         
         // OSC device lock paths
@@ -1028,6 +1055,7 @@ ConfigResult Config::SaveToFileEx(const std::string& filename) const {
         j["openshock_device_ids"] = device_ids_json;
         
         j["openshock_server_url"] = openshock_server_url;
+        j["openshock_coalesce_window_ms"] = openshock_coalesce_window_ms;
         
         // Warning Zone OpenShock Settings
         j["openshock_warning_action"] = openshock_warning_action;
@@ -111,6 +111,25 @@ public:
     // from VRChat. Fixes conflicts with other OSC apps holding 9001. When off,
     // the fixed send/receive ports above are used.
     bool osc_query_enabled = true;
+    // Outbound params are only sent when they change. When > 0, a value that
+    // hasn't changed is re-sent after this many seconds anyway, in case
+    // VRChat dropped or reset it. 0 = change-only.
+    float osc_send_keepalive_seconds = 0.0f;
+    // Kernel receive buffer for the OSC socket (SO_RCVBUF), in KB. VRChat
+    // sends every avatar param at once after an avatar change; the OS default
+    // (~200 KB on Linux) can overflow on that burst. 0 = OS default.
+    int osc_receive_buffer_kb = 1024;
+    // Extra places to send outbound params besides VRChat (OSC routers,
+    // overlays, the VRCOSC PiShock module). filter is a comma-separated list
+    // of address prefixes, e.g. "/VRCOSC/PiShock/,/avatar/parameters/SPVR_";
+    // empty forwards everything. Each message is encoded once for all of them.
+    struct OSCDestination {
+        bool enabled = true;
+        std::string address = "127.0.0.1";
+        int port = 9002;
+        std::string filter;
+    };
+    std::vector<OSCDestination> osc_destinations;
     bool chaining_mode = false;
     std::string osc_address_bounds;
     std::string osc_address_warning;
@@ -243,6 +262,10 @@ public:
     std::string openshock_api_token;
     std::array<std::string, 5> openshock_device_ids; // Support up to 5 device IDs
     std::string openshock_server_url = "https://api.openshock.app"; 
+    // Triggers arriving within this many ms of each other are merged into
+    // one control request (per shocker: strongest type, max intensity and
+    // duration). 0 only merges triggers already waiting when it sends.
+    int openshock_coalesce_window_ms = 20;
     
     // Warning Zone OpenShock Settings
     // Durations are in SECONDS (0.3..15), converted to API ms at send time.
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <cstdint>
 
 namespace StayPutVR {
     // Shared device type definitions that both driver and application use
@@ -22,5 +23,9 @@ namespace StayPutVR {
         float rotation[4];
         bool connected;
         DeviceRole role = static_cast<DeviceRole>(0); // Default to None
+        // Latency tracing (see TriggerTrace.hpp): steady_clock microseconds when
+        // the driver sampled this pose and when the app received it. 0 = unknown.
+        int64_t sample_time_us = 0;
+        int64_t receive_time_us = 0;
     };
 }
@@ -0,0 +1,313 @@
+#include "EventLoop.hpp"
+#include "Logger.hpp"
+
+#include <climits>
+#include <future>
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace StayPutVR {
+
+EventLoop::EventLoop() {
+#ifdef _WIN32
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+}
+
+EventLoop::~EventLoop() {
+    Stop();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+EventLoop& EventLoop::Shared() {
+    static EventLoop loop;
+    static const bool started = loop.Start();
+    (void)started;
+    return loop;
+}
+
+bool EventLoop::Start() {
+    if (running_) return true;
+
+#ifdef _WIN32
+    // WSAPoll has no eventfd: wake it with a datagram to ourselves.
+    wake_sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int len = sizeof(addr);
+    u_long non_blocking = 1;
+    if (wake_sock_ == INVALID_SOCKET ||
+        bind(wake_sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        getsockname(wake_sock_, reinterpret_cast<sockaddr*>(&addr), &len) != 0 ||
+        connect(wake_sock_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ioctlsocket(wake_sock_, FIONBIO, &non_blocking) != 0) {
+        if (Logger::IsInitialized()) Logger::Error("EventLoop: failed to create wake socket: " + std::to_string(WSAGetLastError()));
+        if (wake_sock_ != INVALID_SOCKET) closesocket(wake_sock_);
+        wake_sock_ = INVALID_SOCKET;
+        return false;
+    }
+#else
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0; // the wake fd; watches start at 1
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) != 0) {
+        if (Logger::IsInitialized()) Logger::Error("EventLoop: failed to create epoll/eventfd: " + std::string(strerror(errno)));
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (wake_fd_ >= 0) close(wake_fd_);
+        epoll_fd_ = wake_fd_ = -1;
+        return false;
+    }
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        accepting_ = true;
+    }
+    running_ = true;
+    thread_ = std::thread(&EventLoop::Run, this);
+    return true;
+}
+
+void EventLoop::Stop() {
+    if (!running_.exchange(false)) return;
+    Wake();
+    if (thread_.joinable()) thread_.join();
+
+    // Anything posted before this point still runs (an Invoke() may be
+    // waiting on it); anything after runs inline on its caller.
+    std::vector<Callback> remaining;
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        accepting_ = false;
+        remaining.swap(posted_);
+    }
+    for (const auto& fn : remaining) Dispatch(fn);
+
+#ifdef _WIN32
+    closesocket(wake_sock_);
+    wake_sock_ = INVALID_SOCKET;
+#else
+    close(epoll_fd_);
+    close(wake_fd_);
+    epoll_fd_ = wake_fd_ = -1;
+#endif
+}
+
+EventLoop::Id EventLoop::WatchReadable(SOCKET sock, Callback on_readable) {
+    Id id = 0;
+    Invoke([&] {
+        id = next_id_++;
+        auto watch = std::make_shared<Watch>(Watch{sock, std::move(on_readable)});
+#ifndef _WIN32
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sock, &ev) != 0) {
+            if (Logger::IsInitialized()) Logger::Error("EventLoop: epoll_ctl(ADD) failed: " + std::string(strerror(errno)));
+            id = 0;
+            return;
+        }
+#endif
+        watches_.emplace(id, std::move(watch));
+    });
+    return id;
+}
+
+void EventLoop::Unwatch(Id id) {
+    if (id == 0) return;
+    Invoke([&] {
+        auto it = watches_.find(id);
+        if (it == watches_.end()) return;
+        it->second->active = false;
+#ifndef _WIN32
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second->sock, nullptr);
+#endif
+        watches_.erase(it);
+    });
+}
+
+EventLoop::Id EventLoop::AddTimer(Clock::duration delay, Callback fn, Clock::duration repeat) {
+    Id id = 0;
+    Invoke([&] {
+        id = next_id_++;
+        const Clock::time_point due = Clock::now() + delay;
+        timers_.emplace(id, Timer{due, repeat, std::move(fn)});
+        timer_queue_.emplace(due, id);
+    });
+    return id;
+}
+
+void EventLoop::CancelTimer(Id id) {
+    if (id == 0) return;
+    Invoke([&] {
+        if (id == firing_timer_) {
+            firing_cancelled_ = true; // erased once its callback returns
+            return;
+        }
+        timers_.erase(id); // its timer_queue_ entry is skipped when reached
+    });
+}
+
+void EventLoop::Post(Callback fn) {
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        if (accepting_ && running_) {
+            posted_.push_back(std::move(fn));
+            fn = nullptr;
+        }
+    }
+    if (fn) {
+        Dispatch(fn);
+        return;
+    }
+    Wake();
+}
+
+void EventLoop::Invoke(const Callback& fn) {
+    if (IsLoopThread() || !running_) {
+        fn();
+        return;
+    }
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    Post([&] {
+        fn();
+        done.set_value();
+    });
+    finished.wait();
+}
+
+void EventLoop::Wake() {
+#ifdef _WIN32
+    if (!wake_pending_.exchange(true)) send(wake_sock_, "", 1, 0);
+#else
+    const uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0) {
+        // EAGAIN: the counter is already non-zero, so a wakeup is pending.
+    }
+#endif
+}
+
+void EventLoop::Dispatch(const Callback& fn) {
+    try {
+        fn();
+    } catch (const std::exception& e) {
+        if (Logger::IsInitialized()) Logger::Error("EventLoop: callback threw: " + std::string(e.what()));
+    }
+}
+
+void EventLoop::RunPosted() {
+    std::vector<Callback> batch;
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        batch.swap(posted_);
+    }
+    for (const auto& fn : batch) Dispatch(fn);
+}
+
+void EventLoop::RunDueTimers() {
+    const Clock::time_point now = Clock::now();
+    while (!timer_queue_.empty() && timer_queue_.begin()->first <= now) {
+        const auto [due, id] = *timer_queue_.begin();
+        timer_queue_.erase(timer_queue_.begin());
+        auto it = timers_.find(id);
+        if (it == timers_.end() || it->second.due != due) continue; // cancelled
+
+        // Element references survive the callback adding timers (node-based map).
+        Timer& timer = it->second;
+        firing_timer_ = id;
+        firing_cancelled_ = false;
+        Dispatch(timer.fn);
+        firing_timer_ = 0;
+
+        if (firing_cancelled_ || timer.repeat == Clock::duration::zero()) {
+            timers_.erase(id);
+            continue;
+        }
+        // Keep the cadence, but don't replay ticks missed while the loop was busy.
+        timer.due += timer.repeat;
+        if (timer.due <= now) timer.due = now + timer.repeat;
+        timer_queue_.emplace(timer.due, id);
+    }
+}
+
+int EventLoop::MillisecondsUntilNextTimer() const {
+    if (timer_queue_.empty()) return -1;
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(timer_queue_.begin()->first - Clock::now());
+    if (wait.count() <= 0) return 0;
+    return wait.count() > INT_MAX ? INT_MAX : static_cast<int>(wait.count());
+}
+
+void EventLoop::Run() {
+    loop_thread_id_ = std::this_thread::get_id();
+
+#ifdef _WIN32
+    char drain[64];
+    while (running_) {
+        // WSAPoll takes the whole set each call; rebuild it from the watches.
+        poll_fds_.clear();
+        poll_watches_.clear();
+        poll_fds_.push_back(WSAPOLLFD{wake_sock_, POLLRDNORM, 0});
+        poll_watches_.push_back(nullptr);
+        for (const auto& [id, watch] : watches_) {
+            poll_fds_.push_back(WSAPOLLFD{watch->sock, POLLRDNORM, 0});
+            poll_watches_.push_back(watch);
+        }
+
+        const int ready = WSAPoll(poll_fds_.data(), static_cast<ULONG>(poll_fds_.size()),
+                                  MillisecondsUntilNextTimer());
+        if (ready == SOCKET_ERROR) {
+            if (Logger::IsInitialized()) Logger::Error("EventLoop: WSAPoll failed: " + std::to_string(WSAGetLastError()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (ready > 0) {
+            if (poll_fds_[0].revents) {
+                wake_pending_ = false;
+                while (recv(wake_sock_, drain, sizeof(drain), 0) > 0) {}
+            }
+            for (size_t i = 1; i < poll_fds_.size(); ++i) {
+                // Errors and hang-ups count as readable: the callback's recv reports them.
+                if (poll_fds_[i].revents && poll_watches_[i]->active) Dispatch(poll_watches_[i]->fn);
+            }
+        }
+        RunPosted();
+        RunDueTimers();
+    }
+    poll_watches_.clear();
+#else
+    epoll_event events[64];
+    while (running_) {
+        const int ready = epoll_wait(epoll_fd_, events, 64, MillisecondsUntilNextTimer());
+        for (int i = 0; i < ready; ++i) {
+            const Id id = events[i].data.u64;
+            if (id == 0) {
+                uint64_t count;
+                if (read(wake_fd_, &count, sizeof(count)) < 0) {}
+                continue;
+            }
+            auto it = watches_.find(id);
+            if (it == watches_.end()) continue; // unwatched earlier in this batch
+            std::shared_ptr<Watch> watch = it->second; // survives the callback unwatching itself
+            Dispatch(watch->fn);
+        }
+        RunPosted();
+        RunDueTimers();
+    }
+#endif
+
+    loop_thread_id_ = std::thread::id();
+}
+
+} // namespace StayPutVR
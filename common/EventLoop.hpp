@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#else
+#include "WinsockCompat.hpp"
+#endif
+
+namespace StayPutVR {
+
+// A single-threaded reactor: sockets are watched for readability and timers
+// fire on one thread that sleeps in epoll_wait() (Linux) or WSAPoll()
+// (Windows) until something is ready, instead of each subsystem running its
+// own thread around a blocking recv or a sleep_for() loop.
+//
+// Callbacks run on the loop thread and must not block; hand slow work (HTTP,
+// device I/O) to an AsyncWorkQueue. Watches, timers and Invoke() may be used
+// from any thread: off the loop thread they are marshalled onto it and wait,
+// so once Unwatch()/CancelTimer() returns the callback is not running and
+// will not run again. A callback may cancel itself.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    using Id = uint64_t; // 0 is never a valid id
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // The app-wide loop, started on first use and stopped at exit.
+    static EventLoop& Shared();
+
+    bool Start();
+    void Stop(); // runs anything still posted, then joins
+    bool IsRunning() const { return running_; }
+    bool IsLoopThread() const { return std::this_thread::get_id() == loop_thread_id_; }
+
+    // on_readable runs each time the socket has data (level-triggered).
+    Id WatchReadable(SOCKET sock, Callback on_readable);
+    void Unwatch(Id id);
+
+    // Fires once after delay, then every repeat if repeat is non-zero.
+    Id AddTimer(Clock::duration delay, Callback fn, Clock::duration repeat = Clock::duration::zero());
+    void CancelTimer(Id id);
+
+    // Runs fn on the loop thread: Post() returns at once, Invoke() waits.
+    // With the loop stopped both run fn on the caller's thread.
+    void Post(Callback fn);
+    void Invoke(const Callback& fn);
+
+private:
+    struct Watch {
+        SOCKET sock;
+        Callback fn;
+        bool active = true; // cleared by Unwatch(); a snapshot may still hold it
+    };
+    struct Timer {
+        Clock::time_point due;
+        Clock::duration repeat;
+        Callback fn;
+    };
+
+    void Run();
+    void Wake();
+    void RunPosted();
+    void RunDueTimers();
+    static void Dispatch(const Callback& fn);
+    int MillisecondsUntilNextTimer() const;
+
+    // Loop-thread state.
+    std::unordered_map<Id, std::shared_ptr<Watch>> watches_;
+    std::unordered_map<Id, Timer> timers_;
+    std::multimap<Clock::time_point, Id> timer_queue_;
+    Id firing_timer_ = 0;       // the timer whose callback is running
+    bool firing_cancelled_ = false;
+    uint64_t next_id_ = 1;
+
+    std::mutex post_mutex_;
+    std::vector<Callback> posted_;
+    bool accepting_ = true; // under post_mutex_; false once Stop() has drained posted_
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<std::thread::id> loop_thread_id_{};
+
+#ifdef _WIN32
+    SOCKET wake_sock_ = INVALID_SOCKET; // UDP socket connected to itself on loopback
+    std::atomic<bool> wake_pending_{false};
+    std::vector<WSAPOLLFD> poll_fds_;
+    std::vector<std::shared_ptr<Watch>> poll_watches_;
+#else
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1; // eventfd
+#endif
+};
+
+} // namespace StayPutVR
@@ -1,16 +1,24 @@
 #include "HttpClient.hpp"
 #include "Logger.hpp"
+#include "EventLoop.hpp"
 #ifdef _WIN32
 #include <Windows.h>
 #include <winhttp.h>
+#else
+#include "HttpLib.hpp"
 #endif
 #include <sstream>
 #include <string>
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <memory>
 #include <thread>
 #include <atomic>
-#include <queue>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
+#include <unordered_map>
 
 #ifdef _WIN32
 #pragma comment(lib, "winhttp.lib")
@@ -18,109 +26,577 @@
 
 namespace StayPutVR {
 
-#ifdef _WIN32
+namespace {
+    using Clock = std::chrono::steady_clock;
 
-bool HttpClient::initialized_ = false;
-std::thread HttpClient::worker_thread_;
-std::atomic<bool> HttpClient::worker_running_(false);
-std::queue<std::function<void()>> HttpClient::request_queue_;
-std::mutex HttpClient::queue_mutex_;
+    // Pooled connections idle longer than this are closed. Servers typically
+    // drop keep-alive sockets after 60-120 s; closing ours first avoids a
+    // command landing on a socket the server is about to reset.
+    constexpr auto kIdleTimeout = std::chrono::seconds(45);
+    constexpr auto kEvictionInterval = std::chrono::seconds(15);
+    // Concurrent requests to one host beyond this open extra connections that
+    // are closed, not pooled, when they finish.
+    constexpr size_t kMaxIdlePerHost = 4;
 
-bool HttpClient::Initialize() {
-    if (initialized_) {
+    constexpr const char* kPiShockApiUrl = "https://do.pishock.com/api/apioperate";
+
+    // Async commands that haven't been sent by then are dropped: a shock or
+    // vibration arriving seconds after the violation is no longer feedback.
+    constexpr auto kAsyncCommandDeadline = std::chrono::seconds(5);
+    // A prewarm that can't start soon is pointless once commands are queued.
+    constexpr auto kPrewarmDeadline = std::chrono::seconds(10);
+
+    struct ParsedUrl {
+        std::string scheme; // "http" or "https"
+        std::string host;
+        int port = 0;
+        std::string path;   // including any query string
+
+        // Pool key, and the form httplib::Client takes.
+        std::string Origin() const {
+            const bool ipv6 = host.find(':') != std::string::npos;
+            return scheme + "://" + (ipv6 ? "[" + host + "]" : host) + ":" + std::to_string(port);
+        }
+    };
+
+    bool ParseUrl(const std::string& url, ParsedUrl& out) {
+        const size_t scheme_end = url.find("://");
+        if (scheme_end == std::string::npos) return false;
+        out.scheme = url.substr(0, scheme_end);
+        std::transform(out.scheme.begin(), out.scheme.end(), out.scheme.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (out.scheme != "http" && out.scheme != "https") return false;
+
+        const size_t authority_start = scheme_end + 3;
+        const size_t path_start = url.find_first_of("/?#", authority_start);
+        std::string authority = url.substr(authority_start, path_start == std::string::npos
+                                                            ? std::string::npos
+                                                            : path_start - authority_start);
+        const size_t at = authority.rfind('@');
+        if (at != std::string::npos) authority.erase(0, at + 1);
+
+        std::string port;
+        if (!authority.empty() && authority[0] == '[') {
+            const size_t close = authority.find(']');
+            if (close == std::string::npos) return false;
+            out.host = authority.substr(1, close - 1);
+            if (close + 1 < authority.size()) {
+                if (authority[close + 1] != ':') return false;
+                port = authority.substr(close + 2);
+            }
+        } else {
+            const size_t colon = authority.rfind(':');
+            out.host = authority.substr(0, colon);
+            if (colon != std::string::npos) port = authority.substr(colon + 1);
+        }
+        if (out.host.empty()) return false;
+
+        out.port = out.scheme == "https" ? 443 : 80;
+        if (!port.empty()) {
+            if (port.size() > 5 || !std::all_of(port.begin(), port.end(),
+                                                [](unsigned char c) { return std::isdigit(c); })) {
+                return false;
+            }
+            out.port = std::stoi(port);
+            if (out.port <= 0 || out.port > 65535) return false;
+        }
+
+        out.path = path_start == std::string::npos ? "/" : url.substr(path_start);
+        const size_t fragment = out.path.find('#');
+        if (fragment != std::string::npos) out.path.erase(fragment);
+        if (out.path.empty() || out.path[0] != '/') out.path.insert(0, "/");
         return true;
     }
-    
-    initialized_ = true;
-    
-    // Start the worker thread for async requests
-    StartWorkerThread();
-    
-    return true;
-}
 
-void HttpClient::Shutdown() {
-    if (!initialized_) {
-        return;
+#ifdef _WIN32
+    std::string WideToUtf8(const std::wstring& wstr) {
+        if (wstr.empty()) return std::string();
+        int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
+        std::string strTo(size_needed, 0);
+        WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
+        return strTo;
     }
-    
-    // Stop the worker thread
-    StopWorkerThread();
-    
-    initialized_ = false;
-}
 
-void HttpClient::StartWorkerThread() {
-    if (worker_running_) {
-        return; // Thread already running
+    std::wstring Utf8ToWide(const std::string& str) {
+        if (str.empty()) return std::wstring();
+        int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
+        std::wstring wstrTo(size_needed, 0);
+        MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
+        return wstrTo;
     }
-    
-    // Set the flag
-    worker_running_ = true;
-    
-    // Start the worker thread
-    try {
-        worker_thread_ = std::thread(WorkerThreadFunction);
-        
-        if (Logger::IsInitialized()) {
-            Logger::Info("HttpClient: Worker thread started for async requests");
+
+    // A WinHTTP connect handle. The sockets themselves live in the session's
+    // own keep-alive pool, which WinHTTP shares between all handles to a host;
+    // pooling the handles keeps that session (and its warm sockets) alive.
+    struct Connection {
+        HINTERNET connect = nullptr;
+        bool secure = false;
+        Clock::time_point last_used;
+
+        ~Connection() {
+            if (connect) WinHttpCloseHandle(connect);
         }
-    }
-    catch (const std::exception& e) {
-        worker_running_ = false;
-        if (Logger::IsInitialized()) {
-            Logger::Error("HttpClient: Failed to start worker thread: " + std::string(e.what()));
+    };
+#else
+    // One keep-alive socket (and TLS session, in an OpenSSL build). httplib
+    // checks the socket before each request and reconnects if the server has
+    // closed it, so a stale pooled connection costs a reconnect, not a failure.
+    struct Connection {
+        explicit Connection(const std::string& origin) : client(origin) {}
+
+        httplib::Client client;
+        Clock::time_point last_used;
+    };
+#endif
+
+    // Idle connections per origin. A request takes one out for its duration,
+    // so a connection is never used by two threads at once, and puts it back
+    // if the exchange succeeded.
+    class ConnectionPool {
+    public:
+        ~ConnectionPool() { Clear(); }
+
+        // Returns nullptr if no idle connection to origin is pooled; the caller
+        // then opens one. Either way, must be paired with Return().
+        std::unique_ptr<Connection> Take(const std::string& origin) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++in_flight_;
+            auto it = idle_.find(origin);
+            if (it == idle_.end()) return nullptr;
+            std::unique_ptr<Connection> conn = std::move(it->second.back());
+            it->second.pop_back();
+            if (it->second.empty()) idle_.erase(it);
+            return conn;
+        }
+
+        // Pass nullptr to drop a connection that failed.
+        void Return(const std::string& origin, std::unique_ptr<Connection> conn) {
+            std::unique_ptr<Connection> surplus; // closed after the lock is released
+            std::lock_guard<std::mutex> lock(mutex_);
+            --in_flight_;
+            if (!conn) return;
+            auto& list = idle_[origin];
+            if (list.size() >= kMaxIdlePerHost) {
+                surplus = std::move(conn);
+                return;
+            }
+            conn->last_used = Clock::now();
+            list.push_back(std::move(conn));
+        }
+
+        bool HasIdle(const std::string& origin) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return idle_.count(origin) != 0;
         }
+
+        // Closes connections idle longer than kIdleTimeout.
+        void EvictIdle() {
+            std::vector<std::unique_ptr<Connection>> expired;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                const Clock::time_point cutoff = Clock::now() - kIdleTimeout;
+                for (auto it = idle_.begin(); it != idle_.end();) {
+                    auto& list = it->second;
+                    // Oldest first: Return() appends.
+                    auto fresh = std::find_if(list.begin(), list.end(),
+                        [&](const std::unique_ptr<Connection>& c) { return c->last_used > cutoff; });
+                    std::move(list.begin(), fresh, std::back_inserter(expired));
+                    list.erase(list.begin(), fresh);
+                    it = list.empty() ? idle_.erase(it) : std::next(it);
+                }
+            }
+            if (!expired.empty() && Logger::IsInitialized()) {
+                Logger::Debug("HttpClient: closed " + std::to_string(expired.size()) + " idle connection(s)");
+            }
+            expired.clear();
+#ifdef _WIN32
+            CloseSessionIfUnused();
+#endif
+        }
+
+        void Clear() {
+            std::unordered_map<std::string, std::vector<std::unique_ptr<Connection>>> idle;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle.swap(idle_);
+            }
+            idle.clear();
+#ifdef _WIN32
+            CloseSessionIfUnused();
+#endif
+        }
+
+#ifdef _WIN32
+        // Opened on first use and closed once nothing is pooled or in flight,
+        // which also closes the sockets WinHTTP was keeping alive.
+        HINTERNET Session() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!session_) {
+                session_ = WinHttpOpen(
+                    L"StayPutVR HTTP Client/1.0",
+                    WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                    WINHTTP_NO_PROXY_NAME,
+                    WINHTTP_NO_PROXY_BYPASS,
+                    0
+                );
+            }
+            return session_;
+        }
+#endif
+
+    private:
+#ifdef _WIN32
+        void CloseSessionIfUnused() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (session_ && idle_.empty() && in_flight_ == 0) {
+                WinHttpCloseHandle(session_);
+                session_ = nullptr;
+            }
+        }
+
+        HINTERNET session_ = nullptr;
+#endif
+        std::mutex mutex_;
+        std::unordered_map<std::string, std::vector<std::unique_ptr<Connection>>> idle_;
+        size_t in_flight_ = 0;
+    };
+
+    ConnectionPool g_pool;
+
+    // Idle eviction runs on the shared EventLoop. Kept apart from the pool's
+    // mutex: AddTimer/CancelTimer wait on the loop thread, which may be inside
+    // EvictIdle() waiting for the pool.
+    std::mutex g_eviction_mutex;
+    EventLoop::Id g_eviction_timer = 0;
+
+    void StartIdleEviction() {
+        std::lock_guard<std::mutex> lock(g_eviction_mutex);
+        if (g_eviction_timer != 0) return;
+        g_eviction_timer = EventLoop::Shared().AddTimer(kEvictionInterval, [] { g_pool.EvictIdle(); },
+                                                        kEvictionInterval);
     }
-}
 
-void HttpClient::StopWorkerThread() {
-    if (!worker_running_) {
-        return; // Thread not running
+    void StopIdleEviction() {
+        std::lock_guard<std::mutex> lock(g_eviction_mutex);
+        EventLoop::Shared().CancelTimer(g_eviction_timer);
+        g_eviction_timer = 0;
     }
-    
-    // Set the flag to stop
-    worker_running_ = false;
-    
-    // Wait for the thread to finish
-    if (worker_thread_.joinable()) {
-        worker_thread_.join();
+
+#ifdef _WIN32
+    std::unique_ptr<Connection> OpenConnection(const ParsedUrl& target, std::string& error) {
+        HINTERNET session = g_pool.Session();
+        if (!session) {
+            error = "failed to open HTTP session, error " + std::to_string(GetLastError());
+            return nullptr;
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->secure = target.scheme == "https";
+        conn->connect = WinHttpConnect(session, Utf8ToWide(target.host).c_str(),
+                                       static_cast<INTERNET_PORT>(target.port), 0);
+        if (!conn->connect) {
+            error = "failed to connect to server " + target.host + ", error " + std::to_string(GetLastError());
+            return nullptr;
+        }
+        return conn;
     }
-    
-    // Clear the queue
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        while (!request_queue_.empty()) {
-            request_queue_.pop();
+
+    // Sends one request on conn and reads the whole response. Returns false
+    // only if no HTTP response was received; the status is left to the caller.
+    bool Transfer(Connection& conn, const ParsedUrl& target, const std::string& method,
+                  const std::map<std::string, std::string>& headers, const std::string& body,
+                  std::string& responseText, int& statusCode,
+                  const std::function<void(int)>& progressCallback, std::string& error) {
+        HINTERNET hRequest = WinHttpOpenRequest(
+            conn.connect,
+            Utf8ToWide(method).c_str(),
+            Utf8ToWide(target.path).c_str(),
+            NULL,
+            WINHTTP_NO_REFERER,
+            WINHTTP_DEFAULT_ACCEPT_TYPES,
+            conn.secure ? WINHTTP_FLAG_SECURE : 0
+        );
+        if (!hRequest) {
+            error = "failed to open request, error " + std::to_string(GetLastError());
+            return false;
+        }
+
+        // Add headers
+        for (const auto& header : headers) {
+            std::wstring headerLine = Utf8ToWide(header.first + ": " + header.second);
+            if (!WinHttpAddRequestHeaders(
+                hRequest,
+                headerLine.c_str(),
+                (DWORD)headerLine.length(),
+                WINHTTP_ADDREQ_FLAG_ADD)) {
+
+                DWORD headerError = GetLastError();
+                Logger::Warning("Failed to add header: " + header.first + " Error: " + std::to_string(headerError));
+                // Continue anyway
+            }
+        }
+
+        if (!WinHttpSendRequest(
+                hRequest,
+                WINHTTP_NO_ADDITIONAL_HEADERS,
+                0,
+                (LPVOID)body.c_str(),
+                (DWORD)body.length(),
+                (DWORD)body.length(),
+                0)) {
+            error = "failed to send request, error " + std::to_string(GetLastError());
+            WinHttpCloseHandle(hRequest);
+            return false;
+        }
+
+        if (!WinHttpReceiveResponse(hRequest, NULL)) {
+            error = "failed to receive response, error " + std::to_string(GetLastError());
+            WinHttpCloseHandle(hRequest);
+            return false;
+        }
+
+        DWORD status = 0;
+        DWORD statusSize = sizeof(status);
+        WinHttpQueryHeaders(
+            hRequest,
+            WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+            WINHTTP_HEADER_NAME_BY_INDEX,
+            &status,
+            &statusSize,
+            WINHTTP_NO_HEADER_INDEX
+        );
+        statusCode = static_cast<int>(status);
+
+        // Read the body to the end: WinHTTP only returns the socket to the
+        // session's keep-alive pool once the response has been consumed.
+        responseText.clear();
+        char buffer[4096];
+        for (;;) {
+            DWORD bytesAvailable = 0;
+            if (!WinHttpQueryDataAvailable(hRequest, &bytesAvailable) || bytesAvailable == 0) {
+                break;
+            }
+            DWORD bytesRead = 0;
+            if (!WinHttpReadData(hRequest, buffer, (std::min)(bytesAvailable, (DWORD)sizeof(buffer)), &bytesRead) ||
+                bytesRead == 0) {
+                break;
+            }
+            responseText.append(buffer, bytesRead);
+
+            if (progressCallback) {
+                progressCallback(0); // We don't have total size, so just indicate progress
+            }
         }
+
+        WinHttpCloseHandle(hRequest);
+        return true;
     }
-    
-    if (Logger::IsInitialized()) {
-        Logger::Info("HttpClient: Worker thread stopped");
+#else
+    std::unique_ptr<Connection> OpenConnection(const ParsedUrl& target, std::string& error) {
+        auto conn = std::make_unique<Connection>(target.Origin());
+        if (!conn->client.is_valid()) {
+            error = target.scheme == "https"
+                ? "HTTPS is not available in this build (cpp-httplib built without OpenSSL)"
+                : "invalid URL host";
+            return nullptr;
+        }
+        conn->client.set_keep_alive(true);
+        // httplib writes headers and body separately; on a reused socket Nagle
+        // would hold the body back until the server's delayed ACK (~40 ms).
+        conn->client.set_tcp_nodelay(true);
+        // WinHTTP's defaults, so both backends give up at the same points.
+        conn->client.set_connection_timeout(60);
+        conn->client.set_read_timeout(30);
+        conn->client.set_write_timeout(30);
+        return conn;
     }
-}
 
-void HttpClient::WorkerThreadFunction() {
-    if (Logger::IsInitialized()) {
-        Logger::Debug("HttpClient: Worker thread started");
+    bool Transfer(Connection& conn, const ParsedUrl& target, const std::string& method,
+                  const std::map<std::string, std::string>& headers, const std::string& body,
+                  std::string& responseText, int& statusCode,
+                  const std::function<void(int)>& progressCallback, std::string& error) {
+        httplib::Request req;
+        req.method = method;
+        req.path = target.path;
+        for (const auto& header : headers) {
+            req.headers.emplace(header.first, header.second);
+        }
+        req.body = body;
+        if (progressCallback) {
+            req.download_progress = [&progressCallback](size_t current, size_t total) {
+                progressCallback(total ? static_cast<int>(current * 100 / total) : 0);
+                return true;
+            };
+        }
+
+        httplib::Result result = conn.client.send(req);
+        if (!result) {
+            error = httplib::to_string(result.error());
+            return false;
+        }
+        statusCode = result->status;
+        responseText = std::move(result->body);
+        return true;
     }
-    
-    while (worker_running_) {
-        std::function<void()> request = nullptr;
-        
-        // Get a request from the queue
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            if (!request_queue_.empty()) {
-                request = request_queue_.front();
-                request_queue_.pop();
+#endif
+
+    // Async executor: a few workers blocked on a condition variable. Jobs
+    // carry their origin so that one slow host can hold at most
+    // kMaxConcurrentPerHost workers, leaving the rest for other hosts.
+    constexpr size_t kWorkerCount = 3;
+    constexpr size_t kMaxConcurrentPerHost = 2;
+    constexpr size_t kMaxQueuedJobs = 64;
+
+    struct AsyncJob {
+        std::string host;
+        std::function<void()> run;
+        std::function<void()> on_expired;
+        Clock::time_point queued_at;
+        Clock::time_point deadline; // Clock::time_point::max() for none
+    };
+
+    class AsyncExecutor {
+    public:
+        ~AsyncExecutor() { Stop(); }
+
+        void Start() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (running_) return;
+            running_ = true;
+            try {
+                for (size_t i = 0; i < kWorkerCount; ++i) {
+                    workers_.emplace_back(&AsyncExecutor::WorkerLoop, this);
+                }
+            }
+            catch (const std::exception& e) {
+                if (Logger::IsInitialized()) {
+                    Logger::Error("HttpClient: Failed to start worker thread: " + std::string(e.what()));
+                }
+            }
+            if (Logger::IsInitialized()) {
+                Logger::Info("HttpClient: " + std::to_string(workers_.size()) + " worker threads started for async requests");
             }
         }
-        
-        // Process the request
-        if (request) {
+
+        // Queued jobs are discarded; running ones finish first.
+        void Stop() {
+            std::vector<std::thread> workers;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!running_) return;
+                running_ = false;
+                queue_.clear();
+                workers.swap(workers_);
+            }
+            cv_.notify_all();
+            for (auto& worker : workers) {
+                if (worker.joinable()) worker.join();
+            }
+            if (Logger::IsInitialized()) {
+                Logger::Info("HttpClient: Worker threads stopped");
+            }
+        }
+
+        bool IsRunning() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return running_;
+        }
+
+        bool Enqueue(AsyncJob job) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (queue_.size() >= kMaxQueuedJobs) {
+                    ++stats_.rejected;
+                    if (Logger::IsInitialized()) {
+                        Logger::Warning("HttpClient: async queue full (" + std::to_string(kMaxQueuedJobs) +
+                                        "), dropping request to " + job.host);
+                    }
+                    return false;
+                }
+                queue_.push_back(std::move(job));
+                stats_.peak_queued = (std::max)(stats_.peak_queued, queue_.size());
+            }
+            cv_.notify_one();
+            return true;
+        }
+
+        HttpClient::AsyncStats Stats() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            HttpClient::AsyncStats stats = stats_;
+            stats.queued = queue_.size();
+            return stats;
+        }
+
+    private:
+        void WorkerLoop() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (running_) {
+                // Overdue jobs go first, wherever they are in the queue, so their
+                // callers hear about it at the deadline rather than much later.
+                const Clock::time_point now = Clock::now();
+                std::vector<AsyncJob> expired;
+                for (auto it = queue_.begin(); it != queue_.end();) {
+                    if (it->deadline <= now) {
+                        expired.push_back(std::move(*it));
+                        it = queue_.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                if (!expired.empty()) {
+                    stats_.expired += expired.size();
+                    lock.unlock();
+                    for (auto& job : expired) {
+                        if (Logger::IsInitialized()) {
+                            Logger::Warning("HttpClient: request to " + job.host + " expired after " +
+                                            std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(now - job.queued_at).count()) +
+                                            " ms in the queue");
+                        }
+                        if (job.on_expired) Run(job.on_expired);
+                    }
+                    lock.lock();
+                    continue;
+                }
+
+                // Oldest job whose host is under its cap.
+                auto next = std::find_if(queue_.begin(), queue_.end(), [this](const AsyncJob& job) {
+                    auto it = host_in_flight_.find(job.host);
+                    return it == host_in_flight_.end() || it->second < kMaxConcurrentPerHost;
+                });
+                if (next == queue_.end()) {
+                    // Empty, or every queued host is at its cap: sleep until a
+                    // job arrives or finishes, or the earliest deadline passes.
+                    Clock::time_point wake = Clock::time_point::max();
+                    for (const auto& job : queue_) wake = (std::min)(wake, job.deadline);
+                    if (wake == Clock::time_point::max()) {
+                        cv_.wait(lock);
+                    } else {
+                        cv_.wait_until(lock, wake);
+                    }
+                    continue;
+                }
+
+                AsyncJob job = std::move(*next);
+                queue_.erase(next);
+                ++host_in_flight_[job.host];
+                ++stats_.in_flight;
+                stats_.max_wait_ms = (std::max)(stats_.max_wait_ms,
+                    std::chrono::duration<double, std::milli>(now - job.queued_at).count());
+
+                lock.unlock();
+                Run(job.run);
+                lock.lock();
+
+                if (--host_in_flight_[job.host] == 0) host_in_flight_.erase(job.host);
+                --stats_.in_flight;
+                ++stats_.completed;
+                // A host slot freed up; an idle worker may now have work.
+                cv_.notify_one();
+            }
+        }
+
+        static void Run(const std::function<void()>& fn) {
             try {
-                request();
+                fn();
             }
             catch (const std::exception& e) {
                 if (Logger::IsInitialized()) {
@@ -133,28 +609,81 @@ void HttpClient::WorkerThreadFunction() {
                 }
             }
         }
-        else {
-            // No requests, sleep for a bit
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<AsyncJob> queue_;
+        std::unordered_map<std::string, size_t> host_in_flight_;
+        std::vector<std::thread> workers_;
+        bool running_ = false;
+        HttpClient::AsyncStats stats_; // queued is filled in by Stats()
+    };
+
+    AsyncExecutor g_executor;
+} // namespace
+
+bool HttpClient::initialized_ = false;
+
+bool HttpClient::Initialize() {
+    if (initialized_) {
+        return true;
     }
     
-    if (Logger::IsInitialized()) {
-        Logger::Debug("HttpClient: Worker thread stopped");
-    }
+    initialized_ = true;
+    
+    // Start the worker threads for async requests
+    StartWorkerThread();
+    StartIdleEviction();
+    
+    return true;
 }
 
-void HttpClient::QueueAsyncRequest(std::function<void()> request) {
-    if (!worker_running_) {
-        // Worker not running, start it
-        StartWorkerThread();
+void HttpClient::Shutdown() {
+    if (!initialized_) {
+        return;
     }
     
-    // Add the request to the queue
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        request_queue_.push(request);
+    // Stop the worker threads
+    StopWorkerThread();
+    StopIdleEviction();
+    CloseIdleConnections();
+    
+    initialized_ = false;
+}
+
+void HttpClient::StartWorkerThread() {
+    g_executor.Start();
+}
+
+void HttpClient::StopWorkerThread() {
+    g_executor.Stop();
+}
+
+bool HttpClient::QueueAsyncRequest(
+    const std::string& url,
+    std::function<void()> request,
+    std::chrono::milliseconds deadline,
+    std::function<void()> on_expired) {
+
+    if (!g_executor.IsRunning()) {
+        // Workers not running, start them
+        StartWorkerThread();
     }
+
+    ParsedUrl target;
+    AsyncJob job;
+    job.host = ParseUrl(url, target) ? target.Origin() : url;
+    job.run = std::move(request);
+    job.on_expired = std::move(on_expired);
+    job.queued_at = Clock::now();
+    job.deadline = deadline > std::chrono::milliseconds::zero()
+        ? job.queued_at + deadline
+        : Clock::time_point::max();
+    return g_executor.Enqueue(std::move(job));
+}
+
+HttpClient::AsyncStats HttpClient::GetAsyncStats() {
+    return g_executor.Stats();
 }
 
 bool HttpClient::PostJson(
@@ -178,38 +707,6 @@ bool HttpClient::PostJson(
     return SendHttpRequest(url, "POST", headers, body, responseText, progressCallback);
 }
 
-// Convert a wide character string to a UTF-8 string
-std::string WideToUtf8(const std::wstring& wstr) {
-    if (wstr.empty()) return std::string();
-    
-    // Calculate the required buffer size
-    int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-    
-    // Create the output string of the required size
-    std::string strTo(size_needed, 0);
-    
-    // Perform the conversion
-    WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-    
-    return strTo;
-}
-
-// Convert a UTF-8 string to a wide character string
-std::wstring Utf8ToWide(const std::string& str) {
-    if (str.empty()) return std::wstring();
-    
-    // Calculate the required buffer size
-    int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-    
-    // Create the output string of the required size
-    std::wstring wstrTo(size_needed, 0);
-    
-    // Perform the conversion
-    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
-    
-    return wstrTo;
-}
-
 bool HttpClient::SendHttpRequest(
     const std::string& url,
     const std::string& method,
@@ -217,189 +714,84 @@ bool HttpClient::SendHttpRequest(
     const std::string& body,
     std::string& responseText,
     std::function<void(int progress)> progressCallback) {
-    
-    // Parse URL
-    URL_COMPONENTS urlComp;
-    ZeroMemory(&urlComp, sizeof(urlComp));
-    urlComp.dwStructSize = sizeof(urlComp);
-    
-    // Set required fields
-    urlComp.dwSchemeLength = (DWORD)-1;
-    urlComp.dwHostNameLength = (DWORD)-1;
-    urlComp.dwUrlPathLength = (DWORD)-1;
-    urlComp.dwExtraInfoLength = (DWORD)-1;
-    
-    std::wstring wideUrl = Utf8ToWide(url);
-    if (!WinHttpCrackUrl(wideUrl.c_str(), (DWORD)wideUrl.length(), 0, &urlComp)) {
-        DWORD error = GetLastError();
-        Logger::Error("Failed to parse URL: " + url + " Error: " + std::to_string(error));
-        return false;
-    }
-    
-    // Extract URL components
-    std::wstring scheme(urlComp.lpszScheme, urlComp.dwSchemeLength);
-    std::wstring hostName(urlComp.lpszHostName, urlComp.dwHostNameLength);
-    std::wstring urlPath(urlComp.lpszUrlPath, urlComp.dwUrlPathLength);
-    if (urlComp.dwExtraInfoLength > 0) {
-        urlPath += std::wstring(urlComp.lpszExtraInfo, urlComp.dwExtraInfoLength);
-    }
-    
-    // Open session
-    HINTERNET hSession = WinHttpOpen(
-        L"StayPutVR HTTP Client/1.0",
-        WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-        WINHTTP_NO_PROXY_NAME,
-        WINHTTP_NO_PROXY_BYPASS,
-        0
-    );
-    
-    if (!hSession) {
-        DWORD error = GetLastError();
-        Logger::Error("Failed to open HTTP session. Error: " + std::to_string(error));
-        return false;
-    }
-    
-    // Connect to server
-    HINTERNET hConnect = WinHttpConnect(
-        hSession,
-        hostName.c_str(),
-        urlComp.nPort,
-        0
-    );
-    
-    if (!hConnect) {
-        DWORD error = GetLastError();
-        Logger::Error("Failed to connect to server: " + WideToUtf8(hostName) + " Error: " + std::to_string(error));
-        WinHttpCloseHandle(hSession);
-        return false;
-    }
-    
-    // Create request
-    DWORD flags = (scheme == L"https") ? WINHTTP_FLAG_SECURE : 0;
-    HINTERNET hRequest = WinHttpOpenRequest(
-        hConnect,
-        Utf8ToWide(method).c_str(),
-        urlPath.c_str(),
-        NULL,
-        WINHTTP_NO_REFERER,
-        WINHTTP_DEFAULT_ACCEPT_TYPES,
-        flags
-    );
-    
-    if (!hRequest) {
-        DWORD error = GetLastError();
-        Logger::Error("Failed to open request. Error: " + std::to_string(error));
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return false;
-    }
-    
-    // Add headers
-    for (const auto& header : headers) {
-        std::wstring headerLine = Utf8ToWide(header.first + ": " + header.second);
-        if (!WinHttpAddRequestHeaders(
-            hRequest,
-            headerLine.c_str(),
-            (DWORD)headerLine.length(),
-            WINHTTP_ADDREQ_FLAG_ADD)) {
-            
-            DWORD error = GetLastError();
-            Logger::Warning("Failed to add header: " + header.first + " Error: " + std::to_string(error));
-            // Continue anyway
-        }
-    }
-    
-    // Send request
-    BOOL result = WinHttpSendRequest(
-        hRequest,
-        WINHTTP_NO_ADDITIONAL_HEADERS,
-        0,
-        (LPVOID)body.c_str(),
-        (DWORD)body.length(),
-        (DWORD)body.length(),
-        0
-    );
-    
-    if (!result) {
-        DWORD error = GetLastError();
-        Logger::Error("Failed to send request. Error: " + std::to_string(error));
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
+
+    ParsedUrl target;
+    if (!ParseUrl(url, target)) {
+        Logger::Error("Failed to parse URL: " + url);
         return false;
     }
-    
-    // Receive response
-    result = WinHttpReceiveResponse(hRequest, NULL);
-    if (!result) {
-        DWORD error = GetLastError();
-        Logger::Error("Failed to receive response. Error: " + std::to_string(error));
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
+    const std::string origin = target.Origin();
+
+    // No retry on a transport error: commands are not idempotent, and a
+    // request that failed mid-flight may already have reached the device.
+    std::string error;
+    int statusCode = 0;
+    std::unique_ptr<Connection> conn = g_pool.Take(origin);
+    if (!conn) conn = OpenConnection(target, error);
+    const bool received = conn &&
+        Transfer(*conn, target, method, headers, body, responseText, statusCode, progressCallback, error);
+    g_pool.Return(origin, received ? std::move(conn) : nullptr);
+
+    if (!received) {
+        Logger::Error("HTTP " + method + " " + url + " failed: " + error);
         return false;
     }
-    
-    // Get response status code
-    DWORD statusCode = 0;
-    DWORD statusCodeSize = sizeof(statusCode);
-    WinHttpQueryHeaders(
-        hRequest,
-        WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-        WINHTTP_HEADER_NAME_BY_INDEX,
-        &statusCode,
-        &statusCodeSize,
-        WINHTTP_NO_HEADER_INDEX
-    );
-    
-    // Read response data
-    responseText.clear();
-    DWORD bytesAvailable = 0;
-    DWORD bytesRead = 0;
-    char buffer[4096];
-    
-    do {
-        bytesAvailable = 0;
-        result = WinHttpQueryDataAvailable(hRequest, &bytesAvailable);
-        
-        if (!result || bytesAvailable == 0) {
-            break;
-        }
-        
-        ZeroMemory(buffer, sizeof(buffer));
-        if (bytesAvailable > sizeof(buffer)) {
-            bytesAvailable = sizeof(buffer);
-        }
-        
-        result = WinHttpReadData(hRequest, buffer, bytesAvailable, &bytesRead);
-        
-        if (!result || bytesRead == 0) {
-            break;
-        }
-        
-        responseText.append(buffer, bytesRead);
-        
-        // Call progress callback if provided
-        if (progressCallback) {
-            progressCallback(0); // We don't have total size, so just indicate progress
-        }
-    } while (bytesAvailable > 0);
-    
-    // Clean up
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-    
+
     // Check status code
     if (statusCode >= 200 && statusCode < 300) {
         return true;
     } else {
-        Logger::Error("HTTP request failed with status code: " + std::to_string(statusCode) + 
+        Logger::Error("HTTP request failed with status code: " + std::to_string(statusCode) +
                      " Response: " + responseText);
         return false;
     }
 }
 
+void HttpClient::PrewarmConnection(const std::string& url) {
+    ParsedUrl target;
+    if (!ParseUrl(url, target)) {
+        if (Logger::IsInitialized()) {
+            Logger::Warning("HttpClient: not prewarming unparseable URL: " + url);
+        }
+        return;
+    }
+    const std::string origin = target.Origin();
+    if (g_pool.HasIdle(origin)) {
+        return;
+    }
+
+    // A HEAD exchange is the cheapest way to get DNS, TCP and TLS done; any
+    // response at all means the connection is up and can be pooled.
+    Initialize();
+    QueueAsyncRequest(url, [target, origin]() {
+        std::string error;
+        std::string response;
+        int statusCode = 0;
+        std::unique_ptr<Connection> conn = g_pool.Take(origin);
+        if (conn) {
+            // Warmed since this was queued (several locks in quick succession).
+            g_pool.Return(origin, std::move(conn));
+            return;
+        }
+        conn = OpenConnection(target, error);
+        const bool received = conn &&
+            Transfer(*conn, target, "HEAD", {}, "", response, statusCode, nullptr, error);
+        g_pool.Return(origin, received ? std::move(conn) : nullptr);
+
+        if (Logger::IsInitialized()) {
+            if (received) {
+                Logger::Debug("HttpClient: prewarmed connection to " + origin);
+            } else {
+                Logger::Warning("HttpClient: prewarming " + origin + " failed: " + error);
+            }
+        }
+    }, kPrewarmDeadline);
+}
+
+void HttpClient::CloseIdleConnections() {
+    g_pool.Clear();
+}
+
 bool SendPiShockCommand(
     const std::string& username,
     const std::string& apiKey,
@@ -443,7 +835,7 @@ bool SendPiShockCommand(
     headers["X-PiShock-Api-Key"] = apiKey;
 
     bool success = HttpClient::PostJson(
-        "https://do.pishock.com/api/apioperate",
+        kPiShockApiUrl,
         requestBody,
         response,
         headers
@@ -458,6 +850,10 @@ bool SendPiShockCommand(
     return success;
 }
 
+void PrewarmPiShockConnection() {
+    HttpClient::PrewarmConnection(kPiShockApiUrl);
+}
+
 void SendPiShockCommandAsync(
     const std::string& username,
     const std::string& apiKey,
@@ -508,7 +904,7 @@ void SendPiShockCommandAsync(
         headers["X-PiShock-Api-Key"] = apiKey;
 
         bool success = HttpClient::PostJson(
-            "https://do.pishock.com/api/apioperate",
+            kPiShockApiUrl,
             requestBody,
             response,
             headers
@@ -527,7 +923,14 @@ void SendPiShockCommandAsync(
     };
     
     // Add the request to the async queue
-    HttpClient::QueueAsyncRequest(request);
+    const bool queued = HttpClient::QueueAsyncRequest(kPiShockApiUrl, request, kAsyncCommandDeadline, [callback]() {
+        if (callback) {
+            callback(false, "PiShock command expired before it could be sent");
+        }
+    });
+    if (!queued && callback) {
+        callback(false, "HTTP request queue full");
+    }
 }
 
 bool SendOpenShockCommand(
@@ -679,7 +1082,14 @@ void SendOpenShockCommandAsync(
     };
     
     // Add the request to the async queue
-    HttpClient::QueueAsyncRequest(request);
+    const bool queued = HttpClient::QueueAsyncRequest(serverUrl, request, kAsyncCommandDeadline, [callback]() {
+        if (callback) {
+            callback(false, "OpenShock command expired before it could be sent");
+        }
+    });
+    if (!queued && callback) {
+        callback(false, "HTTP request queue full");
+    }
 }
 
 bool SendOpenShockCommandMulti(
@@ -691,51 +1101,72 @@ bool SendOpenShockCommandMulti(
     int duration,
     std::string& response) {
     
+    if (deviceIds.empty()) {
+        Logger::Error("No device IDs provided for OpenShock multi-device command");
+        return false;
+    }
+    
+    std::vector<OpenShockControl> controls;
+    controls.reserve(deviceIds.size());
+    for (const auto& deviceId : deviceIds) {
+        controls.push_back({deviceId, operation, intensity, duration});
+    }
+    return SendOpenShockControls(serverUrl, apiToken, controls, response);
+}
+
+bool SendOpenShockControls(
+    const std::string& serverUrl,
+    const std::string& apiToken,
+    const std::vector<OpenShockControl>& controls,
+    std::string& response) {
+    
     if (!HttpClient::Initialize()) {
         Logger::Error("Failed to initialize HTTP client for OpenShock multi-device command");
         return false;
     }
     
-    if (deviceIds.empty()) {
-        Logger::Error("No device IDs provided for OpenShock multi-device command");
+    if (controls.empty()) {
+        Logger::Error("No controls provided for OpenShock command");
         return false;
     }
     
-    // Create the JSON payload for OpenShock API with multiple devices
+    // Create the JSON payload for OpenShock API with one entry per device
     nlohmann::json requestBody = nlohmann::json::array();
     
-    // Convert operation integer to string type
-    std::string type_string;
-    switch (operation) {
-        case 0: type_string = "Shock"; break;
-        case 1: type_string = "Vibrate"; break;
-        case 2: type_string = "Sound"; break;
-        default: type_string = "Stop"; break;
-    }
-    
-    // Create control data for each device
-    for (const auto& deviceId : deviceIds) {
+    for (const auto& control : controls) {
+        // Convert operation integer to string type
+        std::string type_string;
+        switch (control.operation) {
+            case 0: type_string = "Shock"; break;
+            case 1: type_string = "Vibrate"; break;
+            case 2: type_string = "Sound"; break;
+            default: type_string = "Stop"; break;
+        }
+        
         nlohmann::json control_data;
-        control_data["id"] = deviceId;
+        control_data["id"] = control.deviceId;
         control_data["type"] = type_string;
         
         // For sound, intensity is required but not meaningful, use 1 as minimum
-        if (type_string == "Sound" && intensity == 0) {
+        if (type_string == "Sound" && control.intensity == 0) {
             control_data["intensity"] = 1;
         } else {
-            control_data["intensity"] = intensity;
+            control_data["intensity"] = control.intensity;
         }
         
-        control_data["duration"] = duration;
+        control_data["duration"] = control.duration;
         control_data["exclusive"] = true;  // Stop other commands when this one starts
         
         requestBody.push_back(control_data);
     }
     
-    Logger::Info("Sending OpenShock multi-device command to " + std::to_string(deviceIds.size()) + 
-                 " devices. Operation: " + std::to_string(operation) + 
-                 ", Intensity: " + std::to_string(intensity) + 
-                 ", Duration: " + std::to_string(duration) + "ms");
+    if (controls.size() == 1) {
+        Logger::Info("Sending OpenShock command. Operation: " + std::to_string(controls[0].operation) + 
+                     ", Intensity: " + std::to_string(controls[0].intensity) + 
+                     ", Duration: " + std::to_string(controls[0].duration) + "ms");
+    } else {
+        Logger::Info("Sending OpenShock multi-device command to " + std::to_string(controls.size()) + " devices");
+    }
     
     // Prepare headers for OpenShock API
     std::map<std::string, std::string> headers;
@@ -760,66 +1191,4 @@ bool SendOpenShockCommandMulti(
     return success;
 }
 
-#else // !_WIN32 — Linux development build: HTTP/PiShock-legacy/OpenShock stubbed (no WinHTTP).
-
-bool HttpClient::initialized_ = false;
-std::thread HttpClient::worker_thread_;
-std::atomic<bool> HttpClient::worker_running_(false);
-std::queue<std::function<void()>> HttpClient::request_queue_;
-std::mutex HttpClient::queue_mutex_;
-
-bool HttpClient::Initialize() { initialized_ = true; return true; }
-void HttpClient::Shutdown() { initialized_ = false; }
-
-bool HttpClient::PostJson(const std::string&, const nlohmann::json&, std::string& responseText,
-                          const std::map<std::string, std::string>&, std::function<void(int)>) {
-    responseText = "HTTP disabled on Linux development build";
-    return false;
-}
-
-bool HttpClient::SendHttpRequest(const std::string&, const std::string&,
-                                 const std::map<std::string, std::string>&, const std::string&,
-                                 std::string& responseText, std::function<void(int)>) {
-    responseText = "HTTP disabled on Linux development build";
-    return false;
-}
-
-void HttpClient::StartWorkerThread() {}
-void HttpClient::StopWorkerThread() {}
-void HttpClient::QueueAsyncRequest(std::function<void()>) {}
-void HttpClient::WorkerThreadFunction() {}
-
-bool SendPiShockCommand(const std::string&, const std::string&, const std::string&,
-                        int, int, int, std::string& response) {
-    response = "PiShock legacy HTTP disabled on Linux development build";
-    return false;
-}
-
-void SendPiShockCommandAsync(const std::string&, const std::string&, const std::string&,
-                             int, int, int,
-                             std::function<void(bool, const std::string&)> callback) {
-    if (callback) callback(false, "PiShock legacy HTTP disabled on Linux development build");
-}
-
-bool SendOpenShockCommand(const std::string&, const std::string&, const std::string&,
-                          int, int, int, std::string& response) {
-    response = "OpenShock HTTP disabled on Linux development build";
-    return false;
-}
-
-void SendOpenShockCommandAsync(const std::string&, const std::string&, const std::string&,
-                               int, int, int,
-                               std::function<void(bool, const std::string&)> callback) {
-    if (callback) callback(false, "OpenShock HTTP disabled on Linux development build");
-}
-
-bool SendOpenShockCommandMulti(const std::string&, const std::string&,
-                               const std::vector<std::string>&, int, int, int,
-                               std::string& response) {
-    response = "OpenShock HTTP disabled on Linux development build";
-    return false;
-}
-
-#endif // _WIN32
-
-} // namespace StayPutVR
\ No newline at end of file
+} // namespace StayPutVR 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <functional>
@@ -27,7 +29,9 @@ public:
         std::function<void(int progress)> progressCallback = nullptr
     );
     
-    // Simple synchronous HTTP request with the WinHTTP API
+    // Synchronous HTTP request over a pooled keep-alive connection to the
+    // URL's host (WinHTTP on Windows, cpp-httplib elsewhere; https needs an
+    // OpenSSL-enabled build off Windows). Succeeds only on a 2xx status.
     static bool SendHttpRequest(
         const std::string& url,
         const std::string& method,
@@ -37,24 +41,47 @@ public:
         std::function<void(int progress)> progressCallback = nullptr
     );
     
-    // Start the worker thread for async requests
+    // Open a connection to url's host on the worker thread, if none is pooled,
+    // so the next request there skips DNS/TCP/TLS setup. Call ahead of a
+    // likely command (e.g. when a lock engages).
+    static void PrewarmConnection(const std::string& url);
+
+    // Close every pooled connection. Idle ones are also closed on their own
+    // after 45 s while the client is initialized.
+    static void CloseIdleConnections();
+    
+    // Start the worker threads for async requests
     static void StartWorkerThread();
     
-    // Stop the worker thread
+    // Stop the worker threads (queued requests are discarded)
     static void StopWorkerThread();
     
-    // Add an async request to the queue
-    static void QueueAsyncRequest(std::function<void()> request);
+    // Queue request to run on a worker thread. url groups requests by host:
+    // at most two run at once per host, so a slow server can't hold up the
+    // others. With a non-zero deadline, a request still queued when it passes
+    // is dropped and on_expired runs instead (on a worker thread). Returns
+    // false, without running either, if the queue is full.
+    static bool QueueAsyncRequest(
+        const std::string& url,
+        std::function<void()> request,
+        std::chrono::milliseconds deadline = std::chrono::milliseconds::zero(),
+        std::function<void()> on_expired = nullptr
+    );
+
+    // Async queue counters since startup. Thread-safe.
+    struct AsyncStats {
+        size_t queued = 0;          // waiting for a worker
+        size_t in_flight = 0;       // running now
+        size_t peak_queued = 0;     // queue-depth high-water mark
+        uint64_t completed = 0;
+        uint64_t expired = 0;       // dropped at their deadline, never sent
+        uint64_t rejected = 0;      // refused with the queue full
+        double max_wait_ms = 0.0;   // longest a request waited before starting
+    };
+    static AsyncStats GetAsyncStats();
     
 private:
     static bool initialized_;
-    static std::thread worker_thread_;
-    static std::atomic<bool> worker_running_;
-    static std::queue<std::function<void()>> request_queue_;
-    static std::mutex queue_mutex_;
-    
-    // Worker thread function
-    static void WorkerThreadFunction();
 };
 
 // Synchronous utility function for PiShock API
@@ -68,7 +95,11 @@ bool SendPiShockCommand(
     std::string& response
 );
 
-// Asynchronous utility function for PiShock API
+// Warm the pooled connection to the PiShock API (see PrewarmConnection)
+void PrewarmPiShockConnection();
+
+// Asynchronous utility function for PiShock API. A command that hasn't been
+// sent within 5 s is dropped and reported to callback as failed.
 void SendPiShockCommandAsync(
     const std::string& username,
     const std::string& apiKey,
@@ -90,7 +121,7 @@ bool SendOpenShockCommand(
     std::string& response
 );
 
-// Asynchronous utility function for OpenShock API
+// Asynchronous utility function for OpenShock API (same 5 s deadline)
 void SendOpenShockCommandAsync(
     const std::string& serverUrl,
     const std::string& apiToken,
@@ -112,4 +143,21 @@ bool SendOpenShockCommandMulti(
     std::string& response
 );
 
+// One shocker's entry in an OpenShock control request
+struct OpenShockControl {
+    std::string deviceId;
+    int operation;           // 0 = shock, 1 = vibrate, 2 = sound
+    int intensity;           // 1-100 for shock/vibrate
+    int duration;            // Duration in milliseconds
+};
+
+// Synchronous OpenShock control request carrying one entry per shocker, each
+// with its own operation, intensity and duration
+bool SendOpenShockControls(
+    const std::string& serverUrl,
+    const std::string& apiToken,
+    const std::vector<OpenShockControl>& controls,
+    std::string& response
+);
+
 } // namespace StayPutVR 
\ No newline at end of file
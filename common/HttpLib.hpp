@@ -0,0 +1,29 @@
+#pragma once
+
+// The one place cpp-httplib is included from. Every user builds it the same
+// way (no exceptions; errors come back through httplib::Result), and with
+// CPPHTTPLIB_OPENSSL_SUPPORT httplib's own inline Client wrappers call
+// SSLClient::get_verify_result(), which the header marks deprecated. That
+// warning is about httplib's internals, not our code, so it is silenced for
+// the include only. Per-file tuning macros (e.g. the WebSocket timeouts in
+// OSCQueryServer.cpp) must still be defined before including this header.
+
+#ifndef CPPHTTPLIB_NO_EXCEPTIONS
+#define CPPHTTPLIB_NO_EXCEPTIONS
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4996)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+#include <cpp-httplib/httplib.h>
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#elif defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
@@ -31,6 +31,10 @@ public:
     virtual void TriggerWarningActions(const std::string& device_serial = "") = 0;
     virtual void TestActions() = 0;
 
+    // Called when a position lock engages, ahead of any action it may
+    // trigger. Managers with a network link can warm it up here.
+    virtual void OnLockEngaged() {}
+
     // Status / error
     virtual std::string GetConnectionStatus() const = 0;
     virtual std::string GetLastError() const = 0;
@@ -0,0 +1,441 @@
+#include "JsonView.hpp"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace StayPutVR {
+
+namespace {
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    size_t SkipSpace(std::string_view text, size_t pos) {
+        while (pos < text.size() && IsSpace(text[pos])) ++pos;
+        return pos;
+    }
+
+    JsonView::Type TypeOf(char first) {
+        switch (first) {
+        case '{': return JsonView::Type::Object;
+        case '[': return JsonView::Type::Array;
+        case '"': return JsonView::Type::String;
+        case 't':
+        case 'f': return JsonView::Type::Bool;
+        case 'n': return JsonView::Type::Null;
+        default: return JsonView::Type::Number;
+        }
+    }
+
+    // The skips below run over text Parse() has already validated, so they
+    // only need to find where a value ends.
+    size_t SkipString(std::string_view text, size_t pos) {
+        for (++pos; pos < text.size(); ++pos) {
+            if (text[pos] == '\\') {
+                ++pos;
+            } else if (text[pos] == '"') {
+                return pos + 1;
+            }
+        }
+        return text.size();
+    }
+
+    size_t SkipValue(std::string_view text, size_t pos) {
+        const char first = text[pos];
+        if (first == '"') {
+            return SkipString(text, pos);
+        }
+        if (first == '{' || first == '[') {
+            int depth = 0;
+            while (pos < text.size()) {
+                const char c = text[pos];
+                if (c == '"') {
+                    pos = SkipString(text, pos);
+                    continue;
+                }
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if ((c == '}' || c == ']') && --depth == 0) {
+                    return pos + 1;
+                }
+                ++pos;
+            }
+            return text.size();
+        }
+        while (pos < text.size() && !IsSpace(text[pos]) && text[pos] != ',' && text[pos] != '}' && text[pos] != ']') {
+            ++pos;
+        }
+        return pos;
+    }
+
+    // One-pass RFC 8259 syntax check. Strings are checked for escapes and
+    // control characters but not for valid UTF-8; bytes pass through as-is.
+    class Validator {
+    public:
+        explicit Validator(std::string_view text) : text_(text) {}
+
+        size_t pos = 0;
+        const char* problem = nullptr;
+
+        bool Value(int depth) {
+            if (depth > JsonView::kMaxDepth) return Fail("nesting too deep");
+            switch (Peek()) {
+            case '{': return Object(depth);
+            case '[': return Array(depth);
+            case '"': return String();
+            case 't': return Literal("true");
+            case 'f': return Literal("false");
+            case 'n': return Literal("null");
+            case '\0': return Fail(pos >= text_.size() ? "unexpected end of input" : "unexpected character");
+            default: return Number();
+            }
+        }
+
+    private:
+        std::string_view text_;
+
+        char Peek() const { return pos < text_.size() ? text_[pos] : '\0'; }
+
+        bool Fail(const char* what) {
+            problem = what;
+            return false;
+        }
+
+        void Space() { pos = SkipSpace(text_, pos); }
+
+        bool Object(int depth) {
+            ++pos;
+            Space();
+            if (Peek() == '}') {
+                ++pos;
+                return true;
+            }
+            for (;;) {
+                if (Peek() != '"') return Fail("expected a member name");
+                if (!String()) return false;
+                Space();
+                if (Peek() != ':') return Fail("expected ':'");
+                ++pos;
+                Space();
+                if (!Value(depth + 1)) return false;
+                Space();
+                if (Peek() == '}') {
+                    ++pos;
+                    return true;
+                }
+                if (Peek() != ',') return Fail("expected ',' or '}'");
+                ++pos;
+                Space();
+            }
+        }
+
+        bool Array(int depth) {
+            ++pos;
+            Space();
+            if (Peek() == ']') {
+                ++pos;
+                return true;
+            }
+            for (;;) {
+                if (!Value(depth + 1)) return false;
+                Space();
+                if (Peek() == ']') {
+                    ++pos;
+                    return true;
+                }
+                if (Peek() != ',') return Fail("expected ',' or ']'");
+                ++pos;
+                Space();
+            }
+        }
+
+        bool String() {
+            for (++pos; pos < text_.size(); ++pos) {
+                const char c = text_[pos];
+                if (c == '"') {
+                    ++pos;
+                    return true;
+                }
+                if (static_cast<unsigned char>(c) < 0x20) return Fail("control character in string");
+                if (c != '\\') continue;
+
+                ++pos;
+                switch (Peek()) {
+                case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u':
+                    for (int i = 0; i < 4; ++i) {
+                        ++pos;
+                        if (!std::isxdigit(static_cast<unsigned char>(Peek()))) return Fail("bad \\u escape");
+                    }
+                    break;
+                default:
+                    return Fail("bad escape sequence");
+                }
+            }
+            return Fail("unterminated string");
+        }
+
+        bool Number() {
+            if (Peek() == '-') ++pos;
+            if (Peek() == '0') {
+                ++pos;
+            } else if (IsDigit(Peek())) {
+                while (IsDigit(Peek())) ++pos;
+            } else {
+                return Fail("unexpected character");
+            }
+            if (Peek() == '.') {
+                ++pos;
+                if (!IsDigit(Peek())) return Fail("expected a digit");
+                while (IsDigit(Peek())) ++pos;
+            }
+            if (Peek() == 'e' || Peek() == 'E') {
+                ++pos;
+                if (Peek() == '+' || Peek() == '-') ++pos;
+                if (!IsDigit(Peek())) return Fail("expected a digit");
+                while (IsDigit(Peek())) ++pos;
+            }
+            return true;
+        }
+
+        bool Literal(std::string_view word) {
+            if (text_.substr(pos, word.size()) != word) return Fail("unexpected character");
+            pos += word.size();
+            return true;
+        }
+    };
+
+    uint32_t Hex4(std::string_view text, size_t pos) {
+        uint32_t value = 0;
+        for (size_t i = pos; i < pos + 4 && i < text.size(); ++i) {
+            const char c = text[i];
+            value <<= 4;
+            if (IsDigit(c)) value |= static_cast<uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') value |= static_cast<uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') value |= static_cast<uint32_t>(c - 'A' + 10);
+        }
+        return value;
+    }
+
+    size_t EncodeUtf8(uint32_t cp, char* out) {
+        if (cp < 0x80) {
+            out[0] = static_cast<char>(cp);
+            return 1;
+        }
+        if (cp < 0x800) {
+            out[0] = static_cast<char>(0xC0 | (cp >> 6));
+            out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 2;
+        }
+        if (cp < 0x10000) {
+            out[0] = static_cast<char>(0xE0 | (cp >> 12));
+            out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+            return 3;
+        }
+        out[0] = static_cast<char>(0xF0 | (cp >> 18));
+        out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 4;
+    }
+
+    // Feeds the decoded bytes of a validated string body (the text between
+    // the quotes) to sink(const char*, size_t) in runs; stops early and
+    // returns false as soon as sink does.
+    template <typename Sink>
+    bool DecodeString(std::string_view body, Sink&& sink) {
+        size_t pos = 0;
+        while (pos < body.size()) {
+            const size_t escape = body.find('\\', pos);
+            if (escape == std::string_view::npos) {
+                return sink(body.data() + pos, body.size() - pos);
+            }
+            if (escape > pos && !sink(body.data() + pos, escape - pos)) {
+                return false;
+            }
+
+            char out[4];
+            size_t length = 1;
+            pos = escape + 2;
+            switch (body[escape + 1]) {
+            case 'b': out[0] = '\b'; break;
+            case 'f': out[0] = '\f'; break;
+            case 'n': out[0] = '\n'; break;
+            case 'r': out[0] = '\r'; break;
+            case 't': out[0] = '\t'; break;
+            case 'u': {
+                uint32_t cp = Hex4(body, escape + 2);
+                pos = escape + 6;
+                if (cp >= 0xD800 && cp <= 0xDBFF && body.substr(pos, 2) == "\\u") {
+                    const uint32_t low = Hex4(body, pos + 2);
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        pos += 6;
+                    }
+                }
+                if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    cp = 0xFFFD; // unpaired surrogate
+                }
+                length = EncodeUtf8(cp, out);
+                break;
+            }
+            default: out[0] = body[escape + 1]; break; // " \ /
+            }
+            if (!sink(out, length)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool DecodedEquals(std::string_view body, std::string_view text) {
+        size_t matched = 0;
+        const bool same = DecodeString(body, [&](const char* data, size_t length) {
+            if (length > text.size() - matched || std::memcmp(text.data() + matched, data, length) != 0) {
+                return false;
+            }
+            matched += length;
+            return true;
+        });
+        return same && matched == text.size();
+    }
+} // namespace
+
+JsonView JsonView::Parse(std::string_view text, std::string* error) {
+    Validator validator(text);
+    validator.pos = SkipSpace(text, 0);
+    const size_t start = validator.pos;
+    bool ok = validator.Value(0);
+    if (ok && SkipSpace(text, validator.pos) != text.size()) {
+        ok = false;
+        validator.problem = "unexpected characters after the document";
+    }
+    if (!ok) {
+        if (error) {
+            *error = std::string(validator.problem) + " at offset " + std::to_string(validator.pos);
+        }
+        return JsonView();
+    }
+    return JsonView(TypeOf(text[start]), text.substr(start, validator.pos - start));
+}
+
+bool JsonView::NextElement(size_t& pos, JsonView& element) const {
+    if (type_ != Type::Array) return false;
+    pos = SkipSpace(raw_, pos == 0 ? 1 : pos);
+    if (pos >= raw_.size() || raw_[pos] == ']') return false;
+    if (raw_[pos] == ',') pos = SkipSpace(raw_, pos + 1);
+
+    const size_t end = SkipValue(raw_, pos);
+    element = JsonView(TypeOf(raw_[pos]), raw_.substr(pos, end - pos));
+    pos = end;
+    return true;
+}
+
+bool JsonView::NextMember(size_t& pos, std::string_view& key, JsonView& value) const {
+    if (type_ != Type::Object) return false;
+    pos = SkipSpace(raw_, pos == 0 ? 1 : pos);
+    if (pos >= raw_.size() || raw_[pos] == '}') return false;
+    if (raw_[pos] == ',') pos = SkipSpace(raw_, pos + 1);
+
+    const size_t key_end = SkipString(raw_, pos);
+    key = raw_.substr(pos + 1, key_end - pos - 2);
+    pos = SkipSpace(raw_, SkipSpace(raw_, key_end) + 1); // past ':'
+
+    const size_t end = SkipValue(raw_, pos);
+    value = JsonView(TypeOf(raw_[pos]), raw_.substr(pos, end - pos));
+    pos = end;
+    return true;
+}
+
+JsonView JsonView::operator[](std::string_view key) const {
+    size_t pos = 0;
+    std::string_view name;
+    JsonView value;
+    while (NextMember(pos, name, value)) {
+        if (DecodedEquals(name, key)) return value;
+    }
+    return JsonView();
+}
+
+JsonView JsonView::At(size_t index) const {
+    size_t pos = 0;
+    JsonView element;
+    while (NextElement(pos, element)) {
+        if (index-- == 0) return element;
+    }
+    return JsonView();
+}
+
+size_t JsonView::Size() const {
+    size_t count = 0;
+    size_t pos = 0;
+    if (type_ == Type::Array) {
+        JsonView element;
+        while (NextElement(pos, element)) ++count;
+    } else if (type_ == Type::Object) {
+        std::string_view key;
+        JsonView value;
+        while (NextMember(pos, key, value)) ++count;
+    }
+    return count;
+}
+
+bool JsonView::AsBool(bool fallback) const {
+    if (type_ != Type::Bool) return fallback;
+    return raw_ == "true";
+}
+
+int64_t JsonView::AsInt(int64_t fallback) const {
+    if (type_ != Type::Number) return fallback;
+    int64_t value = 0;
+    const auto [end, ec] = std::from_chars(raw_.data(), raw_.data() + raw_.size(), value);
+    if (ec == std::errc() && end == raw_.data() + raw_.size()) return value;
+
+    // Fraction, exponent or out of range: go through double and clamp.
+    const double d = AsDouble(0.0);
+    if (std::isnan(d)) return fallback;
+    if (d <= static_cast<double>(std::numeric_limits<int64_t>::min())) return std::numeric_limits<int64_t>::min();
+    if (d >= static_cast<double>(std::numeric_limits<int64_t>::max())) return std::numeric_limits<int64_t>::max();
+    return static_cast<int64_t>(d);
+}
+
+double JsonView::AsDouble(double fallback) const {
+    if (type_ != Type::Number) return fallback;
+    double value = 0.0;
+    const auto [end, ec] = std::from_chars(raw_.data(), raw_.data() + raw_.size(), value);
+    if (ec == std::errc::result_out_of_range) {
+        return raw_[0] == '-' ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+    }
+    return ec == std::errc() ? value : fallback;
+}
+
+std::string JsonView::AsString(std::string_view fallback) const {
+    std::string value;
+    if (!GetString(value)) value.assign(fallback);
+    return value;
+}
+
+bool JsonView::GetString(std::string& out) const {
+    if (type_ != Type::String) return false;
+    out.clear();
+    DecodeString(raw_.substr(1, raw_.size() - 2), [&out](const char* data, size_t length) {
+        out.append(data, length);
+        return true;
+    });
+    return true;
+}
+
+bool JsonView::Equals(std::string_view text) const {
+    return type_ == Type::String && DecodedEquals(raw_.substr(1, raw_.size() - 2), text);
+}
+
+} // namespace StayPutVR
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace StayPutVR {
+
+// Read-only view of a JSON value inside a caller-owned buffer, for handlers
+// that read a handful of fields out of each message (PiShock, Buttplug,
+// Twitch). Parse() validates the whole document in one pass without building
+// anything; lookups then re-scan the text, so reading fields from a small
+// message allocates nothing. Views are valid only while the text is.
+//
+// Lookups never throw: a missing member, an out-of-range index or a value of
+// the wrong type gives an Invalid view, and the As*() accessors return their
+// fallback -- like nlohmann::json::value(), without the exceptions.
+class JsonView {
+public:
+    enum class Type {
+        Invalid, // missing, or a malformed document
+        Null,
+        Bool,
+        Number,
+        String,
+        Object,
+        Array
+    };
+
+    // Validates text as exactly one JSON document (nesting up to kMaxDepth).
+    // Returns an Invalid view and describes the problem in *error if not.
+    static JsonView Parse(std::string_view text, std::string* error = nullptr);
+    static constexpr int kMaxDepth = 64;
+
+    JsonView() = default;
+
+    Type GetType() const { return type_; }
+    bool IsValid() const { return type_ != Type::Invalid; }
+    explicit operator bool() const { return IsValid(); }
+    bool IsNull() const { return type_ == Type::Null; }
+    bool IsBool() const { return type_ == Type::Bool; }
+    bool IsNumber() const { return type_ == Type::Number; }
+    bool IsString() const { return type_ == Type::String; }
+    bool IsObject() const { return type_ == Type::Object; }
+    bool IsArray() const { return type_ == Type::Array; }
+
+    // Object member by (decoded) name, first match.
+    JsonView operator[](std::string_view key) const;
+    // Array element by position.
+    JsonView At(size_t index) const;
+    // Elements of an array or members of an object; 0 for anything else.
+    size_t Size() const;
+    bool Empty() const { return Size() == 0; }
+
+    // f(JsonView element) for each array element.
+    template <typename F>
+    void ForEach(F&& f) const {
+        size_t pos = 0;
+        JsonView element;
+        while (NextElement(pos, element)) f(element);
+    }
+
+    // f(std::string_view key, JsonView value) for each object member. The key
+    // is the raw text between its quotes: escape sequences are not decoded.
+    template <typename F>
+    void ForEachMember(F&& f) const {
+        size_t pos = 0;
+        std::string_view key;
+        JsonView value;
+        while (NextMember(pos, key, value)) f(key, value);
+    }
+
+    bool AsBool(bool fallback = false) const;
+    // Numbers with a fraction or exponent are truncated, as json::get<int> does.
+    int64_t AsInt(int64_t fallback = 0) const;
+    double AsDouble(double fallback = 0.0) const;
+
+    // Decoded string value, or fallback when this is not a string.
+    std::string AsString(std::string_view fallback = {}) const;
+    // Decodes into out (reusing its capacity); false, out untouched, if not a string.
+    bool GetString(std::string& out) const;
+    // Whether this is a string whose decoded value is text. No copies.
+    bool Equals(std::string_view text) const;
+
+    // The value's JSON text; strings include their quotes.
+    std::string_view Raw() const { return raw_; }
+
+private:
+    JsonView(Type type, std::string_view raw) : type_(type), raw_(raw) {}
+
+    bool NextElement(size_t& pos, JsonView& element) const;
+    bool NextMember(size_t& pos, std::string_view& key, JsonView& value) const;
+
+    Type type_ = Type::Invalid;
+    std::string_view raw_;
+};
+
+} // namespace StayPutVR
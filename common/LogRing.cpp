@@ -0,0 +1,57 @@
+#include "LogRing.hpp"
+
+namespace StayPutVR {
+
+std::atomic<bool> LogRing::enabled_{false};
+std::mutex LogRing::mutex_;
+std::vector<LogRing::Record> LogRing::slots_;
+uint64_t LogRing::end_seq_ = 0;
+uint64_t LogRing::first_seq_ = 0;
+
+void LogRing::SetCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.clear();
+    slots_.shrink_to_fit();
+    slots_.resize(capacity);
+    // Keep numbering monotonic across resizes so readers never see a
+    // sequence number reused for a different record.
+    first_seq_ = end_seq_;
+    enabled_.store(capacity > 0, std::memory_order_relaxed);
+}
+
+size_t LogRing::Capacity() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+void LogRing::Push(Logger::LogLevel level, const std::string& text) {
+    if (!enabled_.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slots_.empty()) return;
+    Record& slot = slots_[end_seq_ % slots_.size()];
+    slot.seq = end_seq_;
+    slot.level = level;
+    slot.text.assign(text); // reuses the evicted record's buffer
+    ++end_seq_;
+    if (end_seq_ - first_seq_ > slots_.size()) {
+        first_seq_ = end_seq_ - slots_.size();
+    }
+}
+
+void LogRing::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    first_seq_ = end_seq_;
+}
+
+LogRing::Reader::Reader() { mutex_.lock(); }
+LogRing::Reader::~Reader() { mutex_.unlock(); }
+
+uint64_t LogRing::Reader::FirstSeq() const { return first_seq_; }
+uint64_t LogRing::Reader::EndSeq() const { return end_seq_; }
+
+const LogRing::Record* LogRing::Reader::Get(uint64_t seq) const {
+    if (seq < first_seq_ || seq >= end_seq_) return nullptr;
+    return &slots_[seq % slots_.size()];
+}
+
+} // namespace StayPutVR
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+
+namespace StayPutVR {
+
+// Bounded in-memory copy of the most recent log records, fed by Logger::Log
+// and read by the app's log viewer. Disabled (capacity 0) unless the process
+// opts in with SetCapacity(), so the driver pays nothing for it.
+//
+// Records are addressed by a monotonic sequence number; the ring retains
+// [FirstSeq(), EndSeq()). Slot strings are reused once the ring has wrapped,
+// so steady-state logging does not allocate here.
+class LogRing {
+public:
+    struct Record {
+        uint64_t seq = 0;
+        Logger::LogLevel level = Logger::LogLevel::INFO;
+        std::string text; // formatted line as written to the log file
+    };
+
+    // Resize the ring (0 disables it). Drops everything currently retained.
+    static void SetCapacity(size_t capacity);
+    static size_t Capacity();
+
+    static void Push(Logger::LogLevel level, const std::string& text);
+    static void Clear();
+
+    // Holds the ring lock for its lifetime so records can be read in place
+    // without copying. Keep the scope short and never log from inside it
+    // (Logger::Log would block on the same lock).
+    class Reader {
+    public:
+        Reader();
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        uint64_t FirstSeq() const;
+        uint64_t EndSeq() const;
+        // nullptr if seq has been evicted or not written yet.
+        const Record* Get(uint64_t seq) const;
+    };
+
+private:
+    static std::atomic<bool> enabled_; // lets Push skip the lock when disabled
+    static std::mutex mutex_;
+    static std::vector<Record> slots_;
+    static uint64_t end_seq_;
+    static uint64_t first_seq_;
+};
+
+} // namespace StayPutVR
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <filesystem>
 #include "Config.hpp"
+#include "LogRing.hpp"
 
 namespace StayPutVR {
 
@@ -80,14 +81,17 @@ namespace StayPutVR {
             return;
         }
 
+        std::string logEntry = GetTimeString() + " [" + GetLevelString(level) + "] " + message;
+
+        // In-app log viewer (no-op unless the process enabled the ring).
+        LogRing::Push(level, logEntry);
+
         if (!initialized || !logFile.is_open()) {
-            std::cerr << GetTimeString() << " [" << GetLevelString(level) << "] " << message << std::endl;
+            std::cerr << logEntry << std::endl;
             return;
         }
 
         try {
-            std::string logEntry = GetTimeString() + " [" + GetLevelString(level) + "] " + message;
-            
             logFile << logEntry << std::endl;
             logFile.flush();
             
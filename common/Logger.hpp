@@ -36,6 +36,10 @@ namespace StayPutVR {
         static void Critical(const std::string& message);
         
         static bool IsInitialized() { return initialized; }
+
+        // True when a message at `level` would reach the log file. Lets hot
+        // paths skip building a message string that would be dropped.
+        static bool IsEnabled(LogLevel level) { return initialized && level >= minLogLevel; }
         static void SetLogLevel(LogLevel level);
         
         // Load log level from config
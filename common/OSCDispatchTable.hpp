@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Exact-match lookup from an inbound OSC address to whatever the caller wants
+// to do with it (OSCManager stores a handler id + device).
+//
+// Built off the hot path whenever the configured addresses change, then only
+// read. Open addressing over a power-of-two slot array, at most half full, with
+// the full 64-bit FNV-1a hash kept per slot: an address that isn't in the table
+// almost always lands on an empty slot and is rejected after one probe, without
+// comparing strings or allocating. VRChat sends hundreds of face-tracking and
+// avatar params per second that we don't care about, so that is the common case.
+
+namespace StayPutVR {
+
+    template <typename Route>
+    class OSCDispatchTable {
+    public:
+        // Adds an address. If it is already present the earlier route is kept,
+        // so callers insert in priority order. Empty addresses are ignored (an
+        // unset config path must not match anything). Call Build() afterwards.
+        void Add(std::string_view address, const Route& route) {
+            if (address.empty()) return;
+            for (const Entry& e : entries_) {
+                if (e.address == address) return;
+            }
+            entries_.push_back(Entry{ std::string(address), route, Hash(address) });
+        }
+
+        void Build() {
+            size_t capacity = 16;
+            while (capacity < entries_.size() * 2) capacity *= 2;
+            slots_.assign(capacity, Slot{});
+            mask_ = capacity - 1;
+            for (size_t i = 0; i < entries_.size(); ++i) {
+                size_t s = entries_[i].hash & mask_;
+                while (slots_[s].entry >= 0) s = (s + 1) & mask_;
+                slots_[s] = Slot{ entries_[i].hash, static_cast<int32_t>(i) };
+            }
+        }
+
+        const Route* Find(std::string_view address) const {
+            if (slots_.empty()) return nullptr;
+            const uint64_t h = Hash(address);
+            for (size_t s = h & mask_;; s = (s + 1) & mask_) {
+                const Slot& slot = slots_[s];
+                if (slot.entry < 0) return nullptr;
+                if (slot.hash == h && entries_[slot.entry].address == address) {
+                    return &entries_[slot.entry].route;
+                }
+            }
+        }
+
+        size_t Size() const { return entries_.size(); }
+
+        static uint64_t Hash(std::string_view s) {
+            uint64_t h = 14695981039346656037ull;
+            for (unsigned char c : s) {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+    private:
+        struct Entry {
+            std::string address;
+            Route route;
+            uint64_t hash;
+        };
+
+        struct Slot {
+            uint64_t hash = 0;
+            int32_t entry = -1;
+        };
+
+        std::vector<Entry> entries_;
+        std::vector<Slot> slots_;
+        size_t mask_ = 0;
+    };
+
+} // namespace StayPutVR
@@ -1,16 +1,55 @@
 #include "OSCManager.hpp"
 #include "Logger.hpp"
+#include "AllocationCounter.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <sstream>
-#include <unordered_set>
 #include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/eventfd.h>
+#endif
 
 namespace StayPutVR {
 
+// Built-in outbound addresses, encoded at compile time. Order matches the
+// kOutbound* ids in OSCManager.hpp (statuses are indexed by OSCDeviceType).
+static constexpr OSCMessageTemplate kFixedOutbound[] = {
+    OSCMessageTemplate("/avatar/parameters/SPVR_HMD_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_ControllerLeft_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_ControllerRight_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_FootLeft_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_FootRight_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_Hip_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_Jaw_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_Mic_Status"),
+    OSCMessageTemplate("/avatar/parameters/SPVR_Collar_Mode"),
+    OSCMessageTemplate("/VRCOSC/PiShock/Group"),
+    OSCMessageTemplate("/VRCOSC/PiShock/Duration"),
+    OSCMessageTemplate("/VRCOSC/PiShock/Intensity"),
+    OSCMessageTemplate("/VRCOSC/PiShock/Shock"),
+    OSCMessageTemplate("/VRCOSC/PiShock/Vibrate"),
+    OSCMessageTemplate("/VRCOSC/PiShock/Beep"),
+};
+static_assert(std::size(kFixedOutbound) == OSCManager::kFixedOutboundCount,
+              "kFixedOutbound must list every fixed outbound id");
+static_assert(kFixedOutbound[OSCManager::kOutboundPiShockBeep].Address() == "/VRCOSC/PiShock/Beep",
+              "kFixedOutbound order must match the kOutbound* ids");
+
 OSCManager& OSCManager::GetInstance() {
     static OSCManager instance;
     return instance;
 }
 
+OSCManager::OSCManager() {
+    RebuildDispatchTable();
+    RegisterFixedOutbound();
+}
+
 OSCManager::~OSCManager() {
     if (initialized_) {
         Shutdown();
@@ -84,6 +123,23 @@ bool OSCManager::Initialize(const std::string& address, int send_port, int recei
         WSACleanup();
         return false;
     }
+
+    // Size the kernel buffer before any traffic arrives, and have Linux
+    // report how many datagrams it dropped when that buffer was full.
+    receive_buffer_applied_bytes_ = -1;
+    ApplyReceiveBufferSize();
+    received_datagrams_ = 0;
+    kernel_drops_ = 0;
+    truncated_datagrams_ = 0;
+#ifndef _WIN32
+    {
+        int on = 1;
+        if (setsockopt(receive_socket_, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) != 0 && Logger::IsInitialized()) {
+            Logger::Warning("OSCManager: SO_RXQ_OVFL unavailable (error " + std::to_string(errno) +
+                            "); kernel drops won't be reported");
+        }
+    }
+#endif
     
     // Set up the local address structure for receiving. When OSCQuery is on we
     // bind to port 0 so the OS picks a free ephemeral port; this avoids the
@@ -121,6 +177,23 @@ bool OSCManager::Initialize(const std::string& address, int send_port, int recei
         }
     }
 
+    {
+        std::lock_guard<std::mutex> lock(send_queue_mutex_);
+        pending_sends_.clear();
+        for (SentValue& sent : sent_cache_) {
+            sent.valid = false;
+        }
+    }
+
+    if (!CreateReceiveWakeup()) {
+        closesocket(socket_);
+        closesocket(receive_socket_);
+        delete server_addr_;
+        server_addr_ = nullptr;
+        WSACleanup();
+        return false;
+    }
+
     // Start the receive thread
     receive_thread_running_ = true;
     try {
@@ -135,6 +208,7 @@ bool OSCManager::Initialize(const std::string& address, int send_port, int recei
             Logger::Error("OSCManager: Failed to start receive thread: " + std::string(e.what()));
         }
         receive_thread_running_ = false;
+        CloseReceiveWakeup();
         closesocket(socket_);
         closesocket(receive_socket_);
         delete server_addr_;
@@ -156,16 +230,83 @@ bool OSCManager::Initialize(const std::string& address, int send_port, int recei
 }
 
 void OSCManager::SetSendPort(int send_port) {
-    std::lock_guard<std::mutex> lock(send_addr_mutex_);
-    send_port_ = send_port;
-    if (server_addr_ != nullptr) {
-        server_addr_->sin_port = htons(static_cast<u_short>(send_port));
+    {
+        std::lock_guard<std::mutex> lock(send_addr_mutex_);
+        send_port_ = send_port;
+        if (server_addr_ != nullptr) {
+            server_addr_->sin_port = htons(static_cast<u_short>(send_port));
+        }
     }
+    // The new target has heard nothing from us yet.
+    InvalidateSendCache();
     if (Logger::IsInitialized()) {
         Logger::Info("OSCManager: Send target port updated to " + std::to_string(send_port));
     }
 }
 
+void OSCManager::ApplyReceiveBufferSize() {
+    receive_buffer_applied_bytes_ = receive_buffer_request_bytes_;
+    const int requested = receive_buffer_request_bytes_;
+    if (requested > 0 &&
+        setsockopt(receive_socket_, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&requested),
+                   sizeof(requested)) == SOCKET_ERROR) {
+        if (Logger::IsInitialized()) {
+            Logger::Warning("OSCManager: Setting the receive buffer to " + std::to_string(requested / 1024) +
+                            " KB failed with error: " + std::to_string(WSAGetLastError()));
+        }
+    }
+
+    int granted = 0;
+    socklen_t length = sizeof(granted);
+    if (getsockopt(receive_socket_, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<char*>(&granted), &length) != 0) {
+        return;
+    }
+#ifndef _WIN32
+    granted /= 2; // Linux doubles the request to cover its bookkeeping and reports that
+#endif
+    receive_buffer_bytes_ = granted;
+
+    if (Logger::IsInitialized()) {
+        if (requested > 0 && granted < requested) {
+            Logger::Warning("OSCManager: Receive buffer capped at " + std::to_string(granted / 1024) + " KB of the " +
+                            std::to_string(requested / 1024) + " KB requested"
+#ifndef _WIN32
+                            " (raise net.core.rmem_max to allow more)"
+#endif
+                            );
+        } else {
+            Logger::Info("OSCManager: Receive buffer is " + std::to_string(granted / 1024) + " KB");
+        }
+    }
+}
+
+size_t OSCManager::MaxDatagramSize(SOCKET s) {
+    // The largest UDP payload over IPv4: 65535 minus the IP and UDP headers.
+    size_t size = 65507;
+#ifdef _WIN32
+    unsigned int max_msg = 0;
+    int length = sizeof(max_msg);
+    if (getsockopt(s, SOL_SOCKET, SO_MAX_MSG_SIZE, reinterpret_cast<char*>(&max_msg), &length) == 0 && max_msg > 0) {
+        size = max_msg;
+    }
+#else
+    (void)s;
+#endif
+    return size;
+}
+
+OSCManager::ReceiveStats OSCManager::GetReceiveStats() const {
+    ReceiveStats stats;
+    stats.datagrams = received_datagrams_.load(std::memory_order_relaxed);
+    stats.kernel_drops = kernel_drops_.load(std::memory_order_relaxed);
+    stats.truncated = truncated_datagrams_.load(std::memory_order_relaxed);
+    stats.buffer_bytes = receive_buffer_bytes_.load(std::memory_order_relaxed);
+#ifndef _WIN32
+    stats.drops_supported = true;
+#endif
+    return stats;
+}
+
 void OSCManager::Shutdown() {
     if (!initialized_) {
         if (Logger::IsInitialized()) {
@@ -174,9 +315,13 @@ void OSCManager::Shutdown() {
         return;
     }
     
-    // Stop the receive thread
+    // Anything queued this frame (e.g. final unlock statuses) still goes out.
+    FlushSends();
+
+    // Stop the receive thread. The wakeup interrupts its wait immediately.
     receive_thread_running_ = false;
-    
+    SignalReceiveWakeup();
+
     // Wait for the thread to finish
     if (receive_thread_.joinable()) {
         if (Logger::IsInitialized()) {
@@ -187,6 +332,7 @@ void OSCManager::Shutdown() {
             Logger::Debug("OSCManager: Receive thread stopped");
         }
     }
+    CloseReceiveWakeup();
 
     // Clean up sockets. The send socket and server_addr_ are guarded by
     // send_addr_mutex_ because the OSCQuery browse thread may call SetSendPort();
@@ -237,78 +383,330 @@ void OSCManager::SetConfig(const Config& config) {
     osc_jawopen_path_ = config.osc_jawopen_path;
     osc_collar_toggle_path_ = config.osc_collar_toggle_path;
 
+    RebuildDispatchTable();
+
+    receive_buffer_request_bytes_ = (std::max)(0, config.osc_receive_buffer_kb) * 1024;
+    if (initialized_ && receive_buffer_request_bytes_ != receive_buffer_applied_bytes_) {
+        ApplyReceiveBufferSize();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(send_queue_mutex_);
+        send_keepalive_ = std::chrono::duration<float>((std::max)(0.0f, config.osc_send_keepalive_seconds));
+        // Encode the configured outbound address now rather than on first send,
+        // and drop slots for addresses the config no longer uses.
+        RegisterOutboundLocked(config.osc_sound_effect_path);
+        PruneOutboundLocked({ config.osc_sound_effect_path });
+    }
+    SetDestinations(config.osc_destinations);
+
     if (Logger::IsInitialized()) {
         Logger::Debug("OSCManager: Updated OSC paths from config (jawopen='" +
                       osc_jawopen_path_ + "', collar_toggle='" + osc_collar_toggle_path_ + "')");
     }
 }
 
+void OSCManager::RebuildDispatchTable() {
+    auto table = std::make_shared<DispatchTable>();
+    auto add = [&](const std::string& path, OSCHandler handler, OSCDeviceType device = OSCDeviceType::HMD) {
+        table->Add(path, OSCRoute{ handler, device });
+    };
+
+    // Insertion order is match priority (the first route for an address wins),
+    // matching the order the checks used to run in.
+    add("/avatar/change", OSCHandler::AvatarChange);
+
+    add(osc_lock_path_hmd_, OSCHandler::Lock, OSCDeviceType::HMD);
+    add(osc_lock_path_left_hand_, OSCHandler::Lock, OSCDeviceType::ControllerLeft);
+    add(osc_lock_path_right_hand_, OSCHandler::Lock, OSCDeviceType::ControllerRight);
+    add(osc_lock_path_left_foot_, OSCHandler::Lock, OSCDeviceType::FootLeft);
+    add(osc_lock_path_right_foot_, OSCHandler::Lock, OSCDeviceType::FootRight);
+    add(osc_lock_path_hip_, OSCHandler::Lock, OSCDeviceType::Hip);
+
+    add(osc_global_lock_path_, OSCHandler::GlobalLock);
+    add(osc_global_unlock_path_, OSCHandler::GlobalUnlock);
+    add(osc_global_out_of_bounds_path_, OSCHandler::GlobalOutOfBounds);
+    add(osc_bite_path_, OSCHandler::Bite);
+    add(osc_shock_path_, OSCHandler::Shock);
+    add(osc_estop_stretch_path_, OSCHandler::EStopStretch);
+    add(osc_jawopen_path_, OSCHandler::JawOpen);
+    add(osc_collar_toggle_path_, OSCHandler::CollarToggle);
+
+    // The old if/else chain also had SPVR_<Device>_Latch_IsPosed and
+    // SPVR_<Device>_include fallbacks, but their device parsing was off by one
+    // (substr(25) on a 24-character prefix), so they never matched and are not
+    // routed here either. The configured include paths were never checked.
+
+    table->Build();
+    dispatch_table_.store(std::move(table));
+}
+
+bool OSCManager::FirstSeenAddress(uint64_t hash) {
+    if (hash == 0) hash = 1; // 0 marks an empty slot
+    if (seen_address_count_ >= kSeenAddressSlots / 2) return false;
+    for (size_t s = hash & (kSeenAddressSlots - 1);; s = (s + 1) & (kSeenAddressSlots - 1)) {
+        if (seen_address_hashes_[s] == hash) return false;
+        if (seen_address_hashes_[s] == 0) {
+            seen_address_hashes_[s] = hash;
+            ++seen_address_count_;
+            return true;
+        }
+    }
+}
+
+bool OSCManager::CreateReceiveWakeup() {
+#ifdef _WIN32
+    receive_event_ = WSACreateEvent();
+    wake_event_ = WSACreateEvent();
+    // WSAEventSelect also puts the socket in non-blocking mode, which the
+    // drain loop relies on to stop at WSAEWOULDBLOCK.
+    if (receive_event_ == WSA_INVALID_EVENT || wake_event_ == WSA_INVALID_EVENT ||
+        WSAEventSelect(receive_socket_, receive_event_, FD_READ) == SOCKET_ERROR) {
+        if (Logger::IsInitialized()) {
+            Logger::Error("OSCManager: Failed to set up receive events: " + std::to_string(WSAGetLastError()));
+        }
+        CloseReceiveWakeup();
+        return false;
+    }
+#else
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ < 0) {
+        if (Logger::IsInitialized()) {
+            Logger::Error("OSCManager: eventfd failed with error: " + std::to_string(errno));
+        }
+        return false;
+    }
+#endif
+    return true;
+}
+
+void OSCManager::SignalReceiveWakeup() {
+#ifdef _WIN32
+    if (wake_event_ != WSA_INVALID_EVENT) {
+        WSASetEvent(wake_event_);
+    }
+#else
+    if (wake_fd_ >= 0) {
+        const uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    }
+#endif
+}
+
+void OSCManager::CloseReceiveWakeup() {
+#ifdef _WIN32
+    if (receive_event_ != WSA_INVALID_EVENT) {
+        WSAEventSelect(receive_socket_, receive_event_, 0);
+        WSACloseEvent(receive_event_);
+        receive_event_ = WSA_INVALID_EVENT;
+    }
+    if (wake_event_ != WSA_INVALID_EVENT) {
+        WSACloseEvent(wake_event_);
+        wake_event_ = WSA_INVALID_EVENT;
+    }
+#else
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+#endif
+}
+
 void OSCManager::ReceiveThreadFunction() {
     if (Logger::IsInitialized()) {
         Logger::Debug("OSCManager: Receive thread started");
     }
-    
-    // Buffer for incoming data
-    std::array<char, MAX_PACKET_SIZE> recv_buffer;
-    
-    // Set up timeout for recv to allow checking the running flag.
-    // Winsock takes a DWORD of milliseconds; POSIX takes a struct timeval.
+
+    // Buffers sized from the largest datagram the socket can deliver, so
+    // nothing is ever truncated. One per batch slot on Linux; Windows reads
+    // one datagram at a time. Left uninitialised: pages are only touched by
+    // datagrams that need them. Slots stay 64-byte aligned; oscpp rejects
+    // packets that aren't 4-byte aligned.
+    const size_t slot_size = (MaxDatagramSize(receive_socket_) + 63) & ~size_t(63);
 #ifdef _WIN32
-    DWORD timeout = 500; // 500 ms
-    setsockopt(receive_socket_, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    constexpr size_t kSlots = 1;
 #else
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 500 * 1000; // 500 ms
-    setsockopt(receive_socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    constexpr size_t kSlots = kReceiveBatch;
 #endif
-    
+    std::unique_ptr<char[]> storage(new char[kSlots * slot_size]);
+
+    auto mark_inbound = [this] {
+        // Record inbound liveness: this is the only signal that VRChat (or
+        // any sender) is actually reaching us, since UDP is connectionless.
+        last_inbound_ns_.store(
+            std::chrono::steady_clock::now().time_since_epoch().count(),
+            std::memory_order_relaxed);
+    };
+
+    auto count_truncated = [this, slot_size] {
+        if (truncated_datagrams_.fetch_add(1, std::memory_order_relaxed) == 0 && Logger::IsInitialized()) {
+            Logger::Warning("OSCManager: Dropped a datagram larger than the " + std::to_string(slot_size) +
+                            "-byte receive buffer");
+        }
+    };
+
+    // After an unexpected socket error, back off briefly instead of spinning,
+    // but still wake at once for Shutdown().
+    auto back_off = [this] {
+#ifdef _WIN32
+        WSAWaitForMultipleEvents(1, &wake_event_, FALSE, 100, FALSE);
+#else
+        pollfd wake{ wake_fd_, POLLIN, 0 };
+        poll(&wake, 1, 100);
+#endif
+    };
+
+#ifdef _WIN32
+    WSAEVENT events[2] = { wake_event_, receive_event_ };
     while (receive_thread_running_) {
-        // Receive data
-        int bytes_received = recv(receive_socket_, recv_buffer.data(), recv_buffer.size(), 0);
-        
-        if (bytes_received == SOCKET_ERROR) {
-            int error = WSAGetLastError();
-            if (error == WSAETIMEDOUT) {
-                // Timeout, just continue to check the running flag
-                continue;
+        DWORD which = WSAWaitForMultipleEvents(2, events, FALSE, WSA_INFINITE, FALSE);
+        if (!receive_thread_running_) {
+            break;
+        }
+        if (which == WSA_WAIT_FAILED) {
+            if (Logger::IsInitialized()) {
+                Logger::Error("OSCManager: WSAWaitForMultipleEvents failed with error: " + std::to_string(WSAGetLastError()));
             }
-            else if (error == WSAEMSGSIZE) {
-                // Message too large for the buffer
-                if (Logger::IsInitialized()) {
-                    Logger::Warning("OSCManager: Received an OSC message that exceeds the buffer size (" + 
-                                   std::to_string(MAX_PACKET_SIZE) + " bytes). Consider increasing MAX_PACKET_SIZE.");
+            back_off();
+            continue;
+        }
+        if (which != WSA_WAIT_EVENT_0 + 1) {
+            continue;
+        }
+        WSAResetEvent(receive_event_);
+
+        // Drain everything queued; the socket is non-blocking.
+        while (receive_thread_running_) {
+            int bytes_received = recv(receive_socket_, storage.get(), static_cast<int>(slot_size), 0);
+            if (bytes_received == SOCKET_ERROR) {
+                int error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK) {
+                    break;
+                }
+                if (error == WSAEMSGSIZE) {
+                    count_truncated();
+                    continue;
+                }
+                if (error == WSAECONNRESET) {
+                    // ICMP port-unreachable from an earlier send; not ours to handle.
+                    continue;
                 }
-                // Continue processing despite this error
-                continue;
-            }
-            else {
                 if (Logger::IsInitialized()) {
                     Logger::Error("OSCManager: recv failed with error: " + std::to_string(error));
                 }
-                // Continue running despite errors
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                back_off();
+                break;
+            }
+            if (bytes_received > 0) {
+                mark_inbound();
+                received_datagrams_.fetch_add(1, std::memory_order_relaxed);
+                ProcessOSCMessage(storage.get(), bytes_received);
+            }
+        }
+    }
+#else
+    std::array<mmsghdr, kReceiveBatch> msgs{};
+    std::array<iovec, kReceiveBatch> iovs{};
+    // Room for the SO_RXQ_OVFL control message (the socket's cumulative drop
+    // count, attached once the kernel has dropped anything).
+    union ControlBuffer {
+        char buf[CMSG_SPACE(sizeof(uint32_t))];
+        cmsghdr align;
+    };
+    std::array<ControlBuffer, kReceiveBatch> controls{};
+    for (size_t i = 0; i < kReceiveBatch; ++i) {
+        iovs[i].iov_base = storage.get() + i * slot_size;
+        iovs[i].iov_len = slot_size;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = controls[i].buf;
+    }
+
+    pollfd fds[2] = { { receive_socket_, POLLIN, 0 }, { wake_fd_, POLLIN, 0 } };
+    while (receive_thread_running_) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
                 continue;
             }
+            if (Logger::IsInitialized()) {
+                Logger::Error("OSCManager: poll failed with error: " + std::to_string(errno));
+            }
+            back_off();
+            continue;
+        }
+        if (!receive_thread_running_) {
+            break;
+        }
+        if (!(fds[0].revents & (POLLIN | POLLERR))) {
+            continue;
         }
-        
-        if (bytes_received > 0) {
-            // Record inbound liveness: this is the only signal that VRChat (or
-            // any sender) is actually reaching us, since UDP is connectionless.
-            last_inbound_ns_.store(
-                std::chrono::steady_clock::now().time_since_epoch().count(),
-                std::memory_order_relaxed);
 
-            // Process the received OSC message
-            ProcessOSCMessage(recv_buffer.data(), bytes_received);
+        // Drain everything queued, up to kReceiveBatch datagrams per syscall.
+        while (receive_thread_running_) {
+            for (mmsghdr& m : msgs) {
+                m.msg_hdr.msg_controllen = sizeof(ControlBuffer);
+            }
+            int n = recvmmsg(receive_socket_, msgs.data(), kReceiveBatch, MSG_DONTWAIT, nullptr);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    if (Logger::IsInitialized()) {
+                        Logger::Error("OSCManager: recvmmsg failed with error: " + std::to_string(errno));
+                    }
+                    back_off();
+                }
+                break;
+            }
+            if (n > 0) {
+                mark_inbound();
+                received_datagrams_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            }
+            for (int i = 0; i < n; ++i) {
+                msghdr& hdr = msgs[i].msg_hdr;
+                for (cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                        uint32_t drops = 0;
+                        std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                        kernel_drops_.store(drops, std::memory_order_relaxed);
+                    }
+                }
+                if (hdr.msg_flags & MSG_TRUNC) {
+                    count_truncated();
+                    continue;
+                }
+                ProcessOSCMessage(static_cast<const char*>(iovs[i].iov_base), msgs[i].msg_len);
+            }
+            if (static_cast<size_t>(n) < kReceiveBatch) {
+                break; // queue was emptied; wait for more
+            }
         }
     }
-    
+#endif
+
     if (Logger::IsInitialized()) {
         Logger::Debug("OSCManager: Receive thread stopped");
     }
 }
 
+void OSCManager::PublishLatest(OSCContinuousParam param, float value) {
+    LatestValueSlot& slot = latest_values_[static_cast<size_t>(param)];
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.seq.fetch_add(1, std::memory_order_release);
+}
+
+bool OSCManager::ReadLatest(OSCContinuousParam param, float& value, uint32_t& last_seq) const {
+    const LatestValueSlot& slot = latest_values_[static_cast<size_t>(param)];
+    const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq == last_seq) {
+        return false;
+    }
+    value = slot.value.load(std::memory_order_relaxed);
+    last_seq = seq;
+    return true;
+}
+
 double OSCManager::SecondsSinceLastInbound() const {
     long long ns = last_inbound_ns_.load(std::memory_order_relaxed);
     if (ns == 0) {
@@ -321,6 +719,7 @@ double OSCManager::SecondsSinceLastInbound() const {
 }
 
 void OSCManager::ProcessOSCMessage(const char* data, size_t size) {
+    AllocationScope alloc_scope(AllocTag::OSC);
     try {
         OSCPP::Server::Packet packet(data, size);
 
@@ -341,46 +740,41 @@ void OSCManager::ProcessOSCMessage(const char* data, size_t size) {
 
         if (packet.isMessage()) {
             OSCPP::Server::Message message(packet);
-            std::string address = message.address();
-
-            // Diagnostic: log each distinct inbound address exactly once so the
-            // log shows precisely what VRChat is sending (and at what path) —
-            // e.g. to confirm whether /avatar/parameters/FT/v2/JawOpen arrives.
-            // Bounded by the number of unique avatar params, so not spammy.
-            {
-                static std::mutex seen_mtx;
-                static std::unordered_set<std::string> seen_addrs;
-                bool is_new;
-                {
-                    std::lock_guard<std::mutex> lk(seen_mtx);
-                    is_new = seen_addrs.insert(address).second;
-                }
-                if (is_new && Logger::IsInitialized()) {
-                    Logger::Debug("OSCManager: first inbound OSC address: " + address);
+            const std::string_view address = message.address();
+
+            const std::shared_ptr<const DispatchTable> table = dispatch_table_.load();
+            const OSCRoute* route = table->Find(address);
+            if (!route) {
+                // Diagnostic: log each distinct unrouted address once so the
+                // log shows precisely what VRChat is sending (and at what path)
+                // — e.g. to confirm whether /avatar/parameters/FT/v2/JawOpen
+                // arrives, or that a configured path has a typo.
+                if (Logger::IsEnabled(Logger::LogLevel::DEBUG) &&
+                    FirstSeenAddress(DispatchTable::Hash(address))) {
+                    Logger::Debug("OSCManager: first inbound OSC address: " + std::string(address));
                 }
+                return;
             }
 
             // Avatar change: VRChat sends /avatar/change (with the new avatar id
             // as a string argument) when the user switches avatars. The string
             // arg isn't handled by the tag switch below, so dispatch it up front
-            // so lock/shock state can be reset. Copy the callback under the lock
-            // and invoke it outside the lock (it performs a heavier reset).
-            if (address == "/avatar/change") {
-                std::function<void()> cb;
-                {
-                    std::lock_guard<std::mutex> cb_lock(callback_mutex_);
-                    cb = avatar_change_callback_;
-                }
-                if (cb) {
+            // so lock/shock state can be reset.
+            const std::shared_ptr<const OSCHandlers> handlers = handlers_.load();
+            if (route->handler == OSCHandler::AvatarChange) {
+                // The new avatar starts from default params: whatever we sent
+                // before is gone, so the next sends must not be deduplicated.
+                InvalidateSendCache();
+                if (handlers->avatar_change) {
                     if (Logger::IsInitialized()) {
                         Logger::Debug("OSCManager: /avatar/change received");
                     }
-                    cb();
+                    handlers->avatar_change();
                 }
                 return;
             }
 
-            bool should_log = address.find("SPVR_") != std::string::npos;
+            const bool should_log = Logger::IsEnabled(Logger::LogLevel::DEBUG);
             OSCPP::Server::ArgStream args = message.args();
             
             if (!args.atEnd()) {
@@ -391,157 +785,88 @@ void OSCManager::ProcessOSCMessage(const char* data, size_t size) {
                 if (tag == 'f') {
                     float_value = args.float32();
                     value_bool = float_value > 0.5f;
-                    if (Logger::IsInitialized() && should_log) {
+                    if (should_log) {
                         Logger::Debug("OSCManager: Received float value: " + std::to_string(float_value) + 
-                                    " for address: " + address);
+                                    " for address: " + std::string(address));
                     }
                 }
                 else if (tag == 'i') {
                     int32_t value = args.int32();
                     value_bool = value != 0;
-                    if (Logger::IsInitialized() && should_log) {
+                    if (should_log) {
                         Logger::Debug("OSCManager: Received int value: " + std::to_string(value) + 
-                                    " for address: " + address);
+                                    " for address: " + std::string(address));
                     }
                 }
                 else if (tag == 'T' || tag == 'F') {
                     value_bool = (tag == 'T');
-                    if (Logger::IsInitialized() && should_log) {
+                    if (should_log) {
                         Logger::Debug("OSCManager: Received boolean value: " + std::string(value_bool ? "true" : "false") + 
-                                    " for address: " + address);
+                                    " for address: " + std::string(address));
                     }
                 }
                 else {
-                    if (Logger::IsInitialized() && should_log) {
+                    if (Logger::IsInitialized()) {
                         Logger::Warning("OSCManager: Unsupported argument type: " + std::string(1, tag) + 
-                                      " for address: " + address);
+                                      " for address: " + std::string(address));
                     }
                     return;
                 }
                 
-                // Dispatch callbacks under lock to prevent torn reads
-                // if a setter is called concurrently from the UI thread.
-                std::lock_guard<std::mutex> cb_lock(callback_mutex_);
-
-                // Standard device lock paths
-                if (address == osc_lock_path_hmd_ && lock_callback_) {
-                    lock_callback_(OSCDeviceType::HMD, value_bool);
-                }
-                else if (address == osc_lock_path_left_hand_ && lock_callback_) {
-                    lock_callback_(OSCDeviceType::ControllerLeft, value_bool);
-                }
-                else if (address == osc_lock_path_right_hand_ && lock_callback_) {
-                    lock_callback_(OSCDeviceType::ControllerRight, value_bool);
-                }
-                else if (address == osc_lock_path_left_foot_ && lock_callback_) {
-                    lock_callback_(OSCDeviceType::FootLeft, value_bool);
-                }
-                else if (address == osc_lock_path_right_foot_ && lock_callback_) {
-                    lock_callback_(OSCDeviceType::FootRight, value_bool);
-                }
-                else if (address == osc_lock_path_hip_ && lock_callback_) {
-                    lock_callback_(OSCDeviceType::Hip, value_bool);
-                }
-                
-                // Global lock/unlock paths
-                else if (address == osc_global_lock_path_ && global_lock_callback_ && value_bool) {
-                    global_lock_callback_(true);
-                }
-                else if (address == osc_global_unlock_path_ && global_lock_callback_ && value_bool) {
-                    global_lock_callback_(false);
-                }
-                
-                // Global out-of-bounds path
-                else if (address == osc_global_out_of_bounds_path_ && global_out_of_bounds_callback_ && value_bool) {
-                    global_out_of_bounds_callback_(true);
-                }
-                
-                // Bite path
-                else if (address == osc_bite_path_ && bite_callback_ && value_bool) {
-                    bite_callback_(true);
-                }
-
-                // External shock path (/avatar/parameters/Shock)
-                else if (address == osc_shock_path_ && shock_callback_ && value_bool) {
-                    shock_callback_(true);
-                }
-                
-                // Emergency stop stretch path
-                else if (address == osc_estop_stretch_path_ && estop_stretch_callback_ && tag == 'f') {
-                    if (float_value >= 0.5f) {
-                        estop_stretch_callback_(float_value);
+                // JawOpen bridge parameter (float 0..1) - SPVR_JawOpen. Continuous,
+                // so it only overwrites the mailbox; the UI reads it once a frame.
+                if (route->handler == OSCHandler::JawOpen) {
+                    if (tag == 'f') {
+                        PublishLatest(OSCContinuousParam::JawOpen, float_value);
                     }
+                    return;
                 }
 
-                // JawOpen bridge parameter (float 0..1) - SPVR_JawOpen
-                else if (address == osc_jawopen_path_ && jawopen_callback_ && tag == 'f') {
-                    jawopen_callback_(float_value);
-                }
+                // No lock: the snapshot loaded above stays valid and unchanged
+                // while it is in use, even if a setter publishes a new one.
+                const OSCHandlers& h = *handlers;
+                switch (route->handler) {
+                    case OSCHandler::Lock:
+                        // Pass the exact boolean state to lock/unlock
+                        if (h.lock) h.lock(route->device, value_bool);
+                        break;
 
-                // Unified collar-mode toggle button (momentary contact). Pass both
-                // true and false so the UI can rising-edge detect and advance the mode.
-                else if (address == osc_collar_toggle_path_ && collar_toggle_callback_) {
-                    collar_toggle_callback_(value_bool);
-                }
-                
-                // Latch_IsPosed paths: direct state change (not toggle)
-                else if (address.find("/avatar/parameters/SPVR_") == 0 && address.find("_Latch_IsPosed") != std::string::npos && lock_callback_) {
-                    // Extract device type from the path
-                    std::string deviceStr = address.substr(25); // Remove "/avatar/parameters/SPVR_" prefix
-                    deviceStr = deviceStr.substr(0, deviceStr.find("_Latch_IsPosed")); // Get just the device part
-                    
-                    // Determine which device type it is
-                    OSCDeviceType deviceType;
-                    if (deviceStr == "HMD") {
-                        deviceType = OSCDeviceType::HMD;
-                    } else if (deviceStr == "ControllerLeft") {
-                        deviceType = OSCDeviceType::ControllerLeft;
-                    } else if (deviceStr == "ControllerRight") {
-                        deviceType = OSCDeviceType::ControllerRight;
-                    } else if (deviceStr == "FootLeft") {
-                        deviceType = OSCDeviceType::FootLeft;
-                    } else if (deviceStr == "FootRight") {
-                        deviceType = OSCDeviceType::FootRight;
-                    } else if (deviceStr == "Hip") {
-                        deviceType = OSCDeviceType::Hip;
-                    } else {
-                        // Unknown device, ignore
-                        return;
-                    }
-                    
-                    // Pass the exact boolean state to lock/unlock 
-                    lock_callback_(deviceType, value_bool);
-                }
-                
-                // Include paths: toggle behavior
-                else if (address.find("/avatar/parameters/SPVR_") == 0 && address.find("_include") != std::string::npos && include_callback_) {
-                    // Extract device type from the path
-                    std::string deviceStr = address.substr(25); // Remove "/avatar/parameters/SPVR_" prefix
-                    deviceStr = deviceStr.substr(0, deviceStr.find("_include")); // Get just the device part
-                    
-                    // Determine which device type it is
-                    OSCDeviceType deviceType;
-                    if (deviceStr == "HMD") {
-                        deviceType = OSCDeviceType::HMD;
-                    } else if (deviceStr == "ControllerLeft") {
-                        deviceType = OSCDeviceType::ControllerLeft;
-                    } else if (deviceStr == "ControllerRight") {
-                        deviceType = OSCDeviceType::ControllerRight;
-                    } else if (deviceStr == "FootLeft") {
-                        deviceType = OSCDeviceType::FootLeft;
-                    } else if (deviceStr == "FootRight") {
-                        deviceType = OSCDeviceType::FootRight;
-                    } else if (deviceStr == "Hip") {
-                        deviceType = OSCDeviceType::Hip;
-                    } else {
-                        // Unknown device, ignore
-                        return;
-                    }
-                    
-                    // If value_bool is true, this should toggle the include state
-                    if (value_bool) {
-                        include_callback_(deviceType, true); // The callback will handle toggling
-                    }
+                    case OSCHandler::GlobalLock:
+                        if (h.global_lock && value_bool) h.global_lock(true);
+                        break;
+
+                    case OSCHandler::GlobalUnlock:
+                        if (h.global_lock && value_bool) h.global_lock(false);
+                        break;
+
+                    case OSCHandler::GlobalOutOfBounds:
+                        if (h.global_out_of_bounds && value_bool) h.global_out_of_bounds(true);
+                        break;
+
+                    case OSCHandler::Bite:
+                        if (h.bite && value_bool) h.bite(true);
+                        break;
+
+                    // External shock path (/avatar/parameters/Shock)
+                    case OSCHandler::Shock:
+                        if (h.shock && value_bool) h.shock(true);
+                        break;
+
+                    case OSCHandler::EStopStretch:
+                        if (h.estop_stretch && tag == 'f' && float_value >= 0.5f) {
+                            h.estop_stretch(float_value);
+                        }
+                        break;
+
+                    // Unified collar-mode toggle button (momentary contact). Pass both
+                    // true and false so the UI can rising-edge detect and advance the mode.
+                    case OSCHandler::CollarToggle:
+                        if (h.collar_toggle) h.collar_toggle(value_bool);
+                        break;
+
+                    case OSCHandler::AvatarChange:
+                    case OSCHandler::JawOpen:
+                        break;
                 }
             }
         }
@@ -561,7 +886,6 @@ void OSCManager::SendDeviceStatus(OSCDeviceType device, DeviceStatus status) {
         return;
     }
 
-    std::string path = GetStatusPath(device);
     int statusValue = static_cast<int>(status);
 
     // Send the device status as an int. This OSC param is written on the local
@@ -570,8 +894,8 @@ void OSCManager::SendDeviceStatus(OSCDeviceType device, DeviceStatus status) {
     // synced bools (SPVR_<dev>_Status_b0/_b1/_b2) via a parameter-driver layer,
     // which is what actually reduces synced bits (40 -> 15). The pre-1.4 prefab
     // syncs this int directly, so the same message works for both.
-    if (SendOSCMessage(path, statusValue) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending status " + std::to_string(statusValue) + " to " + path +
+    if (SendOSCMessage(StatusOutboundId(device), statusValue) && Logger::IsEnabled(Logger::LogLevel::DEBUG)) {
+        Logger::Debug("OSCManager: Sending status " + std::to_string(statusValue) + " to " + GetStatusPath(device) +
             " (device=" + GetDeviceString(device) + ", status=" + std::to_string(statusValue) + ")");
     }
 }
@@ -580,9 +904,9 @@ void OSCManager::SendCollarMode(int mode) {
     if (!initialized_) {
         return;
     }
-    const std::string path = "/avatar/parameters/SPVR_Collar_Mode";
-    if (SendOSCMessage(path, mode) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending collar mode " + std::to_string(mode) + " to " + path);
+    if (SendOSCMessage(kOutboundCollarMode, mode) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending collar mode " + std::to_string(mode) +
+                      " to /avatar/parameters/SPVR_Collar_Mode");
     }
 }
 
@@ -590,7 +914,7 @@ void OSCManager::SendSoundEffect(const std::string& path, int value) {
     if (!initialized_) {
         return;
     }
-    SendOSCMessage(path, value);
+    SendOSCMessage(OutboundIdFor(path), value);
 }
 
 void OSCManager::SendPiShockGroup(int group) {
@@ -601,10 +925,8 @@ void OSCManager::SendPiShockGroup(int group) {
         return;
     }
     
-    std::string path = "/VRCOSC/PiShock/Group";
-    
-    if (SendOSCMessage(path, group) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending PiShock Group " + std::to_string(group) + " to " + path + 
+    if (SendOSCMessage(kOutboundPiShockGroup, group) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending PiShock Group " + std::to_string(group) + " to /VRCOSC/PiShock/Group" +
             " (int value=" + std::to_string(group) + ")");
     }
 }
@@ -620,10 +942,8 @@ void OSCManager::SendPiShockDuration(float duration) {
     // Clamp duration to 0-1 range
     duration = (std::max)(0.0f, (std::min)(duration, 1.0f));
     
-    std::string path = "/VRCOSC/PiShock/Duration";
-    
-    if (SendOSCMessage(path, duration) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending PiShock Duration " + std::to_string(duration) + " to " + path + 
+    if (SendOSCMessage(kOutboundPiShockDuration, duration) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending PiShock Duration " + std::to_string(duration) + " to /VRCOSC/PiShock/Duration" +
             " (float value=" + std::to_string(duration) + ", clamped to 0-1 range)");
     }
 }
@@ -639,10 +959,8 @@ void OSCManager::SendPiShockIntensity(float intensity) {
     // Clamp intensity to 0-1 range
     intensity = (std::max)(0.0f, (std::min)(intensity, 1.0f));
     
-    std::string path = "/VRCOSC/PiShock/Intensity";
-    
-    if (SendOSCMessage(path, intensity) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending PiShock Intensity " + std::to_string(intensity) + " to " + path + 
+    if (SendOSCMessage(kOutboundPiShockIntensity, intensity) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending PiShock Intensity " + std::to_string(intensity) + " to /VRCOSC/PiShock/Intensity" +
             " (float value=" + std::to_string(intensity) + ", clamped to 0-1 range)");
     }
 }
@@ -655,10 +973,8 @@ void OSCManager::SendPiShockShock(bool enabled) {
         return;
     }
     
-    std::string path = "/VRCOSC/PiShock/Shock";
-    
-    if (SendOSCMessage(path, enabled) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending PiShock Shock " + std::string(enabled ? "true" : "false") + " to " + path + 
+    if (SendOSCMessage(kOutboundPiShockShock, enabled) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending PiShock Shock " + std::string(enabled ? "true" : "false") + " to /VRCOSC/PiShock/Shock" +
             " (bool value=" + std::string(enabled ? "true" : "false") + ")");
     }
 }
@@ -671,10 +987,8 @@ void OSCManager::SendPiShockVibrate(bool enabled) {
         return;
     }
     
-    std::string path = "/VRCOSC/PiShock/Vibrate";
-    
-    if (SendOSCMessage(path, enabled) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending PiShock Vibrate " + std::string(enabled ? "true" : "false") + " to " + path + 
+    if (SendOSCMessage(kOutboundPiShockVibrate, enabled) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending PiShock Vibrate " + std::string(enabled ? "true" : "false") + " to /VRCOSC/PiShock/Vibrate" +
             " (bool value=" + std::string(enabled ? "true" : "false") + ")");
     }
 }
@@ -687,87 +1001,439 @@ void OSCManager::SendPiShockBeep(bool enabled) {
         return;
     }
     
-    std::string path = "/VRCOSC/PiShock/Beep";
-    
-    if (SendOSCMessage(path, enabled) && Logger::IsInitialized()) {
-        Logger::Debug("OSCManager: Sending PiShock Beep " + std::string(enabled ? "true" : "false") + " to " + path + 
+    if (SendOSCMessage(kOutboundPiShockBeep, enabled) && Logger::IsInitialized()) {
+        Logger::Debug("OSCManager: Sending PiShock Beep " + std::string(enabled ? "true" : "false") + " to /VRCOSC/PiShock/Beep" +
             " (bool value=" + std::string(enabled ? "true" : "false") + ")");
     }
 }
 
-bool OSCManager::SendOSCMessage(const std::string& path, int value) {
-    try {
-        // Create OSC packet with int32 message
-        OSCPP::Client::Packet packet(buffer_.data(), buffer_.size());
-        packet.openMessage(path.c_str(), 1)
-              .int32(value)
-              .closeMessage();
-
-        // Send the packet. Hold send_addr_mutex_ so a concurrent SetSendPort()
-        // (from the OSCQuery browse thread) can't tear server_addr_->sin_port.
-        std::lock_guard<std::mutex> lock(send_addr_mutex_);
-        int result = sendto(socket_,
-                     static_cast<const char*>(packet.data()),
-                     static_cast<int>(packet.size()),
-                     0,
-                     reinterpret_cast<struct sockaddr*>(server_addr_),
-                     sizeof(sockaddr_in));
-                     
-        if (result == SOCKET_ERROR) {
+bool OSCManager::SendOSCMessage(OutboundId id, int value) {
+    return QueueSend(id, OutboundValue{ 'i', static_cast<uint32_t>(value) });
+}
+
+bool OSCManager::SendOSCMessage(OutboundId id, float value) {
+    OutboundValue v{ 'f', 0 };
+    std::memcpy(&v.bits, &value, sizeof(v.bits));
+    return QueueSend(id, v);
+}
+
+bool OSCManager::SendOSCMessage(OutboundId id, bool value) {
+    // OSC doesn't have a native bool type, so we send as int (1 for true, 0 for false)
+    return SendOSCMessage(id, value ? 1 : 0);
+}
+
+OSCManager::OutboundId OSCManager::StatusOutboundId(OSCDeviceType device) {
+    return static_cast<OutboundId>(kOutboundStatusFirst + static_cast<OutboundId>(device));
+}
+
+OSCManager::OutboundId OSCManager::OutboundIdFor(const std::string& path) {
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    return RegisterOutboundLocked(path);
+}
+
+OSCManager::OutboundId OSCManager::RegisterOutboundLocked(const std::string& path) {
+    auto it = outbound_ids_.find(path);
+    if (it != outbound_ids_.end()) {
+        return it->second;
+    }
+    // Registered even when invalid, so a bad path is reported once rather
+    // than on every send.
+    OSCMessageTemplate tmpl(path);
+    if (!tmpl.Valid() && Logger::IsInitialized()) {
+        Logger::Warning("OSCManager: Cannot send to OSC address '" + path + "' (must start with '/' and be at most " +
+                        std::to_string(OSCMessageTemplate::kMaxSize - 9) + " characters)");
+    }
+    const OutboundId id = static_cast<OutboundId>(outbound_templates_.size());
+    outbound_templates_.push_back(tmpl);
+    outbound_routes_.push_back(RoutesForLocked(path));
+    sent_cache_.emplace_back();
+    outbound_ids_.emplace(path, id);
+    return id;
+}
+
+void OSCManager::PruneOutboundLocked(const std::vector<std::string>& keep) {
+    const size_t count = outbound_templates_.size();
+    std::vector<bool> kept(count, false);
+    std::fill(kept.begin(), kept.begin() + (std::min)(count, size_t(kFixedOutboundCount)), true);
+    for (const auto& [path, id] : outbound_ids_) {
+        if (std::find(keep.begin(), keep.end(), path) != keep.end()) {
+            kept[id] = true;
+        }
+    }
+    if (std::find(kept.begin(), kept.end(), false) == kept.end()) {
+        return;
+    }
+
+    // Compact the per-id tables. Ids of kept slots only move down, so each
+    // slot is read before anything is written over it.
+    static constexpr OutboundId kDropped = (std::numeric_limits<OutboundId>::max)();
+    std::vector<OutboundId> remap(count, kDropped);
+    OutboundId next = 0;
+    for (size_t id = 0; id < count; ++id) {
+        if (!kept[id]) {
+            continue;
+        }
+        outbound_templates_[next] = outbound_templates_[id];
+        outbound_routes_[next] = outbound_routes_[id];
+        sent_cache_[next] = sent_cache_[id];
+        remap[id] = next++;
+    }
+    outbound_templates_.resize(next);
+    outbound_routes_.resize(next);
+    sent_cache_.resize(next);
+
+    for (auto it = outbound_ids_.begin(); it != outbound_ids_.end();) {
+        if (remap[it->second] == kDropped) {
+            it = outbound_ids_.erase(it);
+        } else {
+            it->second = remap[it->second];
+            ++it;
+        }
+    }
+    size_t pending = 0;
+    for (const PendingSend& p : pending_sends_) {
+        if (remap[p.id] != kDropped) {
+            pending_sends_[pending++] = PendingSend{ remap[p.id], p.value };
+        }
+    }
+    pending_sends_.resize(pending);
+}
+
+void OSCManager::RegisterFixedOutbound() {
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    outbound_templates_.assign(std::begin(kFixedOutbound), std::end(kFixedOutbound));
+    sent_cache_.assign(outbound_templates_.size(), SentValue{});
+    outbound_routes_.assign(outbound_templates_.size(), 0);
+    for (size_t id = 0; id < outbound_templates_.size(); ++id) {
+        outbound_ids_.emplace(std::string(outbound_templates_[id].Address()), static_cast<OutboundId>(id));
+    }
+}
+
+void OSCManager::SetDestinations(const std::vector<Config::OSCDestination>& destinations) {
+    std::vector<OutboundDestination> parsed;
+    for (const Config::OSCDestination& d : destinations) {
+        if (!d.enabled) {
+            continue;
+        }
+        const std::string label = d.address + ":" + std::to_string(d.port);
+        OutboundDestination dest{};
+        dest.addr.sin_family = AF_INET;
+        dest.addr.sin_port = htons(static_cast<u_short>(d.port));
+        if (d.port <= 0 || d.port > 65535 || inet_pton(AF_INET, d.address.c_str(), &dest.addr.sin_addr) != 1) {
             if (Logger::IsInitialized()) {
-                Logger::Error("OSCManager: Failed to send OSC message, error: " + std::to_string(WSAGetLastError()));
+                Logger::Warning("OSCManager: Ignoring OSC destination " + label + " (expected an IPv4 address and port)");
             }
-            return false;
+            continue;
         }
-        
-        return true;
+        if (parsed.size() == kMaxDestinations) {
+            if (Logger::IsInitialized()) {
+                Logger::Warning("OSCManager: Ignoring OSC destination " + label + " (at most " +
+                                std::to_string(kMaxDestinations) + " are supported)");
+            }
+            continue;
+        }
+        std::stringstream filter(d.filter);
+        std::string prefix;
+        while (std::getline(filter, prefix, ',')) {
+            const size_t begin = prefix.find_first_not_of(" \t");
+            if (begin == std::string::npos) {
+                continue;
+            }
+            const size_t end = prefix.find_last_not_of(" \t");
+            dest.prefixes.push_back(prefix.substr(begin, end - begin + 1));
+        }
+        dest.label = label;
+        parsed.push_back(std::move(dest));
     }
-    catch (const std::exception& e) {
-        if (Logger::IsInitialized()) {
-            Logger::Error("OSCManager: Exception when sending OSC message: " + std::string(e.what()));
+
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    const bool unchanged = std::equal(parsed.begin(), parsed.end(), destinations_.begin(), destinations_.end(),
+        [](const OutboundDestination& a, const OutboundDestination& b) {
+            return a.label == b.label && a.prefixes == b.prefixes;
+        });
+    if (unchanged) {
+        return;
+    }
+    destinations_ = std::move(parsed);
+    for (size_t id = 0; id < outbound_templates_.size(); ++id) {
+        outbound_routes_[id] = RoutesForLocked(outbound_templates_[id].Address());
+    }
+    // A new destination has heard nothing yet; resend everything once.
+    for (SentValue& sent : sent_cache_) {
+        sent.valid = false;
+    }
+
+    if (Logger::IsInitialized()) {
+        std::string list;
+        for (const OutboundDestination& dest : destinations_) {
+            list += (list.empty() ? "" : ", ") + dest.label;
         }
-        return false;
+        Logger::Info("OSCManager: " + std::to_string(destinations_.size()) + " extra OSC destination(s)" +
+                     (list.empty() ? "" : ": " + list));
     }
 }
 
-bool OSCManager::SendOSCMessage(const std::string& path, float value) {
-    try {
-        // Create OSC packet with float message
-        OSCPP::Client::Packet packet(buffer_.data(), buffer_.size());
-        packet.openMessage(path.c_str(), 1)
-              .float32(value)
-              .closeMessage();
-
-        // Send the packet. Hold send_addr_mutex_ so a concurrent SetSendPort()
-        // (from the OSCQuery browse thread) can't tear server_addr_->sin_port.
-        std::lock_guard<std::mutex> lock(send_addr_mutex_);
-        int result = sendto(socket_,
-                     static_cast<const char*>(packet.data()),
-                     static_cast<int>(packet.size()),
-                     0,
-                     reinterpret_cast<struct sockaddr*>(server_addr_),
-                     sizeof(sockaddr_in));
-                     
-        if (result == SOCKET_ERROR) {
-            if (Logger::IsInitialized()) {
-                Logger::Error("OSCManager: Failed to send OSC message, error: " + std::to_string(WSAGetLastError()));
+uint32_t OSCManager::RoutesForLocked(std::string_view address) const {
+    uint32_t routes = 0;
+    for (size_t i = 0; i < destinations_.size(); ++i) {
+        const std::vector<std::string>& prefixes = destinations_[i].prefixes;
+        bool match = prefixes.empty();
+        for (const std::string& prefix : prefixes) {
+            if (address.substr(0, prefix.size()) == prefix) {
+                match = true;
+                break;
             }
-            return false;
         }
-        
-        return true;
+        if (match) {
+            routes |= 1u << i;
+        }
     }
-    catch (const std::exception& e) {
-        if (Logger::IsInitialized()) {
-            Logger::Error("OSCManager: Exception when sending OSC message: " + std::string(e.what()));
+    return routes;
+}
+
+bool OSCManager::QueueSend(OutboundId id, OutboundValue value) {
+    if (!initialized_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    if (id >= outbound_templates_.size() || !outbound_templates_[id].Valid()) {
+        return false;
+    }
+
+    const SentValue& cached = sent_cache_[id];
+    const bool same_as_sent = cached.valid && cached.value == value;
+
+    // Already queued this tick: the newest value wins, and a value that went
+    // back to what VRChat already has doesn't need sending at all.
+    for (auto it = pending_sends_.begin(); it != pending_sends_.end(); ++it) {
+        if (it->id == id) {
+            if (same_as_sent) {
+                pending_sends_.erase(it);
+                return false;
+            }
+            it->value = value;
+            return true;
         }
+    }
+
+    if (same_as_sent) {
         return false;
     }
+    pending_sends_.push_back(PendingSend{ id, value });
+    return true;
 }
 
-bool OSCManager::SendOSCMessage(const std::string& path, bool value) {
-    // OSC doesn't have a native bool type, so we send as int (1 for true, 0 for false)
-    return SendOSCMessage(path, value ? 1 : 0);
+void OSCManager::InvalidateSendCache() {
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    for (SentValue& sent : sent_cache_) {
+        sent.valid = false;
+    }
+}
+
+void OSCManager::FlushSends() {
+    std::lock_guard<std::mutex> lock(send_queue_mutex_);
+    if (!initialized_) {
+        pending_sends_.clear();
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    // Keepalive: re-send values VRChat hasn't heard for a while, in case it
+    // dropped or reset them without telling us.
+    if (send_keepalive_.count() > 0.0f) {
+        for (size_t id = 0; id < sent_cache_.size(); ++id) {
+            const SentValue& sent = sent_cache_[id];
+            if (!sent.valid || now - sent.sent_at < send_keepalive_) {
+                continue;
+            }
+            bool queued = false;
+            for (const PendingSend& p : pending_sends_) {
+                if (p.id == id) { queued = true; break; }
+            }
+            if (!queued) {
+                pending_sends_.push_back(PendingSend{ static_cast<OutboundId>(id), sent.value });
+            }
+        }
+    }
+
+    // Snapshot the primary target so the sends below don't hold
+    // send_addr_mutex_ (SetSendPort may retarget it concurrently).
+    sockaddr_in primary{};
+    {
+        std::lock_guard<std::mutex> addr_lock(send_addr_mutex_);
+        if (server_addr_ == nullptr) {
+            pending_sends_.clear();
+            return;
+        }
+        primary = *server_addr_;
+    }
+
+    // One bundle per buffer-full (in practice, one per flush). Each element is
+    // its template with the value patched in, encoded once into buffer_; every
+    // destination's datagram is a gather list over those bytes. A datagram
+    // carrying a single message sends it bare.
+    static constexpr char kBundleHeader[16] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', '\0',
+                                                0, 0, 0, 0, 0, 0, 0, 1 }; // time tag 1 = immediately
+    size_t next = 0;
+    size_t kept = 0; // unsent entries carried over to the next flush
+    while (next < pending_sends_.size()) {
+        const size_t first = next;
+        size_t size = sizeof(kBundleHeader);
+        element_offsets_.clear();
+        std::memcpy(buffer_.data(), kBundleHeader, sizeof(kBundleHeader));
+        while (next < pending_sends_.size()) {
+            const PendingSend& p = pending_sends_[next];
+            const OSCMessageTemplate& tmpl = outbound_templates_[p.id];
+            const uint32_t element_size = static_cast<uint32_t>(tmpl.Size());
+            if (next > first && size + 4 + element_size > buffer_.size()) {
+                break;
+            }
+            char* out = buffer_.data() + size;
+            out[0] = static_cast<char>(element_size >> 24);
+            out[1] = static_cast<char>(element_size >> 16);
+            out[2] = static_cast<char>(element_size >> 8);
+            out[3] = static_cast<char>(element_size);
+            tmpl.Encode(out + 4, p.value.tag, p.value.bits);
+            element_offsets_.push_back(size);
+            size += 4 + element_size;
+            ++next;
+        }
+        element_offsets_.push_back(size);
+        const size_t count = next - first;
+
+        // Element e spans [element_offsets_[e], element_offsets_[e + 1]),
+        // including its 4-byte size prefix.
+        auto add_datagram = [&](const sockaddr_in* to, uint32_t route_bit) {
+            size_t selected = 0;
+            size_t only = 0;
+            for (size_t e = 0; e < count; ++e) {
+                if (route_bit == 0 || (outbound_routes_[pending_sends_[first + e].id] & route_bit)) {
+                    ++selected;
+                    only = e;
+                }
+            }
+            if (selected == 0) {
+                return;
+            }
+            const size_t first_buffer = send_buffers_.size();
+            if (selected == 1) {
+                AddSendBuffer(buffer_.data() + element_offsets_[only] + 4,
+                              element_offsets_[only + 1] - element_offsets_[only] - 4);
+            } else {
+                AddSendBuffer(buffer_.data(), sizeof(kBundleHeader));
+                // Adjacent selected elements share one buffer.
+                size_t run_begin = 0;
+                size_t run_end = 0;
+                for (size_t e = 0; e < count; ++e) {
+                    if (route_bit != 0 && !(outbound_routes_[pending_sends_[first + e].id] & route_bit)) {
+                        continue;
+                    }
+                    if (run_end != element_offsets_[e]) {
+                        if (run_end > run_begin) {
+                            AddSendBuffer(buffer_.data() + run_begin, run_end - run_begin);
+                        }
+                        run_begin = element_offsets_[e];
+                    }
+                    run_end = element_offsets_[e + 1];
+                }
+                AddSendBuffer(buffer_.data() + run_begin, run_end - run_begin);
+            }
+            datagrams_.push_back(OutboundDatagram{ to, first_buffer, send_buffers_.size() - first_buffer });
+        };
+
+        send_buffers_.clear();
+        datagrams_.clear();
+        add_datagram(&primary, 0); // VRChat gets everything, and goes first
+        for (size_t i = 0; i < destinations_.size(); ++i) {
+            add_datagram(&destinations_[i].addr, 1u << i);
+        }
+
+        if (SendDatagrams()) {
+            for (size_t i = first; i < next; ++i) {
+                sent_cache_[pending_sends_[i].id] = SentValue{ pending_sends_[i].value, now, true };
+            }
+        } else {
+            // VRChat didn't get these. Without a keepalive nothing would ever
+            // resend an unchanged value, so keep them queued for the next flush.
+            for (size_t i = first; i < next; ++i) {
+                pending_sends_[kept++] = pending_sends_[i];
+            }
+        }
+    }
+    pending_sends_.resize(kept);
+}
+
+void OSCManager::AddSendBuffer(const char* data, size_t size) {
+#ifdef _WIN32
+    send_buffers_.push_back(WSABUF{ static_cast<ULONG>(size), const_cast<CHAR*>(data) });
+#else
+    send_buffers_.push_back(iovec{ const_cast<char*>(data), size });
+#endif
+}
+
+bool OSCManager::SendDatagrams() {
+    auto report = [this](size_t index, int error) {
+        if (Logger::IsInitialized()) {
+            std::string target = "primary target";
+            for (const OutboundDestination& dest : destinations_) {
+                if (&dest.addr == datagrams_[index].to) {
+                    target = dest.label;
+                    break;
+                }
+            }
+            Logger::Error("OSCManager: Failed to send OSC message to " + target + ", error: " + std::to_string(error));
+        }
+    };
+
+    bool first_sent = false;
+#ifdef _WIN32
+    for (size_t i = 0; i < datagrams_.size(); ++i) {
+        const OutboundDatagram& d = datagrams_[i];
+        DWORD bytes_sent = 0;
+        int result = WSASendTo(socket_, &send_buffers_[d.first_buffer], static_cast<DWORD>(d.buffer_count),
+                               &bytes_sent, 0, reinterpret_cast<const sockaddr*>(d.to), sizeof(sockaddr_in),
+                               nullptr, nullptr);
+        if (result == SOCKET_ERROR) {
+            report(i, WSAGetLastError());
+        } else if (i == 0) {
+            first_sent = true;
+        }
+    }
+#else
+    // All destinations in one sendmmsg() call; on a failed datagram, report
+    // it and carry on with the rest.
+    send_msgs_.resize(datagrams_.size());
+    for (size_t i = 0; i < datagrams_.size(); ++i) {
+        const OutboundDatagram& d = datagrams_[i];
+        msghdr& hdr = send_msgs_[i].msg_hdr;
+        hdr = msghdr{};
+        hdr.msg_name = const_cast<sockaddr_in*>(d.to);
+        hdr.msg_namelen = sizeof(sockaddr_in);
+        hdr.msg_iov = &send_buffers_[d.first_buffer];
+        hdr.msg_iovlen = d.buffer_count;
+    }
+    size_t done = 0;
+    while (done < send_msgs_.size()) {
+        int n = sendmmsg(socket_, send_msgs_.data() + done, static_cast<unsigned int>(send_msgs_.size() - done), 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            report(done, errno);
+            ++done;
+            continue;
+        }
+        if (n == 0) {
+            break;
+        }
+        if (done == 0) {
+            first_sent = true;
+        }
+        done += static_cast<size_t>(n);
+    }
+#endif
+    return first_sent;
 }
 
 std::string OSCManager::GetDeviceString(OSCDeviceType device) const {
@@ -5,18 +5,24 @@
 #include <WS2tcpip.h>
 #else
 #include "WinsockCompat.hpp"
+#include <sys/uio.h>
 #endif
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <functional>
 #include <unordered_map>
 #include <array>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <vector>
 #include <mutex>
 #include "DeviceTypes.hpp"
 #include "Config.hpp"
+#include "OSCDispatchTable.hpp"
+#include "OSCMessageTemplate.hpp"
 
 // OSC headers - included directly
 #include <oscpp/client.hpp>
@@ -24,7 +30,8 @@
 
 namespace StayPutVR {
 
-// Maximum OSC packet size
+// Largest outbound OSC packet we build (the send buffer size). Inbound
+// datagrams are received into buffers sized from the socket's maximum.
 constexpr size_t MAX_PACKET_SIZE = 8192;
 
 enum class OSCDeviceType {
@@ -38,6 +45,14 @@ enum class OSCDeviceType {
     Mic
 };
 
+// Continuous (float) inbound parameters. These aren't dispatched per packet:
+// the receive thread overwrites a latest-value slot and the UI reads it once a
+// frame with OSCManager::ReadLatest().
+enum class OSCContinuousParam {
+    JawOpen,
+    Count
+};
+
 enum class DeviceRole {
     None,
     HMD,
@@ -57,6 +72,19 @@ enum class DeviceStatus {
     LockedOutOfBounds = 5
 };
 
+// Inbound OSC callbacks registered with OSCManager, one per handler.
+struct OSCHandlers {
+    std::function<void(OSCDeviceType, bool)> lock;        // device lock/unlock
+    std::function<void(OSCDeviceType, bool)> include;     // device include toggle
+    std::function<void(bool)> global_lock;                // global lock/unlock
+    std::function<void(bool)> global_out_of_bounds;
+    std::function<void(bool)> bite;
+    std::function<void(bool)> shock;                      // /avatar/parameters/Shock
+    std::function<void()> avatar_change;                  // /avatar/change
+    std::function<void(float)> estop_stretch;
+    std::function<void(bool)> collar_toggle;              // momentary contact
+};
+
 class OSCManager {
 public:
     static OSCManager& GetInstance();
@@ -77,6 +105,16 @@ public:
     // available over connectionless UDP). Thread-safe.
     double SecondsSinceLastInbound() const;
 
+    // Receive-side counters for the Status tab. Thread-safe.
+    struct ReceiveStats {
+        uint64_t datagrams = 0;     // datagrams read from the socket
+        uint64_t kernel_drops = 0;  // discarded by the OS with the receive buffer full
+        uint64_t truncated = 0;     // larger than the receive buffer (shouldn't happen)
+        int buffer_bytes = 0;       // SO_RCVBUF as granted by the OS
+        bool drops_supported = false; // kernel_drops is only available on Linux (SO_RXQ_OVFL)
+    };
+    ReceiveStats GetReceiveStats() const;
+
     // The port the receive socket is actually bound to. With ephemeral binding
     // this differs from the configured receive_port; otherwise it equals it.
     int GetActualReceivePort() const { return actual_receive_port_; }
@@ -85,9 +123,32 @@ public:
     // OSCQuery to point sends at VRChat's discovered OSC port. Thread-safe.
     void SetSendPort(int send_port);
 
-    // Function to set config for device lock paths
+    // Function to set config for device lock paths. Also applies the send
+    // keepalive and the extra outbound destinations (SetDestinations).
     void SetConfig(const Config& config);
 
+    // Extra outbound destinations besides the primary (VRChat) target. Each
+    // one gets the outbound params whose address starts with one of its
+    // filter prefixes (all of them when the filter is empty). Messages are
+    // still encoded once per flush; every destination is just another
+    // datagram over the same bytes. Disabled entries and entries whose
+    // address isn't an IPv4 literal are skipped. Thread-safe.
+    void SetDestinations(const std::vector<Config::OSCDestination>& destinations);
+    static constexpr size_t kMaxDestinations = 16;
+
+    // Outbound sends are change-only and batched. The Send*() methods below
+    // only queue a value when it differs from what was last sent to that
+    // address (or the keepalive interval from SetConfig has passed);
+    // FlushSends() transmits everything queued since the previous flush as
+    // one OSC bundle; values the primary target didn't get stay queued for
+    // the next flush. The UI flushes once per frame. Thread-safe.
+    void FlushSends();
+
+    // Forget what was last sent, so the next send to each address goes out
+    // even if unchanged. For when the receiver has lost its state (VRChat
+    // resets avatar params on /avatar/change) or the send target changed.
+    void InvalidateSendCache();
+
     // Send device status updates
     void SendDeviceStatus(OSCDeviceType device, DeviceStatus status);
 
@@ -100,41 +161,44 @@ public:
     void SendSoundEffect(const std::string& path, int value);
 
     // Set callback for when a device should be locked/unlocked.
-    // All setters are guarded by callback_mutex_ so the receive thread
-    // never sees a half-written std::function.
-    void SetLockCallback(std::function<void(OSCDeviceType, bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); lock_callback_ = std::move(callback); }
+    // Every setter publishes a new immutable OSCHandlers snapshot (see
+    // handlers_), so the receive thread never sees a half-written
+    // std::function and never waits on a setter. Callbacks run on the
+    // receive thread.
+    void SetLockCallback(std::function<void(OSCDeviceType, bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.lock = std::move(callback); }); }
 
     // Set callback for device include/exclude in locking
-    void SetIncludeCallback(std::function<void(OSCDeviceType, bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); include_callback_ = std::move(callback); }
+    void SetIncludeCallback(std::function<void(OSCDeviceType, bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.include = std::move(callback); }); }
 
     // Set callback for global lock/unlock
-    void SetGlobalLockCallback(std::function<void(bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); global_lock_callback_ = std::move(callback); }
+    void SetGlobalLockCallback(std::function<void(bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.global_lock = std::move(callback); }); }
 
     // Set callback for global out-of-bounds
-    void SetGlobalOutOfBoundsCallback(std::function<void(bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); global_out_of_bounds_callback_ = std::move(callback); }
+    void SetGlobalOutOfBoundsCallback(std::function<void(bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.global_out_of_bounds = std::move(callback); }); }
 
     // Set callback for bite actions
-    void SetBiteCallback(std::function<void(bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); bite_callback_ = std::move(callback); }
+    void SetBiteCallback(std::function<void(bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.bite = std::move(callback); }); }
 
     // Set callback for avatar change (VRChat /avatar/change). Fired when the
     // user switches avatars so lock/shock state can be reset.
-    void SetAvatarChangeCallback(std::function<void()> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); avatar_change_callback_ = std::move(callback); }
+    void SetAvatarChangeCallback(std::function<void()> callback) { UpdateHandlers([&](OSCHandlers& h) { h.avatar_change = std::move(callback); }); }
 
     // Set callback for the external shock param (/avatar/parameters/Shock).
-    void SetShockCallback(std::function<void(bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); shock_callback_ = std::move(callback); }
+    void SetShockCallback(std::function<void(bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.shock = std::move(callback); }); }
 
     // Set callback for emergency stop stretch actions
-    void SetEStopStretchCallback(std::function<void(float)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); estop_stretch_callback_ = std::move(callback); }
+    void SetEStopStretchCallback(std::function<void(float)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.estop_stretch = std::move(callback); }); }
 
-    // Set callback for the VRCFT JawOpen parameter (float 0..1). Fired on every
-    // inbound JawOpen value so the UI can track the live jaw value and enforce
-    // the JawOpen constraint while the HMD is locked.
-    void SetJawOpenCallback(std::function<void(float)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); jawopen_callback_ = std::move(callback); }
+    // Latest value of a continuous parameter (e.g. the VRCFT JawOpen bridge,
+    // float 0..1). Returns true and updates value/last_seq if a packet arrived
+    // since last_seq; intermediate values between two reads are dropped.
+    // Lock-free; intended for one reader per parameter (the UI thread).
+    bool ReadLatest(OSCContinuousParam param, float& value, uint32_t& last_seq) const;
 
     // Set callback for the unified collar-mode toggle button (SPVR_Collar_ToggleButton,
     // a momentary contact). Fired on every inbound value (true and false) so the UI can
     // do rising-edge detection and advance SPVR_Collar_Mode.
-    void SetCollarToggleCallback(std::function<void(bool)> callback) { std::lock_guard<std::mutex> lk(callback_mutex_); collar_toggle_callback_ = std::move(callback); }
+    void SetCollarToggleCallback(std::function<void(bool)> callback) { UpdateHandlers([&](OSCHandlers& h) { h.collar_toggle = std::move(callback); }); }
 
     // VRCOSC PiShock methods
     void SendPiShockGroup(int group);
@@ -144,6 +208,22 @@ public:
     void SendPiShockVibrate(bool enabled);
     void SendPiShockBeep(bool enabled);
     
+    // Outbound addresses are encoded once (OSCMessageTemplate) and referred to
+    // by id. The fixed ids are the built-in addresses, encoded at compile time;
+    // configured addresses get ids above them.
+    using OutboundId = uint16_t;
+    enum : OutboundId {
+        kOutboundStatusFirst = 0,  // + OSCDeviceType, through Mic
+        kOutboundCollarMode = kOutboundStatusFirst + static_cast<OutboundId>(OSCDeviceType::Mic) + 1,
+        kOutboundPiShockGroup,
+        kOutboundPiShockDuration,
+        kOutboundPiShockIntensity,
+        kOutboundPiShockShock,
+        kOutboundPiShockVibrate,
+        kOutboundPiShockBeep,
+        kFixedOutboundCount
+    };
+
     // Helper string conversion functions
     std::string GetDeviceString(OSCDeviceType device) const;
     std::string GetStatusPath(OSCDeviceType device) const;
@@ -152,7 +232,10 @@ public:
     std::string GetRoleString(DeviceRole role) const;
 
 private:
-    OSCManager() = default;
+    // tools/alloc_audit replays packets through ProcessOSCMessage.
+    friend class AllocationAudit;
+
+    OSCManager();
     ~OSCManager();
     OSCManager(const OSCManager&) = delete;
     OSCManager& operator=(const OSCManager&) = delete;
@@ -167,6 +250,16 @@ private:
     // Written from the receive thread, read from the UI thread.
     std::atomic<long long> last_inbound_ns_{0};
 
+    // Receive buffer and overflow accounting (see GetReceiveStats).
+    int receive_buffer_request_bytes_ = 0;   // from config; 0 = OS default
+    int receive_buffer_applied_bytes_ = -1;  // last request applied to the socket
+    std::atomic<int> receive_buffer_bytes_{0};
+    std::atomic<uint64_t> received_datagrams_{0};
+    std::atomic<uint64_t> kernel_drops_{0};
+    std::atomic<uint64_t> truncated_datagrams_{0};
+    void ApplyReceiveBufferSize();
+    static size_t MaxDatagramSize(SOCKET s);
+
     // Socket and buffer
     SOCKET socket_ = INVALID_SOCKET;
     SOCKET receive_socket_ = INVALID_SOCKET;
@@ -175,19 +268,140 @@ private:
     // OSCQuery browse thread when VRChat is discovered) and the senders running
     // on the UI thread don't tear the sin_port field.
     mutable std::mutex send_addr_mutex_;
+
+    // An outbound argument: the OSC type tag and its raw 32 bits.
+    struct OutboundValue {
+        char tag = 0;
+        uint32_t bits = 0;
+        bool operator==(const OutboundValue& other) const { return tag == other.tag && bits == other.bits; }
+    };
+    struct PendingSend {
+        OutboundId id;
+        OutboundValue value;
+    };
+    struct SentValue {
+        OutboundValue value;
+        std::chrono::steady_clock::time_point sent_at;
+        bool valid = false;
+    };
+
+    struct OutboundDestination {
+        sockaddr_in addr;
+        std::vector<std::string> prefixes;  // empty = every address
+        std::string label;                  // "host:port", for logging
+    };
+
+    // One datagram of a flush: a run of scatter/gather buffers pointing into
+    // buffer_, sent to one destination.
+#ifdef _WIN32
+    using SendBuffer = WSABUF;
+#else
+    using SendBuffer = iovec;
+#endif
+    struct OutboundDatagram {
+        const sockaddr_in* to;
+        size_t first_buffer;
+        size_t buffer_count;
+    };
+
+    // Guards everything below, including buffer_. Taken before
+    // send_addr_mutex_ when both are needed.
+    std::mutex send_queue_mutex_;
+    std::vector<OSCMessageTemplate> outbound_templates_;      // by OutboundId
+    std::vector<uint32_t> outbound_routes_;                   // by OutboundId: bit i = destinations_[i]
+    std::unordered_map<std::string, OutboundId> outbound_ids_;
+    std::vector<SentValue> sent_cache_;                       // by OutboundId
+    std::vector<PendingSend> pending_sends_;                  // issue order, one per id
+    std::chrono::duration<float> send_keepalive_{ 0.0f };     // 0 = change-only, no re-sends
+    std::vector<OutboundDestination> destinations_;           // extras, at most kMaxDestinations
     std::array<char, MAX_PACKET_SIZE> buffer_;
+    std::vector<size_t> element_offsets_;                     // per flush chunk, into buffer_
+    std::vector<SendBuffer> send_buffers_;
+    std::vector<OutboundDatagram> datagrams_;
+#ifndef _WIN32
+    std::vector<mmsghdr> send_msgs_;
+#endif
+
+    static OutboundId StatusOutboundId(OSCDeviceType device);
+    OutboundId OutboundIdFor(const std::string& path);
+    OutboundId RegisterOutboundLocked(const std::string& path);
+    // Drops the slots of configured addresses not in keep (the fixed ids
+    // stay), so a changed path doesn't leave a stale slot behind for good.
+    // Renumbers the remaining configured ids.
+    void PruneOutboundLocked(const std::vector<std::string>& keep);
+    void RegisterFixedOutbound();
+    uint32_t RoutesForLocked(std::string_view address) const;
+    bool QueueSend(OutboundId id, OutboundValue value);
+    void AddSendBuffer(const char* data, size_t size);
+    // Sends datagrams_ (sendmmsg on Linux, a WSASendTo loop on Windows).
+    // Returns whether the first datagram went out.
+    bool SendDatagrams();
     
     // Thread for receiving OSC messages
     std::thread receive_thread_;
     std::atomic<bool> receive_thread_running_ = false;
-    
+
+    // The receive thread blocks until the socket is readable or Shutdown()
+    // signals the wakeup, then drains every queued datagram before waiting
+    // again. Windows: WSAEventSelect event + a manual-reset wake event.
+    // Linux: poll() on the socket + an eventfd.
+#ifdef _WIN32
+    WSAEVENT receive_event_ = WSA_INVALID_EVENT;
+    WSAEVENT wake_event_ = WSA_INVALID_EVENT;
+#else
+    int wake_fd_ = -1;
+#endif
+    bool CreateReceiveWakeup();
+    void SignalReceiveWakeup();
+    void CloseReceiveWakeup();
+
+    // Datagrams read per recvmmsg() call on Linux.
+    static constexpr size_t kReceiveBatch = 16;
+
     // Receive thread function
     void ReceiveThreadFunction();
     
     // Process received OSC message
     void ProcessOSCMessage(const char* data, size_t size);
+
+    // What an inbound address is wired to. The handler decides which callback
+    // runs and what value it needs; device is only meaningful for Lock.
+    enum class OSCHandler : uint8_t {
+        AvatarChange,
+        Lock,
+        GlobalLock,
+        GlobalUnlock,
+        GlobalOutOfBounds,
+        Bite,
+        Shock,
+        EStopStretch,
+        JawOpen,
+        CollarToggle
+    };
+    struct OSCRoute {
+        OSCHandler handler;
+        OSCDeviceType device;
+    };
+    using DispatchTable = OSCDispatchTable<OSCRoute>;
+
+    // Rebuild the address table from the osc_*_path_ members below and publish
+    // it to the receive thread. Called on construction and from SetConfig().
+    void RebuildDispatchTable();
+
+    // Current address table. Replaced wholesale by RebuildDispatchTable(); the
+    // receive thread holds a reference for the duration of one message.
+    std::atomic<std::shared_ptr<const DispatchTable>> dispatch_table_;
+
+    // Hashes of unrouted addresses already reported by the debug-level
+    // "first inbound OSC address" log. Receive thread only; fixed size, so
+    // logging stops once it's full rather than growing.
+    static constexpr size_t kSeenAddressSlots = 1024;
+    std::array<uint64_t, kSeenAddressSlots> seen_address_hashes_{};
+    size_t seen_address_count_ = 0;
+    bool FirstSeenAddress(uint64_t hash);
     
-    // OSC paths from config
+    // OSC paths from config. Only read on the thread calling SetConfig(); the
+    // receive thread goes through dispatch_table_.
     std::string osc_lock_path_hmd_ = "/avatar/parameters/SPVR_HMD_Latch_IsPosed";
     std::string osc_lock_path_left_hand_ = "/avatar/parameters/SPVR_ControllerLeft_Latch_IsPosed";
     std::string osc_lock_path_right_hand_ = "/avatar/parameters/SPVR_ControllerRight_Latch_IsPosed";
@@ -218,44 +432,37 @@ private:
     // Unified collar-mode toggle button (momentary contact). Inbound only.
     std::string osc_collar_toggle_path_ = "/avatar/parameters/SPVR_Collar_ToggleButton";
 
-    // Helper methods for sending OSC messages
-    bool SendOSCMessage(const std::string& path, int value);
-    bool SendOSCMessage(const std::string& path, float value);
-    bool SendOSCMessage(const std::string& path, bool value);
-    
-    // Mutex protecting all callback members below. The receive thread
-    // holds this while dispatching; Set*Callback() holds it while writing.
-    mutable std::mutex callback_mutex_;
-
-    // Callback for lock/unlock events
-    std::function<void(OSCDeviceType, bool)> lock_callback_;
+    // Latest-value mailboxes for OSCContinuousParam. Written only by the
+    // receive thread: the value is stored first, then seq is bumped with
+    // release order so a reader that sees the new seq sees that value (or a
+    // later one).
+    struct LatestValueSlot {
+        std::atomic<float> value{0.0f};
+        std::atomic<uint32_t> seq{0};
+    };
+    std::array<LatestValueSlot, static_cast<size_t>(OSCContinuousParam::Count)> latest_values_;
+    void PublishLatest(OSCContinuousParam param, float value);
+
+    // Helper methods for sending OSC messages. Return true if the value was
+    // queued, false if it was unchanged (or OSC isn't initialized).
+    bool SendOSCMessage(OutboundId id, int value);
+    bool SendOSCMessage(OutboundId id, float value);
+    bool SendOSCMessage(OutboundId id, bool value);
     
-    // Callback for include/exclude events
-    std::function<void(OSCDeviceType, bool)> include_callback_;
-    
-    // Callback for global lock/unlock events
-    std::function<void(bool)> global_lock_callback_;
-    
-    // Callback for global out-of-bounds events
-    std::function<void(bool)> global_out_of_bounds_callback_;
-    
-    // Callback for bite events
-    std::function<void(bool)> bite_callback_;
-
-    // Callback for external shock param (/avatar/parameters/Shock)
-    std::function<void(bool)> shock_callback_;
-
-    // Callback for avatar change events (/avatar/change)
-    std::function<void()> avatar_change_callback_;
-    
-    // Callback for emergency stop stretch events
-    std::function<void(float)> estop_stretch_callback_;
-
-    // Callback for the VRCFT JawOpen parameter (float 0..1)
-    std::function<void(float)> jawopen_callback_;
-
-    // Callback for the unified collar-mode toggle button (momentary contact, bool)
-    std::function<void(bool)> collar_toggle_callback_;
+    // Callback snapshot, replaced wholesale (copy, edit, publish) by the
+    // Set*Callback() setters; the receive thread loads it once per message and
+    // calls through it without taking a lock. handlers_write_mutex_ only
+    // serializes setters against each other so no update is lost.
+    std::atomic<std::shared_ptr<const OSCHandlers>> handlers_{ std::make_shared<const OSCHandlers>() };
+    std::mutex handlers_write_mutex_;
+
+    template <typename Edit>
+    void UpdateHandlers(Edit&& edit) {
+        std::lock_guard<std::mutex> lock(handlers_write_mutex_);
+        auto next = std::make_shared<OSCHandlers>(*handlers_.load());
+        edit(*next);
+        handlers_.store(std::move(next));
+    }
 };
 
 } // namespace StayPutVR 
\ No newline at end of file
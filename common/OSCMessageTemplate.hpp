@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// A one-argument OSC message encoded ahead of time up to its argument: the
+// NUL-padded address, the ",?" type tag string and a 4-byte argument slot.
+// Sending it is a copy of the bytes with the tag character and the big-endian
+// argument patched in -- no per-send address encoding or string building.
+//
+// The constructor is constexpr, so templates for built-in addresses are
+// encoded at compile time; OSCManager builds the rest when paths are
+// configured. Addresses too long for kMaxSize produce an invalid template.
+
+namespace StayPutVR {
+
+    class OSCMessageTemplate {
+    public:
+        static constexpr size_t kMaxSize = 160;
+
+        constexpr OSCMessageTemplate() = default;
+
+        constexpr explicit OSCMessageTemplate(std::string_view address) {
+            // Address and its terminator, padded to 4; ",x\0\0"; 4-byte argument.
+            const size_t padded = (address.size() + 4) & ~size_t(3);
+            if (address.empty() || address[0] != '/' || padded + 8 > kMaxSize) {
+                return;
+            }
+            for (size_t i = 0; i < address.size(); ++i) {
+                bytes_[i] = address[i];
+            }
+            bytes_[padded] = ',';
+            bytes_[padded + 1] = 'i';
+            address_length_ = static_cast<uint16_t>(address.size());
+            tag_offset_ = static_cast<uint16_t>(padded + 1);
+            size_ = static_cast<uint16_t>(padded + 8);
+        }
+
+        constexpr bool Valid() const { return size_ != 0; }
+        constexpr size_t Size() const { return size_; }
+        constexpr std::string_view Address() const { return std::string_view(bytes_.data(), address_length_); }
+
+        // Writes Size() bytes to out: the message with type tag `tag` ('i' or
+        // 'f') and the argument's raw 32 bits in network byte order.
+        void Encode(char* out, char tag, uint32_t bits) const {
+            std::memcpy(out, bytes_.data(), size_);
+            out[tag_offset_] = tag;
+            char* arg = out + size_ - 4;
+            arg[0] = static_cast<char>(bits >> 24);
+            arg[1] = static_cast<char>(bits >> 16);
+            arg[2] = static_cast<char>(bits >> 8);
+            arg[3] = static_cast<char>(bits);
+        }
+
+    private:
+        std::array<char, kMaxSize> bytes_{};
+        uint16_t size_ = 0;
+        uint16_t address_length_ = 0;
+        uint16_t tag_offset_ = 0;
+    };
+
+} // namespace StayPutVR
@@ -1,7 +1,10 @@
 #include "OSCQueryServer.hpp"
 #include "Logger.hpp"
+#include "EventLoop.hpp"
 #include <memory>
 #include <chrono>
+#include <condition_variable>
+#include <unordered_set>
 
 #ifdef _WIN32
     #include <WS2tcpip.h>
@@ -16,8 +19,13 @@
     #include <net/if.h>
 #endif
 
-#define CPPHTTPLIB_NO_EXCEPTIONS
-#include <cpp-httplib/httplib.h>
+// LISTEN streams: Stop() has no way to interrupt a handler blocked in read()
+// other than the peer answering its Close frame, or the read timing out. The
+// server pings every 2 s (see HTTPThread), so a live client never idles out
+// at 5 s, while a dead or unresponsive one can't hold shutdown for longer.
+#define CPPHTTPLIB_WEBSOCKET_READ_TIMEOUT_SECOND 5
+#define CPPHTTPLIB_WEBSOCKET_CLOSE_TIMEOUT_SECOND 1
+#include "HttpLib.hpp"
 
 #include <mdns/mdns.h>
 
@@ -150,8 +158,207 @@ static json ValueToJSON(const std::variant<float, int, bool, std::string>& v) {
     return json::array({0});
 }
 
+// "/avatar//parameters/" -> "/avatar/parameters"; "" and "/" -> "/".
+static std::string NormalizePath(const std::string& path) {
+    std::string normalized;
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        if (end > start) {
+            normalized += '/';
+            normalized.append(path, start, end - start);
+        }
+        start = end + 1;
+    }
+    return normalized.empty() ? "/" : normalized;
+}
+
+// If-None-Match holds one or more (possibly weak) ETags, or "*".
+static bool ETagMatches(const std::string& if_none_match, const std::string& etag) {
+    std::istringstream ss(if_none_match);
+    std::string candidate;
+    while (std::getline(ss, candidate, ',')) {
+        const size_t begin = candidate.find_first_not_of(" \t");
+        if (begin == std::string::npos) continue;
+        const size_t end = candidate.find_last_not_of(" \t");
+        candidate = candidate.substr(begin, end - begin + 1);
+        if (candidate == "*") return true;
+        if (candidate.rfind("W/", 0) == 0) candidate = candidate.substr(2);
+        if (candidate == etag) return true;
+    }
+    return false;
+}
+
+// One OSC message, as the LISTEN extension streams it. Hand-encoded: the tree
+// only ever holds these four value types.
+static std::string EncodeOSCMessage(const std::string& address,
+                                    const std::variant<float, int, bool, std::string>& value) {
+    std::string out;
+    auto pad = [&out] { out.append(4 - out.size() % 4, '\0'); }; // terminator + align
+    auto put32 = [&out](uint32_t v) {
+        for (int shift = 24; shift >= 0; shift -= 8) out += static_cast<char>((v >> shift) & 0xFF);
+    };
+    out += address;
+    pad();
+    if (auto* f = std::get_if<float>(&value)) {
+        out += ",f";
+        pad();
+        uint32_t bits;
+        std::memcpy(&bits, f, sizeof(bits));
+        put32(bits);
+    } else if (auto* i = std::get_if<int>(&value)) {
+        out += ",i";
+        pad();
+        put32(static_cast<uint32_t>(*i));
+    } else if (auto* b = std::get_if<bool>(&value)) {
+        out += *b ? ",T" : ",F";
+        pad();
+    } else {
+        out += ",s";
+        pad();
+        out += std::get<std::string>(value);
+        pad();
+    }
+    return out;
+}
+
+struct OSCQueryServer::StreamClient {
+    httplib::ws::WebSocket* ws = nullptr;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_set<std::string> listening;
+    // Latest frame per path not yet sent, in first-changed order. A newer
+    // value replaces the pending one (counted in coalesced) instead of
+    // queueing behind it, so the backlog is bounded by the LISTEN count.
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> pending;
+    std::vector<std::string> order;
+    bool closing = false;  // the connection is done; the writer exits
+    bool stopping = false; // ...because of Stop(): the writer closes the socket
+    uint64_t sent = 0;
+    uint64_t coalesced = 0;
+
+    // Caller holds mutex.
+    void OfferLocked(const std::string& path, std::shared_ptr<const std::string> frame) {
+        auto [it, inserted] = pending.try_emplace(path, std::move(frame));
+        if (inserted) {
+            order.push_back(path);
+        } else {
+            it->second = std::move(frame);
+            ++coalesced;
+        }
+        cv.notify_one();
+    }
+
+    void WriteLoop() {
+        std::vector<std::shared_ptr<const std::string>> batch;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cv.wait(lock, [this] { return closing || !order.empty(); });
+            if (closing) break;
+            for (const std::string& path : order) {
+                auto it = pending.find(path);
+                if (it == pending.end()) continue; // IGNOREd since
+                batch.push_back(std::move(it->second));
+                pending.erase(it);
+            }
+            order.clear();
+            lock.unlock();
+
+            size_t written = 0;
+            while (written < batch.size() && ws->send(batch[written]->data(), batch[written]->size())) {
+                ++written;
+            }
+            const bool ok = written == batch.size();
+            batch.clear();
+
+            lock.lock();
+            sent += written;
+            if (!ok) break; // the handler's read() fails on the same broken socket
+        }
+        const bool going_away = stopping;
+        lock.unlock();
+        // The handler thread is blocked in read(); closing from here is what
+        // ends it (the peer echoes the Close frame or drops the connection).
+        if (going_away) ws->close(httplib::ws::CloseStatus::GoingAway, "server stopping");
+    }
+};
+
+// --- mDNS state (the responder/browser itself is further down) ---
+
+// Per local interface: a socket on 5353 that hears every multicast query and
+// response on the link (answering the former, browsing the latter), and an
+// ephemeral-port socket our own browse queries go out on, which receives
+// unicast replies. Binding each to its interface makes multicast egress
+// *every* interface (the mdns lib only pins IP_MULTICAST_IF for a specific
+// address); INADDR_ANY would use only the OS default interface -- which a VPN
+// like Tailscale can own, hiding us from the real LAN where VRChat is.
+//
+// The answer packets are built once when the sockets are opened: the ports
+// and the interface address can't change until the next Start().
+struct MDNSInterface {
+    std::string ip;
+    struct sockaddr_in addr{}; // sin_port 0: the A record carries no port
+    int listen_sock = -1;
+    int query_sock = -1;
+    std::string answer[2];   // [0] _oscjson._tcp, [1] _osc._udp
+    std::string announce[2];
+    std::string goodbye[2];
+};
+
+struct MDNSContext {
+    const MDNSInterface* iface;
+    std::optional<int> osc_port; // VRChat's, if this packet carried them
+    std::optional<int> query_port;
+};
+
+// Browse queries go out every second while VRChat hasn't been seen, backing
+// off to 8 s; VRChat's own start-up announcement is heard on the 5353
+// sockets in between. Once found, a slow query keeps it fresh, and after
+// kVRChatLostAfter without seeing its OSC service we assume VRChat has gone
+// away and clear the discovered port. That lets a VRChat restart on the
+// *same* port be re-detected: the next discovery differs from the stored
+// value and fires the retarget callback again.
+static constexpr auto kSearchIntervalMin = std::chrono::seconds(1);
+static constexpr auto kSearchIntervalMax = std::chrono::seconds(8);
+static constexpr auto kFoundInterval = std::chrono::seconds(5);
+static constexpr auto kVRChatLostAfter = std::chrono::seconds(20);
+static constexpr auto kBindRetryInterval = std::chrono::seconds(5); // while UDP 5353 can't be bound
+static constexpr auto kInterfaceCheckInterval = std::chrono::seconds(30);
+
+// The responder/browser's state. It lives on the shared EventLoop: every
+// member below is only touched from loop callbacks, or through Invoke().
+struct OSCQueryServer::MDNSState {
+    using Clock = EventLoop::Clock;
+
+    explicit MDNSState(OSCQueryServer* server) : self(server) {}
+
+    OSCQueryServer* self;
+    EventLoop& loop = EventLoop::Shared();
+    std::vector<MDNSInterface> ifaces;
+    std::vector<std::string> ips;
+    std::vector<EventLoop::Id> watches;
+    EventLoop::Id query_timer = 0;
+    EventLoop::Id announce_timer = 0; // the follow-up announcement
+    EventLoop::Id check_timer = 0;    // interface re-check / bind retry
+    int bind_attempts = 0;
+    bool vrchat_seen = false;
+    Clock::duration search_interval = kSearchIntervalMin;
+    Clock::time_point last_seen;
+    char buffer[2048];
+
+    void Open();
+    void CloseAll(bool goodbye);
+    void CheckInterfaces();
+    void Query();
+    void OnReadable(const MDNSInterface& iface, int sock);
+};
+
 OSCQueryServer::OSCQueryServer() {
     hostname_ = GetLocalHostname();
+    instance_ = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    tree_.push_back(TreeNode{ "/" });
+    tree_index_["/"] = 0;
 }
 
 OSCQueryServer::~OSCQueryServer() {
@@ -173,11 +380,12 @@ bool OSCQueryServer::Start(int osc_udp_port) {
         return false;
     }
 
+    host_info_ = BuildHostInfo();
     running_ = true;
 
     http_thread_ = std::thread(&OSCQueryServer::HTTPThread, this);
-    mdns_browse_thread_ = std::thread(&OSCQueryServer::MDNSBrowseThread, this);
-    mdns_listen_thread_ = std::thread(&OSCQueryServer::MDNSListenThread, this);
+    mdns_ = std::make_unique<MDNSState>(this);
+    EventLoop::Shared().Invoke([this] { mdns_->Open(); });
 
     LogInfo("OSCQuery started: HTTP port=" + std::to_string(http_port_) +
             " OSC port=" + std::to_string(osc_port_));
@@ -188,19 +396,28 @@ void OSCQueryServer::Stop() {
     if (!running_) return;
     running_ = false;
 
+    // Each LISTEN stream holds an HTTP worker in a blocking read, and
+    // listen() doesn't return until every worker has; close them first.
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        for (const auto& client : stream_clients_) {
+            std::lock_guard<std::mutex> client_lock(client->mutex);
+            client->closing = true;
+            client->stopping = true;
+            client->cv.notify_one();
+        }
+    }
+
     if (http_server_) {
         static_cast<httplib::Server*>(http_server_)->stop();
     }
 
-    {
-        std::lock_guard<std::mutex> lock(mdns_sockets_mutex_);
-        for (int s : mdns_sockets_) if (s >= 0) mdns_socket_close(s);
-        mdns_sockets_.clear();
+    if (mdns_) {
+        EventLoop::Shared().Invoke([this] { mdns_->CloseAll(/*goodbye=*/true); });
+        mdns_.reset();
     }
 
     if (http_thread_.joinable()) http_thread_.join();
-    if (mdns_browse_thread_.joinable()) mdns_browse_thread_.join();
-    if (mdns_listen_thread_.joinable()) mdns_listen_thread_.join();
 
     http_server_ = nullptr;
     LogInfo("OSCQuery stopped");
@@ -208,24 +425,147 @@ void OSCQueryServer::Stop() {
 
 void OSCQueryServer::AddParameter(const std::string& path, const std::string& osc_type,
                                    Access access, std::variant<float, int, bool, std::string> initial_value) {
+    // An unset (empty) config path has no place in the tree.
+    if (path.empty() || path[0] != '/') return;
+
     std::lock_guard<std::mutex> lock(param_mutex_);
     auto it = param_index_.find(path);
     if (it != param_index_.end()) {
-        params_[it->second].osc_type = osc_type;
-        params_[it->second].access = access;
-        params_[it->second].value = initial_value;
+        ParamNode& p = params_[it->second];
+        if (p.osc_type == osc_type && p.access == access && p.value == initial_value) return;
+        p.osc_type = osc_type;
+        p.access = access;
+        p.value = std::move(initial_value);
+        InvalidateLocked(tree_index_.at(NormalizePath(path)));
         return;
     }
+    const size_t node = EnsureNodeLocked(NormalizePath(path));
     param_index_[path] = params_.size();
-    params_.push_back({path, osc_type, access, initial_value});
+    // Two spellings of the same path ("/a//b", "/a/b"): the first one keeps the node.
+    if (tree_[node].param < 0) {
+        tree_[node].param = static_cast<int>(params_.size());
+    }
+    params_.push_back({path, osc_type, access, std::move(initial_value)});
+    InvalidateLocked(node);
 }
 
 void OSCQueryServer::UpdateValue(const std::string& path, std::variant<float, int, bool, std::string> value) {
     std::lock_guard<std::mutex> lock(param_mutex_);
     auto it = param_index_.find(path);
-    if (it != param_index_.end()) {
-        params_[it->second].value = value;
+    if (it == param_index_.end() || params_[it->second].value == value) return;
+    params_[it->second].value = value;
+    InvalidateLocked(tree_index_.at(NormalizePath(path)));
+    // Published under param_mutex_ so streams see changes in update order.
+    if (stream_listens_ > 0) PublishValueLocked(path, value);
+}
+
+void OSCQueryServer::PublishValueLocked(const std::string& path,
+                                        const std::variant<float, int, bool, std::string>& value) {
+    std::shared_ptr<const std::string> frame; // encoded once, shared by every listener
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    for (const auto& client : stream_clients_) {
+        std::lock_guard<std::mutex> client_lock(client->mutex);
+        if (client->closing || !client->listening.count(path)) continue;
+        if (!frame) frame = std::make_shared<const std::string>(EncodeOSCMessage(path, value));
+        client->OfferLocked(path, frame);
+    }
+}
+
+void OSCQueryServer::SetListening(StreamClient& client, const std::string& path, bool listen) {
+    // Under param_mutex_ so the current value queued on LISTEN can't land
+    // after a newer one from a racing UpdateValue().
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    auto node = tree_index_.find(NormalizePath(path));
+    if (node == tree_index_.end() || tree_[node->second].param < 0) {
+        LogDebug("OSCQuery stream: " + std::string(listen ? "LISTEN" : "IGNORE") +
+                 " for unknown parameter " + path);
+        return;
+    }
+    const ParamNode& param = params_[tree_[node->second].param];
+
+    std::lock_guard<std::mutex> client_lock(client.mutex);
+    if (listen) {
+        if (!client.listening.insert(param.full_path).second) return;
+        ++stream_listens_;
+        client.OfferLocked(param.full_path,
+                           std::make_shared<const std::string>(EncodeOSCMessage(param.full_path, param.value)));
+    } else if (client.listening.erase(param.full_path)) {
+        --stream_listens_;
+        client.pending.erase(param.full_path);
+    }
+}
+
+size_t OSCQueryServer::EnsureNodeLocked(const std::string& path) {
+    auto it = tree_index_.find(path);
+    if (it != tree_index_.end()) return it->second;
+
+    const size_t slash = path.rfind('/');
+    const size_t parent = EnsureNodeLocked(slash == 0 ? "/" : path.substr(0, slash));
+    const size_t node = tree_.size();
+    TreeNode n;
+    n.path = path;
+    n.parent = parent;
+    tree_.push_back(std::move(n));
+    tree_[parent].children[path.substr(slash + 1)] = node;
+    tree_index_[path] = node;
+    return node;
+}
+
+void OSCQueryServer::InvalidateLocked(size_t node) {
+    const uint64_t version = ++tree_version_;
+    for (;;) {
+        TreeNode& n = tree_[node];
+        n.version = version;
+        n.json.reset();
+        if (node == n.parent) break;
+        node = n.parent;
+    }
+}
+
+const std::shared_ptr<const std::string>& OSCQueryServer::SerializeLocked(size_t node) {
+    if (tree_[node].json) return tree_[node].json;
+
+    // Same document nlohmann produced from the old per-request DOM: keys in
+    // sorted order, containers always carry CONTENTS, leaves only if
+    // something is nested under them.
+    std::string out = "{";
+    const int param = tree_[node].param;
+    if (param >= 0) {
+        out += "\"ACCESS\":" + std::to_string(static_cast<int>(params_[param].access)) + ",";
+    }
+    if (param < 0 || !tree_[node].children.empty()) {
+        out += "\"CONTENTS\":{";
+        bool first = true;
+        for (const auto& [name, child] : tree_[node].children) {
+            if (!first) out += ',';
+            first = false;
+            out += json(name).dump();
+            out += ':';
+            out += *SerializeLocked(child);
+        }
+        out += "},";
+    }
+    out += "\"FULL_PATH\":";
+    out += json(param >= 0 ? params_[param].full_path : tree_[node].path).dump();
+    if (param >= 0) {
+        out += ",\"TYPE\":" + json(params_[param].osc_type).dump();
+        out += ",\"VALUE\":" + ValueToJSON(params_[param].value).dump();
     }
+    out += "}";
+
+    tree_[node].json = std::make_shared<const std::string>(std::move(out));
+    return tree_[node].json;
+}
+
+std::optional<OSCQueryServer::NodeResponse> OSCQueryServer::GetNodeJSON(const std::string& path) {
+    std::lock_guard<std::mutex> lock(param_mutex_);
+    auto it = tree_index_.find(NormalizePath(path));
+    if (it == tree_index_.end()) return std::nullopt;
+    return NodeResponse{ SerializeLocked(it->second), MakeETag(tree_[it->second].version) };
+}
+
+std::string OSCQueryServer::MakeETag(uint64_t version) const {
+    return "\"" + std::to_string(instance_) + "-" + std::to_string(version) + "\"";
 }
 
 std::optional<int> OSCQueryServer::GetVRChatOSCPort() const {
@@ -250,523 +590,407 @@ std::string OSCQueryServer::BuildHostInfo() const {
     j["OSC_TRANSPORT"] = "UDP";
     j["EXTENSIONS"]["ACCESS"] = true;
     j["EXTENSIONS"]["VALUE"] = true;
+    j["EXTENSIONS"]["LISTEN"] = true;
     return j.dump();
 }
 
-static json MakeParamJSON(const OSCQueryServer::ParamNode& p) {
-    json node;
-    node["FULL_PATH"] = p.full_path;
-    node["TYPE"] = p.osc_type;
-    node["ACCESS"] = static_cast<int>(p.access);
-    node["VALUE"] = ValueToJSON(p.value);
-    return node;
-}
-
-static json MakeContainerJSON(const std::string& path) {
-    json node;
-    node["FULL_PATH"] = path;
-    node["CONTENTS"] = json::object();
-    return node;
-}
-
-std::string OSCQueryServer::BuildFullTree() const {
-    std::lock_guard<std::mutex> lock(param_mutex_);
-
-    json root = MakeContainerJSON("/");
-
-    for (auto& p : params_) {
-        std::vector<std::string> segments;
-        std::istringstream ss(p.full_path.substr(1));
-        std::string seg;
-        while (std::getline(ss, seg, '/')) {
-            if (!seg.empty()) segments.push_back(seg);
-        }
-
-        json* current = &root;
-        std::string built_path;
-        for (size_t i = 0; i < segments.size(); i++) {
-            built_path += "/" + segments[i];
-            bool is_leaf = (i == segments.size() - 1);
-
-            if (!current->contains("CONTENTS")) {
-                (*current)["CONTENTS"] = json::object();
-            }
-
-            auto& contents = (*current)["CONTENTS"];
-            if (!contents.contains(segments[i])) {
-                if (is_leaf) {
-                    contents[segments[i]] = MakeParamJSON(p);
-                } else {
-                    contents[segments[i]] = MakeContainerJSON(built_path);
-                }
-            }
-            current = &contents[segments[i]];
-        }
-    }
-
-    return root.dump();
-}
-
-std::string OSCQueryServer::BuildNodeJSON(const std::string& path) const {
-    std::lock_guard<std::mutex> lock(param_mutex_);
-    auto it = param_index_.find(path);
-    if (it != param_index_.end()) {
-        return MakeParamJSON(params_[it->second]).dump();
-    }
-
-    json container = MakeContainerJSON(path);
-    bool found = false;
-    for (auto& p : params_) {
-        if (p.full_path.rfind(path, 0) == 0 && p.full_path.size() > path.size()) {
-            std::string remainder = p.full_path.substr(path.size());
-            if (remainder[0] == '/') remainder = remainder.substr(1);
-            auto slash = remainder.find('/');
-            std::string child = (slash != std::string::npos) ? remainder.substr(0, slash) : remainder;
-
-            if (!container["CONTENTS"].contains(child)) {
-                if (slash == std::string::npos) {
-                    container["CONTENTS"][child] = MakeParamJSON(p);
-                } else {
-                    std::string child_path = path + "/" + child;
-                    container["CONTENTS"][child] = MakeContainerJSON(child_path);
-                }
-                found = true;
-            }
-        }
-    }
-
-    if (found) return container.dump();
-    return "";
-}
-
 void OSCQueryServer::HTTPThread() {
     auto server_ptr = std::make_unique<httplib::Server>();
     auto* server = server_ptr.get();
     http_server_ = server;
 
-    server->Get("/", [this](const httplib::Request& req, httplib::Response& res) {
-        LogInfo("OSCQuery HTTP GET / " + std::string(req.has_param("HOST_INFO") ? "?HOST_INFO " : "") +
-                "from " + req.remote_addr + " (this means a client -- e.g. VRChat -- found us)");
-        if (req.has_param("HOST_INFO")) {
-            res.set_content(BuildHostInfo(), "application/json");
-        } else {
-            res.set_content(BuildFullTree(), "application/json");
+    // Cached bodies with an ETag; a client repeating the ETag it already
+    // has (If-None-Match) gets an empty 304 instead of the tree again.
+    auto respond = [](const httplib::Request& req, httplib::Response& res,
+                      const std::string& body, const std::string& etag) {
+        res.set_header("ETag", etag);
+        if (ETagMatches(req.get_header_value("If-None-Match"), etag)) {
+            res.status = 304;
+            return;
         }
-    });
-
-    server->Get(".*", [this](const httplib::Request& req, httplib::Response& res) {
-        std::string path = req.path;
-        LogDebug("OSCQuery HTTP GET " + path + " from " + req.remote_addr);
-        if (path == "/") return;
-
+        res.set_content(body, "application/json");
+    };
+    auto serve = [this, respond](const httplib::Request& req, httplib::Response& res) {
         if (req.has_param("HOST_INFO")) {
-            res.set_content(BuildHostInfo(), "application/json");
+            respond(req, res, host_info_, MakeETag(0));
             return;
         }
-
-        std::string body = BuildNodeJSON(path);
-        if (body.empty()) {
+        std::optional<NodeResponse> node = GetNodeJSON(req.path);
+        if (!node) {
             res.status = 404;
             res.set_content("{}", "application/json");
-        } else {
-            res.set_content(body, "application/json");
-        }
-    });
-
-    LogInfo("OSCQuery HTTP server listening on port " + std::to_string(http_port_));
-    server->listen("0.0.0.0", http_port_);
-
-    server_ptr.reset();
-    http_server_ = nullptr;
-}
-
-// --- mDNS Browse (discover VRChat) ---
-
-struct BrowseContext {
-    OSCQueryServer* self;
-    std::optional<int> osc_port;
-    std::optional<int> query_port;
-};
-
-static int MDNSBrowseCallback(int sock, const struct sockaddr* from, size_t addrlen,
-                               mdns_entry_type_t entry, uint16_t query_id, uint16_t rtype,
-                               uint16_t rclass, uint32_t ttl, const void* data, size_t size,
-                               size_t name_offset, size_t name_length, size_t record_offset,
-                               size_t record_length, void* user_data) {
-    auto* ctx = static_cast<BrowseContext*>(user_data);
-    if (rtype != MDNS_RECORDTYPE_SRV) return 0;
-
-    char name_buf[256] = {};
-    mdns_string_t name = mdns_string_extract(data, size, &name_offset, name_buf, sizeof(name_buf));
-    std::string service_name(name.str, name.length);
-
-    mdns_record_srv_t srv = mdns_record_parse_srv(data, size, record_offset, record_length,
-                                                   name_buf, sizeof(name_buf));
-
-    if (service_name.find("_osc._udp") != std::string::npos &&
-        service_name.find("VRChat") != std::string::npos) {
-        ctx->osc_port = srv.port;
-        LogInfo("OSCQuery: found VRChat OSC at port " + std::to_string(srv.port));
-    }
-    else if (service_name.find("_oscjson._tcp") != std::string::npos &&
-             service_name.find("VRChat") != std::string::npos) {
-        ctx->query_port = srv.port;
-        LogInfo("OSCQuery: found VRChat OSCQuery at port " + std::to_string(srv.port));
-    }
-
-    return 0;
-}
-
-void OSCQueryServer::MDNSBrowseThread() {
-    LogInfo("OSCQuery mDNS browse thread started");
-
-    // After this many consecutive browse cycles without seeing VRChat's
-    // _osc._udp service, assume VRChat has gone away and clear the discovered
-    // port. This lets a VRChat restart on the *same* port be re-detected: with
-    // vrc_osc_port_ cleared, the next discovery differs from the stored value
-    // and fires the retarget callback again. At ~7s per cycle, 3 misses is
-    // roughly 20s of silence before we declare VRChat gone.
-    constexpr int MAX_BROWSE_MISSES = 3;
-    int consecutive_misses = 0;
-
-    while (running_) {
-        // Query on every interface (bind each socket to a specific interface so
-        // the query egresses it), so we find VRChat regardless of which interface
-        // it advertises on -- not just the OS default (which a VPN can own).
-        std::vector<int> socks;
-        for (const auto& ip : EnumerateLocalIPv4()) {
-            struct sockaddr_in saddr{};
-            saddr.sin_family = AF_INET;
-            saddr.sin_port = 0; // ephemeral source port on this interface
-            inet_pton(AF_INET, ip.c_str(), &saddr.sin_addr);
-            int sock = mdns_socket_open_ipv4(&saddr);
-            if (sock >= 0) socks.push_back(sock);
-        }
-        if (socks.empty()) {
-            LogWarning("OSCQuery: failed to open any mDNS query socket");
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-            continue;
+            return;
         }
+        respond(req, res, *node->body, node->etag);
+    };
 
-        BrowseContext ctx{this, std::nullopt, std::nullopt};
-        char buffer[2048];
-
-        mdns_query_t queries[2] = {
-            {MDNS_RECORDTYPE_PTR, MDNS_STRING_CONST("_oscjson._tcp.local.")},
-            {MDNS_RECORDTYPE_PTR, MDNS_STRING_CONST("_osc._udp.local.")}
-        };
+    server->Get("/", [serve](const httplib::Request& req, httplib::Response& res) {
+        LogInfo("OSCQuery HTTP GET / " + std::string(req.has_param("HOST_INFO") ? "?HOST_INFO " : "") +
+                "from " + req.remote_addr + " (this means a client -- e.g. VRChat -- found us)");
+        serve(req, res);
+    });
 
-        for (int sock : socks) {
-#ifdef _WIN32
-            DWORD tv = 200;
-            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
-#else
-            struct timeval tv; tv.tv_sec = 0; tv.tv_usec = 200000;
-            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-#endif
-            mdns_multiquery_send(sock, queries, 2, buffer, sizeof(buffer), 0);
-        }
+    server->Get(".*", [serve](const httplib::Request& req, httplib::Response& res) {
+        LogDebug("OSCQuery HTTP GET " + req.path + " from " + req.remote_addr);
+        serve(req, res);
+    });
 
-        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
-        while (std::chrono::steady_clock::now() < deadline && running_) {
-            for (int sock : socks)
-                mdns_query_recv(sock, buffer, sizeof(buffer), MDNSBrowseCallback, &ctx, 0);
+    // LISTEN streams: a WebSocket upgrade on any path. Over the limit (or
+    // while stopping) the upgrade is refused with a plain 503 up front.
+    server->set_pre_routing_handler([this](const httplib::Request& req, httplib::Response& res) {
+        if (!req.has_header("Sec-WebSocket-Key")) return httplib::Server::HandlerResponse::Unhandled;
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        if (running_ && stream_clients_.size() < kMaxStreamClients) {
+            return httplib::Server::HandlerResponse::Unhandled;
         }
+        res.status = 503;
+        return httplib::Server::HandlerResponse::Handled;
+    });
+    server->set_websocket_ping_interval(2);
 
-        for (int sock : socks) mdns_socket_close(sock);
-
-        if (ctx.osc_port || ctx.query_port) {
-            bool osc_port_changed = false;
-            int new_osc_port = 0;
-            {
-                std::lock_guard<std::mutex> lock(vrc_mutex_);
-                if (ctx.osc_port && vrc_osc_port_ != ctx.osc_port) {
-                    vrc_osc_port_ = ctx.osc_port;
-                    osc_port_changed = true;
-                    new_osc_port = *ctx.osc_port;
-                }
-                if (ctx.query_port) vrc_query_port_ = ctx.query_port;
-            }
-
-            // Notify outside the lock so the callback can safely retarget the
-            // OSC send socket.
-            if (osc_port_changed) {
-                std::function<void(int)> cb;
-                {
-                    std::lock_guard<std::mutex> lock(callback_mutex_);
-                    cb = vrc_port_discovered_callback_;
-                }
-                if (cb) cb(new_osc_port);
+    server->WebSocket(".*", [this](const httplib::Request& req, httplib::ws::WebSocket& ws) {
+        auto client = std::make_shared<StreamClient>();
+        client->ws = &ws;
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            if (!running_ || stream_clients_.size() >= kMaxStreamClients) {
+                ws.close(httplib::ws::CloseStatus::GoingAway);
+                return;
             }
+            stream_clients_.push_back(client);
         }
-
-        // Track VRChat presence based on whether its OSC service was seen this
-        // cycle. On a sustained run of misses, forget the discovered port so a
-        // same-port restart is treated as a fresh discovery next time around.
-        if (ctx.osc_port) {
-            consecutive_misses = 0;
-        } else if (++consecutive_misses >= MAX_BROWSE_MISSES) {
-            bool had_port = false;
-            {
-                std::lock_guard<std::mutex> lock(vrc_mutex_);
-                had_port = vrc_osc_port_.has_value();
-                vrc_osc_port_.reset();
-                vrc_query_port_.reset();
-            }
-            if (had_port) {
-                LogInfo("OSCQuery: VRChat no longer advertising its OSC service; "
-                        "cleared discovered port (will retarget on rediscovery)");
+        LogInfo("OSCQuery stream opened from " + req.remote_addr);
+
+        std::thread writer(&StreamClient::WriteLoop, client.get());
+        std::string message;
+        for (;;) {
+            const httplib::ws::ReadResult result = ws.read(message);
+            if (result == httplib::ws::Fail) break;
+            if (result != httplib::ws::Text) continue;
+            json command = json::parse(message, nullptr, false);
+            if (!command.is_object() || !command.contains("DATA") || !command["DATA"].is_string()) continue;
+            const std::string name = command.value("COMMAND", "");
+            if (name == "LISTEN" || name == "IGNORE") {
+                SetListening(*client, command["DATA"].get<std::string>(), name == "LISTEN");
             }
-            consecutive_misses = 0;
         }
 
-        for (int i = 0; i < 50 && running_; i++) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        {
+            std::lock_guard<std::mutex> lock(client->mutex);
+            client->closing = true;
+            client->cv.notify_one();
         }
-    }
-
-    LogInfo("OSCQuery mDNS browse thread stopped");
-}
-
-// --- mDNS Listen (announce our services) ---
-
-struct ListenContext {
-    OSCQueryServer* self;
-    int sock;
-    std::string service_name;
-    std::string hostname;
-    int http_port;
-    int osc_port;
-    struct sockaddr_in local_addr;
-};
-
-static int MDNSListenCallback(int sock, const struct sockaddr* from, size_t addrlen,
-                               mdns_entry_type_t entry, uint16_t query_id, uint16_t rtype,
-                               uint16_t rclass, uint32_t ttl, const void* data, size_t size,
-                               size_t name_offset, size_t name_length, size_t record_offset,
-                               size_t record_length, void* user_data) {
-    auto* ctx = static_cast<ListenContext*>(user_data);
+        writer.join();
+        {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            stream_clients_.erase(std::find(stream_clients_.begin(), stream_clients_.end(), client));
+            std::lock_guard<std::mutex> client_lock(client->mutex);
+            stream_listens_ -= client->listening.size();
+        }
+        LogInfo("OSCQuery stream from " + req.remote_addr + " closed (" + std::to_string(client->sent) +
+                " sent, " + std::to_string(client->coalesced) + " superseded before sending)");
+    });
 
-    if (entry != MDNS_ENTRYTYPE_QUESTION) return 0;
+    LogInfo("OSCQuery HTTP server listening on port " + std::to_string(http_port_));
+    server->listen("0.0.0.0", http_port_);
 
-    char name_buf[256] = {};
-    mdns_string_t name = mdns_string_extract(data, size, &name_offset, name_buf, sizeof(name_buf));
-    std::string query_name(name.str, name.length);
+    server_ptr.reset();
+    http_server_ = nullptr;
+}
 
-    char sendbuf[2048];
+// --- mDNS (announce our services, discover VRChat) ---
+
+// mdns_answer_multicast_rclass_ttl() without the send, so a packet can be
+// built once and replayed with mdns_multicast_send().
+static std::string BuildMDNSAnswer(mdns_record_t answer, const mdns_record_t* additional,
+                                   size_t additional_count, uint16_t rclass, uint32_t ttl) {
+    char buffer[2048];
+    auto* header = reinterpret_cast<struct mdns_header_t*>(buffer);
+    header->query_id = 0;
+    header->flags = htons(0x8400);
+    header->questions = 0;
+    header->answer_rrs = htons(1);
+    header->authority_rrs = 0;
+    header->additional_rrs = htons(mdns_answer_get_record_count(additional, additional_count));
+
+    mdns_string_table_t string_table = {{0}, 0, 0};
+    void* data = MDNS_POINTER_OFFSET(buffer, sizeof(struct mdns_header_t));
+    mdns_record_update_rclass_ttl(&answer, rclass, ttl);
+    data = mdns_answer_add_record(buffer, sizeof(buffer), data, answer, &string_table);
+    for (size_t i = 0; data && i < additional_count; ++i) {
+        mdns_record_t record = additional[i];
+        mdns_record_update_rclass_ttl(&record, rclass, ttl);
+        data = mdns_answer_add_record(buffer, sizeof(buffer), data, record, &string_table);
+    }
+    data = mdns_answer_add_txt_record(buffer, sizeof(buffer), data, additional, additional_count,
+                                      rclass, ttl, &string_table);
+    if (!data) return {};
+    return std::string(buffer, MDNS_POINTER_DIFF(data, buffer));
+}
 
-    std::string oscjson_service = ctx->service_name + "._oscjson._tcp.local.";
-    std::string osc_service = ctx->service_name + "._osc._udp.local.";
-    std::string host = ctx->hostname + ".local.";
+// PTR (service type -> instance) answer with the instance's SRV and TXT and
+// the host's A record for this interface, as a reply, an announcement
+// (cache-flush) and a goodbye (ttl 0).
+static void BuildServicePackets(MDNSInterface& iface, const std::string& service_name,
+                                const std::string& hostname, int http_port, int osc_port) {
+    const std::string host = hostname + ".local.";
+    const char* types[2] = { "_oscjson._tcp.local.", "_osc._udp.local." };
+    const int ports[2] = { http_port, osc_port };
+    for (int i = 0; i < 2; ++i) {
+        const std::string type = types[i];
+        const std::string instance = service_name + "." + type;
 
-    if (query_name.find("_oscjson._tcp.local") != std::string::npos) {
         mdns_record_t answer = {};
-        answer.name = {MDNS_STRING_CONST("_oscjson._tcp.local.")};
+        answer.name = {type.c_str(), type.size()};
         answer.type = MDNS_RECORDTYPE_PTR;
-        answer.data.ptr.name = {oscjson_service.c_str(), oscjson_service.size()};
-        answer.rclass = 0;
+        answer.data.ptr.name = {instance.c_str(), instance.size()};
         answer.ttl = 120;
 
-        mdns_record_t additional[2] = {};
-        additional[0].name = {oscjson_service.c_str(), oscjson_service.size()};
+        mdns_record_t additional[3] = {};
+        additional[0].name = {instance.c_str(), instance.size()};
         additional[0].type = MDNS_RECORDTYPE_SRV;
         additional[0].data.srv.name = {host.c_str(), host.size()};
-        additional[0].data.srv.port = static_cast<uint16_t>(ctx->http_port);
-        additional[0].data.srv.priority = 0;
-        additional[0].data.srv.weight = 0;
-        additional[0].rclass = 0;
+        additional[0].data.srv.port = static_cast<uint16_t>(ports[i]);
         additional[0].ttl = 120;
 
-        additional[1].name = {host.c_str(), host.size()};
-        additional[1].type = MDNS_RECORDTYPE_A;
-        additional[1].data.a.addr = ctx->local_addr;
-        additional[1].rclass = 0;
+        additional[1].name = {instance.c_str(), instance.size()};
+        additional[1].type = MDNS_RECORDTYPE_TXT;
+        additional[1].data.txt.key = {MDNS_STRING_CONST("txtvers")};
+        additional[1].data.txt.value = {MDNS_STRING_CONST("1")};
         additional[1].ttl = 120;
 
-        mdns_query_answer_multicast(sock, sendbuf, sizeof(sendbuf),
-                                     answer, nullptr, 0, additional, 2);
-        LogDebug("OSCQuery: answered mDNS query for _oscjson._tcp.local (asker wants our OSCQuery service)");
-    }
+        additional[2].name = {host.c_str(), host.size()};
+        additional[2].type = MDNS_RECORDTYPE_A;
+        additional[2].data.a.addr = iface.addr;
+        additional[2].ttl = 120;
 
-    if (query_name.find("_osc._udp.local") != std::string::npos) {
-        mdns_record_t answer = {};
-        answer.name = {MDNS_STRING_CONST("_osc._udp.local.")};
-        answer.type = MDNS_RECORDTYPE_PTR;
-        answer.data.ptr.name = {osc_service.c_str(), osc_service.size()};
-        answer.rclass = 0;
-        answer.ttl = 120;
+        iface.answer[i] = BuildMDNSAnswer(answer, additional, 3, MDNS_CLASS_IN, 60);
+        iface.announce[i] = BuildMDNSAnswer(answer, additional, 3, MDNS_CLASS_IN | MDNS_CACHE_FLUSH, 60);
+        iface.goodbye[i] = BuildMDNSAnswer(answer, additional, 3, MDNS_CLASS_IN, 0);
+    }
+}
 
-        mdns_record_t additional[2] = {};
-        additional[0].name = {osc_service.c_str(), osc_service.size()};
-        additional[0].type = MDNS_RECORDTYPE_SRV;
-        additional[0].data.srv.name = {host.c_str(), host.size()};
-        additional[0].data.srv.port = static_cast<uint16_t>(ctx->osc_port);
-        additional[0].data.srv.priority = 0;
-        additional[0].data.srv.weight = 0;
-        additional[0].rclass = 0;
-        additional[0].ttl = 120;
+static void SendPackets(const std::vector<MDNSInterface>& ifaces, const std::string (MDNSInterface::*packets)[2]) {
+    for (const auto& iface : ifaces) {
+        if (iface.listen_sock < 0) continue;
+        for (const std::string& packet : iface.*packets) {
+            if (!packet.empty()) mdns_multicast_send(iface.listen_sock, packet.data(), packet.size());
+        }
+    }
+}
 
-        additional[1].name = {host.c_str(), host.size()};
-        additional[1].type = MDNS_RECORDTYPE_A;
-        additional[1].data.a.addr = ctx->local_addr;
-        additional[1].rclass = 0;
-        additional[1].ttl = 120;
+static int MDNSCallback(int sock, const struct sockaddr* from, size_t addrlen,
+                        mdns_entry_type_t entry, uint16_t query_id, uint16_t rtype,
+                        uint16_t rclass, uint32_t ttl, const void* data, size_t size,
+                        size_t name_offset, size_t name_length, size_t record_offset,
+                        size_t record_length, void* user_data) {
+    auto* ctx = static_cast<MDNSContext*>(user_data);
 
-        mdns_query_answer_multicast(sock, sendbuf, sizeof(sendbuf),
-                                     answer, nullptr, 0, additional, 2);
-        LogDebug("OSCQuery: answered mDNS query for _osc._udp.local");
+    char name_buf[256] = {};
+    mdns_string_t name = mdns_string_extract(data, size, &name_offset, name_buf, sizeof(name_buf));
+    std::string record_name(name.str, name.length);
+
+    if (entry == MDNS_ENTRYTYPE_QUESTION) {
+        // Only the 5353 socket answers; a question can't reach the query socket anyway.
+        if (sock != ctx->iface->listen_sock) return 0;
+        if (record_name.find("_oscjson._tcp.local") != std::string::npos) {
+            const std::string& packet = ctx->iface->answer[0];
+            mdns_multicast_send(sock, packet.data(), packet.size());
+            LogDebug("OSCQuery: answered mDNS query for _oscjson._tcp.local (asker wants our OSCQuery service)");
+        }
+        if (record_name.find("_osc._udp.local") != std::string::npos) {
+            const std::string& packet = ctx->iface->answer[1];
+            mdns_multicast_send(sock, packet.data(), packet.size());
+            LogDebug("OSCQuery: answered mDNS query for _osc._udp.local");
+        }
+        return 0;
     }
 
+    // Answers: VRChat's replies to our queries or anyone else's, and its own
+    // announcements when it starts.
+    if (rtype != MDNS_RECORDTYPE_SRV || record_name.find("VRChat") == std::string::npos) return 0;
+    if (ttl == 0) return 0; // a goodbye
+    mdns_record_srv_t srv = mdns_record_parse_srv(data, size, record_offset, record_length,
+                                                   name_buf, sizeof(name_buf));
+    if (record_name.find("_osc._udp") != std::string::npos) {
+        ctx->osc_port = srv.port;
+    } else if (record_name.find("_oscjson._tcp") != std::string::npos) {
+        ctx->query_port = srv.port;
+    }
     return 0;
 }
 
-// Announce (or, with ttl 0, retract) our two services on one socket, using the
-// given interface address for the SRV target's A record.
-static void AnnounceOnSocket(int sock, const std::string& service_name,
-                             const std::string& hostname, int http_port, int osc_port,
-                             const struct sockaddr_in& local_addr, bool goodbye) {
-    char sendbuf[2048];
-    std::string oscjson_service = service_name + "._oscjson._tcp.local.";
-    std::string osc_service = service_name + "._osc._udp.local.";
-    std::string host = hostname + ".local.";
-    const uint32_t ttl = goodbye ? 0 : 120;
-
-    auto send_one = [&](const std::string& svc, int port) {
-        mdns_record_t answer = {};
-        answer.name = {svc.c_str(), svc.size()};
-        answer.type = MDNS_RECORDTYPE_SRV;
-        answer.data.srv.name = {host.c_str(), host.size()};
-        answer.data.srv.port = static_cast<uint16_t>(port);
-        answer.data.srv.priority = 0;
-        answer.data.srv.weight = 0;
-        answer.rclass = 0;
-        answer.ttl = ttl;
-
-        mdns_record_t additional = {};
-        additional.name = {host.c_str(), host.size()};
-        additional.type = MDNS_RECORDTYPE_A;
-        additional.data.a.addr = local_addr;
-        additional.rclass = 0;
-        additional.ttl = ttl;
-
-        if (goodbye)
-            mdns_goodbye_multicast(sock, sendbuf, sizeof(sendbuf), answer, nullptr, 0, &additional, 1);
-        else
-            mdns_announce_multicast(sock, sendbuf, sizeof(sendbuf), answer, nullptr, 0, &additional, 1);
-    };
+void OSCQueryServer::NoteVRChatServices(std::optional<int> osc_port, std::optional<int> query_port) {
+    bool osc_port_changed = false;
+    {
+        std::lock_guard<std::mutex> lock(vrc_mutex_);
+        if (osc_port && vrc_osc_port_ != osc_port) {
+            vrc_osc_port_ = osc_port;
+            osc_port_changed = true;
+            LogInfo("OSCQuery: found VRChat OSC at port " + std::to_string(*osc_port));
+        }
+        if (query_port && vrc_query_port_ != query_port) {
+            vrc_query_port_ = query_port;
+            LogInfo("OSCQuery: found VRChat OSCQuery at port " + std::to_string(*query_port));
+        }
+    }
 
-    send_one(oscjson_service, http_port);
-    send_one(osc_service, osc_port);
+    // Notify outside the lock so the callback can safely retarget the OSC
+    // send socket.
+    if (osc_port_changed) {
+        std::function<void(int)> cb;
+        {
+            std::lock_guard<std::mutex> lock(callback_mutex_);
+            cb = vrc_port_discovered_callback_;
+        }
+        if (cb) cb(*osc_port);
+    }
 }
 
-void OSCQueryServer::MDNSListenThread() {
-    LogInfo("OSCQuery mDNS listen thread started");
-
-    // Open one socket per local interface so the multicast announcement/answer
-    // egresses *every* interface (the mdns lib only pins IP_MULTICAST_IF when a
-    // socket is bound to a specific interface address). Binding INADDR_ANY would
-    // send out only the OS default interface -- which a VPN like Tailscale can
-    // own, hiding us from the real LAN where VRChat is.
-    int bind_attempts = 0;
-    while (running_) {
-        std::vector<std::string> ips = EnumerateLocalIPv4();
-        std::vector<int> socks;
-        std::vector<ListenContext> ctxs;
-        ctxs.reserve(ips.size());
-
-        for (const auto& ip : ips) {
-            struct sockaddr_in saddr{};
-            saddr.sin_family = AF_INET;
-            saddr.sin_port = htons(MDNS_PORT);
-            inet_pton(AF_INET, ip.c_str(), &saddr.sin_addr);
-            int sock = mdns_socket_open_ipv4(&saddr);
+// (Re)open both sockets on every interface, announce and start browsing.
+// Advertising needs at least one 5353 socket; browsing works without.
+void OSCQueryServer::MDNSState::Open() {
+    CloseAll(/*goodbye=*/true);
+    ips = EnumerateLocalIPv4();
+    size_t advertising = 0;
+    std::string ip_list;
+    for (const auto& ip : ips) {
+        MDNSInterface iface;
+        iface.ip = ip;
+        iface.addr.sin_family = AF_INET;
+        inet_pton(AF_INET, ip.c_str(), &iface.addr.sin_addr);
+        struct sockaddr_in bind_addr = iface.addr;
+        bind_addr.sin_port = htons(MDNS_PORT);
+        iface.listen_sock = mdns_socket_open_ipv4(&bind_addr);
+        iface.query_sock = mdns_socket_open_ipv4(&iface.addr); // ephemeral port
+        if (iface.listen_sock < 0 && iface.query_sock < 0) continue;
+        if (iface.listen_sock >= 0) {
+            BuildServicePackets(iface, self->service_name_, self->hostname_, self->http_port_, self->osc_port_);
+            ip_list += (advertising++ ? ", " : "") + ip;
+        }
+        ifaces.push_back(std::move(iface));
+    }
+    // ifaces no longer moves, so the callbacks can hold on to its elements.
+    for (const auto& iface : ifaces) {
+        for (int sock : {iface.listen_sock, iface.query_sock}) {
             if (sock < 0) continue;
-
-            ListenContext ctx{};
-            ctx.self = this;
-            ctx.sock = sock;
-            ctx.service_name = service_name_;
-            ctx.hostname = hostname_;
-            ctx.http_port = http_port_;
-            ctx.osc_port = osc_port_;
-            ctx.local_addr = saddr;
-            ctx.local_addr.sin_port = 0; // A record carries no port
-            socks.push_back(sock);
-            ctxs.push_back(ctx);
+            watches.push_back(loop.WatchReadable(static_cast<SOCKET>(sock),
+                                                 [this, &iface, sock] { OnReadable(iface, sock); }));
         }
+    }
 
-        if (socks.empty()) {
-            if (bind_attempts == 0) {
-                LogError("OSCQuery: could not bind the mDNS port on any interface (UDP 5353 in use, "
-                         "e.g. by avahi/Bonjour or another OSC app). VRChat will NOT discover "
-                         "StayPutVR. Turn off \"OSC Query\" to use manual ports, or free UDP 5353. "
-                         "Retrying every 5s...");
-            } else if (bind_attempts % 12 == 0) {
-                LogWarning("OSCQuery: still unable to bind mDNS UDP 5353; discovery unavailable.");
-            }
-            ++bind_attempts;
-            mdns_advertising_ = false;
-            for (int i = 0; i < 50 && running_; i++)
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+    if (advertising == 0) {
+        if (bind_attempts == 0) {
+            LogError("OSCQuery: could not bind the mDNS port on any interface (UDP 5353 in use, "
+                     "e.g. by avahi/Bonjour or another OSC app). VRChat will NOT discover "
+                     "StayPutVR. Turn off \"OSC Query\" to use manual ports, or free UDP 5353. "
+                     "Retrying every 5s...");
+        } else if (bind_attempts % 12 == 0) {
+            LogWarning("OSCQuery: still unable to bind mDNS UDP 5353; discovery unavailable.");
         }
-
+        ++bind_attempts;
+        check_timer = loop.AddTimer(kBindRetryInterval, [this] { CheckInterfaces(); });
+    } else {
         if (bind_attempts > 0) LogInfo("OSCQuery: mDNS port bound after retry; advertising resumed");
         bind_attempts = 0;
+        self->mdns_advertising_ = true;
+        LogInfo("OSCQuery: advertising as '" + self->service_name_ + "' host " + self->hostname_ +
+                ".local on " + std::to_string(advertising) + " interface(s) [" + ip_list +
+                "] (oscjson tcp:" + std::to_string(self->http_port_) + ", osc udp:" +
+                std::to_string(self->osc_port_) + "). Watch for an HTTP GET line when VRChat connects.");
+        SendPackets(ifaces, &MDNSInterface::announce);
+        announce_timer = loop.AddTimer(std::chrono::seconds(1), [this] { // RFC 6762 8.3: announce twice
+            announce_timer = 0;
+            SendPackets(ifaces, &MDNSInterface::announce);
+        });
+        check_timer = loop.AddTimer(kInterfaceCheckInterval, [this] { CheckInterfaces(); });
+    }
+    if (ifaces.empty()) LogWarning("OSCQuery: failed to open any mDNS query socket");
+    Query();
+}
+
+void OSCQueryServer::MDNSState::CloseAll(bool goodbye) {
+    for (EventLoop::Id id : watches) loop.Unwatch(id);
+    watches.clear();
+    for (EventLoop::Id* timer : {&query_timer, &announce_timer, &check_timer}) {
+        loop.CancelTimer(*timer);
+        *timer = 0;
+    }
+    if (goodbye) SendPackets(ifaces, &MDNSInterface::goodbye);
+    for (auto& iface : ifaces) {
+        if (iface.listen_sock >= 0) mdns_socket_close(iface.listen_sock);
+        if (iface.query_sock >= 0) mdns_socket_close(iface.query_sock);
+    }
+    ifaces.clear();
+    self->mdns_advertising_ = false;
+}
+
+// Interfaces come and go (VPNs, Wi-Fi); re-open only on a change, or to
+// retry binding 5353.
+void OSCQueryServer::MDNSState::CheckInterfaces() {
+    check_timer = 0;
+    if (!self->mdns_advertising_ || EnumerateLocalIPv4() != ips) {
+        Open();
+        return;
+    }
+    check_timer = loop.AddTimer(kInterfaceCheckInterval, [this] { CheckInterfaces(); });
+}
+
+void OSCQueryServer::MDNSState::Query() {
+    loop.CancelTimer(query_timer);
+    const Clock::time_point now = Clock::now();
+    if (vrchat_seen && now - last_seen >= kVRChatLostAfter) {
+        vrchat_seen = false;
+        search_interval = kSearchIntervalMin;
+        bool had_port = false;
         {
-            std::lock_guard<std::mutex> lock(mdns_sockets_mutex_);
-            mdns_sockets_ = socks;
+            std::lock_guard<std::mutex> lock(self->vrc_mutex_);
+            had_port = self->vrc_osc_port_.has_value();
+            self->vrc_osc_port_.reset();
+            self->vrc_query_port_.reset();
         }
-        mdns_advertising_ = true;
-
-        std::string ip_list;
-        for (size_t i = 0; i < ips.size() && i < socks.size(); ++i)
-            ip_list += (i ? ", " : "") + ips[i];
-        LogInfo("OSCQuery: advertising as '" + service_name_ + "' host " + hostname_ + ".local on " +
-                std::to_string(socks.size()) + " interface(s) [" + ip_list + "] (oscjson tcp:" +
-                std::to_string(http_port_) + ", osc udp:" + std::to_string(osc_port_) +
-                "). Watch for an HTTP GET line when VRChat connects.");
-
-        // Initial announcement on every interface, then set a short recv timeout
-        // so the listen loop stays responsive to shutdown.
-        for (size_t i = 0; i < socks.size(); ++i) {
-            AnnounceOnSocket(socks[i], service_name_, hostname_, http_port_, osc_port_,
-                             ctxs[i].local_addr, /*goodbye=*/false);
-#ifdef _WIN32
-            DWORD tv = 250;
-            setsockopt(socks[i], SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
-#else
-            struct timeval tv; tv.tv_sec = 0; tv.tv_usec = 250000;
-            setsockopt(socks[i], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-#endif
+        if (had_port) {
+            LogInfo("OSCQuery: VRChat no longer advertising its OSC service; "
+                    "cleared discovered port (will retarget on rediscovery)");
         }
-        LogInfo("OSCQuery: announced services (oscjson tcp:" + std::to_string(http_port_) +
-                " osc udp:" + std::to_string(osc_port_) + ")");
+    }
 
-        char buffer[2048];
-        while (running_) {
-            for (size_t i = 0; i < socks.size(); ++i)
-                mdns_socket_listen(socks[i], buffer, sizeof(buffer), MDNSListenCallback, &ctxs[i]);
+    // Query on every interface so we find VRChat regardless of which one it
+    // advertises on -- not just the OS default.
+    static const mdns_query_t queries[2] = {
+        {MDNS_RECORDTYPE_PTR, MDNS_STRING_CONST("_oscjson._tcp.local.")},
+        {MDNS_RECORDTYPE_PTR, MDNS_STRING_CONST("_osc._udp.local.")}
+    };
+    for (const auto& iface : ifaces) {
+        if (iface.query_sock >= 0) {
+            mdns_multiquery_send(iface.query_sock, queries, 2, buffer, sizeof(buffer), 0);
         }
+    }
 
-        // Retract + close. Take ownership under the lock so Stop() doesn't also
-        // close these (double-close), then say goodbye on each interface.
-        std::vector<int> to_close;
-        {
-            std::lock_guard<std::mutex> lock(mdns_sockets_mutex_);
-            to_close.swap(mdns_sockets_);
-        }
-        for (size_t i = 0; i < to_close.size(); ++i) {
-            struct sockaddr_in la = (i < ctxs.size()) ? ctxs[i].local_addr : sockaddr_in{};
-            AnnounceOnSocket(to_close[i], service_name_, hostname_, http_port_, osc_port_, la,
-                             /*goodbye=*/true);
-            mdns_socket_close(to_close[i]);
-        }
-        mdns_advertising_ = false;
-        break; // running_ became false; leave the retry loop
+    Clock::duration next = kFoundInterval;
+    if (!vrchat_seen) {
+        next = search_interval;
+        search_interval = (std::min<Clock::duration>)(search_interval * 2, kSearchIntervalMax);
     }
+    query_timer = loop.AddTimer(next, [this] { Query(); });
+}
 
-    LogInfo("OSCQuery mDNS listen thread stopped");
+void OSCQueryServer::MDNSState::OnReadable(const MDNSInterface& iface, int sock) {
+    MDNSContext ctx{&iface, std::nullopt, std::nullopt};
+    // Non-blocking sockets: drain whatever arrived, a packet at a time.
+    while (sock == iface.listen_sock
+               ? mdns_socket_listen(sock, buffer, sizeof(buffer), MDNSCallback, &ctx)
+               : mdns_query_recv(sock, buffer, sizeof(buffer), MDNSCallback, &ctx, 0)) {
+    }
+    if (ctx.osc_port) {
+        last_seen = Clock::now();
+        if (!vrchat_seen) {
+            vrchat_seen = true;
+            loop.CancelTimer(query_timer);
+            query_timer = loop.AddTimer(kFoundInterval, [this] { Query(); });
+        }
+    }
+    if (ctx.osc_port || ctx.query_port) self->NoteVRChatServices(ctx.osc_port, ctx.query_port);
 }
 
 } // namespace StayPutVR
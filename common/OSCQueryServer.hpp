@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -60,12 +63,46 @@ public:
 
 private:
     void HTTPThread();
-    void MDNSBrowseThread();
-    void MDNSListenThread();
+    // Records a sighting of VRChat's services from any mDNS packet and fires
+    // the port-discovered callback when its OSC port is new.
+    void NoteVRChatServices(std::optional<int> osc_port, std::optional<int> query_port);
 
     std::string BuildHostInfo() const;
-    std::string BuildFullTree() const;
-    std::string BuildNodeJSON(const std::string& path) const;
+
+    // LISTEN/IGNORE extension: a client opens a WebSocket on the HTTP port and
+    // sends {"COMMAND":"LISTEN","DATA":"/path"}; every UpdateValue() on that
+    // path is then pushed to it as a binary OSC message. Each client has its
+    // own writer thread and a pending frame per path, so a slow client only
+    // ever falls behind to the latest value rather than queueing without
+    // bound or stalling UpdateValue(). Defined in the .cpp (httplib types).
+    struct StreamClient;
+    static constexpr size_t kMaxStreamClients = 4; // each one holds an HTTP worker thread
+    void PublishValueLocked(const std::string& path, const std::variant<float, int, bool, std::string>& value);
+    void SetListening(StreamClient& client, const std::string& path, bool listen);
+
+    // The OSCQuery tree, kept alongside params_ with each node's JSON
+    // serialized on demand and cached until something under it changes. An
+    // HTTP GET copies the cached body out; AddParameter/UpdateValue only
+    // re-serialize the changed leaf and its ancestors on the next request.
+    // version is bumped on every change to the subtree and, with instance_,
+    // forms the node's ETag.
+    struct TreeNode {
+        std::string path;                       // normalized, e.g. "/avatar/parameters"
+        std::map<std::string, size_t> children; // by name, sorted as nlohmann orders object keys
+        size_t parent = 0;                      // the root is its own parent
+        int param = -1;                         // index into params_, or -1 for a container
+        uint64_t version = 0;
+        std::shared_ptr<const std::string> json; // null = needs re-serializing
+    };
+    struct NodeResponse {
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+    };
+    size_t EnsureNodeLocked(const std::string& path);
+    void InvalidateLocked(size_t node);
+    const std::shared_ptr<const std::string>& SerializeLocked(size_t node);
+    std::optional<NodeResponse> GetNodeJSON(const std::string& path);
+    std::string MakeETag(uint64_t version) const;
 
     std::thread http_thread_;
     std::atomic<bool> running_{false};
@@ -73,10 +110,11 @@ private:
     int osc_port_ = 0;
     void* http_server_ = nullptr;
 
-    std::thread mdns_browse_thread_;
-    std::thread mdns_listen_thread_;
-    std::mutex mdns_sockets_mutex_;
-    std::vector<int> mdns_sockets_; // one mDNS listen socket per local interface
+    // Answers queries for our services and browses for VRChat's over every
+    // interface's sockets, driven by readiness and timers on the shared
+    // EventLoop rather than a thread of its own. Defined in the .cpp.
+    struct MDNSState;
+    std::unique_ptr<MDNSState> mdns_;
     std::atomic<bool> mdns_advertising_{false};
 
     mutable std::mutex vrc_mutex_;
@@ -86,6 +124,18 @@ private:
     mutable std::mutex param_mutex_;
     std::vector<ParamNode> params_;
     std::unordered_map<std::string, size_t> param_index_;
+    std::vector<TreeNode> tree_;                        // [0] is "/"
+    std::unordered_map<std::string, size_t> tree_index_; // normalized path -> tree_ index
+    uint64_t tree_version_ = 0;
+
+    // Distinguishes this server's ETags from an earlier instance's, whose
+    // versions restarted from 1 over a different tree.
+    uint64_t instance_ = 0;
+    std::string host_info_; // built at Start()
+
+    std::mutex stream_mutex_;
+    std::vector<std::shared_ptr<StreamClient>> stream_clients_;
+    std::atomic<size_t> stream_listens_{0}; // LISTENs across all clients; UpdateValue's fast path
 
     mutable std::mutex callback_mutex_;
     std::function<void(int)> vrc_port_discovered_callback_;
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// End-to-end latency tracing for disobedience triggers: from the driver's pose
+// sample to the shocker's server acknowledging the command.
+//
+// A TriggerTrace is a small value type (id + one timestamp per stage) that is
+// created in CheckDevicePositionDeviations when a device fires, made "current"
+// on the UI thread with a TriggerLatency::Scope, picked up by the integration
+// managers at enqueue time (copied into their action data / work lambdas) and
+// stamped as it moves through send and response. When the response arrives the
+// manager hands it to TriggerLatency::Complete(), which folds each stage delta
+// into a per-integration histogram shown on the Status tab.
+//
+// Timestamps are steady_clock microseconds. On Windows steady_clock is backed
+// by QueryPerformanceCounter, which is system-wide, so the driver's sample time
+// (a different process) is directly comparable with the app's stamps.
+
+namespace StayPutVR {
+
+    // Stages in the order a trigger passes through them.
+    enum class TraceStage : int {
+        Sample = 0,   // driver sampled the pose (driver process)
+        IpcReceive,   // app parsed the IPC device update
+        Evaluate,     // CheckDevicePositionDeviations decided to fire
+        Enqueue,      // integration manager accepted the action
+        Send,         // network write started
+        Response,     // server acknowledged (HTTP response / WebSocket ack)
+        Count
+    };
+
+    // Integrations that report completed traces.
+    enum class TraceIntegration : int {
+        PiShock = 0,  // legacy HTTP API
+        PiShockWS,    // WebSocket v2
+        OpenShock,
+        Buttplug,
+        Count
+    };
+
+    inline const char* ToString(TraceStage stage) {
+        switch (stage) {
+            case TraceStage::Sample:     return "Sample";
+            case TraceStage::IpcReceive: return "IPC receive";
+            case TraceStage::Evaluate:   return "Evaluate";
+            case TraceStage::Enqueue:    return "Enqueue";
+            case TraceStage::Send:       return "Send";
+            case TraceStage::Response:   return "Response";
+            case TraceStage::Count:      break;
+        }
+        return "Unknown";
+    }
+
+    inline const char* ToString(TraceIntegration integration) {
+        switch (integration) {
+            case TraceIntegration::PiShock:   return "PiShock";
+            case TraceIntegration::PiShockWS: return "PiShock (WS)";
+            case TraceIntegration::OpenShock: return "OpenShock";
+            case TraceIntegration::Buttplug:  return "Buttplug";
+            case TraceIntegration::Count:     break;
+        }
+        return "Unknown";
+    }
+
+    // steady_clock "now" in microseconds since the clock's epoch.
+    inline int64_t TraceNowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct TriggerTrace {
+        static constexpr int kStageCount = static_cast<int>(TraceStage::Count);
+
+        uint64_t id = 0;                       // 0 = not traced
+        std::array<int64_t, kStageCount> t_us{}; // 0 = stage not recorded
+
+        bool IsActive() const { return id != 0; }
+
+        void Mark(TraceStage stage) { MarkAt(stage, TraceNowUs()); }
+        void MarkAt(TraceStage stage, int64_t us) {
+            if (id != 0 && us > 0) t_us[static_cast<int>(stage)] = us;
+        }
+        int64_t At(TraceStage stage) const { return t_us[static_cast<int>(stage)]; }
+    };
+
+    // Lock-free log2 histogram of microsecond latencies. Bucket i holds samples
+    // in [2^i, 2^(i+1)) us (bucket 0 also takes 0); the last bucket is open-ended
+    // (~17 min+, i.e. never in practice). Percentiles are reported as the upper
+    // bound of the bucket that contains them, which is plenty for "is it 5 ms
+    // or 500 ms".
+    class LatencyHistogram {
+    public:
+        static constexpr int kBuckets = 30;
+
+        void Record(int64_t us) {
+            if (us < 0) return; // clock skew / missing stamp; never count it
+            int bucket = 0;
+            for (uint64_t v = static_cast<uint64_t>(us); v > 1 && bucket < kBuckets - 1; v >>= 1) ++bucket;
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_us_.fetch_add(static_cast<uint64_t>(us), std::memory_order_relaxed);
+            uint64_t prev = max_us_.load(std::memory_order_relaxed);
+            while (static_cast<uint64_t>(us) > prev &&
+                   !max_us_.compare_exchange_weak(prev, static_cast<uint64_t>(us), std::memory_order_relaxed)) {}
+        }
+
+        uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+        uint64_t MaxUs() const { return max_us_.load(std::memory_order_relaxed); }
+        uint64_t MeanUs() const {
+            uint64_t n = Count();
+            return n ? sum_us_.load(std::memory_order_relaxed) / n : 0;
+        }
+
+        // Approximate percentile (p in 0..1), as the containing bucket's upper
+        // bound clamped to the observed maximum.
+        uint64_t PercentileUs(double p) const {
+            uint64_t n = Count();
+            if (n == 0) return 0;
+            uint64_t target = static_cast<uint64_t>(p * static_cast<double>(n - 1)) + 1;
+            uint64_t seen = 0;
+            for (int i = 0; i < kBuckets; ++i) {
+                seen += buckets_[i].load(std::memory_order_relaxed);
+                if (seen >= target) return (std::min)((uint64_t{2} << i) - 1, MaxUs());
+            }
+            return MaxUs();
+        }
+
+        void Reset() {
+            for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            sum_us_.store(0, std::memory_order_relaxed);
+            max_us_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_us_{0};
+        std::atomic<uint64_t> max_us_{0};
+    };
+
+    // Process-wide trace registry. All members are static (like Logger); the
+    // histograms are lock-free so worker threads can Complete() while the UI
+    // thread renders them.
+    class TriggerLatency {
+    public:
+        // Start a trace at evaluation time. sample_us / receive_us come from
+        // the device update that caused the trigger (0 if unknown, e.g. an
+        // older driver or a non-pose trigger such as Jaw/Mic/OSC).
+        static TriggerTrace Begin(int64_t sample_us, int64_t receive_us) {
+            TriggerTrace trace;
+            trace.id = next_id_.fetch_add(1, std::memory_order_relaxed);
+            trace.MarkAt(TraceStage::Sample, sample_us);
+            trace.MarkAt(TraceStage::IpcReceive, receive_us);
+            trace.Mark(TraceStage::Evaluate);
+            return trace;
+        }
+
+        // The trace active on this thread (inactive if none). Managers copy it
+        // at enqueue time so it follows the action onto their worker thread.
+        static TriggerTrace Current() { return current_; }
+
+        // RAII: make a trace current on this thread for the duration of the
+        // Trigger*() calls that fan it out to the integrations.
+        class Scope {
+        public:
+            explicit Scope(const TriggerTrace& trace) : previous_(current_) { current_ = trace; }
+            ~Scope() { current_ = previous_; }
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        private:
+            TriggerTrace previous_;
+        };
+
+        // Fold a finished trace into the integration's histograms: one per
+        // adjacent stage pair that was recorded, plus first-to-last total.
+        static void Complete(TraceIntegration integration, const TriggerTrace& trace) {
+            if (!trace.IsActive()) return;
+            auto& h = histograms_[static_cast<int>(integration)];
+            int64_t first = 0, last = 0, prev = 0;
+            for (int s = 0; s < TriggerTrace::kStageCount; ++s) {
+                int64_t t = trace.t_us[s];
+                if (t == 0) continue;
+                if (prev != 0) h.stage[s].Record(t - prev);
+                if (first == 0) first = t;
+                prev = last = t;
+            }
+            if (first != 0 && last > first) h.total.Record(last - first);
+        }
+
+        // Histogram of the delay INTO stage (from the previous recorded stage).
+        static const LatencyHistogram& StageHistogram(TraceIntegration integration, TraceStage stage) {
+            return histograms_[static_cast<int>(integration)].stage[static_cast<int>(stage)];
+        }
+        static const LatencyHistogram& TotalHistogram(TraceIntegration integration) {
+            return histograms_[static_cast<int>(integration)].total;
+        }
+
+        static void Reset() {
+            for (auto& h : histograms_) {
+                for (auto& s : h.stage) s.Reset();
+                h.total.Reset();
+            }
+        }
+
+    private:
+        struct IntegrationHistograms {
+            std::array<LatencyHistogram, TriggerTrace::kStageCount> stage;
+            LatencyHistogram total;
+        };
+
+        static inline std::atomic<uint64_t> next_id_{1};
+        static inline thread_local TriggerTrace current_{};
+        static inline std::array<IntegrationHistograms, static_cast<int>(TraceIntegration::Count)> histograms_{};
+    };
+
+} // namespace StayPutVR
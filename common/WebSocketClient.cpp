@@ -2,142 +2,1268 @@
 #include "Logger.hpp"
 #include <sstream>
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <random>
 
 #ifdef _WIN32
+#include <WS2tcpip.h>
 #pragma comment(lib, "winhttp.lib")
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <netinet/tcp.h>
+#endif
+
+#ifdef STAYPUTVR_WITH_ZLIB
+#include <zlib.h>
 #endif
 
 namespace StayPutVR {
 
-#ifdef _WIN32
+namespace {
+    constexpr std::chrono::milliseconds kConnectTimeout{10000}; // TCP connect, TLS, upgrade; also a stalled send
+    constexpr std::chrono::milliseconds kCloseWait{500};        // for the server to answer our close frame
+    constexpr int kPollSliceMs = 250;                          // receive thread rechecks stop/keepalive this often
+    constexpr size_t kMaxMessageBytes = 16 * 1024 * 1024;
+    constexpr size_t kMaxHandshakeBytes = 16 * 1024;
+    constexpr size_t kSpareBytes = 1024 * 1024;      // recycled buffer capacity kept for bursts
+    constexpr size_t kMaxSpareCapacity = 256 * 1024; // larger one-off buffers are freed, not kept
+    constexpr size_t kHighWaterMark = 32; // queued messages before keyed updates start replacing each other
+    constexpr size_t kMaxQueued = 256;    // Normal messages beyond this are refused
+    constexpr size_t kMaxFreeBuffers = kMaxQueued; // recycled payload buffers ...
+    constexpr size_t kMaxFreeCapacity = 4096;       // ... of command size; larger ones are freed
+
+    double MillisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    enum Opcode : uint8_t {
+        kContinuation = 0x0,
+        kText = 0x1,
+        kBinary = 0x2,
+        kClose = 0x8,
+        kPing = 0x9,
+        kPong = 0xA
+    };
+
+    std::mutex g_tls_mutex;
+    TlsTransportFactory g_tls_factory = DefaultTlsTransportFactory();
+
+    TlsTransportFactory CurrentTlsFactory() {
+        std::lock_guard<std::mutex> lock(g_tls_mutex);
+        return g_tls_factory;
+    }
+
+    // SHA-1 (RFC 3174), needed only to check Sec-WebSocket-Accept.
+    std::array<uint8_t, 20> Sha1(std::string_view input) {
+        uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        std::string data(input);
+        const uint64_t bit_length = static_cast<uint64_t>(input.size()) * 8;
+        data.push_back(static_cast<char>(0x80));
+        while (data.size() % 64 != 56) data.push_back('\0');
+        for (int i = 7; i >= 0; --i) data.push_back(static_cast<char>(bit_length >> (i * 8)));
+
+        const auto rotl = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+        for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+            uint32_t w[80];
+            for (int i = 0; i < 16; ++i) {
+                const auto* p = reinterpret_cast<const uint8_t*>(data.data() + chunk + i * 4);
+                w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+            }
+            for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; ++i) {
+                uint32_t f, k;
+                if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+                else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+                else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+                else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+                const uint32_t t = rotl(a, 5) + f + e + k + w[i];
+                e = d; d = c; c = rotl(b, 30); b = a; a = t;
+            }
+            h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+        }
+
+        std::array<uint8_t, 20> digest{};
+        for (int i = 0; i < 20; ++i) digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - (i % 4) * 8));
+        return digest;
+    }
+
+    std::string Base64(const uint8_t* data, size_t length) {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        out.reserve((length + 2) / 3 * 4);
+        for (size_t i = 0; i < length; i += 3) {
+            const uint32_t n = (uint32_t(data[i]) << 16) |
+                               (i + 1 < length ? uint32_t(data[i + 1]) << 8 : 0) |
+                               (i + 2 < length ? uint32_t(data[i + 2]) : 0);
+            out += kAlphabet[(n >> 18) & 63];
+            out += kAlphabet[(n >> 12) & 63];
+            out += i + 1 < length ? kAlphabet[(n >> 6) & 63] : '=';
+            out += i + 2 < length ? kAlphabet[n & 63] : '=';
+        }
+        return out;
+    }
+
+    std::string_view Trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+        return s;
+    }
+
+    bool IEquals(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+
+    // Splits a header value on sep, trimming each piece.
+    template <typename Fn>
+    void ForEachToken(std::string_view list, char sep, Fn&& fn) {
+        while (!list.empty()) {
+            const size_t end = list.find(sep);
+            fn(Trim(list.substr(0, end)));
+            if (end == std::string_view::npos) break;
+            list.remove_prefix(end + 1);
+        }
+    }
+
+    bool SetNonBlocking(SOCKET sock) {
+#ifdef _WIN32
+        u_long non_blocking = 1;
+        return ioctlsocket(sock, FIONBIO, &non_blocking) == 0;
+#else
+        const int flags = fcntl(sock, F_GETFL, 0);
+        return flags >= 0 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    }
+
+    bool ConnectInProgress() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EINPROGRESS;
+#endif
+    }
+
+    int MillisecondsUntil(std::chrono::steady_clock::time_point deadline) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        return left > 0 ? static_cast<int>(left) : 0;
+    }
+} // namespace
+
+// Raw-deflate decoder state for permessage-deflate (RFC 7692).
+struct WebSocketClient::Inflater {
+#ifdef STAYPUTVR_WITH_ZLIB
+    z_stream stream{};
+    bool ready = false;
+
+    Inflater() { ready = inflateInit2(&stream, -15) == Z_OK; } // any server window fits in 15 bits
+    ~Inflater() { if (ready) inflateEnd(&stream); }
+#endif
+};
+
+#ifdef _WIN32
+
+// Helper function to convert UTF-8 to wide string
+static std::wstring Utf8ToWide(const std::string& str) {
+    if (str.empty()) return std::wstring();
+    int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
+    std::wstring wstrTo(size_needed, 0);
+    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
+    return wstrTo;
+}
+
+#endif // _WIN32
+
+WebSocketClient::WebSocketClient()
+    : h_session_(nullptr)
+    , h_connection_(nullptr)
+    , h_websocket_(nullptr)
+    , state_(WebSocketState::DISCONNECTED)
+    , port_(0)
+    , secure_(false)
+    , receive_thread_running_(false)
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+}
+
+WebSocketClient::~WebSocketClient() {
+    Disconnect();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void WebSocketClient::SetTlsTransportFactory(TlsTransportFactory factory) {
+    std::lock_guard<std::mutex> lock(g_tls_mutex);
+    g_tls_factory = std::move(factory);
+}
+
+bool WebSocketClient::ParseUrl(const std::string& url) {
+    // Parse WebSocket URL (ws:// or wss://)
+    url_ = url;
+
+    size_t start;
+    if (url.rfind("wss://", 0) == 0) {
+        secure_ = true;
+        start = 6;
+    } else if (url.rfind("ws://", 0) == 0) {
+        secure_ = false;
+        start = 5;
+    } else {
+        SetError("Invalid WebSocket URL format. Must start with ws:// or wss://");
+        return false;
+    }
+
+    // Find path separator
+    const size_t path_pos = url.find('/', start);
+    const std::string host_port = url.substr(start, path_pos == std::string::npos ? std::string::npos : path_pos - start);
+    path_ = path_pos == std::string::npos ? "/" : url.substr(path_pos);
+
+    // Parse host and port
+    const size_t port_pos = host_port.find(':');
+    if (port_pos != std::string::npos) {
+        host_ = host_port.substr(0, port_pos);
+        port_ = std::atoi(host_port.c_str() + port_pos + 1);
+    } else {
+        host_ = host_port;
+        port_ = secure_ ? 443 : 80;
+    }
+
+    if (host_.empty() || port_ <= 0 || port_ > 65535) {
+        SetError("Invalid WebSocket URL: " + url);
+        return false;
+    }
+    return true;
+}
+
+bool WebSocketClient::Connect(const std::string& url) {
+    // A dropped connection (e.g. the socket dying silently across a sleep/resume)
+    // leaves the receive thread setting state_ to ERROR_STATE/DISCONNECTING and
+    // exiting without cleaning up. Tear that dead connection down here so a
+    // reconnect can proceed, instead of wedging on the guard below until the app
+    // is restarted. Disconnect() joins the stale receive thread and frees handles.
+    if (state_ == WebSocketState::ERROR_STATE ||
+        state_ == WebSocketState::DISCONNECTING) {
+        Disconnect();
+    }
+
+    if (state_ != WebSocketState::DISCONNECTED) {
+        SetError("Already connected or connecting");
+        return false;
+    }
+
+    state_ = WebSocketState::CONNECTING;
+
+    // Parse URL
+    if (!ParseUrl(url)) {
+        state_ = WebSocketState::ERROR_STATE;
+        return false;
+    }
+
+    stop_requested_ = false;
+    close_sent_ = false;
+    native_ = true;
+#ifdef _WIN32
+    // Without a TLS layer, WinHTTP still handles wss://.
+    if (secure_ && !CurrentTlsFactory()) {
+        native_ = false;
+    }
+#endif
+
+    if (!(native_ ? ConnectNative() : ConnectWinHttp())) {
+        state_ = WebSocketState::ERROR_STATE;
+        return false;
+    }
+
+    // Connection successful
+    state_ = WebSocketState::CONNECTED;
+    Logger::Info("WebSocket connected to: " + url + (deflate_active_ ? " (permessage-deflate)" : ""));
+
+    StartWriter();
+
+    // Start receive thread
+    receive_thread_running_ = true;
+    receive_thread_ = std::thread(&WebSocketClient::ReceiveThreadFunction, this);
+
+    // Call connected callback
+    if (on_connected_) {
+        on_connected_();
+    }
+
+    return true;
+}
+
+bool WebSocketClient::ConnectNative() {
+    std::string error;
+    if (!OpenSocket(error)) {
+        SetError(error);
+        CloseNative();
+        return false;
+    }
+
+    if (secure_) {
+        TlsTransportFactory factory = CurrentTlsFactory();
+        if (!factory) {
+            SetError("wss:// is not available: this build has no TLS support");
+            CloseNative();
+            return false;
+        }
+        transport_ = factory(sock_, host_, kConnectTimeout, error);
+        if (!transport_) {
+            SetError("TLS connection to " + host_ + " failed: " + error);
+            CloseNative();
+            return false;
+        }
+    } else {
+        transport_ = MakePlainTransport(sock_);
+    }
+
+    if (!PerformHandshake(error)) {
+        SetError("WebSocket upgrade failed: " + error);
+        CloseNative();
+        return false;
+    }
+
+    last_received_ = std::chrono::steady_clock::now();
+    ping_outstanding_ = false;
+    return true;
+}
+
+bool WebSocketClient::OpenSocket(std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* results = nullptr;
+    const std::string port = std::to_string(port_);
+    const int rc = getaddrinfo(host_.c_str(), port.c_str(), &hints, &results);
+    if (rc != 0) {
+#ifdef _WIN32
+        error = "Failed to resolve " + host_ + ". Error: " + std::to_string(rc);
+#else
+        error = "Failed to resolve " + host_ + ": " + gai_strerror(rc);
+#endif
+        return false;
+    }
+
+    // Try each address in turn, all within one overall deadline.
+    const auto deadline = std::chrono::steady_clock::now() + kConnectTimeout;
+    std::string attempt_error = "No usable address for " + host_;
+    for (addrinfo* ai = results; ai && sock_ == INVALID_SOCKET; ai = ai->ai_next) {
+        SOCKET sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock == INVALID_SOCKET) continue;
+        if (!SetNonBlocking(sock) ||
+            (connect(sock, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) != 0 && !ConnectInProgress())) {
+            attempt_error = "Failed to connect to " + host_ + ":" + port + ". Error: " + std::to_string(WSAGetLastError());
+            closesocket(sock);
+            continue;
+        }
+
+        int so_error = 0;
+        socklen_t so_error_len = sizeof(so_error);
+        if (!WaitForSocket(sock, true, MillisecondsUntil(deadline))) {
+            attempt_error = "Timed out connecting to " + host_ + ":" + port;
+            closesocket(sock);
+            continue;
+        }
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&so_error), &so_error_len) != 0 ||
+            so_error != 0) {
+            attempt_error = "Failed to connect to " + host_ + ":" + port + ". Error: " + std::to_string(so_error);
+            closesocket(sock);
+            continue;
+        }
+        sock_ = sock;
+    }
+    freeaddrinfo(results);
+    if (sock_ == INVALID_SOCKET) {
+        error = attempt_error;
+        return false;
+    }
+
+    // Frames are written whole; don't hold small ones back for coalescing.
+    int one = 1;
+    setsockopt(sock_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+    return true;
+}
+
+bool WebSocketClient::PerformHandshake(std::string& error) {
+    std::random_device random;
+    uint8_t nonce[16];
+    for (uint8_t& byte : nonce) byte = static_cast<uint8_t>(random());
+    const std::string key = Base64(nonce, sizeof(nonce));
+    mask_state_ = random() | 1; // xorshift state must be non-zero
+
+    const bool default_port = port_ == (secure_ ? 443 : 80);
+    std::string request = "GET " + path_ + " HTTP/1.1\r\n"
+                          "Host: " + host_ + (default_port ? "" : ":" + std::to_string(port_)) + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n"
+                          "User-Agent: StayPutVR WebSocket Client/1.0\r\n";
+#ifdef STAYPUTVR_WITH_ZLIB
+    if (compression_offered_) {
+        request += "Sec-WebSocket-Extensions: permessage-deflate\r\n";
+    }
+#endif
+    request += "\r\n";
+    if (!WriteAll(request.data(), request.size(), error)) return false;
+
+    // Read up to the end of the headers. The server may send its first frames
+    // in the same segment; those bytes are kept for the receive loop.
+    const auto deadline = std::chrono::steady_clock::now() + kConnectTimeout;
+    std::string response;
+    size_t header_end;
+    char chunk[1024];
+    while ((header_end = response.find("\r\n\r\n")) == std::string::npos) {
+        if (response.size() > kMaxHandshakeBytes) {
+            error = "response headers too large";
+            return false;
+        }
+        size_t n = 0;
+        switch (transport_->Read(chunk, sizeof(chunk), n)) {
+        case WebSocketTransport::IoStatus::Ok:
+            response.append(chunk, n);
+            break;
+        case WebSocketTransport::IoStatus::WouldBlock:
+            if (MillisecondsUntil(deadline) == 0) {
+                error = "timed out waiting for the server";
+                return false;
+            }
+            WaitForSocket(sock_, false, MillisecondsUntil(deadline));
+            break;
+        case WebSocketTransport::IoStatus::Closed:
+            error = "server closed the connection";
+            return false;
+        case WebSocketTransport::IoStatus::Error:
+            error = transport_->LastError();
+            return false;
+        }
+    }
+    handshake_leftover_.assign(response, header_end + 4, std::string::npos);
+    leftover_pos_ = 0;
+    response.resize(header_end);
+
+    const std::string_view headers(response);
+    const size_t status_end = headers.find("\r\n");
+    const std::string_view status_line = headers.substr(0, status_end);
+    if (status_line.size() < 12 || status_line.substr(0, 5) != "HTTP/" || status_line.substr(9, 3) != "101") {
+        error = "server answered \"" + std::string(status_line) + "\"";
+        return false;
+    }
+
+    std::string_view upgrade, connection, accept;
+    std::string extensions;
+    ForEachToken(status_end == std::string_view::npos ? std::string_view() : headers.substr(status_end + 2), '\n',
+                 [&](std::string_view line) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        const size_t colon = line.find(':');
+        if (colon == std::string_view::npos) return;
+        const std::string_view name = Trim(line.substr(0, colon));
+        const std::string_view value = Trim(line.substr(colon + 1));
+        if (IEquals(name, "Upgrade")) upgrade = value;
+        else if (IEquals(name, "Connection")) connection = value;
+        else if (IEquals(name, "Sec-WebSocket-Accept")) accept = value;
+        else if (IEquals(name, "Sec-WebSocket-Extensions")) {
+            if (!extensions.empty()) extensions += ',';
+            extensions.append(value);
+        }
+    });
+
+    bool connection_upgrade = false;
+    ForEachToken(connection, ',', [&](std::string_view token) {
+        connection_upgrade = connection_upgrade || IEquals(token, "Upgrade");
+    });
+    if (!IEquals(upgrade, "websocket") || !connection_upgrade) {
+        error = "server did not switch to the websocket protocol";
+        return false;
+    }
+    const auto digest = Sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    if (accept != Base64(digest.data(), digest.size())) {
+        error = "Sec-WebSocket-Accept does not match the key";
+        return false;
+    }
+
+    // The server may only accept what was offered: at most one permessage-deflate.
+    deflate_active_ = false;
+    server_no_context_takeover_ = false;
+    ForEachToken(extensions, ',', [&](std::string_view extension) {
+        if (!error.empty() || extension.empty()) return;
+        bool first = true;
+        ForEachToken(extension, ';', [&](std::string_view param) {
+            if (!error.empty()) return;
+            if (first) {
+                first = false;
+#ifdef STAYPUTVR_WITH_ZLIB
+                if (IEquals(param, "permessage-deflate") && compression_offered_ && !deflate_active_) {
+                    deflate_active_ = true;
+                    return;
+                }
+#endif
+                error = "server chose an extension that was not offered: " + std::string(extension);
+                return;
+            }
+            const std::string_view name = Trim(param.substr(0, param.find('=')));
+            if (IEquals(name, "server_no_context_takeover")) {
+                server_no_context_takeover_ = true;
+            } else if (!IEquals(name, "client_no_context_takeover") &&
+                       !IEquals(name, "server_max_window_bits") &&
+                       !IEquals(name, "client_max_window_bits")) {
+                // Window sizes need no action: inflate uses the largest window,
+                // and nothing is compressed on the way out.
+                error = "unknown permessage-deflate parameter: " + std::string(param);
+            }
+        });
+    });
+    if (!error.empty()) {
+        deflate_active_ = false;
+        return false;
+    }
+#ifdef STAYPUTVR_WITH_ZLIB
+    if (deflate_active_) {
+        inflater_ = std::make_unique<Inflater>();
+        if (!inflater_->ready) {
+            error = "failed to initialise zlib";
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+void WebSocketClient::Disconnect() {
+    if (state_ == WebSocketState::DISCONNECTED) {
+        return;
+    }
+
+    const bool was_connected = state_ == WebSocketState::CONNECTED;
+    state_ = WebSocketState::DISCONNECTING;
+
+    // Let queued messages (typically a final stop) go out ahead of the close.
+    StopWriter(was_connected);
+
+    if (native_) {
+        // Start the closing handshake; the receive thread exits when the
+        // server answers it.
+        if (was_connected && !close_sent_.exchange(true)) {
+            const char normal_closure[2] = {0x03, static_cast<char>(0xE8)}; // 1000
+            SendFrame(kClose, normal_closure, sizeof(normal_closure));
+        }
+    } else {
+        receive_thread_running_ = false;
+#ifdef _WIN32
+        // Close WebSocket first to unblock the receive thread
+        if (h_websocket_) {
+            WinHttpWebSocketClose(h_websocket_, WINHTTP_WEB_SOCKET_SUCCESS_CLOSE_STATUS, NULL, 0);
+        }
+#endif
+    }
+
+    if (receive_thread_.joinable()) {
+        // Give the thread a short time to finish gracefully
+        bool exited;
+        {
+            std::unique_lock<std::mutex> lock(exit_mutex_);
+            exited = receive_thread_exited_.wait_for(lock, kCloseWait, [this] { return !receive_thread_running_; });
+        }
+
+        if (native_) {
+            // A server that never answers the close: the loop sees the stop
+            // flag (and the shut-down socket) within one poll slice.
+            if (!exited) {
+                stop_requested_ = true;
+                shutdown(sock_, SD_BOTH);
+            }
+            receive_thread_.join();
+        } else if (exited) {
+            receive_thread_.join();
+        } else {
+            // WinHTTP receive didn't return in time, force detach
+            Logger::Warning("WebSocket receive thread did not join in time, detaching");
+            receive_thread_.detach();
+        }
+    }
+
+    if (native_) {
+        CloseNative();
+    } else {
+        CleanupHandles();
+    }
+    state_ = WebSocketState::DISCONNECTED;
+
+    Logger::Info("WebSocket disconnected");
+
+    // Call disconnected callback
+    if (on_disconnected_) {
+        on_disconnected_("User requested disconnect");
+    }
+}
+
+void WebSocketClient::CloseNative() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    transport_.reset(); // TLS close_notify is best effort
+    if (sock_ != INVALID_SOCKET) {
+        closesocket(sock_);
+        sock_ = INVALID_SOCKET;
+    }
+    inflater_.reset();
+    deflate_active_ = false;
+    handshake_leftover_.clear();
+    leftover_pos_ = 0;
+    message_.clear();
+    compressed_.clear();
+}
+
+bool WebSocketClient::IsConnected() const {
+    return state_ == WebSocketState::CONNECTED;
+}
+
+bool WebSocketClient::SendText(std::string_view message, SendPriority priority, std::string_view supersede_key) {
+    return Enqueue(kText, message, priority, supersede_key);
+}
+
+bool WebSocketClient::SendBinary(const void* data, size_t length) {
+    return Enqueue(kBinary, std::string_view(static_cast<const char*>(data), length), SendPriority::Normal, {});
+}
+
+bool WebSocketClient::Enqueue(uint8_t opcode, std::string_view payload, SendPriority priority, std::string_view key) {
+    if (!IsConnected()) {
+        SetError("Cannot send - not connected");
+        return false;
+    }
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(out_mutex_);
+        if (writer_stop_ || !writer_running_) {
+            SetError("Cannot send - not connected");
+            return false;
+        }
+
+        if (priority == SendPriority::Urgent) {
+            // A stop makes queued updates for the same device, or for every
+            // device when it carries no key, moot.
+            size_t kept = 0;
+            for (size_t i = 0; i < out_normal_.size(); ++i) {
+                OutboundMessage& queued = out_normal_[i];
+                if (!queued.key.empty() && (key.empty() || queued.key == key)) {
+                    RecyclePayload(queued.payload);
+                    ++send_stats_.superseded;
+                } else {
+                    if (kept != i) out_normal_[kept] = std::move(queued);
+                    ++kept;
+                }
+            }
+            out_normal_.erase(out_normal_.begin() + static_cast<std::ptrdiff_t>(kept), out_normal_.end());
+        } else {
+            const size_t queued = out_urgent_.size() + out_normal_.size();
+            if (!key.empty() && queued >= kHighWaterMark) {
+                // Backed up: the newest update overwrites the latest queued
+                // one for the same key, so that key's last value on the wire
+                // is still the newest.
+                for (auto it = out_normal_.rbegin(); it != out_normal_.rend(); ++it) {
+                    if (it->key == key && it->opcode == opcode) {
+                        it->payload.assign(payload);
+                        ++send_stats_.superseded;
+                        return true;
+                    }
+                }
+            }
+            if (queued >= kMaxQueued) {
+                ++send_stats_.rejected;
+                SetError("Cannot send - outbound queue is full");
+                return false;
+            }
+        }
+
+        OutboundMessage message;
+        if (!free_.empty()) {
+            message.payload = std::move(free_.back());
+            free_.pop_back();
+        }
+        message.payload.assign(payload);
+        message.key.assign(key);
+        message.opcode = opcode;
+        message.queued_at = std::chrono::steady_clock::now();
+        auto& queue = priority == SendPriority::Urgent ? out_urgent_ : out_normal_;
+        queue.push_back(std::move(message));
+
+        send_stats_.peak_queued = std::max(send_stats_.peak_queued, out_urgent_.size() + out_normal_.size());
+        wake = priority == SendPriority::Urgent || batch_holds_ == 0;
+    }
+    if (wake) {
+        out_cv_.notify_one();
+    }
+    return true;
+}
+
+WebSocketClient::SendBatch::SendBatch(WebSocketClient& client) : client_(client) {
+    std::lock_guard<std::mutex> lock(client_.out_mutex_);
+    ++client_.batch_holds_;
+}
+
+WebSocketClient::SendBatch::~SendBatch() {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(client_.out_mutex_);
+        wake = --client_.batch_holds_ == 0 && !client_.out_normal_.empty();
+    }
+    if (wake) {
+        client_.out_cv_.notify_one();
+    }
+}
+
+WebSocketClient::SendStats WebSocketClient::GetSendStats() const {
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    SendStats stats = send_stats_;
+    stats.queued = out_urgent_.size() + out_normal_.size();
+    if (stats.sent > 0) stats.avg_queue_ms = queue_ms_total_ / static_cast<double>(stats.sent);
+    if (stats.writes > 0) stats.avg_write_ms = write_ms_total_ / static_cast<double>(stats.writes);
+    return stats;
+}
+
+void WebSocketClient::RecyclePayload(std::string& payload) {
+    if (free_.size() < kMaxFreeBuffers && payload.capacity() <= kMaxFreeCapacity) {
+        free_.push_back(std::move(payload));
+    }
+}
+
+void WebSocketClient::StartWriter() {
+    {
+        std::lock_guard<std::mutex> lock(out_mutex_);
+        writer_stop_ = false;
+        writer_running_ = true;
+    }
+    writer_thread_ = std::thread(&WebSocketClient::WriterThreadFunction, this);
+}
+
+void WebSocketClient::StopWriter(bool drain) {
+    if (!writer_thread_.joinable()) {
+        return;
+    }
+
+    bool exited;
+    {
+        std::unique_lock<std::mutex> lock(out_mutex_);
+        if (!drain) {
+            for (auto* queue : {&out_urgent_, &out_normal_}) {
+                for (auto& message : *queue) {
+                    RecyclePayload(message.payload);
+                }
+                queue->clear();
+            }
+        }
+        writer_stop_ = true;
+        out_cv_.notify_one();
+        exited = writer_exited_.wait_for(lock, kCloseWait, [this] { return !writer_running_; });
+    }
+
+    // A write stuck on a peer that stopped reading fails as soon as the
+    // socket is shut down. (WinHTTP sends are bounded by its own timeouts.)
+    if (!exited && native_) {
+        Logger::Warning("WebSocket send queue did not drain in time, dropping it");
+        shutdown(sock_, SD_BOTH);
+    }
+    writer_thread_.join();
+
+    std::lock_guard<std::mutex> lock(out_mutex_);
+    out_urgent_.clear();
+    out_normal_.clear();
+}
+
+void WebSocketClient::WriterThreadFunction() {
+    std::unique_lock<std::mutex> lock(out_mutex_);
+    for (;;) {
+        out_cv_.wait(lock, [this] {
+            return writer_stop_ || !out_urgent_.empty() || (!out_normal_.empty() && batch_holds_ == 0);
+        });
+        if (out_urgent_.empty() && out_normal_.empty()) {
+            if (writer_stop_) break;
+            continue;
+        }
+
+        // Everything queued goes out in this write, urgent messages first.
+        // Normal messages stay put while a SendBatch is still adding to them.
+        for (auto& message : out_urgent_) out_batch_.push_back(std::move(message));
+        out_urgent_.clear();
+        if (batch_holds_ == 0 || writer_stop_) {
+            for (auto& message : out_normal_) out_batch_.push_back(std::move(message));
+            out_normal_.clear();
+        }
+
+        lock.unlock();
+        const auto write_start = std::chrono::steady_clock::now();
+        uint64_t writes = 0;
+        const bool ok = WriteBatch(writes);
+        const auto write_end = std::chrono::steady_clock::now();
+        lock.lock();
+
+        if (ok) {
+            for (const auto& message : out_batch_) {
+                const double queue_ms = MillisecondsBetween(message.queued_at, write_start);
+                queue_ms_total_ += queue_ms;
+                send_stats_.max_queue_ms = std::max(send_stats_.max_queue_ms, queue_ms);
+            }
+            const double write_ms = MillisecondsBetween(write_start, write_end);
+            write_ms_total_ += write_ms;
+            send_stats_.max_write_ms = std::max(send_stats_.max_write_ms, write_ms);
+            send_stats_.sent += out_batch_.size();
+            send_stats_.writes += writes;
+        } else {
+            Logger::Warning("WebSocket dropped " + std::to_string(out_batch_.size()) + " outgoing message(s): " + GetLastError());
+        }
+
+        for (auto& message : out_batch_) {
+            RecyclePayload(message.payload);
+        }
+        out_batch_.clear();
+    }
+
+    writer_running_ = false;
+    writer_exited_.notify_all();
+}
+
+bool WebSocketClient::WriteBatch(uint64_t& writes) {
+    // Opcode and length only: payloads can carry account data (PiShock
+    // publishes embed the user and shocker ids), and this is the writer's
+    // hot path.
+    if (Logger::IsEnabled(Logger::LogLevel::DEBUG)) {
+        for (const auto& message : out_batch_) {
+            Logger::Debug("WebSocket sent opcode " + std::to_string(static_cast<int>(message.opcode)) + ", " +
+                          std::to_string(message.payload.size()) + " bytes");
+        }
+    }
+
+    if (native_) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        if (!transport_) {
+            SetError("Cannot send - not connected");
+            return false;
+        }
+        send_frame_.clear();
+        for (const auto& message : out_batch_) {
+            AppendFrame(message.opcode, message.payload.data(), message.payload.size());
+        }
+        std::string error;
+        if (!WriteAll(send_frame_.data(), send_frame_.size(), error)) {
+            SetError("Failed to send WebSocket frames: " + error);
+            return false;
+        }
+        writes = 1;
+        return true;
+    }
+
+#ifdef _WIN32
+    // WinHTTP takes one message per call.
+    for (const auto& message : out_batch_) {
+        DWORD result = WinHttpWebSocketSend(
+            h_websocket_,
+            message.opcode == kText ? WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE : WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE,
+            (PVOID)message.payload.data(),
+            (DWORD)message.payload.length()
+        );
+
+        if (result != ERROR_SUCCESS) {
+            std::ostringstream oss;
+            oss << "Failed to send WebSocket message. Error: " << result;
+            SetError(oss.str());
+            return false;
+        }
+        ++writes;
+    }
+#endif
+    return true;
+}
+
+bool WebSocketClient::SendFrame(uint8_t opcode, const char* data, size_t length) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (!transport_) {
+        SetError("Cannot send - not connected");
+        return false;
+    }
+
+    send_frame_.clear();
+    AppendFrame(opcode, data, length);
+
+    std::string error;
+    if (!WriteAll(send_frame_.data(), send_frame_.size(), error)) {
+        SetError("Failed to send WebSocket frame: " + error);
+        return false;
+    }
+    return true;
+}
+
+void WebSocketClient::AppendFrame(uint8_t opcode, const char* data, size_t length) {
+    // One unfragmented frame: header, mask key, masked payload.
+    send_frame_.push_back(static_cast<char>(0x80 | opcode));
+    if (length < 126) {
+        send_frame_.push_back(static_cast<char>(0x80 | length));
+    } else if (length <= 0xFFFF) {
+        send_frame_.push_back(static_cast<char>(0x80 | 126));
+        send_frame_.push_back(static_cast<char>(length >> 8));
+        send_frame_.push_back(static_cast<char>(length));
+    } else {
+        send_frame_.push_back(static_cast<char>(0x80 | 127));
+        for (int i = 7; i >= 0; --i) send_frame_.push_back(static_cast<char>(static_cast<uint64_t>(length) >> (i * 8)));
+    }
+
+    // Masking only has to stop a browser script steering the bytes on the
+    // wire; an xorshift seeded per connection from random_device does that.
+    mask_state_ ^= mask_state_ << 13;
+    mask_state_ ^= mask_state_ >> 17;
+    mask_state_ ^= mask_state_ << 5;
+    char key[4];
+    std::memcpy(key, &mask_state_, sizeof(key));
+    send_frame_.append(key, sizeof(key));
+
+    const size_t header_size = send_frame_.size();
+    send_frame_.resize(header_size + length);
+    char* out = send_frame_.data() + header_size;
+    for (size_t i = 0; i < length; ++i) {
+        out[i] = static_cast<char>(data[i] ^ key[i & 3]);
+    }
+}
+
+bool WebSocketClient::WriteAll(const char* data, size_t length, std::string& error) {
+    const auto deadline = std::chrono::steady_clock::now() + kConnectTimeout;
+    while (length > 0) {
+        size_t n = 0;
+        WebSocketTransport::IoStatus status;
+        {
+            std::lock_guard<std::mutex> lock(io_mutex_);
+            status = transport_->Write(data, length, n);
+        }
+        switch (status) {
+        case WebSocketTransport::IoStatus::Ok:
+            data += n;
+            length -= n;
+            break;
+        case WebSocketTransport::IoStatus::WouldBlock:
+            if (MillisecondsUntil(deadline) == 0) {
+                error = "send timed out";
+                return false;
+            }
+            WaitForSocket(sock_, true, kPollSliceMs);
+            break;
+        case WebSocketTransport::IoStatus::Closed:
+            error = "connection closed";
+            return false;
+        case WebSocketTransport::IoStatus::Error:
+            error = transport_->LastError();
+            return false;
+        }
+    }
+    return true;
+}
+
+WebSocketClient::ReadResult WebSocketClient::ReadExact(char* buffer, size_t length, std::string& error) {
+    while (length > 0) {
+        if (leftover_pos_ < handshake_leftover_.size()) {
+            const size_t n = std::min(length, handshake_leftover_.size() - leftover_pos_);
+            std::memcpy(buffer, handshake_leftover_.data() + leftover_pos_, n);
+            leftover_pos_ += n;
+            buffer += n;
+            length -= n;
+            continue;
+        }
+        if (stop_requested_) {
+            return ReadResult::Stopped;
+        }
+
+        size_t n = 0;
+        WebSocketTransport::IoStatus status;
+        {
+            std::lock_guard<std::mutex> lock(io_mutex_);
+            status = transport_->Read(buffer, length, n);
+        }
+        switch (status) {
+        case WebSocketTransport::IoStatus::Ok:
+            buffer += n;
+            length -= n;
+            last_received_ = std::chrono::steady_clock::now();
+            ping_outstanding_ = false;
+            break;
+        case WebSocketTransport::IoStatus::WouldBlock:
+            if (!WaitForSocket(sock_, false, kPollSliceMs) && ping_interval_.count() > 0) {
+                // Quiet connection: ping it, and give up if even that goes unanswered.
+                const auto idle = std::chrono::steady_clock::now() - last_received_;
+                if (idle >= 2 * ping_interval_) {
+                    error = "no traffic from the server for " + std::to_string(2 * ping_interval_.count()) + "s";
+                    return ReadResult::TimedOut;
+                }
+                if (idle >= ping_interval_ && !ping_outstanding_) {
+                    ping_outstanding_ = true;
+                    SendFrame(kPing, nullptr, 0);
+                }
+            }
+            break;
+        case WebSocketTransport::IoStatus::Closed:
+            return ReadResult::Closed;
+        case WebSocketTransport::IoStatus::Error:
+            error = transport_->LastError();
+            return ReadResult::Error;
+        }
+    }
+    return ReadResult::Ok;
+}
+
+bool WebSocketClient::InflateMessage(std::string& error) {
+#ifdef STAYPUTVR_WITH_ZLIB
+    // The sender strips the trailing empty stored block; put it back.
+    compressed_.append("\x00\x00\xff\xff", 4);
+    z_stream& z = inflater_->stream;
+    z.next_in = reinterpret_cast<Bytef*>(compressed_.data());
+    z.avail_in = static_cast<uInt>(compressed_.size());
+
+    message_.clear();
+    size_t produced = 0;
+    for (;;) {
+        if (message_.size() - produced < 1024) {
+            if (message_.size() >= kMaxMessageBytes) {
+                error = "inflated message exceeds " + std::to_string(kMaxMessageBytes) + " bytes";
+                return false;
+            }
+            message_.resize(std::min(kMaxMessageBytes, std::max<size_t>(message_.size() * 2, compressed_.size() * 4)));
+        }
+        z.next_out = reinterpret_cast<Bytef*>(message_.data() + produced);
+        z.avail_out = static_cast<uInt>(message_.size() - produced);
+        const int rc = inflate(&z, Z_SYNC_FLUSH);
+        produced = message_.size() - z.avail_out;
+        if (rc == Z_STREAM_END) {
+            inflateReset(&z); // a final block ends this stream; the next message starts a new one
+            break;
+        }
+        if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            error = std::string("inflate failed: ") + (z.msg ? z.msg : std::to_string(rc));
+            return false;
+        }
+        if (z.avail_in == 0 && z.avail_out > 0) break;
+    }
+    message_.resize(produced);
+    compressed_.clear();
+    if (server_no_context_takeover_) {
+        inflateReset(&z);
+    }
+    return true;
+#else
+    error = "compressed frame without permessage-deflate";
+    return false;
+#endif
+}
+
+void WebSocketClient::Update() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (inbox_.empty()) return;
+        delivering_.swap(inbox_);
+    }
 
-// Helper function to convert DWORD to string
-static std::string DWordToString(DWORD value) {
-    std::ostringstream oss;
-    oss << value;
-    return oss.str();
-}
+    // Deliver without holding the lock so the receive thread keeps queueing.
+    for (const std::string& message : delivering_) {
+        if (on_message_) {
+            on_message_(message);
+        }
+    }
 
-// Helper function to convert UTF-8 to wide string
-static std::wstring Utf8ToWide(const std::string& str) {
-    if (str.empty()) return std::wstring();
-    int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-    std::wstring wstrTo(size_needed, 0);
-    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
-    return wstrTo;
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    for (std::string& buffer : delivering_) {
+        if (buffer.capacity() <= kMaxSpareCapacity && spare_bytes_ + buffer.capacity() <= kSpareBytes) {
+            spare_bytes_ += buffer.capacity();
+            buffer.clear();
+            spare_.push_back(std::move(buffer));
+        }
+    }
+    delivering_.clear();
 }
 
-// Helper function to convert wide string to UTF-8
-static std::string WideToUtf8(const std::wstring& wstr) {
-    if (wstr.empty()) return std::string();
-    int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-    std::string strTo(size_needed, 0);
-    WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-    return strTo;
+void WebSocketClient::QueueMessage() {
+    // Hand the assembled buffer over whole and carry on in a recycled one.
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    inbox_.push_back(std::move(message_));
+    message_.clear();
+    if (!spare_.empty()) {
+        message_.swap(spare_.back());
+        spare_.pop_back();
+        spare_bytes_ -= message_.capacity();
+    }
 }
 
-WebSocketClient::WebSocketClient()
-    : h_session_(nullptr)
-    , h_connection_(nullptr)
-    , h_websocket_(nullptr)
-    , state_(WebSocketState::DISCONNECTED)
-    , port_(0)
-    , secure_(false)
-    , receive_thread_running_(false)
-{
-}
+void WebSocketClient::ReceiveThreadFunction() {
+    Logger::Debug("WebSocket receive thread started");
 
-WebSocketClient::~WebSocketClient() {
-    Disconnect();
+    if (native_) {
+        NativeReceiveLoop();
+    } else {
+        WinHttpReceiveLoop();
+    }
+
+    // Reflect reality on every exit path, so Disconnect()'s wait completes
+    // promptly instead of timing out.
+    {
+        std::lock_guard<std::mutex> lock(exit_mutex_);
+        receive_thread_running_ = false;
+    }
+    receive_thread_exited_.notify_all();
+    Logger::Debug("WebSocket receive thread stopped");
 }
 
-bool WebSocketClient::ParseUrl(const std::string& url) {
-    // Parse WebSocket URL (ws:// or wss://)
-    url_ = url;
-    
-    // Check protocol
-    if (url.find("wss://") == 0) {
-        secure_ = true;
-        size_t start = 6; // Length of "wss://"
-        
-        // Find path separator
-        size_t path_pos = url.find('/', start);
-        std::string host_port;
-        
-        if (path_pos != std::string::npos) {
-            host_port = url.substr(start, path_pos - start);
-            path_ = Utf8ToWide(url.substr(path_pos));
-        } else {
-            host_port = url.substr(start);
-            path_ = L"/";
-        }
-        
-        // Parse host and port
-        size_t port_pos = host_port.find(':');
-        if (port_pos != std::string::npos) {
-            host_ = Utf8ToWide(host_port.substr(0, port_pos));
-            port_ = std::stoi(host_port.substr(port_pos + 1));
-        } else {
-            host_ = Utf8ToWide(host_port);
-            port_ = INTERNET_DEFAULT_HTTPS_PORT;
+void WebSocketClient::NativeReceiveLoop() {
+    std::string error;
+    ReadResult result = ReadResult::Ok;
+    bool server_closed = false;
+    uint16_t close_code = 0;
+    bool in_message = false;
+    bool message_compressed = false;
+    uint8_t message_opcode = kText;
+
+    const auto read = [&](char* buffer, size_t length) {
+        result = ReadExact(buffer, length, error);
+        return result == ReadResult::Ok;
+    };
+    // Protocol violations close the connection with the matching status code.
+    const auto fail = [&](uint16_t code, const std::string& why) {
+        error = why;
+        if (!close_sent_.exchange(true)) {
+            const char payload[2] = {static_cast<char>(code >> 8), static_cast<char>(code & 0xFF)};
+            SendFrame(kClose, payload, sizeof(payload));
         }
-        
-        return true;
-    } else if (url.find("ws://") == 0) {
-        secure_ = false;
-        size_t start = 5; // Length of "ws://"
-        
-        size_t path_pos = url.find('/', start);
-        std::string host_port;
-        
-        if (path_pos != std::string::npos) {
-            host_port = url.substr(start, path_pos - start);
-            path_ = Utf8ToWide(url.substr(path_pos));
+    };
+
+    for (;;) {
+        uint8_t head[2];
+        if (!read(reinterpret_cast<char*>(head), sizeof(head))) break;
+
+        const bool fin = (head[0] & 0x80) != 0;
+        const bool rsv1 = (head[0] & 0x40) != 0;
+        const uint8_t opcode = head[0] & 0x0F;
+        if ((head[0] & 0x30) != 0 || (rsv1 && (!deflate_active_ || (opcode != kText && opcode != kBinary)))) {
+            fail(1002, "unexpected reserved bits in frame header");
+            break;
+        }
+        if ((head[1] & 0x80) != 0) {
+            fail(1002, "server frames must not be masked");
+            break;
+        }
+
+        uint64_t length = head[1] & 0x7F;
+        if (length >= 126) {
+            uint8_t ext[8];
+            const size_t ext_size = length == 126 ? 2 : 8;
+            if (!read(reinterpret_cast<char*>(ext), ext_size)) break;
+            length = 0;
+            for (size_t i = 0; i < ext_size; ++i) length = (length << 8) | ext[i];
+        }
+
+        if (opcode >= kClose) {
+            if (!fin || length > 125) {
+                fail(1002, "invalid control frame");
+                break;
+            }
+            control_.resize(static_cast<size_t>(length));
+            if (!read(control_.data(), control_.size())) break;
+
+            if (opcode == kPing) {
+                SendFrame(kPong, control_.data(), control_.size());
+            } else if (opcode == kClose) {
+                close_code = control_.size() >= 2
+                    ? static_cast<uint16_t>((uint8_t(control_[0]) << 8) | uint8_t(control_[1]))
+                    : 1005;
+                if (!close_sent_.exchange(true)) {
+                    SendFrame(kClose, control_.data(), std::min<size_t>(control_.size(), 2));
+                }
+                server_closed = true;
+                break;
+            } else if (opcode != kPong) {
+                fail(1002, "unknown control opcode " + std::to_string(opcode));
+                break;
+            }
+            continue;
+        }
+
+        if (opcode == kContinuation) {
+            if (!in_message) {
+                fail(1002, "continuation frame outside a message");
+                break;
+            }
+        } else if (opcode == kText || opcode == kBinary) {
+            if (in_message) {
+                fail(1002, "new message before the previous one finished");
+                break;
+            }
+            in_message = true;
+            message_opcode = opcode;
+            message_compressed = rsv1;
         } else {
-            host_port = url.substr(start);
-            path_ = L"/";
-        }
-        
-        size_t port_pos = host_port.find(':');
-        if (port_pos != std::string::npos) {
-            host_ = Utf8ToWide(host_port.substr(0, port_pos));
-            port_ = std::stoi(host_port.substr(port_pos + 1));
+            fail(1002, "unknown opcode " + std::to_string(opcode));
+            break;
+        }
+
+        // Fragments are read straight onto the end of the message buffer.
+        std::string& target = message_compressed ? compressed_ : message_;
+        if (length > kMaxMessageBytes - target.size()) {
+            fail(1009, "message exceeds " + std::to_string(kMaxMessageBytes) + " bytes");
+            break;
+        }
+        const size_t offset = target.size();
+        target.resize(offset + static_cast<size_t>(length));
+        if (!read(target.data() + offset, static_cast<size_t>(length))) break;
+        if (!fin) continue;
+
+        in_message = false;
+        if (message_compressed && !InflateMessage(error)) {
+            fail(1007, error);
+            break;
+        }
+        if (message_opcode == kText) {
+            QueueMessage();
         } else {
-            host_ = Utf8ToWide(host_port);
-            port_ = INTERNET_DEFAULT_HTTP_PORT;
+            message_.clear();
         }
-        
-        return true;
     }
-    
-    SetError("Invalid WebSocket URL format. Must start with ws:// or wss://");
-    return false;
-}
 
-bool WebSocketClient::Connect(const std::string& url) {
-    // A dropped connection (e.g. the socket dying silently across a sleep/resume)
-    // leaves the receive thread setting state_ to ERROR_STATE/DISCONNECTING and
-    // exiting without cleaning up. Tear that dead connection down here so a
-    // reconnect can proceed, instead of wedging on the guard below until the app
-    // is restarted. Disconnect() joins the stale receive thread and frees handles.
-    if (state_ == WebSocketState::ERROR_STATE ||
-        state_ == WebSocketState::DISCONNECTING) {
-        Disconnect();
+    if (server_closed) {
+        // Either the answer to our own close (Disconnect() is waiting) or the
+        // server hanging up on us.
+        if (state_ == WebSocketState::CONNECTED) {
+            Logger::Info("WebSocket close frame received (code " + std::to_string(close_code) + ")");
+            state_ = WebSocketState::DISCONNECTING;
+
+            if (on_disconnected_) {
+                on_disconnected_("Server closed connection");
+            }
+        }
+        return;
+    }
+    if (result == ReadResult::Stopped || state_ != WebSocketState::CONNECTED) {
+        return;
     }
 
-    if (state_ != WebSocketState::DISCONNECTED) {
-        SetError("Already connected or connecting");
-        return false;
+    if (result == ReadResult::Closed && error.empty()) {
+        error = "connection closed without a close frame";
     }
-    
-    state_ = WebSocketState::CONNECTING;
-    
-    // Parse URL
-    if (!ParseUrl(url)) {
-        state_ = WebSocketState::ERROR_STATE;
-        return false;
+    const std::string error_msg = "WebSocket receive failed: " + error;
+    SetError(error_msg);
+    state_ = WebSocketState::ERROR_STATE;
+
+    if (on_error_) {
+        on_error_(error_msg);
+    }
+    if (on_disconnected_) {
+        on_disconnected_("Receive error");
     }
-    
+}
+
+#ifdef _WIN32
+
+bool WebSocketClient::ConnectWinHttp() {
     // Open session
     h_session_ = WinHttpOpen(
         L"StayPutVR WebSocket Client/1.0",
@@ -146,51 +1272,48 @@ bool WebSocketClient::Connect(const std::string& url) {
         WINHTTP_NO_PROXY_BYPASS,
         0
     );
-    
+
     if (!h_session_) {
         std::ostringstream oss;
-        oss << "Failed to open WinHTTP session. Error: " << GetLastError();
+        oss << "Failed to open WinHTTP session. Error: " << ::GetLastError();
         SetError(oss.str());
-        state_ = WebSocketState::ERROR_STATE;
         return false;
     }
-    
+
     // Connect to server
-    h_connection_ = WinHttpConnect(h_session_, host_.c_str(), port_, 0);
+    h_connection_ = WinHttpConnect(h_session_, Utf8ToWide(host_).c_str(), static_cast<INTERNET_PORT>(port_), 0);
     if (!h_connection_) {
         std::ostringstream oss;
-        oss << "Failed to connect to server. Error: " << GetLastError();
+        oss << "Failed to connect to server. Error: " << ::GetLastError();
         SetError(oss.str());
         CleanupHandles();
-        state_ = WebSocketState::ERROR_STATE;
         return false;
     }
-    
+
     // Open request
     DWORD flags = WINHTTP_FLAG_SECURE;
     if (!secure_) {
         flags = 0;
     }
-    
+
     HINTERNET h_request = WinHttpOpenRequest(
         h_connection_,
         L"GET",
-        path_.c_str(),
+        Utf8ToWide(path_).c_str(),
         NULL,
         WINHTTP_NO_REFERER,
         WINHTTP_DEFAULT_ACCEPT_TYPES,
         flags
     );
-    
+
     if (!h_request) {
         std::ostringstream oss;
-        oss << "Failed to open request. Error: " << GetLastError();
+        oss << "Failed to open request. Error: " << ::GetLastError();
         SetError(oss.str());
         CleanupHandles();
-        state_ = WebSocketState::ERROR_STATE;
         return false;
     }
-    
+
     // Upgrade to WebSocket
     BOOL result = WinHttpSetOption(
         h_request,
@@ -198,17 +1321,16 @@ bool WebSocketClient::Connect(const std::string& url) {
         NULL,
         0
     );
-    
+
     if (!result) {
         std::ostringstream oss;
-        oss << "Failed to set WebSocket upgrade option. Error: " << GetLastError();
+        oss << "Failed to set WebSocket upgrade option. Error: " << ::GetLastError();
         SetError(oss.str());
         WinHttpCloseHandle(h_request);
         CleanupHandles();
-        state_ = WebSocketState::ERROR_STATE;
         return false;
     }
-    
+
     // Send request
     result = WinHttpSendRequest(
         h_request,
@@ -219,190 +1341,62 @@ bool WebSocketClient::Connect(const std::string& url) {
         0,
         0
     );
-    
+
     if (!result) {
         std::ostringstream oss;
-        oss << "Failed to send WebSocket upgrade request. Error: " << GetLastError();
+        oss << "Failed to send WebSocket upgrade request. Error: " << ::GetLastError();
         SetError(oss.str());
         WinHttpCloseHandle(h_request);
         CleanupHandles();
-        state_ = WebSocketState::ERROR_STATE;
         return false;
     }
-    
+
     // Receive response
     result = WinHttpReceiveResponse(h_request, NULL);
     if (!result) {
         std::ostringstream oss;
-        oss << "Failed to receive WebSocket upgrade response. Error: " << GetLastError();
+        oss << "Failed to receive WebSocket upgrade response. Error: " << ::GetLastError();
         SetError(oss.str());
         WinHttpCloseHandle(h_request);
         CleanupHandles();
-        state_ = WebSocketState::ERROR_STATE;
         return false;
     }
-    
+
     // Complete WebSocket handshake
     h_websocket_ = WinHttpWebSocketCompleteUpgrade(h_request, NULL);
     WinHttpCloseHandle(h_request);
-    
+
     if (!h_websocket_) {
         std::ostringstream oss;
-        oss << "Failed to complete WebSocket upgrade. Error: " << GetLastError();
+        oss << "Failed to complete WebSocket upgrade. Error: " << ::GetLastError();
         SetError(oss.str());
         CleanupHandles();
-        state_ = WebSocketState::ERROR_STATE;
-        return false;
-    }
-    
-    // Connection successful
-    state_ = WebSocketState::CONNECTED;
-    Logger::Info("WebSocket connected to: " + url);
-    
-    // Start receive thread
-    receive_thread_running_ = true;
-    receive_thread_ = std::thread(&WebSocketClient::ReceiveThreadFunction, this);
-    
-    // Call connected callback
-    if (on_connected_) {
-        on_connected_();
-    }
-    
-    return true;
-}
-
-void WebSocketClient::Disconnect() {
-    if (state_ == WebSocketState::DISCONNECTED) {
-        return;
-    }
-    
-    state_ = WebSocketState::DISCONNECTING;
-    
-    // Stop receive thread
-    receive_thread_running_ = false;
-    
-    // Close WebSocket first to unblock the receive thread
-    if (h_websocket_) {
-        WinHttpWebSocketClose(h_websocket_, WINHTTP_WEB_SOCKET_SUCCESS_CLOSE_STATUS, NULL, 0);
-    }
-    
-    // Wait for receive thread with timeout
-    if (receive_thread_.joinable()) {
-        // Give the thread a short time to finish gracefully
-        auto start = std::chrono::steady_clock::now();
-        bool joined = false;
-        
-        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500)) {
-            if (!receive_thread_running_) {
-                // Thread has finished, safe to join
-                receive_thread_.join();
-                joined = true;
-                break;
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        }
-        
-        if (!joined) {
-            // Thread didn't finish in time, force detach
-            Logger::Warning("WebSocket receive thread did not join in time, detaching");
-            receive_thread_.detach();
-        }
-    }
-    
-    CleanupHandles();
-    state_ = WebSocketState::DISCONNECTED;
-    
-    Logger::Info("WebSocket disconnected");
-    
-    // Call disconnected callback
-    if (on_disconnected_) {
-        on_disconnected_("User requested disconnect");
-    }
-}
-
-bool WebSocketClient::IsConnected() const {
-    return state_ == WebSocketState::CONNECTED;
-}
-
-bool WebSocketClient::SendText(const std::string& message) {
-    if (!IsConnected()) {
-        SetError("Cannot send - not connected");
-        return false;
-    }
-    
-    DWORD result = WinHttpWebSocketSend(
-        h_websocket_,
-        WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE,
-        (PVOID)message.c_str(),
-        (DWORD)message.length()
-    );
-    
-    if (result != ERROR_SUCCESS) {
-        std::ostringstream oss;
-        oss << "Failed to send WebSocket message. Error: " << result;
-        SetError(oss.str());
         return false;
     }
-    
-    Logger::Debug("WebSocket sent: " + message);
-    return true;
-}
 
-bool WebSocketClient::SendBinary(const void* data, size_t length) {
-    if (!IsConnected()) {
-        SetError("Cannot send - not connected");
-        return false;
-    }
-    
-    DWORD result = WinHttpWebSocketSend(
-        h_websocket_,
-        WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE,
-        (PVOID)data,
-        (DWORD)length
-    );
-    
-    if (result != ERROR_SUCCESS) {
-        std::ostringstream oss;
-        oss << "Failed to send WebSocket binary message. Error: " << result;
-        SetError(oss.str());
-        return false;
-    }
-    
     return true;
 }
 
-void WebSocketClient::Update() {
-    // Process queued messages
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    while (!message_queue_.empty()) {
-        std::string message = message_queue_.front();
-        message_queue_.pop();
-        
-        if (on_message_) {
-            on_message_(message);
-        }
-    }
-}
+void WebSocketClient::WinHttpReceiveLoop() {
+    const DWORD READ_CHUNK = 8192;
 
-void WebSocketClient::ReceiveThreadFunction() {
-    Logger::Debug("WebSocket receive thread started");
-    
-    const DWORD BUFFER_SIZE = 8192;
-    std::vector<BYTE> buffer(BUFFER_SIZE);
-    std::string accumulated_message;
-    
     while (receive_thread_running_ && state_ == WebSocketState::CONNECTED) {
+        // Receive straight onto the end of the message being assembled.
+        const size_t offset = message_.size();
+        message_.resize(offset + READ_CHUNK);
+
         DWORD bytes_read = 0;
         WINHTTP_WEB_SOCKET_BUFFER_TYPE buffer_type;
-        
+
         DWORD result = WinHttpWebSocketReceive(
             h_websocket_,
-            buffer.data(),
-            BUFFER_SIZE,
+            message_.data() + offset,
+            READ_CHUNK,
             &bytes_read,
             &buffer_type
         );
-        
+        message_.resize(offset + (result == ERROR_SUCCESS ? bytes_read : 0));
+
         if (result != ERROR_SUCCESS) {
             if (receive_thread_running_) {
                 std::ostringstream oss;
@@ -410,7 +1404,7 @@ void WebSocketClient::ReceiveThreadFunction() {
                 std::string error_msg = oss.str();
                 SetError(error_msg);
                 state_ = WebSocketState::ERROR_STATE;
-                
+
                 if (on_error_) {
                     on_error_(error_msg);
                 }
@@ -420,38 +1414,39 @@ void WebSocketClient::ReceiveThreadFunction() {
             }
             break;
         }
-        
-        if (buffer_type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE ||
-            buffer_type == WINHTTP_WEB_SOCKET_UTF8_FRAGMENT_BUFFER_TYPE) {
-            
-            // Append to accumulated message
-            accumulated_message.append((char*)buffer.data(), bytes_read);
-            
-            // If this is a complete message (not a fragment), queue it
-            if (buffer_type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE) {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                message_queue_.push(accumulated_message);
-                Logger::Debug("WebSocket received: " + accumulated_message);
-                accumulated_message.clear();
-            }
+
+        if (buffer_type == WINHTTP_WEB_SOCKET_UTF8_MESSAGE_BUFFER_TYPE) {
+            QueueMessage();
+        }
+        else if (buffer_type == WINHTTP_WEB_SOCKET_BINARY_MESSAGE_BUFFER_TYPE) {
+            message_.clear();
         }
         else if (buffer_type == WINHTTP_WEB_SOCKET_CLOSE_BUFFER_TYPE) {
+            message_.clear();
             Logger::Info("WebSocket close frame received");
             receive_thread_running_ = false;
             state_ = WebSocketState::DISCONNECTING;
-            
+
             if (on_disconnected_) {
                 on_disconnected_("Server closed connection");
             }
             break;
         }
+        else if (message_.size() > kMaxMessageBytes) {
+            std::string error_msg = "WebSocket message exceeds " + std::to_string(kMaxMessageBytes) + " bytes";
+            SetError(error_msg);
+            state_ = WebSocketState::ERROR_STATE;
+
+            if (on_error_) {
+                on_error_(error_msg);
+            }
+            if (on_disconnected_) {
+                on_disconnected_("Receive error");
+            }
+            break;
+        }
+        // Otherwise a fragment: keep appending.
     }
-    
-    // Reflect reality on every exit path (the receive-error path above breaks
-    // without clearing this), so Disconnect()'s join completes promptly instead
-    // of timing out and detaching an already-finished thread.
-    receive_thread_running_ = false;
-    Logger::Debug("WebSocket receive thread stopped");
 }
 
 void WebSocketClient::CleanupHandles() {
@@ -469,6 +1464,14 @@ void WebSocketClient::CleanupHandles() {
     }
 }
 
+#else // !_WIN32 — every connection is native; there is no WinHTTP.
+
+bool WebSocketClient::ConnectWinHttp() { return false; }
+void WebSocketClient::WinHttpReceiveLoop() {}
+void WebSocketClient::CleanupHandles() {}
+
+#endif // _WIN32
+
 void WebSocketClient::SetError(const std::string& error) {
     std::lock_guard<std::mutex> lock(error_mutex_);
     last_error_ = error;
@@ -480,46 +1483,4 @@ std::string WebSocketClient::GetLastError() const {
     return last_error_;
 }
 
-#else // !_WIN32 — Linux development build stub (no WinHTTP WebSocket).
-
-WebSocketClient::WebSocketClient()
-    : h_session_(nullptr), h_connection_(nullptr), h_websocket_(nullptr),
-      state_(WebSocketState::DISCONNECTED), port_(0), secure_(false),
-      receive_thread_running_(false) {}
-
-WebSocketClient::~WebSocketClient() {}
-
-bool WebSocketClient::Connect(const std::string& url) {
-    url_ = url;
-    SetError("WebSocket not supported on the Linux development build");
-    return false;
-}
-
-void WebSocketClient::Disconnect() {}
-bool WebSocketClient::IsConnected() const { return false; }
-bool WebSocketClient::SendText(const std::string&) { return false; }
-bool WebSocketClient::SendBinary(const void*, size_t) { return false; }
-void WebSocketClient::Update() {}
-
-std::string WebSocketClient::GetLastError() const {
-    std::lock_guard<std::mutex> lock(error_mutex_);
-    return last_error_;
-}
-
-bool WebSocketClient::ParseUrl(const std::string&) { return false; }
-
-void WebSocketClient::SetError(const std::string& error) {
-    {
-        std::lock_guard<std::mutex> lock(error_mutex_);
-        last_error_ = error;
-    }
-    state_ = WebSocketState::ERROR_STATE;
-}
-
-void WebSocketClient::ReceiveThreadFunction() {}
-void WebSocketClient::CleanupHandles() {}
-
-#endif // _WIN32
-
 } // namespace StayPutVR
-
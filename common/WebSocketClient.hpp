@@ -1,11 +1,17 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <functional>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
+#include <vector>
+#include "WebSocketTransport.hpp"
 #ifdef _WIN32
 #include <Windows.h>
 #include <winhttp.h>
@@ -25,12 +31,33 @@ enum class WebSocketState {
     ERROR_STATE
 };
 
-// Callback types
-using OnMessageCallback = std::function<void(const std::string& message)>;
+// Callback types. The message view is only valid for the duration of the
+// callback: it points into a receive buffer that is reused afterwards.
+using OnMessageCallback = std::function<void(std::string_view message)>;
 using OnConnectedCallback = std::function<void()>;
 using OnDisconnectedCallback = std::function<void(const std::string& reason)>;
 using OnErrorCallback = std::function<void(const std::string& error)>;
 
+// Outgoing message priority. Urgent messages (stop, emergency stop) go out
+// ahead of everything queued and are never dropped or held back.
+enum class SendPriority {
+    Normal,
+    Urgent
+};
+
+// RFC 6455 client. Connections run natively over a socket on every platform:
+// ws:// directly, wss:// through the TLS transport layer (OpenSSL when built
+// with it, or whatever SetTlsTransportFactory() installs). Windows builds
+// without a TLS layer fall back to WinHTTP for wss://.
+//
+// A receive thread assembles each message in place in a reusable buffer and
+// queues it; Update() delivers queued text messages to the message callback
+// on the caller's thread (binary messages are dropped). Pings are answered,
+// idle connections are kept alive with pings of our own, and permessage-
+// deflate is negotiated when built with zlib.
+//
+// Sends are queued and written by a per-connection writer thread, so a slow
+// socket never stalls the caller (often the UI thread).
 class WebSocketClient {
 public:
     WebSocketClient();
@@ -41,61 +68,196 @@ public:
     void Disconnect();
     bool IsConnected() const;
     WebSocketState GetState() const { return state_; }
-    
-    // Send message
-    bool SendText(const std::string& message);
+
+    // Queue a message for the writer thread and return at once. Everything
+    // queued by the time the writer wakes goes out in a single write.
+    //
+    // supersede_key marks updates where only the latest one matters (a
+    // device's intensity). Once the queue is past its high-water mark a new
+    // update replaces a still-queued one with the same key rather than
+    // waiting behind it. An Urgent message discards queued updates with its
+    // key, or every keyed update when it has none (stop all).
+    // Returns false if not connected or the queue is full.
+    bool SendText(std::string_view message, SendPriority priority = SendPriority::Normal,
+                  std::string_view supersede_key = {});
     bool SendBinary(const void* data, size_t length);
-    
-    // Update - call this regularly to process messages
+
+    // Holds the writer back from Normal messages while alive, so a burst
+    // queued in one go (a command per device) leaves in one write. Urgent
+    // messages are not held.
+    class SendBatch {
+    public:
+        explicit SendBatch(WebSocketClient& client);
+        ~SendBatch();
+        SendBatch(const SendBatch&) = delete;
+        SendBatch& operator=(const SendBatch&) = delete;
+    private:
+        WebSocketClient& client_;
+    };
+
+    // Outbound queue counters since construction. Queue time is enqueue to
+    // the start of the write carrying the message; write time is per write.
+    struct SendStats {
+        size_t queued = 0;       // waiting right now
+        size_t peak_queued = 0;
+        uint64_t sent = 0;       // messages written
+        uint64_t writes = 0;     // socket writes they took
+        uint64_t superseded = 0; // updates replaced or cancelled before sending
+        uint64_t rejected = 0;   // refused because the queue was full
+        double avg_queue_ms = 0.0;
+        double max_queue_ms = 0.0;
+        double avg_write_ms = 0.0;
+        double max_write_ms = 0.0;
+    };
+    SendStats GetSendStats() const;
+
+    // Update - call this regularly (from one thread) to process messages
     void Update();
-    
+
     // Callbacks
     void SetOnMessageCallback(OnMessageCallback callback) { on_message_ = callback; }
     void SetOnConnectedCallback(OnConnectedCallback callback) { on_connected_ = callback; }
     void SetOnDisconnectedCallback(OnDisconnectedCallback callback) { on_disconnected_ = callback; }
     void SetOnErrorCallback(OnErrorCallback callback) { on_error_ = callback; }
-    
+
+    // Native connections send a ping after this long without hearing from the
+    // server, and drop the connection if another interval passes in silence.
+    // Zero disables. Takes effect on the next Connect().
+    void SetPingInterval(std::chrono::seconds interval) { ping_interval_ = interval; }
+
+    // Offer permessage-deflate on the next Connect() (on by default; a no-op
+    // in builds without zlib). Only inbound messages are compressed.
+    void SetCompressionEnabled(bool enabled) { compression_offered_ = enabled; }
+    bool IsCompressionActive() const { return deflate_active_; }
+
+    // Replaces the TLS layer used for wss:// by every client from the next
+    // Connect() on. An empty factory disables native wss://.
+    static void SetTlsTransportFactory(TlsTransportFactory factory);
+
     // Get last error
     std::string GetLastError() const;
 
 private:
-    // WebSocket handles
+    struct Inflater;
+
+    // WinHTTP handles (Windows wss:// without a TLS layer)
     HINTERNET h_session_;
     HINTERNET h_connection_;
     HINTERNET h_websocket_;
-    
+
+    // Native connection
+    SOCKET sock_ = INVALID_SOCKET;
+    std::unique_ptr<WebSocketTransport> transport_;
+    std::mutex io_mutex_;    // one transport call at a time (TLS is not full-duplex safe)
+    std::mutex send_mutex_;  // one outgoing write at a time
+    std::string send_frame_; // frame assembly buffer, under send_mutex_
+    uint32_t mask_state_ = 0; // mask key generator, under send_mutex_
+    std::string handshake_leftover_; // frame bytes that arrived with the 101 response
+    size_t leftover_pos_ = 0;
+    std::chrono::seconds ping_interval_{20};
+    std::chrono::steady_clock::time_point last_received_;
+    bool ping_outstanding_ = false;
+    std::atomic<bool> close_sent_{false};
+    bool compression_offered_ = true;
+    std::atomic<bool> deflate_active_{false};
+    bool server_no_context_takeover_ = false;
+    std::unique_ptr<Inflater> inflater_;
+
     // State
     std::atomic<WebSocketState> state_;
     std::string last_error_;
     mutable std::mutex error_mutex_;
-    
+
     // Connection info
     std::string url_;
-    std::wstring host_;
-    std::wstring path_;
+    std::string host_;
+    std::string path_;
     int port_;
     bool secure_;
-    
-    // Message queue for received messages
-    std::queue<std::string> message_queue_;
+    bool native_ = true;
+
+    // Receive-thread buffers: the message being assembled (payload is read
+    // straight into it), the compressed payload of a deflated message, and
+    // the current control frame.
+    std::string message_;
+    std::string compressed_;
+    std::string control_;
+
+    // Complete messages waiting for Update(), and emptied buffers kept for
+    // reuse so steady traffic allocates nothing.
+    std::vector<std::string> inbox_;
+    std::vector<std::string> spare_;
+    size_t spare_bytes_ = 0; // capacity held in spare_
+    std::vector<std::string> delivering_; // Update() only
     std::mutex queue_mutex_;
-    
+
+    // Outbound queue. Urgent messages wait in their own list so they are
+    // always written first; payload buffers are recycled through free_.
+    struct OutboundMessage {
+        std::string payload;
+        std::string key;
+        uint8_t opcode = 0;
+        std::chrono::steady_clock::time_point queued_at;
+    };
+    std::vector<OutboundMessage> out_urgent_;
+    std::vector<OutboundMessage> out_normal_;
+    std::vector<OutboundMessage> out_batch_; // writer thread only
+    std::vector<std::string> free_;
+    int batch_holds_ = 0;
+    bool writer_stop_ = false;
+    bool writer_running_ = false;
+    SendStats send_stats_;
+    double queue_ms_total_ = 0.0;
+    double write_ms_total_ = 0.0;
+    mutable std::mutex out_mutex_;
+    std::condition_variable out_cv_;
+    std::condition_variable writer_exited_;
+    std::thread writer_thread_;
+
     // Callbacks
     OnMessageCallback on_message_;
     OnConnectedCallback on_connected_;
     OnDisconnectedCallback on_disconnected_;
     OnErrorCallback on_error_;
-    
+
     // Background thread for receiving
     std::thread receive_thread_;
     std::atomic<bool> receive_thread_running_;
-    
+    std::atomic<bool> stop_requested_{false};
+    std::mutex exit_mutex_;
+    std::condition_variable receive_thread_exited_;
+
     // Helper methods
     bool ParseUrl(const std::string& url);
     void SetError(const std::string& error);
+    void QueueMessage();
     void ReceiveThreadFunction();
     void CleanupHandles();
+
+    // Outbound queue
+    bool Enqueue(uint8_t opcode, std::string_view payload, SendPriority priority, std::string_view key);
+    void StartWriter();
+    void StopWriter(bool drain);
+    void WriterThreadFunction();
+    bool WriteBatch(uint64_t& writes);
+    void RecyclePayload(std::string& payload); // under out_mutex_
+
+    // Native protocol
+    bool ConnectNative();
+    bool OpenSocket(std::string& error);
+    bool PerformHandshake(std::string& error);
+    void NativeReceiveLoop();
+    enum class ReadResult { Ok, Closed, Stopped, TimedOut, Error };
+    ReadResult ReadExact(char* buffer, size_t length, std::string& error);
+    bool WriteAll(const char* data, size_t length, std::string& error);
+    void AppendFrame(uint8_t opcode, const char* data, size_t length);
+    bool SendFrame(uint8_t opcode, const char* data, size_t length);
+    bool InflateMessage(std::string& error);
+    void CloseNative();
+
+    // WinHTTP
+    bool ConnectWinHttp();
+    void WinHttpReceiveLoop();
 };
 
 } // namespace StayPutVR
-
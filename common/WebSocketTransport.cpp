@@ -0,0 +1,212 @@
+#include "WebSocketTransport.hpp"
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#else
+#include <poll.h>
+#endif
+
+#ifdef STAYPUTVR_WITH_OPENSSL
+#include <csignal>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#endif
+
+namespace StayPutVR {
+
+namespace {
+    bool LastSocketErrorWouldBlock() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    class PlainTransport : public WebSocketTransport {
+    public:
+        explicit PlainTransport(SOCKET sock) : sock_(sock) {}
+
+        IoStatus Read(char* buffer, size_t length, size_t& n) override {
+            const auto got = recv(sock_, buffer, static_cast<int>(length), 0);
+            if (got > 0) {
+                n = static_cast<size_t>(got);
+                return IoStatus::Ok;
+            }
+            if (got == 0) return IoStatus::Closed;
+            if (LastSocketErrorWouldBlock()) return IoStatus::WouldBlock;
+            error_ = "recv failed: " + std::to_string(WSAGetLastError());
+            return IoStatus::Error;
+        }
+
+        IoStatus Write(const char* data, size_t length, size_t& n) override {
+#ifdef MSG_NOSIGNAL
+            const auto sent = send(sock_, data, static_cast<int>(length), MSG_NOSIGNAL);
+#else
+            const auto sent = send(sock_, data, static_cast<int>(length), 0);
+#endif
+            if (sent >= 0) {
+                n = static_cast<size_t>(sent);
+                return IoStatus::Ok;
+            }
+            if (LastSocketErrorWouldBlock()) return IoStatus::WouldBlock;
+            error_ = "send failed: " + std::to_string(WSAGetLastError());
+            return IoStatus::Error;
+        }
+
+        std::string LastError() const override { return error_; }
+
+    private:
+        SOCKET sock_;
+        std::string error_;
+    };
+
+#ifdef STAYPUTVR_WITH_OPENSSL
+    std::string OpenSslErrorString(const char* what) {
+        std::string message = what;
+        const unsigned long code = ERR_get_error();
+        if (code != 0) {
+            char text[256];
+            ERR_error_string_n(code, text, sizeof(text));
+            message += std::string(": ") + text;
+        }
+        ERR_clear_error();
+        return message;
+    }
+
+    // One context for every connection: the system trust store, TLS 1.2+.
+    SSL_CTX* SharedContext() {
+        static SSL_CTX* ctx = [] {
+#ifndef _WIN32
+            // OpenSSL writes with write(), which raises SIGPIPE on a reset
+            // connection; ignore it as cpp-httplib's server does.
+            signal(SIGPIPE, SIG_IGN);
+#endif
+            SSL_CTX* c = SSL_CTX_new(TLS_client_method());
+            if (c) {
+                SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+                SSL_CTX_set_default_verify_paths(c);
+                SSL_CTX_set_verify(c, SSL_VERIFY_PEER, nullptr);
+                // Writes are retried with a buffer that may have moved.
+                SSL_CTX_set_mode(c, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+            }
+            return c;
+        }();
+        return ctx;
+    }
+
+    class OpenSslTransport : public WebSocketTransport {
+    public:
+        explicit OpenSslTransport(SSL* ssl) : ssl_(ssl) {}
+
+        ~OpenSslTransport() override {
+            SSL_shutdown(ssl_); // best effort: the socket is non-blocking
+            SSL_free(ssl_);
+        }
+
+        IoStatus Read(char* buffer, size_t length, size_t& n) override {
+            ERR_clear_error();
+            const int result = SSL_read_ex(ssl_, buffer, length, &n);
+            return result == 1 ? IoStatus::Ok : Status(result, "SSL_read");
+        }
+
+        IoStatus Write(const char* data, size_t length, size_t& n) override {
+            ERR_clear_error();
+            const int result = SSL_write_ex(ssl_, data, length, &n);
+            return result == 1 ? IoStatus::Ok : Status(result, "SSL_write");
+        }
+
+        std::string LastError() const override { return error_; }
+
+    private:
+        IoStatus Status(int result, const char* what) {
+            switch (SSL_get_error(ssl_, result)) {
+            case SSL_ERROR_WANT_READ:
+            case SSL_ERROR_WANT_WRITE:
+                return IoStatus::WouldBlock;
+            case SSL_ERROR_ZERO_RETURN:
+                return IoStatus::Closed;
+            case SSL_ERROR_SYSCALL:
+                if (ERR_peek_error() == 0) {
+                    return IoStatus::Closed; // peer went away without close_notify
+                }
+                [[fallthrough]];
+            default:
+                error_ = OpenSslErrorString(what);
+                return IoStatus::Error;
+            }
+        }
+
+        SSL* ssl_;
+        std::string error_;
+    };
+
+    std::unique_ptr<WebSocketTransport> ConnectOpenSsl(SOCKET sock, const std::string& host,
+                                                       std::chrono::milliseconds timeout, std::string& error) {
+        SSL_CTX* ctx = SharedContext();
+        if (!ctx) {
+            error = OpenSslErrorString("SSL_CTX_new");
+            return nullptr;
+        }
+        SSL* ssl = SSL_new(ctx);
+        if (!ssl) {
+            error = OpenSslErrorString("SSL_new");
+            return nullptr;
+        }
+        SSL_set_fd(ssl, static_cast<int>(sock));
+        SSL_set_tlsext_host_name(ssl, host.c_str()); // SNI
+        SSL_set1_host(ssl, host.c_str());            // certificate name check
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        for (;;) {
+            ERR_clear_error();
+            const int result = SSL_connect(ssl);
+            if (result == 1) break;
+            const int reason = SSL_get_error(ssl, result);
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if ((reason == SSL_ERROR_WANT_READ || reason == SSL_ERROR_WANT_WRITE) && left > 0) {
+                WaitForSocket(sock, reason == SSL_ERROR_WANT_WRITE, static_cast<int>(left));
+                continue;
+            }
+            if (left <= 0) {
+                error = "TLS handshake with " + host + " timed out";
+            } else if (SSL_get_verify_result(ssl) != X509_V_OK) {
+                error = std::string("TLS certificate verification failed: ") +
+                        X509_verify_cert_error_string(SSL_get_verify_result(ssl));
+                ERR_clear_error();
+            } else {
+                error = OpenSslErrorString("TLS handshake failed");
+            }
+            SSL_free(ssl);
+            return nullptr;
+        }
+        return std::make_unique<OpenSslTransport>(ssl);
+    }
+#endif
+} // namespace
+
+std::unique_ptr<WebSocketTransport> MakePlainTransport(SOCKET sock) {
+    return std::make_unique<PlainTransport>(sock);
+}
+
+TlsTransportFactory DefaultTlsTransportFactory() {
+#ifdef STAYPUTVR_WITH_OPENSSL
+    return ConnectOpenSsl;
+#else
+    return nullptr;
+#endif
+}
+
+bool WaitForSocket(SOCKET sock, bool for_write, int timeout_ms) {
+#ifdef _WIN32
+    WSAPOLLFD pfd{sock, static_cast<SHORT>(for_write ? POLLWRNORM : POLLRDNORM), 0};
+    return WSAPoll(&pfd, 1, timeout_ms) > 0;
+#else
+    pollfd pfd{sock, static_cast<short>(for_write ? POLLOUT : POLLIN), 0};
+    return poll(&pfd, 1, timeout_ms) > 0;
+#endif
+}
+
+} // namespace StayPutVR
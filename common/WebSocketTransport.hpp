@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#else
+#include "WinsockCompat.hpp"
+#endif
+
+namespace StayPutVR {
+
+// The byte stream under a native WebSocketClient connection: the socket
+// itself for ws://, a TLS session over it for wss://. The client gives it a
+// connected non-blocking socket (which the client owns and closes) and makes
+// one Read or Write call at a time, so implementations need no locking.
+class WebSocketTransport {
+public:
+    enum class IoStatus {
+        Ok,         // n > 0 bytes moved
+        WouldBlock, // wait for the socket and retry
+        Closed,     // orderly end of stream
+        Error       // see LastError()
+    };
+
+    virtual ~WebSocketTransport() = default;
+
+    virtual IoStatus Read(char* buffer, size_t length, size_t& n) = 0;
+    virtual IoStatus Write(const char* data, size_t length, size_t& n) = 0;
+    virtual std::string LastError() const = 0;
+};
+
+// Wraps a connected socket for wss://, running the TLS handshake (verifying
+// the certificate against host) within timeout. Returns nullptr and sets
+// error on failure.
+using TlsTransportFactory = std::function<std::unique_ptr<WebSocketTransport>(
+    SOCKET sock, const std::string& host, std::chrono::milliseconds timeout, std::string& error)>;
+
+std::unique_ptr<WebSocketTransport> MakePlainTransport(SOCKET sock);
+
+// The built-in TLS layer: OpenSSL in builds with STAYPUTVR_WITH_OPENSSL,
+// otherwise an empty factory (no native wss://).
+TlsTransportFactory DefaultTlsTransportFactory();
+
+// Waits up to timeout_ms for sock to become readable (or writable). Returns
+// false on timeout; errors and hang-ups count as ready, so the next I/O call
+// reports them.
+bool WaitForSocket(SOCKET sock, bool for_write, int timeout_ms);
+
+} // namespace StayPutVR
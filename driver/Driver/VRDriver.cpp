@@ -1,5 +1,6 @@
 #include "VRDriver.hpp"
 #include "../../../common/Logger.hpp"
+#include "../../../common/TriggerTrace.hpp"
 #include "../IPC/IPCServer.hpp"
 
 // Define the global variable
@@ -231,14 +232,14 @@ void StayPutVR::VRDriver::Cleanup()
 void StayPutVR::VRDriver::RunFrame()
 {
     try {
-        // Collect events
+        // Collect events straight into the member so its capacity is reused
+        // frame to frame (no per-frame vector allocation).
         vr::VREvent_t event;
-        std::vector<vr::VREvent_t> events;
+        this->openvr_events_.clear();
         while (vr::VRServerDriverHost()->PollNextEvent(&event, sizeof(event)))
         {
-            events.push_back(event);
+            this->openvr_events_.push_back(event);
         }
-        this->openvr_events_ = events;
 
         // Update frame timing
         std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
@@ -254,7 +255,9 @@ void StayPutVR::VRDriver::RunFrame()
         // Lazy initialization: Only initialize IPC when we have data to send
         // This prevents aggressive connection attempts when no companion app is available
         
-        // Collect device positions from all tracked devices
+        // Collect device positions from all tracked devices. Stamp the sample
+        // time first so the trace's Sample stage covers the pose fetch.
+        const int64_t sample_time_us = TraceNowUs();
         auto tracked_devices = GetAllTrackedDeviceInfo();
         
         // Only attempt IPC operations if we have devices to send
@@ -278,6 +281,7 @@ void StayPutVR::VRDriver::RunFrame()
                     pos_data.rotation[3] = device.pose.qRotation.w;
                     
                     pos_data.connected = device.pose.deviceIsConnected;
+                    pos_data.sample_time_us = sample_time_us;
                     
                     device_positions.push_back(pos_data);
                 }
@@ -183,6 +183,13 @@ namespace StayPutVR {
                 uint8_t connectedFlag = device.connected ? 1 : 0;
                 buffer.push_back(connectedFlag);
             }
+
+            // Trailer: pose sample time (steady_clock us) for latency tracing.
+            // Appended after the device list so older apps, which stop parsing
+            // after the last device, simply ignore it. 0 (untimed) for an empty list.
+            int64_t sampleTimeUs = devices.empty() ? 0 : devices.front().sample_time_us;
+            buffer.insert(buffer.end(), reinterpret_cast<uint8_t*>(&sampleTimeUs),
+                         reinterpret_cast<uint8_t*>(&sampleTimeUs) + sizeof(sampleTimeUs));
             
             // Send the message
             WriteMessageAsync(buffer);
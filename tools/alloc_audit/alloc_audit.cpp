@@ -0,0 +1,219 @@
+// Steady-state allocation audit.
+//
+// Runs a stand-in for the app's frame loop with no driver, sockets or window:
+//   - a device update for 16 trackers through UIManager::UpdateDevicePositions
+//     (what IPCClient delivers every driver frame),
+//   - a burst of VRChat-style OSC traffic (a face-tracking bundle plus SPVR_
+//     and avatar parameters) through OSCManager::ProcessOSCMessage,
+//   - one Status-tab UI frame on a headless ImGui context.
+// After a warm-up it counts allocations per frame for each AllocTag (requires
+// a STAYPUTVR_ALLOC_AUDIT build) and compares them against alloc_budget.txt.
+// Exit status is 1 if any subsystem allocates more per frame than its budget,
+// so the budget file acts as a ratchet: lower it whenever a hot path is fixed.
+//
+// Usage: stayputvr_alloc_audit [budget_file]
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../application/src/ui/UIManager.hpp"
+#include "../../common/AllocationCounter.hpp"
+#include "../../common/Logger.hpp"
+#include "../../common/OSCManager.hpp"
+#include "../common/HeadlessImGui.hpp"
+
+#ifndef STAYPUTVR_ALLOC_AUDIT_BUDGET
+#define STAYPUTVR_ALLOC_AUDIT_BUDGET "alloc_budget.txt"
+#endif
+
+// main.cpp owns this in the app; UIManager references it.
+std::atomic<bool> g_running = true;
+
+namespace StayPutVR {
+
+    class AllocationAudit {
+    public:
+        static constexpr int kDevices = 16;
+        static constexpr int kWarmupFrames = 120;
+        static constexpr int kFrames = 600;
+        static constexpr int kTagCount = static_cast<int>(AllocTag::Count);
+
+        void Setup() {
+            CreateHeadlessImGuiContext();
+
+            // Never Initialize()d and deliberately leaked, as in ui_bench: the
+            // destructor would save the config over the user's real one.
+            ui_ = new UIManager();
+            ui_->effigy_load_attempted_ = true;
+            ui_->vrcft_logos_load_attempted_ = true;
+
+            for (int i = 0; i < kDevices; ++i) {
+                DevicePositionData d{};
+                d.type = i == 0 ? DeviceType::HMD : (i < 3 ? DeviceType::CONTROLLER : DeviceType::TRACKER);
+                d.serial = "LHR-AUDIT" + std::to_string(10000 + i);
+                d.position[1] = 1.0f;
+                d.rotation[3] = 1.0f;
+                d.connected = true;
+                devices_.push_back(d);
+            }
+
+            // Registered once, so dispatch exercises the callback branches.
+            OSCManager& osc = OSCManager::GetInstance();
+            osc.SetConfig(ui_->config_);
+            osc.SetLockCallback([](OSCDeviceType, bool) {});
+            osc.SetIncludeCallback([](OSCDeviceType, bool) {});
+            osc.SetCollarToggleCallback([](bool) {});
+
+            BuildOscTraffic();
+        }
+
+        void Frame(int frame) {
+            // IPC stand-in: the device update the client would hand over.
+            const float d = (frame & 1) ? 0.0005f : -0.0005f;
+            for (auto& dev : devices_) dev.position[0] += d;
+            ui_->UpdateDevicePositions(devices_);
+
+            OSCManager& osc = OSCManager::GetInstance();
+            for (const auto& packet : osc_packets_) {
+                osc.ProcessOSCMessage(packet.data(), packet.size());
+            }
+
+            {
+                AllocationScope alloc_scope(AllocTag::UI);
+                HeadlessFrame([this] { ui_->RenderMainTab(); });
+            }
+            ServiceHeadlessTextures();
+        }
+
+        // Allocations per steady-state frame, per tag.
+        std::array<double, kTagCount> Run() {
+            for (int i = 0; i < kWarmupFrames; ++i) Frame(i);
+
+            std::array<uint64_t, kTagCount> before{};
+            for (int t = 0; t < kTagCount; ++t) before[t] = AllocationCounter::TagAllocations(static_cast<AllocTag>(t));
+            for (int i = 0; i < kFrames; ++i) Frame(kWarmupFrames + i);
+
+            std::array<double, kTagCount> per_frame{};
+            for (int t = 0; t < kTagCount; ++t) {
+                per_frame[t] = static_cast<double>(
+                    AllocationCounter::TagAllocations(static_cast<AllocTag>(t)) - before[t]) / kFrames;
+            }
+            return per_frame;
+        }
+
+    private:
+        using Packet = std::vector<char>;
+
+        void AddFloat(const char* address, float value) {
+            Packet buf(256);
+            OSCPP::Client::Packet p(buf.data(), buf.size());
+            p.openMessage(address, 1).float32(value).closeMessage();
+            buf.resize(p.size());
+            osc_packets_.push_back(std::move(buf));
+        }
+
+        // oscpp has no T/F writer; the receiver treats int32 0/1 the same.
+        void AddBool(const char* address, bool value) {
+            Packet buf(256);
+            OSCPP::Client::Packet p(buf.data(), buf.size());
+            p.openMessage(address, 1).int32(value ? 1 : 0).closeMessage();
+            buf.resize(p.size());
+            osc_packets_.push_back(std::move(buf));
+        }
+
+        void BuildOscTraffic() {
+            // Face-tracking bundle, as VRChat batches high-rate params.
+            {
+                Packet buf(1024);
+                OSCPP::Client::Packet p(buf.data(), buf.size());
+                p.openBundle(1);
+                for (const char* addr : { "/avatar/parameters/FT/v2/JawOpen",
+                                          "/avatar/parameters/FT/v2/MouthClosed",
+                                          "/avatar/parameters/FT/v2/EyeLidLeft",
+                                          "/avatar/parameters/FT/v2/EyeLidRight" }) {
+                    p.openMessage(addr, 1).float32(0.25f).closeMessage();
+                }
+                p.closeBundle();
+                buf.resize(p.size());
+                osc_packets_.push_back(std::move(buf));
+            }
+            AddFloat("/avatar/parameters/VelocityX", 0.1f);
+            AddFloat("/avatar/parameters/VelocityZ", 0.2f);
+            AddFloat("/avatar/parameters/SPVR_JawOpen", 0.3f);
+            AddBool("/avatar/parameters/SPVR_HMD_Latch_IsPosed", false);
+            AddBool("/avatar/parameters/SPVR_Collar_ToggleButton", false);
+        }
+
+        UIManager* ui_ = nullptr;
+        std::vector<DevicePositionData> devices_;
+        std::vector<Packet> osc_packets_;
+    };
+
+    // "Tag allowed_allocs_per_frame" per line; '#' comments. Unlisted tags
+    // have a budget of 0.
+    static bool LoadBudget(const std::string& path, std::map<std::string, double>& budget) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream ss(line);
+            std::string tag;
+            double allowed = 0.0;
+            if (ss >> tag >> allowed) budget[tag] = allowed;
+        }
+        return true;
+    }
+
+} // namespace StayPutVR
+
+int main(int argc, char** argv) {
+    using namespace StayPutVR;
+
+    if (!AllocationCounter::TaggingEnabled()) {
+        std::fprintf(stderr, "alloc_audit: build with -DSTAYPUTVR_ALLOC_AUDIT=ON to enable per-subsystem counters\n");
+        return 2;
+    }
+
+    const std::string budget_path = argc > 1 ? argv[1] : STAYPUTVR_ALLOC_AUDIT_BUDGET;
+    std::map<std::string, double> budget;
+    if (!LoadBudget(budget_path, budget)) {
+        std::fprintf(stderr, "alloc_audit: cannot read budget file %s\n", budget_path.c_str());
+        return 2;
+    }
+
+    Logger::SetLogLevel(Logger::LogLevel::E_ERROR);
+
+    AllocationAudit audit;
+    audit.Setup();
+    const auto per_frame = audit.Run();
+
+    bool failed = false;
+    std::printf("%-10s %14s %10s\n", "Subsystem", "allocs/frame", "budget");
+    for (int t = 0; t < AllocationAudit::kTagCount; ++t) {
+        const char* name = ToString(static_cast<AllocTag>(t));
+        const double allowed = budget.count(name) ? budget[name] : 0.0;
+        const double measured = per_frame[t];
+        const char* verdict = "";
+        if (measured > allowed + 1e-9) {
+            verdict = "  FAIL";
+            failed = true;
+        } else if (measured < allowed) {
+            verdict = "  (under budget: lower it)";
+        }
+        std::printf("%-10s %14.2f %10.2f%s\n", name, measured, allowed, verdict);
+    }
+
+    if (failed) {
+        std::printf("\nalloc_audit: steady-state frames allocate more than %s allows\n", budget_path.c_str());
+        return 1;
+    }
+    std::printf("\nalloc_audit: OK\n");
+    return 0;
+}
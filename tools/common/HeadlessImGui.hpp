@@ -0,0 +1,69 @@
+#pragma once
+
+#include "imgui.h"
+
+// Shared by the headless tools (ui_bench, alloc_audit): an ImGui context with
+// no platform/renderer backend. The "renderer" only acknowledges ImGui's
+// texture requests and drops the draw lists, so the UI code runs exactly as
+// in the app minus the GPU work.
+
+namespace StayPutVR {
+
+    inline void CreateHeadlessImGuiContext(float width = 800.0f, float height = 850.0f) {
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(width, height);
+        io.DeltaTime = 1.0f / 60.0f;
+        io.IniFilename = nullptr;
+        io.LogFilename = nullptr;
+        // We service texture requests ourselves (ServiceHeadlessTextures), so
+        // the atlas is built lazily exactly as it is with the GL backend.
+        io.BackendRendererName = "null";
+        io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    }
+
+    // Call after ImGui::Render(): acknowledge texture create/update/destroy
+    // requests so ImGui's font atlas bookkeeping behaves as with a real backend.
+    inline void ServiceHeadlessTextures() {
+        for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+            switch (tex->Status) {
+                case ImTextureStatus_WantCreate:
+                    tex->SetTexID(static_cast<ImTextureID>(1));
+                    tex->SetStatus(ImTextureStatus_OK);
+                    break;
+                case ImTextureStatus_WantUpdates:
+                    tex->SetStatus(ImTextureStatus_OK);
+                    break;
+                case ImTextureStatus_WantDestroy:
+                    if (tex->UnusedFrames > 0) {
+                        tex->SetTexID(ImTextureID_Invalid);
+                        tex->SetStatus(ImTextureStatus_Destroyed);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // One frame of the main window with `render_body` drawing its contents,
+    // using the same window setup as UIManager::RenderMainWindow.
+    template <typename Fn>
+    void HeadlessFrame(Fn&& render_body) {
+        ImGui::NewFrame();
+        const ImGuiViewport* viewport = ImGui::GetMainViewport();
+        ImGui::SetNextWindowPos(viewport->WorkPos);
+        ImGui::SetNextWindowSize(viewport->WorkSize);
+        ImGui::Begin("StayPutVR Control Panel", nullptr,
+            ImGuiWindowFlags_NoDecoration |
+            ImGuiWindowFlags_NoMove |
+            ImGuiWindowFlags_NoResize |
+            ImGuiWindowFlags_NoSavedSettings |
+            ImGuiWindowFlags_AlwaysVerticalScrollbar);
+        render_body();
+        ImGui::End();
+        ImGui::Render();
+    }
+
+} // namespace StayPutVR
@@ -0,0 +1,166 @@
+// Cold vs warm HttpClient command latency against a loopback HTTP server.
+//
+// A local cpp-httplib server stands in for the OpenShock API
+// (POST /1/shockers/control). Each command is sent with
+// SendOpenShockCommand(), exactly as OpenShockManager sends it:
+//
+// 1. Cold: the pool is emptied before every command, so each one connects
+//    first -- what every command paid before connections were pooled.
+// 2. Prewarmed: the pool is emptied, PrewarmConnection() runs (as it does
+//    when a lock engages), then one command is timed.
+// 3. Warm: back-to-back commands on the pooled keep-alive connection.
+//
+// Loopback TCP setup is only tens of microseconds; a real link pays DNS, the
+// TCP handshake and a TLS handshake (several round trips). handshake_ms
+// stands in for that: the server stalls the first request on each new
+// connection by that long. (httplib's server closes a connection after 100
+// requests, so long warm runs show the odd reconnect.)
+//
+// With a non-zero stall the bench exits non-zero unless the prewarmed p50 beats
+// the cold p50. With 0 the phases only differ by loopback setup and scheduling
+// noise, so nothing is checked.
+//
+// Usage: stayputvr_http_latency_bench [commands] [handshake_ms]   (default 200, 30)
+
+#include "../../common/HttpLib.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../common/HttpClient.hpp"
+#include "../../common/Logger.hpp"
+
+using namespace StayPutVR;
+using Clock = std::chrono::steady_clock;
+
+// Counts connections by client port; the first request on each is stalled.
+class FakeOpenShockServer {
+public:
+    bool Start(int handshake_ms) {
+        server_.set_pre_routing_handler([this, handshake_ms](const httplib::Request& req, httplib::Response&) {
+            bool first;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                first = ports_.insert(req.remote_port).second;
+            }
+            if (first && handshake_ms > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(handshake_ms));
+            }
+            return httplib::Server::HandlerResponse::Unhandled;
+        });
+        server_.Post("/1/shockers/control", [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(R"({"message":"Successfully sent control messages"})", "application/json");
+        });
+        server_.Get("/", [](const httplib::Request&, httplib::Response&) {}); // also answers HEAD
+        port_ = server_.bind_to_any_port("127.0.0.1");
+        if (port_ <= 0) return false;
+        thread_ = std::thread([this] { server_.listen_after_bind(); });
+        server_.wait_until_ready();
+        return true;
+    }
+
+    void Stop() {
+        server_.stop();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    std::string Url() const { return "http://127.0.0.1:" + std::to_string(port_); }
+
+    size_t Connections() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ports_.size();
+    }
+
+private:
+    httplib::Server server_;
+    std::thread thread_;
+    int port_ = 0;
+    std::mutex mutex_;
+    std::set<int> ports_;
+};
+
+static bool SendCommand(const std::string& url) {
+    std::string response;
+    return SendOpenShockCommand(url, "bench-token", "bench-shocker", 1, 10, 300, response);
+}
+
+// Prints the phase's percentiles and returns its p50 in microseconds.
+static double Report(const char* name, std::vector<double> micros, size_t connections) {
+    std::sort(micros.begin(), micros.end());
+    const auto at = [&](double q) { return micros[static_cast<size_t>(q * (micros.size() - 1))]; };
+    std::printf("%-12s %6zu cmds %9.1f us p50 %9.1f us p99 %9.1f us max %6zu connections\n",
+                name, micros.size(), at(0.5), at(0.99), micros.back(), connections);
+    return at(0.5);
+}
+
+int main(int argc, char** argv) {
+    const int commands = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+    const int handshake_ms = argc > 2 ? std::max(0, std::atoi(argv[2])) : 30;
+
+    Logger::SetLogLevel(Logger::LogLevel::E_ERROR);
+    HttpClient::Initialize();
+
+    FakeOpenShockServer server;
+    if (!server.Start(handshake_ms)) {
+        std::fprintf(stderr, "failed to start loopback server\n");
+        return 1;
+    }
+    const std::string url = server.Url();
+    std::printf("%d commands per phase, simulated handshake %d ms, server %s\n\n",
+                commands, handshake_ms, url.c_str());
+
+    const auto timed = [&](std::vector<double>& out) {
+        const Clock::time_point start = Clock::now();
+        if (!SendCommand(url)) {
+            std::fprintf(stderr, "command failed\n");
+            std::exit(1);
+        }
+        out.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    };
+
+    std::vector<double> cold;
+    size_t before = server.Connections();
+    for (int i = 0; i < commands; ++i) {
+        HttpClient::CloseIdleConnections();
+        timed(cold);
+    }
+    const double cold_p50 = Report("cold", cold, server.Connections() - before);
+
+    // Prewarming is asynchronous; the lock-to-violation gap is seconds, so
+    // give it ample time before the command.
+    std::vector<double> prewarmed;
+    before = server.Connections();
+    for (int i = 0; i < std::min(commands, 50); ++i) {
+        HttpClient::CloseIdleConnections();
+        HttpClient::PrewarmConnection(url);
+        std::this_thread::sleep_for(std::chrono::milliseconds(handshake_ms + 20));
+        timed(prewarmed);
+    }
+    const double prewarmed_p50 = Report("prewarmed", prewarmed, server.Connections() - before);
+
+    std::vector<double> warm;
+    SendCommand(url);
+    before = server.Connections();
+    for (int i = 0; i < commands; ++i) {
+        timed(warm);
+    }
+    Report("warm", warm, server.Connections() - before);
+
+    HttpClient::Shutdown();
+    server.Stop();
+
+    if (handshake_ms > 0 && prewarmed_p50 >= cold_p50) {
+        std::fprintf(stderr, "\nFAIL: prewarmed p50 (%.1f us) is not below cold p50 (%.1f us)\n",
+                     prewarmed_p50, cold_p50);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,344 @@
+// Field extraction from integration messages: nlohmann::json DOM parsing (what
+// the handlers used to do) against JsonView, over message corpora for each
+// service in corpus/ -- one message per line, in the proportions a session
+// produces (mostly acks, pongs and keepalives).
+//
+// Each extractor reads the fields its handler reads:
+//   pishock_ws       IsError, Message (PONG / publish ack / other)
+//   buttplug         per message: Ok Id, ServerInfo, device lists with their
+//                    vibrate actuators, DeviceRemoved, Error
+//   twitch_eventsub  message_type, subscription_type and the event fields
+//   http_responses   PiShock UserId, Twitch token/validate/users responses
+// Both extractors must agree on every message before anything is timed.
+// Allocations are process-wide per message, after a warm-up pass.
+//
+// Usage: stayputvr_json_extract_bench [messages_per_corpus] [corpus_dir]
+//        (default 200000, the corpus directory next to this file)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "../../common/AllocationCounter.hpp"
+#include "../../common/JsonView.hpp"
+
+#ifndef STAYPUTVR_JSON_CORPUS_DIR
+#define STAYPUTVR_JSON_CORPUS_DIR "corpus"
+#endif
+
+using namespace StayPutVR;
+using Clock = std::chrono::steady_clock;
+using json = nlohmann::json;
+
+// What an extractor pulled out of one message; reused across messages.
+struct Fields {
+    int kind = 0; // -1: did not parse
+    int64_t a = 0;
+    int64_t b = 0;
+    bool flag = false;
+    int count = 0;
+    std::string text1;
+    std::string text2;
+
+    void Reset() {
+        kind = 0;
+        a = b = 0;
+        flag = false;
+        count = 0;
+        text1.clear();
+        text2.clear();
+    }
+
+    bool operator==(const Fields& other) const {
+        return kind == other.kind && a == other.a && b == other.b && flag == other.flag &&
+               count == other.count && text1 == other.text1 && text2 == other.text2;
+    }
+};
+
+using Extractor = std::function<void(std::string_view, Fields&)>;
+
+// --- PiShock WebSocket -------------------------------------------------------
+
+static void PiShockDom(std::string_view message, Fields& f) {
+    const json r = json::parse(message, nullptr, false);
+    if (r.is_discarded()) { f.kind = -1; return; }
+    if (r.contains("IsError") && r["IsError"].is_boolean() && r["IsError"].get<bool>()) {
+        f.kind = 1;
+        f.text1 = r.contains("Message") && r["Message"].is_string() ? r["Message"].get<std::string>() : "Unknown error";
+    } else if (r.contains("Message") && r["Message"].is_string()) {
+        const std::string msg = r["Message"].get<std::string>();
+        if (msg == "PONG") f.kind = 2;
+        else if (msg == "Publish successful.") f.kind = 3;
+        else { f.kind = 4; f.text1 = msg; }
+    }
+}
+
+static void PiShockView(std::string_view message, Fields& f) {
+    const JsonView r = JsonView::Parse(message);
+    if (!r) { f.kind = -1; return; }
+    if (r["IsError"].AsBool()) {
+        f.kind = 1;
+        if (!r["Message"].GetString(f.text1)) f.text1 = "Unknown error";
+    } else if (const JsonView msg = r["Message"]; msg.IsString()) {
+        if (msg.Equals("PONG")) f.kind = 2;
+        else if (msg.Equals("Publish successful.")) f.kind = 3;
+        else { f.kind = 4; msg.GetString(f.text1); }
+    }
+}
+
+// --- Buttplug ----------------------------------------------------------------
+
+static void ButtplugDeviceDom(const json& device, Fields& f) {
+    ++f.count;
+    f.text1 = device.value("DeviceName", "Unknown");
+    if (device.contains("DeviceMessages") && device["DeviceMessages"].contains("ScalarCmd") &&
+        device["DeviceMessages"]["ScalarCmd"].is_array()) {
+        for (const auto& actuator : device["DeviceMessages"]["ScalarCmd"]) {
+            if (actuator.value("ActuatorType", "") == "Vibrate") ++f.b;
+        }
+    }
+}
+
+static void ButtplugDom(std::string_view message, Fields& f) {
+    const json j = json::parse(message, nullptr, false);
+    if (j.is_discarded()) { f.kind = -1; return; }
+    if (!j.is_array()) return;
+    for (const auto& msg : j) {
+        if (msg.contains("Ok")) {
+            f.kind |= 1;
+            f.a += msg["Ok"].value("Id", 0);
+        } else if (msg.contains("ServerInfo")) {
+            f.kind |= 2;
+            f.text2 = msg["ServerInfo"].value("ServerName", "Unknown");
+            f.a += msg["ServerInfo"].value("MessageVersion", 0);
+        } else if (msg.contains("DeviceList")) {
+            f.kind |= 4;
+            for (const auto& device : msg["DeviceList"]["Devices"]) ButtplugDeviceDom(device, f);
+        } else if (msg.contains("DeviceAdded")) {
+            f.kind |= 8;
+            ButtplugDeviceDom(msg["DeviceAdded"], f);
+        } else if (msg.contains("DeviceRemoved")) {
+            f.kind |= 16;
+            f.a += msg["DeviceRemoved"].value("DeviceIndex", -1);
+        } else if (msg.contains("Error")) {
+            f.kind |= 32;
+            f.a += msg["Error"].value("Id", 0);
+            f.b += msg["Error"].value("ErrorCode", 0);
+            f.text2 = msg["Error"].value("ErrorMessage", "Unknown error");
+        }
+    }
+}
+
+static void ButtplugDeviceView(const JsonView& device, Fields& f) {
+    ++f.count;
+    if (!device["DeviceName"].GetString(f.text1)) f.text1 = "Unknown";
+    device["DeviceMessages"]["ScalarCmd"].ForEach([&f](const JsonView& actuator) {
+        if (actuator["ActuatorType"].Equals("Vibrate")) ++f.b;
+    });
+}
+
+static void ButtplugView(std::string_view message, Fields& f) {
+    const JsonView j = JsonView::Parse(message);
+    if (!j) { f.kind = -1; return; }
+    j.ForEach([&f](const JsonView& msg) {
+        msg.ForEachMember([&f](std::string_view type, const JsonView& body) {
+            if (type == "Ok") {
+                f.kind |= 1;
+                f.a += body["Id"].AsInt(0);
+            } else if (type == "ServerInfo") {
+                f.kind |= 2;
+                if (!body["ServerName"].GetString(f.text2)) f.text2 = "Unknown";
+                f.a += body["MessageVersion"].AsInt(0);
+            } else if (type == "DeviceList") {
+                f.kind |= 4;
+                body["Devices"].ForEach([&f](const JsonView& device) { ButtplugDeviceView(device, f); });
+            } else if (type == "DeviceAdded") {
+                f.kind |= 8;
+                ButtplugDeviceView(body, f);
+            } else if (type == "DeviceRemoved") {
+                f.kind |= 16;
+                f.a += body["DeviceIndex"].AsInt(-1);
+            } else if (type == "Error") {
+                f.kind |= 32;
+                f.a += body["Id"].AsInt(0);
+                f.b += body["ErrorCode"].AsInt(0);
+                if (!body["ErrorMessage"].GetString(f.text2)) f.text2 = "Unknown error";
+            }
+        });
+    });
+}
+
+// --- Twitch EventSub ---------------------------------------------------------
+
+static void TwitchDom(std::string_view message, Fields& f) {
+    const json j = json::parse(message, nullptr, false);
+    if (j.is_discarded()) { f.kind = -1; return; }
+    if (!j.contains("metadata") || !j.contains("payload")) return;
+    if (j["metadata"].value("message_type", "") != "notification") return;
+    f.kind = 1;
+    f.text1 = j["metadata"].value("subscription_type", "");
+    if (!j["payload"].contains("event")) return;
+    const json& event = j["payload"]["event"];
+    f.text2 = event.value("user_name", "");
+    if (f.text1 == "channel.cheer") {
+        f.a = event.value("bits", 0);
+    } else if (f.text1 == "channel.subscribe" || f.text1 == "channel.subscription.gift") {
+        f.a = event.value("cumulative_months", 1);
+        f.flag = event.value("is_gift", false);
+    } else if (event.contains("reward") && event["reward"].contains("cost")) {
+        f.b = event["reward"]["cost"].get<int>();
+    }
+}
+
+static void TwitchView(std::string_view message, Fields& f) {
+    const JsonView j = JsonView::Parse(message);
+    if (!j) { f.kind = -1; return; }
+    const JsonView metadata = j["metadata"];
+    const JsonView payload = j["payload"];
+    if (!metadata || !payload) return;
+    if (!metadata["message_type"].Equals("notification")) return;
+    f.kind = 1;
+    metadata["subscription_type"].GetString(f.text1);
+    const JsonView event = payload["event"];
+    if (!event) return;
+    event["user_name"].GetString(f.text2);
+    if (f.text1 == "channel.cheer") {
+        f.a = event["bits"].AsInt(0);
+    } else if (f.text1 == "channel.subscribe" || f.text1 == "channel.subscription.gift") {
+        f.a = event["cumulative_months"].AsInt(1);
+        f.flag = event["is_gift"].AsBool(false);
+    } else if (const JsonView cost = event["reward"]["cost"]; cost.IsNumber()) {
+        f.b = cost.AsInt();
+    }
+}
+
+// --- HTTP responses ----------------------------------------------------------
+
+static void HttpDom(std::string_view message, Fields& f) {
+    const json j = json::parse(message, nullptr, false);
+    if (j.is_discarded()) { f.kind = -1; return; }
+    if (j.contains("UserId") && j["UserId"].is_number()) f.a = j["UserId"].get<int64_t>();
+    if (j.contains("access_token") && j["access_token"].is_string()) {
+        f.text1 = j["access_token"].get<std::string>();
+        f.b = j.value("expires_in", 3600);
+    }
+    if (j.contains("scopes") && j["scopes"].is_array()) {
+        for (const auto& scope : j["scopes"]) {
+            ++f.count;
+            f.flag = f.flag || scope == "chat:read";
+        }
+    }
+    if (j.contains("data") && j["data"].is_array() && !j["data"].empty()) {
+        f.text2 = j["data"][0].value("id", "");
+    }
+}
+
+static void HttpView(std::string_view message, Fields& f) {
+    const JsonView j = JsonView::Parse(message);
+    if (!j) { f.kind = -1; return; }
+    if (const JsonView user_id = j["UserId"]; user_id.IsNumber()) f.a = user_id.AsInt();
+    if (j["access_token"].GetString(f.text1)) {
+        f.b = j["expires_in"].AsInt(3600);
+    }
+    j["scopes"].ForEach([&f](const JsonView& scope) {
+        ++f.count;
+        f.flag = f.flag || scope.Equals("chat:read");
+    });
+    j["data"].At(0)["id"].GetString(f.text2);
+}
+
+// -----------------------------------------------------------------------------
+
+struct Result {
+    double ns_per_message = 0.0;
+    double allocations_per_message = 0.0;
+};
+
+static Result Time(const std::vector<std::string>& corpus, const Extractor& extract, int messages) {
+    Fields fields;
+    int64_t sink = 0;
+    for (const auto& message : corpus) { fields.Reset(); extract(message, fields); } // warm-up
+
+    const int rounds = std::max<int>(1, messages / static_cast<int>(corpus.size()));
+    const uint64_t allocations_before = AllocationCounter::TotalAllocations();
+    const Clock::time_point start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto& message : corpus) {
+            fields.Reset();
+            extract(message, fields);
+            sink += fields.a + fields.kind;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const uint64_t allocations = AllocationCounter::TotalAllocations() - allocations_before;
+    if (sink == 42) std::printf(" "); // keep the work observable
+
+    const double total = static_cast<double>(rounds) * corpus.size();
+    return {seconds * 1e9 / total, allocations / total};
+}
+
+int main(int argc, char** argv) {
+    const int messages = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+    const std::string corpus_dir = argc > 2 ? argv[2] : STAYPUTVR_JSON_CORPUS_DIR;
+
+    struct Corpus {
+        const char* name;
+        Extractor dom;
+        Extractor view;
+    };
+    const Corpus corpora[] = {
+        {"pishock_ws", PiShockDom, PiShockView},
+        {"buttplug", ButtplugDom, ButtplugView},
+        {"twitch_eventsub", TwitchDom, TwitchView},
+        {"http_responses", HttpDom, HttpView},
+    };
+
+    int failures = 0;
+    std::printf("%-16s %5s %14s %14s %14s %14s %8s\n", "corpus", "msgs", "DOM ns/msg", "DOM allocs", "view ns/msg",
+                "view allocs", "speedup");
+    for (const Corpus& corpus : corpora) {
+        std::vector<std::string> lines;
+        std::ifstream in(corpus_dir + "/" + corpus.name + ".jsonl");
+        for (std::string line; std::getline(in, line);) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) lines.push_back(line);
+        }
+        if (lines.empty()) {
+            std::printf("%-16s FAIL: no messages in %s/%s.jsonl\n", corpus.name, corpus_dir.c_str(), corpus.name);
+            ++failures;
+            continue;
+        }
+
+        bool agree = true;
+        for (const auto& line : lines) {
+            Fields dom, view;
+            corpus.dom(line, dom);
+            corpus.view(line, view);
+            if (!(dom == view) || dom.kind < 0) {
+                std::printf("%-16s FAIL: extractors disagree on %s\n", corpus.name, line.c_str());
+                agree = false;
+            }
+        }
+        if (!agree) {
+            ++failures;
+            continue;
+        }
+
+        const Result dom = Time(lines, corpus.dom, messages);
+        const Result view = Time(lines, corpus.view, messages);
+        std::printf("%-16s %5zu %14.0f %14.1f %14.0f %14.2f %7.1fx\n", corpus.name, lines.size(), dom.ns_per_message,
+                    dom.allocations_per_message, view.ns_per_message, view.allocations_per_message,
+                    dom.ns_per_message / view.ns_per_message);
+    }
+
+    std::printf("\n%s\n", failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return failures == 0 ? 0 : 1;
+}
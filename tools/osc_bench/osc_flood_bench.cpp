@@ -0,0 +1,460 @@
+// Inbound OSC flood benchmark (Linux).
+//
+// Blasts a loopback UDP socket with VRChat-like traffic -- nested bundles of
+// face-tracking floats, plus an occasional bare SPVR_ latch boolean -- at a
+// sweep of send rates, and reports for each rate:
+//   - packets sent / reaching the callback,
+//   - kernel drops: the socket's drop counter (the count SO_RXQ_OVFL reports),
+//     read from /proc/net/udp so the receiver under test needs no changes,
+//   - receive-to-callback latency percentiles,
+//   - receiver CPU time per 10k packets (process CPU minus the sender thread).
+//
+// Latency is carried by the last message of every bundle: SPVR_EStop_Stretch
+// with the bundle's sequence number as its float value, which OSCManager hands
+// to the EStopStretch callback. The sender records the send time per sequence
+// number and the callback the arrival time.
+//
+// Receivers:
+//   osc  OSCManager's receive thread and dispatch (default).
+//   raw  A blocking recvfrom() per datagram + oscpp walk, as a floor to
+//        compare against (roughly the receive loop before it was batched).
+//
+// Usage: stayputvr_osc_flood_bench [--receiver osc|raw] [--seconds S]
+//                                  [--rates r1,r2,...] [--floats N]
+//                                  [--rcvbuf-kb KB]
+//   rates are packets/s; 0 = as fast as the sender can go. --rcvbuf-kb sets
+//   the receive buffer (osc: Config::osc_receive_buffer_kb, whose default
+//   applies otherwise; raw: SO_RCVBUF, OS default otherwise).
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include "../../common/Logger.hpp"
+#include "../../common/OSCManager.hpp"
+
+using namespace StayPutVR;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    const char* kMarkerPath = "/avatar/parameters/SPVR_EStop_Stretch";
+    const char* kLatchPath = "/avatar/parameters/SPVR_HMD_Latch_IsPosed";
+    constexpr int kBoolEvery = 50;        // one bare latch bool per this many bundles
+    constexpr int kFloatsPerInner = 26;   // VRCFT splits its params over several bundles
+    constexpr size_t kMaxDatagram = 65507; // largest UDP payload over IPv4
+
+    long long NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    double CpuSeconds(clockid_t clock) {
+        timespec ts{};
+        clock_gettime(clock, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    // The kernel's drop counter for the UDP socket bound to `port`: the last
+    // column of /proc/net/udp, the same sk_drops that SO_RXQ_OVFL reports.
+    long long SocketDrops(int port) {
+        std::ifstream in("/proc/net/udp");
+        std::string line;
+        std::getline(in, line); // header
+        char want[8];
+        std::snprintf(want, sizeof(want), ":%04X", port);
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            std::string slot, local;
+            ss >> slot >> local;
+            if (local.size() < 5 || local.compare(local.size() - 5, 5, want) != 0) {
+                continue;
+            }
+            std::string last, token;
+            while (ss >> token) last = token;
+            return std::atoll(last.c_str());
+        }
+        return -1;
+    }
+
+    // A face-tracking bundle: an outer bundle of inner bundles holding
+    // `floats` params, with the latency marker as the very last message so its
+    // float is the packet's last four bytes. Empty if it doesn't fit in one
+    // UDP datagram.
+    std::vector<char> BuildFaceBundle(int floats) {
+        static const char* kNames[] = {
+            "EyeLeftX", "EyeLeftY", "EyeRightX", "EyeRightY", "EyeLidLeft", "EyeLidRight",
+            "BrowInnerUpLeft", "BrowInnerUpRight", "BrowOuterUpLeft", "BrowOuterUpRight",
+            "CheekPuffLeft", "CheekPuffRight", "JawOpen", "JawForward", "JawLeft", "JawRight",
+            "MouthClosed", "MouthSmileLeft", "MouthSmileRight", "MouthFrownLeft", "MouthFrownRight",
+            "LipPuckerUpperLeft", "LipPuckerUpperRight", "TongueOut", "NoseSneerLeft", "NoseSneerRight",
+        };
+        std::vector<char> buf(kMaxDatagram);
+        OSCPP::Client::Packet p(buf.data(), buf.size());
+        try {
+            p.openBundle(1);
+            int written = 0;
+            while (written < floats) {
+                p.openBundle(1);
+                for (int i = 0; i < kFloatsPerInner && written < floats; ++i, ++written) {
+                    char address[96];
+                    std::snprintf(address, sizeof(address), "/avatar/parameters/FT/v2/%s%d",
+                                  kNames[written % std::size(kNames)], written / static_cast<int>(std::size(kNames)));
+                    p.openMessage(address, 1).float32(0.01f * (written % 100)).closeMessage();
+                }
+                if (written == floats) {
+                    p.openMessage(kMarkerPath, 1).float32(1.0f).closeMessage();
+                }
+                p.closeBundle();
+            }
+            p.closeBundle();
+        } catch (const std::exception&) {
+            return {};
+        }
+        buf.resize(p.size());
+        return buf;
+    }
+
+    std::vector<char> BuildLatchBool(bool value) {
+        std::vector<char> buf(256);
+        OSCPP::Client::Packet p(buf.data(), buf.size());
+        p.openMessage(kLatchPath, 1).int32(value ? 1 : 0).closeMessage();
+        buf.resize(p.size());
+        return buf;
+    }
+
+    void PatchMarker(std::vector<char>& packet, float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        char* out = packet.data() + packet.size() - 4;
+        out[0] = static_cast<char>(bits >> 24);
+        out[1] = static_cast<char>(bits >> 16);
+        out[2] = static_cast<char>(bits >> 8);
+        out[3] = static_cast<char>(bits);
+    }
+
+    // Arrival times by sequence number, shared by both receivers.
+    struct Arrivals {
+        std::unique_ptr<std::atomic<long long>[]> at;
+        size_t capacity = 0;
+        std::atomic<long long> bools{ 0 };
+
+        void Reset(size_t n) {
+            if (n > capacity) {
+                at.reset(new std::atomic<long long>[n]);
+                capacity = n;
+            }
+            for (size_t i = 0; i < capacity; ++i) at[i].store(0, std::memory_order_relaxed);
+            bools = 0;
+        }
+
+        void Mark(float seq) {
+            const size_t i = static_cast<size_t>(seq);
+            if (i < capacity) at[i].store(NowNs(), std::memory_order_relaxed);
+        }
+    };
+
+    Arrivals g_arrivals;
+
+    // Receiver under test. Start() returns the UDP port to send to;
+    // rcvbuf_kb < 0 leaves the receiver's default buffer size.
+    class Receiver {
+    public:
+        virtual ~Receiver() = default;
+        virtual int Start(int rcvbuf_kb) = 0;
+        virtual void Stop() = 0;
+        virtual int BufferBytes() const = 0;
+    };
+
+    class OSCManagerReceiver : public Receiver {
+    public:
+        int Start(int rcvbuf_kb) override {
+            OSCManager& osc = OSCManager::GetInstance();
+            Config config;
+            if (rcvbuf_kb >= 0) config.osc_receive_buffer_kb = rcvbuf_kb;
+            osc.SetConfig(config);
+            osc.SetEStopStretchCallback([](float seq) { g_arrivals.Mark(seq); });
+            osc.SetLockCallback([](OSCDeviceType, bool) { ++g_arrivals.bools; });
+            // Sends go nowhere; the receive socket binds an ephemeral port.
+            if (!osc.Initialize("127.0.0.1", 9, 0, true)) {
+                return -1;
+            }
+            return osc.GetActualReceivePort();
+        }
+
+        void Stop() override {
+            // Cross-check: OSCManager's own SO_RXQ_OVFL count vs /proc.
+            const OSCManager::ReceiveStats rx = OSCManager::GetInstance().GetReceiveStats();
+            std::printf("\nOSCManager receive stats: %llu datagrams, %llu kernel drops, %llu truncated\n",
+                        static_cast<unsigned long long>(rx.datagrams),
+                        static_cast<unsigned long long>(rx.kernel_drops),
+                        static_cast<unsigned long long>(rx.truncated));
+            OSCManager::GetInstance().Shutdown();
+        }
+
+        int BufferBytes() const override { return OSCManager::GetInstance().GetReceiveStats().buffer_bytes; }
+    };
+
+    class RawReceiver : public Receiver {
+    public:
+        int Start(int rcvbuf_kb) override {
+            fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (fd_ >= 0 && rcvbuf_kb > 0) {
+                int bytes = rcvbuf_kb * 1024;
+                setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+            }
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                return -1;
+            }
+            socklen_t len = sizeof(addr);
+            getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+            timeval tv{ 0, 100 * 1000 };
+            setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            running_ = true;
+            thread_ = std::thread([this] {
+                std::vector<char> buf(kMaxDatagram);
+                while (running_) {
+                    ssize_t n = recvfrom(fd_, buf.data(), buf.size(), 0, nullptr, nullptr);
+                    if (n > 0) {
+                        try {
+                            Walk(OSCPP::Server::Packet(buf.data(), static_cast<size_t>(n)));
+                        } catch (const std::exception&) {
+                        }
+                    }
+                }
+            });
+            return ntohs(addr.sin_port);
+        }
+
+        void Stop() override {
+            running_ = false;
+            if (thread_.joinable()) thread_.join();
+            if (fd_ >= 0) close(fd_);
+        }
+
+        int BufferBytes() const override {
+            int bytes = 0;
+            socklen_t length = sizeof(bytes);
+            getsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &bytes, &length);
+            return bytes / 2; // Linux reports double the usable size
+        }
+
+    private:
+        static void Walk(const OSCPP::Server::Packet& packet) {
+            if (packet.isBundle()) {
+                OSCPP::Server::Bundle bundle(packet);
+                OSCPP::Server::PacketStream packets(bundle.packets());
+                while (!packets.atEnd()) Walk(packets.next());
+                return;
+            }
+            OSCPP::Server::Message message(packet);
+            OSCPP::Server::ArgStream args(message.args());
+            if (std::strcmp(message.address(), kMarkerPath) == 0 && args.tag() == 'f') {
+                g_arrivals.Mark(args.float32());
+            } else if (std::strcmp(message.address(), kLatchPath) == 0) {
+                ++g_arrivals.bools;
+            }
+        }
+
+        int fd_ = -1;
+        std::atomic<bool> running_{ false };
+        std::thread thread_;
+    };
+
+    struct StepResult {
+        double achieved_pps = 0;
+        long long sent = 0;
+        long long bundles = 0;
+        long long delivered = 0;
+        long long bools_sent = 0;
+        long long bools_delivered = 0;
+        long long drops = 0;
+        double p50_us = 0, p99_us = 0, p999_us = 0, max_us = 0;
+        double cpu_us_per_10k = 0;
+    };
+
+    double Percentile(std::vector<double>& sorted, double q) {
+        if (sorted.empty()) return 0.0;
+        const size_t i = std::min(sorted.size() - 1, static_cast<size_t>(std::ceil(q * sorted.size())) - 1);
+        return sorted[i];
+    }
+
+    StepResult RunStep(int fd, const sockaddr_in& to, int port, std::vector<char> bundle,
+                       int rate, double seconds) {
+        // At full speed the sender manages a few hundred thousand packets/s;
+        // size the arrival table for that.
+        const size_t max_bundles = static_cast<size_t>((rate > 0 ? rate : 1000000) * seconds) + 1;
+        std::vector<long long> sent_at(max_bundles, 0);
+        g_arrivals.Reset(max_bundles);
+
+        const std::vector<char> latch_on = BuildLatchBool(true);
+        const std::vector<char> latch_off = BuildLatchBool(false);
+
+        const long long drops_before = SocketDrops(port);
+        const double cpu_process_before = CpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+        const double cpu_sender_before = CpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+
+        StepResult r;
+        const auto start = Clock::now();
+        const auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        const double interval_ns = rate > 0 ? 1e9 / rate : 0.0;
+        size_t seq = 1; // the EStop callback only fires for values >= 0.5
+        while (seq < max_bundles) {
+            const auto now = Clock::now();
+            if (now >= end) break;
+            if (rate > 0) {
+                const auto due = start + std::chrono::nanoseconds(static_cast<long long>(r.sent * interval_ns));
+                if (now < due) {
+                    if (due - now > std::chrono::microseconds(200)) {
+                        std::this_thread::sleep_for(due - now - std::chrono::microseconds(100));
+                    }
+                    continue;
+                }
+            }
+            if (r.bundles > 0 && r.bundles % kBoolEvery == 0 && r.bools_sent * kBoolEvery < r.bundles) {
+                const std::vector<char>& latch = (r.bools_sent & 1) ? latch_off : latch_on;
+                sendto(fd, latch.data(), latch.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+                ++r.bools_sent;
+                ++r.sent;
+                continue;
+            }
+            PatchMarker(bundle, static_cast<float>(seq));
+            sent_at[seq] = NowNs();
+            if (sendto(fd, bundle.data(), bundle.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) < 0) {
+                continue;
+            }
+            ++seq;
+            ++r.bundles;
+            ++r.sent;
+        }
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        const double cpu_sender = CpuSeconds(CLOCK_THREAD_CPUTIME_ID) - cpu_sender_before;
+
+        // Let the receiver drain what the socket still holds.
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        const double cpu_process = CpuSeconds(CLOCK_PROCESS_CPUTIME_ID) - cpu_process_before;
+        const long long drops_after = SocketDrops(port);
+
+        std::vector<double> latencies;
+        latencies.reserve(seq);
+        for (size_t i = 1; i < seq; ++i) {
+            const long long at = g_arrivals.at[i].load(std::memory_order_relaxed);
+            if (at != 0) {
+                latencies.push_back((at - sent_at[i]) / 1000.0);
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        r.achieved_pps = r.sent / elapsed;
+        r.delivered = static_cast<long long>(latencies.size());
+        r.bools_delivered = g_arrivals.bools;
+        r.drops = (drops_before >= 0 && drops_after >= 0) ? drops_after - drops_before : -1;
+        r.p50_us = Percentile(latencies, 0.50);
+        r.p99_us = Percentile(latencies, 0.99);
+        r.p999_us = Percentile(latencies, 0.999);
+        r.max_us = latencies.empty() ? 0.0 : latencies.back();
+        const long long received = r.delivered + r.bools_delivered;
+        r.cpu_us_per_10k = received > 0 ? (cpu_process - cpu_sender) * 1e6 * 10000.0 / received : 0.0;
+        return r;
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string receiver_name = "osc";
+    double seconds = 2.0;
+    std::vector<int> rates = { 1000, 5000, 10000, 20000, 50000, 0 };
+    int floats = 104;
+    int rcvbuf_kb = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--receiver" && has_value) {
+            receiver_name = argv[++i];
+        } else if (arg == "--seconds" && has_value) {
+            seconds = std::atof(argv[++i]);
+        } else if (arg == "--rcvbuf-kb" && has_value) {
+            rcvbuf_kb = std::atoi(argv[++i]);
+        } else if (arg == "--floats" && has_value) {
+            floats = std::atoi(argv[++i]);
+        } else if (arg == "--rates" && has_value) {
+            rates.clear();
+            std::stringstream ss(argv[++i]);
+            std::string rate;
+            while (std::getline(ss, rate, ',')) rates.push_back(std::atoi(rate.c_str()));
+        } else {
+            std::fprintf(stderr, "usage: %s [--receiver osc|raw] [--seconds S] [--rates r1,r2,...] [--floats N] [--rcvbuf-kb KB]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((receiver_name != "osc" && receiver_name != "raw") || seconds <= 0.0 || floats < 1 || rates.empty()) {
+        std::fprintf(stderr, "osc_flood_bench: bad arguments\n");
+        return 1;
+    }
+    Logger::SetLogLevel(Logger::LogLevel::E_ERROR);
+
+    const std::vector<char> bundle = BuildFaceBundle(floats);
+    if (bundle.empty()) {
+        std::fprintf(stderr, "osc_flood_bench: %d floats don't fit in one %zu-byte datagram\n", floats, kMaxDatagram);
+        return 1;
+    }
+
+    std::unique_ptr<Receiver> receiver;
+    if (receiver_name == "raw") {
+        receiver = std::make_unique<RawReceiver>();
+    } else {
+        receiver = std::make_unique<OSCManagerReceiver>();
+    }
+    const int port = receiver->Start(rcvbuf_kb);
+    if (port <= 0) {
+        std::fprintf(stderr, "osc_flood_bench: receiver failed to start\n");
+        return 1;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(static_cast<uint16_t>(port));
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::printf("StayPutVR OSC flood benchmark: receiver=%s, %d floats/bundle (%zu bytes), "
+                "1 latch bool per %d bundles, %.1f s per rate, receive buffer %d KB\n\n",
+                receiver_name.c_str(), floats, bundle.size(), kBoolEvery, seconds, receiver->BufferBytes() / 1024);
+    std::printf("%9s %10s %10s %10s %8s %7s %9s %9s %9s %9s %12s\n",
+                "target/s", "sent/s", "bundles", "delivered", "bools", "drops",
+                "p50 us", "p99 us", "p99.9 us", "max us", "cpu us/10k");
+
+    for (int rate : rates) {
+        const StepResult r = RunStep(fd, to, port, bundle, rate, seconds);
+        char target[16];
+        if (rate > 0) {
+            std::snprintf(target, sizeof(target), "%d", rate);
+        } else {
+            std::snprintf(target, sizeof(target), "max");
+        }
+        char bools[24];
+        std::snprintf(bools, sizeof(bools), "%lld/%lld", r.bools_delivered, r.bools_sent);
+        std::printf("%9s %10.0f %10lld %10lld %8s %7lld %9.1f %9.1f %9.1f %9.1f %12.0f\n",
+                    target, r.achieved_pps, r.bundles, r.delivered, bools, r.drops,
+                    r.p50_us, r.p99_us, r.p999_us, r.max_us, r.cpu_us_per_10k);
+    }
+
+    close(fd);
+    receiver->Stop();
+    return 0;
+}
@@ -0,0 +1,223 @@
+// Outbound OSC encode/send microbenchmark.
+//
+// 1. Encode only: a status message built with oscpp, with and without the
+//    GetStatusPath() string building every send used to do, against
+//    OSCMessageTemplate::Encode (memcpy + tag + value patch). The encodings
+//    are checked to be byte-identical first.
+// 2. End to end through OSCManager to a loopback UDP sink: one status change
+//    per FlushSends() (one datagram each), and eight status changes per flush
+//    (one bundle each), as a frame with several edges would produce; then
+//    the latter fanned out to four destinations.
+//
+// Usage: stayputvr_osc_send_bench [messages]   (default 2000000)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../common/Logger.hpp"
+#include "../../common/OSCManager.hpp"
+#include "../../common/OSCMessageTemplate.hpp"
+
+using namespace StayPutVR;
+using Clock = std::chrono::steady_clock;
+
+static double Seconds(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+}
+
+static void Report(const char* name, long long messages, double seconds) {
+    std::printf("%-34s %12.0f msg/s %10.1f ns/msg\n", name, messages / seconds, seconds * 1e9 / messages);
+}
+
+// Keeps the sink socket drained so sends never stall on a full buffer.
+class UdpSink {
+public:
+    bool Open() {
+        fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        if (fd_ < 0 || bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+        timeval tv{ 0, 100 * 1000 };
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        running_ = true;
+        thread_ = std::thread([this] {
+            char buf[MAX_PACKET_SIZE];
+            while (running_) {
+                if (recv(fd_, buf, sizeof(buf), 0) > 0) {
+                    ++datagrams_;
+                }
+            }
+        });
+        return true;
+    }
+
+    void Close() {
+        running_ = false;
+        if (thread_.joinable()) thread_.join();
+        if (fd_ >= 0) close(fd_);
+    }
+
+    int Port() const { return port_; }
+    long long Datagrams() const { return datagrams_; }
+
+private:
+    int fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{ false };
+    std::atomic<long long> datagrams_{ 0 };
+    std::thread thread_;
+};
+
+int main(int argc, char** argv) {
+    long long messages = 2000000;
+    if (argc > 1) {
+        messages = std::atoll(argv[1]);
+        if (messages <= 0) {
+            std::fprintf(stderr, "usage: %s [messages]\n", argv[0]);
+            return 1;
+        }
+    }
+    Logger::SetLogLevel(Logger::LogLevel::E_ERROR);
+
+    const char* path = "/avatar/parameters/SPVR_ControllerRight_Status";
+    static constexpr OSCMessageTemplate kTemplate("/avatar/parameters/SPVR_ControllerRight_Status");
+    static_assert(kTemplate.Valid());
+
+    // --- Correctness: template output == oscpp output ---
+    {
+        char a[256], b[256];
+        OSCPP::Client::Packet packet(a, sizeof(a));
+        packet.openMessage(path, 1).int32(3).closeMessage();
+        kTemplate.Encode(b, 'i', 3);
+        if (packet.size() != kTemplate.Size() || std::memcmp(a, b, packet.size()) != 0) {
+            std::fprintf(stderr, "osc_send_bench: template encoding differs from oscpp\n");
+            return 1;
+        }
+    }
+
+    std::printf("StayPutVR OSC send benchmark, %lld messages\n\n", messages);
+
+    // --- Encode only ---
+    {
+        char buf[256];
+        volatile char sink = 0;
+        auto t0 = Clock::now();
+        for (long long i = 0; i < messages; ++i) {
+            OSCPP::Client::Packet packet(buf, sizeof(buf));
+            packet.openMessage(path, 1).int32(static_cast<int32_t>(i & 7)).closeMessage();
+            sink = sink + buf[packet.size() - 1];
+        }
+        Report("encode: oscpp per send", messages, Seconds(t0));
+
+        // Plus building the address string, as SendDeviceStatus used to.
+        OSCManager& osc = OSCManager::GetInstance();
+        t0 = Clock::now();
+        for (long long i = 0; i < messages; ++i) {
+            const std::string status_path = osc.GetStatusPath(OSCDeviceType::ControllerRight);
+            OSCPP::Client::Packet packet(buf, sizeof(buf));
+            packet.openMessage(status_path.c_str(), 1).int32(static_cast<int32_t>(i & 7)).closeMessage();
+            sink = sink + buf[packet.size() - 1];
+        }
+        Report("encode: GetStatusPath + oscpp", messages, Seconds(t0));
+
+        t0 = Clock::now();
+        for (long long i = 0; i < messages; ++i) {
+            kTemplate.Encode(buf, 'i', static_cast<uint32_t>(i & 7));
+            sink = sink + buf[kTemplate.Size() - 1];
+        }
+        Report("encode: precomputed template", messages, Seconds(t0));
+    }
+
+    // --- End to end through OSCManager ---
+    UdpSink sink;
+    if (!sink.Open()) {
+        std::fprintf(stderr, "osc_send_bench: cannot open loopback sink\n");
+        return 1;
+    }
+    OSCManager& osc = OSCManager::GetInstance();
+    if (!osc.Initialize("127.0.0.1", sink.Port(), 0, true)) {
+        std::fprintf(stderr, "osc_send_bench: OSCManager::Initialize failed\n");
+        return 1;
+    }
+
+    const long long sends = messages / 10;
+    {
+        const long long before = sink.Datagrams();
+        auto t0 = Clock::now();
+        for (long long i = 0; i < sends; ++i) {
+            osc.SendDeviceStatus(OSCDeviceType::ControllerRight, static_cast<DeviceStatus>(1 + (i & 1)));
+            osc.FlushSends();
+        }
+        Report("OSCManager: 1 status per flush", sends, Seconds(t0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::printf("%-34s %12lld of %lld datagrams\n", "  received by sink", sink.Datagrams() - before, sends);
+    }
+    {
+        const OSCDeviceType devices[] = {
+            OSCDeviceType::HMD, OSCDeviceType::ControllerLeft, OSCDeviceType::ControllerRight,
+            OSCDeviceType::FootLeft, OSCDeviceType::FootRight, OSCDeviceType::Hip,
+            OSCDeviceType::Jaw, OSCDeviceType::Mic
+        };
+        const long long flushes = sends / 8;
+        auto t0 = Clock::now();
+        for (long long i = 0; i < flushes; ++i) {
+            for (OSCDeviceType d : devices) {
+                osc.SendDeviceStatus(d, static_cast<DeviceStatus>(1 + (i & 1)));
+            }
+            osc.FlushSends();
+        }
+        Report("OSCManager: 8 statuses per flush", flushes * 8, Seconds(t0));
+    }
+    {
+        // Unchanged values: what the status re-assert loops cost now.
+        auto t0 = Clock::now();
+        for (long long i = 0; i < sends; ++i) {
+            osc.SendDeviceStatus(OSCDeviceType::HMD, DeviceStatus::LockedSafe);
+            osc.FlushSends();
+        }
+        Report("OSCManager: unchanged (deduped)", sends, Seconds(t0));
+    }
+
+    {
+        // Fan-out: the same flushes with three extra destinations (the sink
+        // again), one of them filtered. Encoding is shared; each destination
+        // costs one more datagram in the same sendmmsg() call.
+        Config config;
+        config.osc_destinations = {
+            { true, "127.0.0.1", sink.Port(), "" },
+            { true, "127.0.0.1", sink.Port(), "" },
+            { true, "127.0.0.1", sink.Port(), "/avatar/parameters/SPVR_Hip" },
+        };
+        osc.SetConfig(config);
+        const OSCDeviceType devices[] = {
+            OSCDeviceType::HMD, OSCDeviceType::ControllerLeft, OSCDeviceType::ControllerRight,
+            OSCDeviceType::FootLeft, OSCDeviceType::FootRight, OSCDeviceType::Hip,
+            OSCDeviceType::Jaw, OSCDeviceType::Mic
+        };
+        const long long flushes = sends / 8;
+        auto t0 = Clock::now();
+        for (long long i = 0; i < flushes; ++i) {
+            for (OSCDeviceType d : devices) {
+                osc.SendDeviceStatus(d, static_cast<DeviceStatus>(1 + (i & 1)));
+            }
+            osc.FlushSends();
+        }
+        Report("OSCManager: 8 per flush, 4 dests", flushes * 8, Seconds(t0));
+    }
+
+    osc.Shutdown();
+    sink.Close();
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Headless UI benchmark.
+//
+// Drives each UIManager::Render*Tab for N frames against a synthetic device
+// set (8 / 32 / 64 devices, every integration enabled) inside a plain ImGui
+// context: no GLFW window, no OpenGL context. The "renderer" just acknowledges
+// ImGui's texture requests and drops the draw lists, so what is measured is the
+// CPU cost of building the UI, which is what the app pays on the UI thread
+// every frame.
+//
+// Usage: stayputvr_ui_bench [frames_per_tab]   (default 600)
+//
+// Output is one table per device count: average and max CPU time per frame
+// (NewFrame .. Render, inclusive) and heap allocations per frame on this thread.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+
+#include "../../application/src/ui/UIManager.hpp"
+#include "../../common/AllocationCounter.hpp"
+#include "../../common/LogRing.hpp"
+#include "../../common/Logger.hpp"
+#include "../common/HeadlessImGui.hpp"
+
+// main.cpp owns this in the app; UIManager references it.
+std::atomic<bool> g_running = true;
+
+namespace StayPutVR {
+
+    class UIBenchmark {
+    public:
+        struct TabResult {
+            const char* name;
+            double avg_us = 0.0;
+            double max_us = 0.0;
+            double allocs_per_frame = 0.0;
+        };
+
+        explicit UIBenchmark(int frames) : frames_(frames) {}
+
+        bool Setup() {
+            CreateHeadlessImGuiContext();
+
+            // Constructed, never Initialize()d: that would create the GLFW
+            // window, connect IPC and OSC and load the user's config.
+            ui_ = new UIManager();
+            ui_->ApplyTheme();
+
+            // The effigy and VRCFT logos are GL textures; mark them as already
+            // attempted so the Devices/VRCFT tabs draw their no-texture fallback.
+            ui_->effigy_load_attempted_ = true;
+            ui_->vrcft_logos_load_attempted_ = true;
+
+            EnableAllIntegrations();
+            FillLogRing();
+            return true;
+        }
+
+        // Replace the device set with `count` synthetic trackers (one HMD and
+        // two controllers first, like a real full-body setup).
+        void SetDeviceCount(int count) {
+            ui_->device_positions_.clear();
+            ui_->device_map_.clear();
+            devices_.clear();
+            for (int i = 0; i < count; ++i) {
+                DevicePositionData d{};
+                d.type = i == 0 ? DeviceType::HMD : (i < 3 ? DeviceType::CONTROLLER : DeviceType::TRACKER);
+                d.serial = "BENCH-" + std::to_string(i);
+                d.position[0] = 0.1f * static_cast<float>(i % 8);
+                d.position[1] = 1.0f + 0.05f * static_cast<float>(i / 8);
+                d.position[2] = 0.0f;
+                d.rotation[3] = 1.0f;
+                d.connected = true;
+                devices_.push_back(d);
+            }
+            ui_->UpdateDevicePositions(devices_);
+
+            for (size_t i = 0; i < ui_->device_positions_.size(); ++i) {
+                DevicePosition& dev = ui_->device_positions_[i];
+                dev.device_name = "Device " + std::to_string(i);
+                dev.include_in_locking = (i % 2) == 0;
+                dev.pishock_enabled[i % dev.pishock_enabled.size()] = true;
+                dev.openshock_enabled[i % dev.openshock_enabled.size()] = true;
+                dev.vibration_device_enabled[i % dev.vibration_device_enabled.size()] = true;
+            }
+        }
+
+        std::vector<TabResult> RunAllTabs() {
+            std::vector<TabResult> results;
+            results.push_back(RunTab("Main",            [this] { ui_->RenderMainTab(); }));
+            results.push_back(RunTab("Devices",         [this] { ui_->RenderDevicesTab(); }));
+            results.push_back(RunTab("  Device list",   [this] { ui_->RenderDeviceList(); }));
+            results.push_back(RunTab("Notifications",   [this] { ui_->RenderNotificationsTab(); }));
+            results.push_back(RunTab("Timers",          [this] { ui_->RenderTimersTab(); }));
+            results.push_back(RunTab("OSC",             [this] { ui_->RenderOSCTab(); }));
+            results.push_back(RunTab("Integrations",    [this] { ui_->RenderIntegrationsTab(); }));
+            results.push_back(RunTab("  PiShock",       [this] { ui_->RenderPiShockTab(); }));
+            results.push_back(RunTab("  OpenShock",     [this] { ui_->RenderOpenShockTab(); }));
+            results.push_back(RunTab("  OSC Triggers",  [this] { ui_->RenderOSCTriggersTab(); }));
+            results.push_back(RunTab("  BPIO",          [this] { ui_->RenderButtplugTab(); }));
+            results.push_back(RunTab("  Twitch",        [this] { ui_->RenderTwitchTab(); }));
+            results.push_back(RunTab("  VRCFT",         [this] { ui_->RenderVRCFTTab(); }));
+            results.push_back(RunTab("  Mic",           [this] { ui_->RenderMicTab(); }));
+            results.push_back(RunTab("Settings",        [this] { ui_->RenderSettingsTab(); }));
+            results.push_back(RunTab("Logs",            [this] { ui_->RenderLogsTab(); }));
+            return results;
+        }
+
+        void Teardown() {
+            // Stop the managers' worker threads. The UIManager itself is
+            // deliberately leaked: its destructor saves the config, which
+            // would overwrite the user's real config.ini with bench settings.
+            ui_->ShutdownTwitchManager();
+            ui_->ShutdownPiShockManager();
+            ui_->ShutdownOpenShockManager();
+            ui_->ShutdownButtplugManager();
+            ImGui::DestroyContext();
+        }
+
+    private:
+        void EnableAllIntegrations() {
+            Config& c = ui_->config_;
+            c.osc_enabled = true;
+            c.pishock_enabled = c.pishock_user_agreement = true;
+            c.openshock_enabled = c.openshock_user_agreement = true;
+            c.buttplug_enabled = c.buttplug_user_agreement = true;
+            c.twitch_enabled = c.twitch_user_agreement = true;
+            c.jawopen_enabled = c.jawopen_user_agreement = true;
+            c.mic_enabled = c.mic_user_agreement = true;
+            ui_->osc_enabled_ = true;
+
+            // Managers and panels as Initialize() would create them, minus the
+            // auto-connects (the WebSocket managers are initialized directly).
+            ui_->InitializeTwitchManager();
+            ui_->InitializePiShockManager();
+            ui_->InitializeOpenShockManager();
+            ui_->pishock_ws_manager_ = std::make_unique<PiShockWebSocketManager>();
+            ui_->pishock_ws_manager_->Initialize(&c);
+            ui_->buttplug_manager_ = std::make_unique<ButtplugManager>();
+            ui_->buttplug_manager_->Initialize(&c);
+            ui_->microphone_manager_ = std::make_unique<MicrophoneManager>();
+
+            ui_->pishock_panel_ = std::make_unique<PiShockPanel>(
+                c, ui_->pishock_manager_, ui_->pishock_ws_manager_, [] {});
+            ui_->openshock_panel_ = std::make_unique<OpenShockPanel>(
+                c, ui_->openshock_manager_, [] {});
+            ui_->buttplug_panel_ = std::make_unique<ButtplugPanel>(
+                c, ui_->buttplug_manager_, [] {});
+        }
+
+        // A full Logs tab ring, as after a long session.
+        static void FillLogRing() {
+            LogRing::SetCapacity(kLogLines);
+            for (int i = 0; i < kLogLines; ++i) {
+                const auto level = (i % 50 == 0) ? Logger::LogLevel::WARNING : Logger::LogLevel::INFO;
+                LogRing::Push(level, "2026-01-01 00:00:00.000 [INFO] OSCManager: received /avatar/parameters/SPVR_Bench_" +
+                                     std::to_string(i % 64) + " value " + std::to_string(i));
+            }
+        }
+
+        template <typename Fn>
+        TabResult RunTab(const char* name, Fn&& render_tab) {
+            // Warm-up: first frames create windows/tables and bake glyphs.
+            for (int i = 0; i < kWarmupFrames; ++i) {
+                HeadlessFrame(render_tab);
+                ServiceHeadlessTextures();
+            }
+
+            TabResult r{name};
+            double total_us = 0.0;
+            uint64_t total_allocs = 0;
+            for (int i = 0; i < frames_; ++i) {
+                // Feed a fresh pose update between frames (outside the timed
+                // region) so tables see changing positions as they do live.
+                Jitter(i);
+                const uint64_t a0 = AllocationCounter::ThreadAllocations();
+                const auto t0 = std::chrono::steady_clock::now();
+                HeadlessFrame(render_tab);
+                const double us = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - t0).count();
+                total_allocs += AllocationCounter::ThreadAllocations() - a0;
+                ServiceHeadlessTextures();
+                total_us += us;
+                r.max_us = (std::max)(r.max_us, us);
+            }
+            r.avg_us = frames_ > 0 ? total_us / frames_ : 0.0;
+            r.allocs_per_frame = frames_ > 0 ? static_cast<double>(total_allocs) / frames_ : 0.0;
+            return r;
+        }
+
+        void Jitter(int frame) {
+            const float d = (frame & 1) ? 0.0005f : -0.0005f;
+            for (auto& dev : devices_) dev.position[0] += d;
+            ui_->UpdateDevicePositions(devices_);
+        }
+
+        static constexpr int kWarmupFrames = 30;
+        static constexpr int kLogLines = 20000;
+
+        int frames_;
+        UIManager* ui_ = nullptr;
+        std::vector<DevicePositionData> devices_;
+    };
+
+} // namespace StayPutVR
+
+int main(int argc, char** argv) {
+    using namespace StayPutVR;
+
+    int frames = 600;
+    if (argc > 1) {
+        frames = std::atoi(argv[1]);
+        if (frames <= 0) {
+            std::fprintf(stderr, "usage: %s [frames_per_tab]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Logger isn't initialized here, so everything goes to stderr; keep it quiet.
+    Logger::SetLogLevel(Logger::LogLevel::E_ERROR);
+
+    UIBenchmark bench(frames);
+    if (!bench.Setup()) {
+        return 1;
+    }
+
+    std::printf("StayPutVR UI benchmark: ImGui %s, null renderer, %d frames per tab\n",
+                IMGUI_VERSION, frames);
+    for (int count : {8, 32, 64}) {
+        bench.SetDeviceCount(count);
+        std::printf("\n%d devices\n", count);
+        std::printf("%-18s %12s %12s %14s\n", "Tab", "avg us/frame", "max us", "allocs/frame");
+        for (const auto& r : bench.RunAllTabs()) {
+            std::printf("%-18s %12.1f %12.1f %14.1f\n", r.name, r.avg_us, r.max_us, r.allocs_per_frame);
+        }
+    }
+
+    bench.Teardown();
+    return 0;
+}
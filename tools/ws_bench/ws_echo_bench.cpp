@@ -0,0 +1,499 @@
+// WebSocketClient against loopback servers: round-trip latency, receive-path
+// allocations, and the protocol paths (fragments, pings, permessage-deflate,
+// keepalive, closing handshake).
+//
+// 1. echo: cpp-httplib's WebSocket server echoes text messages of several
+//    sizes; each round trip is SendText() until the echo comes out of
+//    Update(). Every echo is compared with what was sent.
+// 2. push: a scripted server writes pre-built frames -- messages split into
+//    three fragments with a ping between them -- and the client's process-
+//    wide allocation count is taken per delivered message once warm. The
+//    server checks the pongs that come back.
+// 3. deflate: as push, but the server accepts permessage-deflate and
+//    compresses every message (context takeover on, as real servers do).
+//    Skipped in builds without zlib.
+// 4. keepalive: the server goes quiet; the client must ping after one
+//    interval and drop the connection when the ping goes unanswered.
+// 5. send queue: a SendBatch burst leaves in one write; an urgent stop
+//    overtakes held updates and cancels the ones it makes moot; updates past
+//    the high-water mark replace each other, newest value last. Then a
+//    stream of sends for throughput, coalescing and allocations per message.
+//
+// Usage: stayputvr_ws_echo_bench [round_trips] [push_messages]   (default 2000, 20000)
+
+#include "../../common/HttpLib.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef STAYPUTVR_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#include "../../common/AllocationCounter.hpp"
+#include "../../common/Logger.hpp"
+#include "../../common/WebSocketClient.hpp"
+
+using namespace StayPutVR;
+using Clock = std::chrono::steady_clock;
+
+static int g_failures = 0;
+
+static void Check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("  FAIL: %s\n", what);
+        ++g_failures;
+    }
+}
+
+// Runs Update() until pred holds or timeout passes.
+static bool PumpUntil(WebSocketClient& client, const std::function<bool()>& pred,
+                      std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+    const Clock::time_point deadline = Clock::now() + timeout;
+    while (!pred()) {
+        if (Clock::now() > deadline) return false;
+        client.Update();
+    }
+    return true;
+}
+
+// One accepted connection of the scripted server, speaking raw RFC 6455.
+class RawPeer {
+public:
+    explicit RawPeer(SOCKET sock) : sock_(sock) {}
+
+    bool WriteAll(const std::string& bytes) {
+        size_t done = 0;
+        while (done < bytes.size()) {
+            const auto n = send(sock_, bytes.data() + done, bytes.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Server frames are unmasked.
+    static std::string Frame(uint8_t opcode, const std::string& payload, bool fin = true, bool rsv1 = false) {
+        std::string frame;
+        frame.push_back(static_cast<char>((fin ? 0x80 : 0) | (rsv1 ? 0x40 : 0) | opcode));
+        if (payload.size() < 126) {
+            frame.push_back(static_cast<char>(payload.size()));
+        } else if (payload.size() <= 0xFFFF) {
+            frame.push_back(126);
+            frame.push_back(static_cast<char>(payload.size() >> 8));
+            frame.push_back(static_cast<char>(payload.size()));
+        } else {
+            frame.push_back(127);
+            for (int i = 7; i >= 0; --i) frame.push_back(static_cast<char>(uint64_t(payload.size()) >> (i * 8)));
+        }
+        return frame + payload;
+    }
+
+    // Reads one (masked) client frame; false on EOF or timeout.
+    bool ReadFrame(uint8_t& opcode, std::string& payload, int timeout_ms = 5000) {
+        uint8_t head[2];
+        if (!ReadExact(reinterpret_cast<char*>(head), 2, timeout_ms)) return false;
+        opcode = head[0] & 0x0F;
+        uint64_t length = head[1] & 0x7F;
+        if (length >= 126) {
+            uint8_t ext[8];
+            const size_t n = length == 126 ? 2 : 8;
+            if (!ReadExact(reinterpret_cast<char*>(ext), n, timeout_ms)) return false;
+            length = 0;
+            for (size_t i = 0; i < n; ++i) length = (length << 8) | ext[i];
+        }
+        char key[4] = {};
+        if ((head[1] & 0x80) && !ReadExact(key, 4, timeout_ms)) return false;
+        payload.resize(length);
+        if (!ReadExact(payload.data(), payload.size(), timeout_ms)) return false;
+        for (size_t i = 0; i < payload.size(); ++i) payload[i] ^= key[i & 3];
+        return true;
+    }
+
+    bool ReadExact(char* out, size_t length, int timeout_ms) {
+        while (length > 0) {
+            if (!WaitForSocket(sock_, false, timeout_ms)) return false;
+            const auto n = recv(sock_, out, length, 0);
+            if (n <= 0) return false;
+            out += n;
+            length -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    std::string request_headers;
+
+private:
+    SOCKET sock_;
+};
+
+// Accepts one connection, answers the upgrade (with permessage-deflate when
+// allow_deflate and offered), then runs script on its own thread.
+class ScriptedServer {
+public:
+    using Script = std::function<void(RawPeer&, bool deflate)>;
+
+    bool Start(bool allow_deflate, Script script) {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listener_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener_, 1) != 0 ||
+            getsockname(listener_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this, allow_deflate, script] {
+            const SOCKET sock = accept(listener_, nullptr, nullptr);
+            if (sock == INVALID_SOCKET) return;
+            RawPeer peer(sock);
+            std::string& request = peer.request_headers;
+            char c;
+            while (request.find("\r\n\r\n") == std::string::npos && recv(sock, &c, 1, 0) == 1) request += c;
+
+            const size_t key_at = request.find("Sec-WebSocket-Key: ");
+            const std::string key = request.substr(key_at + 19, request.find("\r\n", key_at) - key_at - 19);
+            const bool deflate = allow_deflate && request.find("permessage-deflate") != std::string::npos;
+            std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                   "Sec-WebSocket-Accept: " + httplib::detail::websocket_accept_key(key) + "\r\n";
+            if (deflate) response += "Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover\r\n";
+            response += "\r\n";
+            if (peer.WriteAll(response)) script(peer, deflate);
+            shutdown(sock, SD_BOTH);
+            closesocket(sock);
+        });
+        return true;
+    }
+
+    void Stop() {
+        if (thread_.joinable()) thread_.join();
+        closesocket(listener_);
+    }
+
+    std::string Url() const { return "ws://127.0.0.1:" + std::to_string(port_); }
+
+private:
+    SOCKET listener_ = INVALID_SOCKET;
+    int port_ = 0;
+    std::thread thread_;
+};
+
+static void Report(const char* name, std::vector<double> micros) {
+    std::sort(micros.begin(), micros.end());
+    const auto at = [&](double q) { return micros[static_cast<size_t>(q * (micros.size() - 1))]; };
+    std::printf("  %-10s %6zu round trips %8.1f us p50 %8.1f us p99 %8.1f us max\n",
+                name, micros.size(), at(0.5), at(0.99), micros.back());
+}
+
+static void EchoPhase(int round_trips) {
+    std::printf("echo (cpp-httplib server)\n");
+    httplib::Server server;
+    server.set_tcp_nodelay(true); // as the client does; otherwise Nagle dominates
+    server.WebSocket("/echo", [](const httplib::Request&, httplib::ws::WebSocket& ws) {
+        std::string message;
+        while (ws.read(message) == httplib::ws::Text) ws.send(message);
+    });
+    const int port = server.bind_to_any_port("127.0.0.1");
+    std::thread listener([&] { server.listen_after_bind(); });
+    server.wait_until_ready();
+
+    WebSocketClient client;
+    std::string received;
+    size_t count = 0;
+    client.SetOnMessageCallback([&](std::string_view message) {
+        received.assign(message);
+        ++count;
+    });
+    Check(client.Connect("ws://127.0.0.1:" + std::to_string(port) + "/echo"), "connect to echo server");
+
+    for (size_t size : {32, 1024, 70000}) {
+        std::string payload(size, '\0');
+        for (size_t i = 0; i < size; ++i) payload[i] = static_cast<char>('a' + i % 26);
+        std::vector<double> micros;
+        bool intact = true;
+        for (int i = 0; i < round_trips && client.IsConnected(); ++i) {
+            const size_t before = count;
+            const Clock::time_point start = Clock::now();
+            client.SendText(payload);
+            if (!PumpUntil(client, [&] { return count > before; })) break;
+            micros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+            intact = intact && received == payload;
+        }
+        Check(micros.size() == static_cast<size_t>(round_trips), "every echo arrived");
+        Check(intact, "echoes match what was sent");
+        if (!micros.empty()) Report((std::to_string(size) + " B").c_str(), micros);
+    }
+
+    client.Disconnect();
+    server.stop();
+    listener.join();
+}
+
+// Returns the payload of message i: its index, padded to size.
+static std::string PushPayload(int i, size_t size) {
+    std::string payload = "{\"seq\":" + std::to_string(i) + "}";
+    payload.resize(std::max(size, payload.size()), ' ');
+    return payload;
+}
+
+static void PushPhase(const char* name, bool deflate_wanted, int messages) {
+    std::printf("%s (scripted server)\n", name);
+    constexpr size_t kSize = 300;
+    std::atomic<int> pongs{0};
+
+    // Everything is built up front so the allocation count below is the
+    // client's alone: the expected messages, and the server's frames.
+    std::vector<std::string> expected;
+    for (int i = 0; i < messages; ++i) expected.push_back(PushPayload(i, kSize));
+
+    std::string burst;
+#ifdef STAYPUTVR_WITH_ZLIB
+    z_stream z{};
+    if (deflate_wanted) deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+#endif
+    for (int i = 0; i < messages; ++i) {
+        std::string body = expected[i];
+#ifdef STAYPUTVR_WITH_ZLIB
+        if (deflate_wanted) {
+            body.resize(expected[i].size() + 64);
+            z.next_in = reinterpret_cast<Bytef*>(expected[i].data());
+            z.avail_in = static_cast<uInt>(expected[i].size());
+            z.next_out = reinterpret_cast<Bytef*>(body.data());
+            z.avail_out = static_cast<uInt>(body.size());
+            deflate(&z, Z_SYNC_FLUSH);
+            body.resize(body.size() - z.avail_out - 4); // drop 00 00 ff ff (RFC 7692 7.2.1)
+        }
+#endif
+        // Three fragments, with a ping between the first two now and then.
+        const size_t third = body.size() / 3;
+        burst += RawPeer::Frame(0x1, body.substr(0, third), false, deflate_wanted);
+        if (i % 100 == 0) burst += RawPeer::Frame(0x9, "p" + std::to_string(i));
+        burst += RawPeer::Frame(0x0, body.substr(third, third), false);
+        burst += RawPeer::Frame(0x0, body.substr(2 * third), true);
+    }
+#ifdef STAYPUTVR_WITH_ZLIB
+    if (deflate_wanted) deflateEnd(&z);
+#endif
+
+    ScriptedServer server;
+    const bool started = server.Start(deflate_wanted, [&](RawPeer& peer, bool) {
+        peer.WriteAll(burst);
+
+        // Collect pongs until the client's close frame, then answer it.
+        uint8_t opcode;
+        std::string payload;
+        while (peer.ReadFrame(opcode, payload)) {
+            if (opcode == 0xA) ++pongs;
+            if (opcode == 0x8) {
+                peer.WriteAll(RawPeer::Frame(0x8, payload));
+                break;
+            }
+        }
+    });
+    if (!started) {
+        Check(false, "start scripted server");
+        return;
+    }
+
+    WebSocketClient client;
+    int received = 0;
+    bool in_order = true;
+    uint64_t allocations_at_warm = 0;
+    client.SetOnMessageCallback([&](std::string_view message) {
+        in_order = in_order && message == expected[received];
+        if (++received == messages / 10) allocations_at_warm = AllocationCounter::TotalAllocations();
+    });
+    Check(client.Connect(server.Url()), "connect to scripted server");
+    Check(client.IsCompressionActive() == deflate_wanted, "permessage-deflate negotiated as expected");
+
+    const Clock::time_point start = Clock::now();
+    PumpUntil(client, [&] { return received == messages; }, std::chrono::milliseconds(20000));
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const uint64_t allocations = AllocationCounter::TotalAllocations() - allocations_at_warm;
+
+    Check(received == messages, "every message delivered");
+    Check(in_order, "messages intact and in order");
+    const Clock::time_point close_start = Clock::now();
+    client.Disconnect();
+    const double close_ms = std::chrono::duration<double, std::milli>(Clock::now() - close_start).count();
+    server.Stop();
+    Check(pongs == (messages + 99) / 100, "every ping answered");
+
+    const int warm = messages - messages / 10;
+    std::printf("  %d messages (%zu B, 3 fragments each) in %.1f ms, %.0f msg/s\n",
+                received, kSize, seconds * 1000, received / seconds);
+    std::printf("  %.3f allocations per message once warm (process-wide, %d messages)\n",
+                warm > 0 ? double(allocations) / warm : 0.0, warm);
+    std::printf("  %d pongs, closing handshake %.1f ms\n", pongs.load(), close_ms);
+}
+
+static void KeepalivePhase() {
+    std::printf("keepalive (scripted server)\n");
+    std::atomic<bool> pinged{false};
+    ScriptedServer server;
+    server.Start(false, [&](RawPeer& peer, bool) {
+        uint8_t opcode;
+        std::string payload;
+        // Say nothing: the client should ping after one interval ...
+        if (peer.ReadFrame(opcode, payload, 3000) && opcode == 0x9) pinged = true;
+        // ... and hang up after the next one goes by unanswered.
+        while (peer.ReadFrame(opcode, payload, 4000)) {}
+    });
+
+    WebSocketClient client;
+    client.SetPingInterval(std::chrono::seconds(1));
+    std::atomic<bool> dropped{false};
+    client.SetOnDisconnectedCallback([&](const std::string& reason) {
+        if (reason == "Receive error") dropped = true;
+    });
+    Check(client.Connect(server.Url()), "connect to scripted server");
+    const Clock::time_point start = Clock::now();
+    PumpUntil(client, [&] { return dropped.load(); }, std::chrono::milliseconds(4000));
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    Check(pinged, "client pinged the quiet server");
+    Check(dropped, "client dropped the silent connection");
+    client.Disconnect();
+    server.Stop();
+    std::printf("  ping sent, dead connection detected after %.2f s (interval 1 s)\n", seconds);
+}
+
+static void SendQueuePhase(int messages) {
+    std::printf("send queue (scripted server)\n");
+    std::mutex mutex;
+    std::vector<std::string> frames;
+    std::atomic<int> frame_count{0};
+    ScriptedServer server;
+    server.Start(false, [&](RawPeer& peer, bool) {
+        uint8_t opcode;
+        std::string payload;
+        while (peer.ReadFrame(opcode, payload)) {
+            if (opcode == 0x8) {
+                peer.WriteAll(RawPeer::Frame(0x8, payload));
+                break;
+            }
+            if (frame_count < 1000) {
+                std::lock_guard<std::mutex> lock(mutex);
+                frames.push_back(payload);
+            }
+            ++frame_count;
+        }
+    });
+
+    WebSocketClient client;
+    Check(client.Connect(server.Url()), "connect to scripted server");
+    const auto wait_for = [&](int count) {
+        PumpUntil(client, [&] { return frame_count.load() >= count; });
+        return frame_count.load() == count;
+    };
+    const auto take_frames = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> taken;
+        taken.swap(frames);
+        frame_count = 0;
+        return taken;
+    };
+
+    // A burst of one command per device leaves in one write.
+    {
+        WebSocketClient::SendBatch batch(client);
+        for (int d = 0; d < 4; ++d) client.SendText("d" + std::to_string(d) + "=1", SendPriority::Normal, "d" + std::to_string(d));
+    }
+    Check(wait_for(4), "batched burst delivered");
+    take_frames();
+    WebSocketClient::SendStats stats = client.GetSendStats();
+    Check(stats.sent == 4 && stats.writes == 1, "batched burst took one write");
+
+    // Held updates back up past the high-water mark; a stop for d1 overtakes them.
+    {
+        WebSocketClient::SendBatch batch(client);
+        for (int i = 0; i < 100; ++i) {
+            const std::string device = "d" + std::to_string(i % 4);
+            client.SendText(device + "=" + std::to_string(i), SendPriority::Normal, device);
+        }
+        client.SendText("stop d1", SendPriority::Urgent, "d1");
+        PumpUntil(client, [&] { return frame_count.load() >= 1; });
+    }
+    PumpUntil(client, [&] { return client.GetSendStats().queued == 0; });
+    wait_for(1 + 24);
+    std::vector<std::string> got = take_frames();
+    Check(!got.empty() && got.front() == "stop d1", "urgent stop went out first");
+    Check(std::none_of(got.begin() + 1, got.end(), [](const std::string& f) { return f.rfind("d1=", 0) == 0; }),
+          "stop cancelled the queued updates for its device");
+    Check(got.size() == 25 && got.back() == "d3=99" && got[got.size() - 2] == "d2=98" && got[got.size() - 3] == "d0=96",
+          "superseded updates keep each device's newest value last");
+    const uint64_t superseded = client.GetSendStats().superseded;
+    Check(superseded == 100 - 32 + 8, "superseded count");
+
+    // A stop with no key cancels every held update.
+    {
+        WebSocketClient::SendBatch batch(client);
+        for (int d = 0; d < 4; ++d) client.SendText("d" + std::to_string(d) + "=5", SendPriority::Normal, "d" + std::to_string(d));
+        client.SendText("stop all", SendPriority::Urgent);
+    }
+    wait_for(1);
+    got = take_frames();
+    Check(got.size() == 1 && got.front() == "stop all", "stop all cancelled every held update");
+
+    // Throughput: unkeyed sends as fast as the caller can queue them,
+    // staying under the queue limit so nothing is refused.
+    std::vector<std::string> payloads;
+    for (int i = 0; i < messages; ++i) payloads.push_back(PushPayload(i, 64));
+    const WebSocketClient::SendStats before = client.GetSendStats();
+    const int warm = messages / 10;
+    uint64_t allocations_at_warm = 0;
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < messages; ++i) {
+        if (i == warm) allocations_at_warm = AllocationCounter::TotalAllocations();
+        while (client.GetSendStats().queued >= 200) std::this_thread::yield();
+        client.SendText(payloads[i]);
+    }
+    const uint64_t allocations = AllocationCounter::TotalAllocations() - allocations_at_warm;
+    Check(wait_for(messages), "every queued message delivered");
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stats = client.GetSendStats();
+    const uint64_t sent = stats.sent - before.sent;
+    const uint64_t writes = stats.writes - before.writes;
+
+    const Clock::time_point close_start = Clock::now();
+    client.Disconnect();
+    const double close_ms = std::chrono::duration<double, std::milli>(Clock::now() - close_start).count();
+    server.Stop();
+
+    std::printf("  burst of 4 in 1 write; stop overtook 100 held updates, %llu superseded\n",
+                static_cast<unsigned long long>(superseded));
+    std::printf("  %d messages (64 B) in %.1f ms, %.0f msg/s, %.1f messages per write\n",
+                messages, seconds * 1000, messages / seconds, writes ? double(sent) / writes : 0.0);
+    std::printf("  queue %.3f ms avg %.3f ms max, write %.3f ms avg %.3f ms max, peak %zu queued\n",
+                stats.avg_queue_ms, stats.max_queue_ms, stats.avg_write_ms, stats.max_write_ms, stats.peak_queued);
+    std::printf("  %.3f allocations per message once warm (process-wide, sender side), close %.1f ms\n",
+                double(allocations) / (messages - warm), close_ms);
+}
+
+int main(int argc, char** argv) {
+    const int round_trips = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+    const int push_messages = argc > 2 ? std::max(10, std::atoi(argv[2])) : 20000;
+
+    Logger::SetLogLevel(Logger::LogLevel::E_ERROR);
+
+    EchoPhase(round_trips);
+    PushPhase("push", false, push_messages);
+#ifdef STAYPUTVR_WITH_ZLIB
+    PushPhase("deflate", true, push_messages);
+#else
+    std::printf("deflate: skipped (built without zlib)\n");
+#endif
+    KeepalivePhase();
+    SendQueuePhase(push_messages);
+
+    std::printf("\n%s\n", g_failures == 0 ? "all checks passed" : "CHECKS FAILED");
+    return g_failures == 0 ? 0 : 1;
+}